@@ -0,0 +1,404 @@
+﻿#ifndef _DUALFLOAT_BASIC_H_
+#error "it must include by <dualdouble.h> or <dualfloat.h>"
+#else
+#ifndef _DUAL_CXX_
+#define _DUAL_CXX_
+
+/**
+ * dual<T>的运算符,对float与double只写一次
+ * 运算由dual_traits<T>提供,其特化由dualimpl.h生成,
+ * 因此运算符与泛型代码使用的函数与C的函数相同.
+ */
+
+/* 单数类型T对应的双数类型与运算,由dualimpl.h特化 */
+template <class T> struct dual_traits {};
+
+/* 使模板参数不参与推导,单数运算数可以是整数等可转换的类型 */
+template <class T> struct dual_id { typedef T type; };
+
+/*
+ * 运算精度等级: df_fast使用fdf*函数,df_accurate使用df*函数,
+ * df_sloppy的双数加减法使用sdf2add/sdf2sub(其余同df_fast),
+ * df_correct使用正确舍入的cdf*函数.
+ * dual<T>的运算符使用df_default,由FAST_DF_OPERATOR选择.
+ */
+struct df_fast {};
+struct df_accurate {};
+struct df_sloppy {};
+struct df_correct {};
+#ifdef FAST_DF_OPERATOR
+typedef df_fast df_default;
+#else
+typedef df_accurate df_default;
+#endif
+
+/* 精度等级P的运算,由dualimpl.h特化 */
+template <class T, class P> struct dual_tier {};
+
+/*
+ * 指定运算精度的双数,如dualdouble_t<df_fast>,与dual<T>的布局相同,
+ * 可直接传给C函数;由dual<T>或其他精度等级构造需显式转换(不做任何计算),
+ * 不同精度等级的双数不能直接运算.
+ */
+template <class T, class P> struct dual_t : dual<T> {
+  dual_t() {}
+  dual_t(T a) {
+    this->hi = a;
+    this->lo = 0;
+  }
+  explicit dual_t(dual<T> a) : dual<T>(a) {}
+};
+
+template <class P> using dualdouble_t = dual_t<double, P>;
+template <class P> using dualfloat_t = dual_t<float, P>;
+
+#ifdef DF_EXPR_TEMPLATE
+#include "dualexpr_cxx.h"
+
+template <class T> inline T &operator+=(T &a, dual<T> b) {
+  return a = dual_traits<T>::add1(b, a);
+}
+
+template <class T> inline T &operator-=(T &a, dual<T> b) {
+  return a = dual_traits<T>::sub1r(a, b);
+}
+
+template <class T> inline T &operator*=(T &a, dual<T> b) {
+  return a = dual_traits<T>::mul(b, a).hi;
+}
+
+template <class T> inline T &operator/=(T &a, dual<T> b) {
+  return a = dual_traits<T>::div(a, b).hi;
+}
+
+#else
+/* add */
+template <class T>
+inline dual<T> operator+(dual<T> a, typename dual_id<T>::type b) {
+  return dual_traits<T>::add(a, b);
+}
+
+template <class T>
+inline dual<T> operator+(typename dual_id<T>::type a, dual<T> b) {
+  return dual_traits<T>::add(b, a);
+}
+
+template <class T> inline dual<T> operator+(dual<T> a, dual<T> b) {
+  return dual_traits<T>::add(a, b);
+}
+
+template <class T>
+inline dual<T> &operator+=(dual<T> &a, typename dual_id<T>::type b) {
+  return a = dual_traits<T>::add(a, b);
+}
+
+template <class T> inline dual<T> &operator+=(dual<T> &a, dual<T> b) {
+  return a = dual_traits<T>::add(a, b);
+}
+
+template <class T> inline T &operator+=(T &a, dual<T> b) {
+  return a = dual_traits<T>::add1(b, a);
+}
+
+/* sub */
+template <class T>
+inline dual<T> operator-(dual<T> a, typename dual_id<T>::type b) {
+  return dual_traits<T>::sub(a, b);
+}
+
+template <class T>
+inline dual<T> operator-(typename dual_id<T>::type a, dual<T> b) {
+  return dual_traits<T>::sub(a, b);
+}
+
+template <class T> inline dual<T> operator-(dual<T> a, dual<T> b) {
+  return dual_traits<T>::sub(a, b);
+}
+
+template <class T> inline dual<T> operator-(dual<T> a) {
+  return dual_traits<T>::neg(a);
+}
+
+template <class T>
+inline dual<T> &operator-=(dual<T> &a, typename dual_id<T>::type b) {
+  return a = dual_traits<T>::sub(a, b);
+}
+
+template <class T> inline dual<T> &operator-=(dual<T> &a, dual<T> b) {
+  return a = dual_traits<T>::sub(a, b);
+}
+
+template <class T> inline T &operator-=(T &a, dual<T> b) {
+  return a = dual_traits<T>::sub1r(a, b);
+}
+
+/* mul */
+template <class T>
+inline dual<T> operator*(dual<T> a, typename dual_id<T>::type b) {
+  return dual_traits<T>::mul(a, b);
+}
+
+template <class T>
+inline dual<T> operator*(typename dual_id<T>::type a, dual<T> b) {
+  return dual_traits<T>::mul(b, a);
+}
+
+template <class T> inline dual<T> operator*(dual<T> a, dual<T> b) {
+  return dual_traits<T>::mul(a, b);
+}
+
+template <class T>
+inline dual<T> &operator*=(dual<T> &a, typename dual_id<T>::type b) {
+  return a = dual_traits<T>::mul(a, b);
+}
+
+template <class T> inline dual<T> &operator*=(dual<T> &a, dual<T> b) {
+  return a = dual_traits<T>::mul(a, b);
+}
+
+template <class T> inline T &operator*=(T &a, dual<T> b) {
+  return a = dual_traits<T>::mul(b, a).hi;
+}
+
+/* div */
+template <class T>
+inline dual<T> operator/(dual<T> a, typename dual_id<T>::type b) {
+  return dual_traits<T>::div(a, b);
+}
+
+template <class T>
+inline dual<T> operator/(typename dual_id<T>::type a, dual<T> b) {
+  return dual_traits<T>::div(a, b);
+}
+
+template <class T> inline dual<T> operator/(dual<T> a, dual<T> b) {
+  return dual_traits<T>::div(a, b);
+}
+
+template <class T>
+inline dual<T> &operator/=(dual<T> &a, typename dual_id<T>::type b) {
+  return a = dual_traits<T>::div(a, b);
+}
+
+template <class T> inline dual<T> &operator/=(dual<T> &a, dual<T> b) {
+  return a = dual_traits<T>::div(a, b);
+}
+
+template <class T> inline T &operator/=(T &a, dual<T> b) {
+  return a = dual_traits<T>::div(a, b).hi;
+}
+#endif
+
+/* 指定精度等级的运算 */
+template <class T, class P>
+inline dual_t<T, P> operator+(dual_t<T, P> a, typename dual_id<T>::type b) {
+  return dual_t<T, P>(dual_tier<T, P>::add(a, b));
+}
+
+template <class T, class P>
+inline dual_t<T, P> operator+(typename dual_id<T>::type a, dual_t<T, P> b) {
+  return dual_t<T, P>(dual_tier<T, P>::add(b, a));
+}
+
+template <class T, class P>
+inline dual_t<T, P> operator+(dual_t<T, P> a, dual_t<T, P> b) {
+  return dual_t<T, P>(dual_tier<T, P>::add(a, b));
+}
+
+template <class T, class P, class Q>
+void operator+(dual_t<T, P> a, dual_t<T, Q> b) = delete;
+
+template <class T, class P>
+inline dual_t<T, P> &operator+=(dual_t<T, P> &a,
+                                 typename dual_id<T>::type b) {
+  return a = a + b;
+}
+
+template <class T, class P>
+inline dual_t<T, P> &operator+=(dual_t<T, P> &a, dual_t<T, P> b) {
+  return a = a + b;
+}
+
+template <class T, class P>
+inline dual_t<T, P> operator-(dual_t<T, P> a, typename dual_id<T>::type b) {
+  return dual_t<T, P>(dual_tier<T, P>::sub(a, b));
+}
+
+template <class T, class P>
+inline dual_t<T, P> operator-(typename dual_id<T>::type a, dual_t<T, P> b) {
+  return dual_t<T, P>(dual_tier<T, P>::sub(a, b));
+}
+
+template <class T, class P>
+inline dual_t<T, P> operator-(dual_t<T, P> a, dual_t<T, P> b) {
+  return dual_t<T, P>(dual_tier<T, P>::sub(a, b));
+}
+
+template <class T, class P, class Q>
+void operator-(dual_t<T, P> a, dual_t<T, Q> b) = delete;
+
+template <class T, class P>
+inline dual_t<T, P> &operator-=(dual_t<T, P> &a,
+                                 typename dual_id<T>::type b) {
+  return a = a - b;
+}
+
+template <class T, class P>
+inline dual_t<T, P> &operator-=(dual_t<T, P> &a, dual_t<T, P> b) {
+  return a = a - b;
+}
+
+template <class T, class P> inline dual_t<T, P> operator-(dual_t<T, P> a) {
+  return dual_t<T, P>(dual_traits<T>::neg(a));
+}
+
+template <class T, class P>
+inline dual_t<T, P> operator*(dual_t<T, P> a, typename dual_id<T>::type b) {
+  return dual_t<T, P>(dual_tier<T, P>::mul(a, b));
+}
+
+template <class T, class P>
+inline dual_t<T, P> operator*(typename dual_id<T>::type a, dual_t<T, P> b) {
+  return dual_t<T, P>(dual_tier<T, P>::mul(b, a));
+}
+
+template <class T, class P>
+inline dual_t<T, P> operator*(dual_t<T, P> a, dual_t<T, P> b) {
+  return dual_t<T, P>(dual_tier<T, P>::mul(a, b));
+}
+
+template <class T, class P, class Q>
+void operator*(dual_t<T, P> a, dual_t<T, Q> b) = delete;
+
+template <class T, class P>
+inline dual_t<T, P> &operator*=(dual_t<T, P> &a,
+                                 typename dual_id<T>::type b) {
+  return a = a * b;
+}
+
+template <class T, class P>
+inline dual_t<T, P> &operator*=(dual_t<T, P> &a, dual_t<T, P> b) {
+  return a = a * b;
+}
+
+template <class T, class P>
+inline dual_t<T, P> operator/(dual_t<T, P> a, typename dual_id<T>::type b) {
+  return dual_t<T, P>(dual_tier<T, P>::div(a, b));
+}
+
+template <class T, class P>
+inline dual_t<T, P> operator/(typename dual_id<T>::type a, dual_t<T, P> b) {
+  return dual_t<T, P>(dual_tier<T, P>::div(a, b));
+}
+
+template <class T, class P>
+inline dual_t<T, P> operator/(dual_t<T, P> a, dual_t<T, P> b) {
+  return dual_t<T, P>(dual_tier<T, P>::div(a, b));
+}
+
+template <class T, class P, class Q>
+void operator/(dual_t<T, P> a, dual_t<T, Q> b) = delete;
+
+template <class T, class P>
+inline dual_t<T, P> &operator/=(dual_t<T, P> &a,
+                                 typename dual_id<T>::type b) {
+  return a = a / b;
+}
+
+template <class T, class P>
+inline dual_t<T, P> &operator/=(dual_t<T, P> &a, dual_t<T, P> b) {
+  return a = a / b;
+}
+
+/* cmp_eq */
+template <class T>
+inline bool operator==(const dual<T> &a, typename dual_id<T>::type b) {
+  return (a.hi == b && a.lo == 0);
+}
+
+template <class T> inline bool operator==(const dual<T> &a, const dual<T> &b) {
+  return (a.hi == b.hi && a.lo == b.lo);
+}
+
+template <class T>
+inline bool operator==(typename dual_id<T>::type a, const dual<T> &b) {
+  return (a == b.hi && b.lo == 0);
+}
+
+/* cmp_gt */
+template <class T>
+inline bool operator>(const dual<T> &a, typename dual_id<T>::type b) {
+  return (a.hi > b || (a.hi == b && a.lo > 0));
+}
+
+template <class T> inline bool operator>(const dual<T> &a, const dual<T> &b) {
+  return (a.hi > b.hi || (a.hi == b.hi && a.lo > b.lo));
+}
+
+template <class T>
+inline bool operator>(typename dual_id<T>::type a, const dual<T> &b) {
+  return (a > b.hi || (a == b.hi && b.lo < 0));
+}
+
+/* cmp_lt */
+template <class T>
+inline bool operator<(const dual<T> &a, typename dual_id<T>::type b) {
+  return (a.hi < b || (a.hi == b && a.lo < 0));
+}
+
+template <class T> inline bool operator<(const dual<T> &a, const dual<T> &b) {
+  return (a.hi < b.hi || (a.hi == b.hi && a.lo < b.lo));
+}
+
+template <class T>
+inline bool operator<(typename dual_id<T>::type a, const dual<T> &b) {
+  return (a < b.hi || (a == b.hi && b.lo > 0));
+}
+
+/* cmp_gt_eq */
+template <class T>
+inline bool operator>=(const dual<T> &a, typename dual_id<T>::type b) {
+  return (a.hi > b || (a.hi == b && a.lo >= 0));
+}
+
+template <class T> inline bool operator>=(const dual<T> &a, const dual<T> &b) {
+  return (a.hi > b.hi || (a.hi == b.hi && a.lo >= b.lo));
+}
+
+template <class T>
+inline bool operator>=(typename dual_id<T>::type a, const dual<T> &b) {
+  return (b <= a);
+}
+
+/* cmp_lt_eq */
+template <class T>
+inline bool operator<=(const dual<T> &a, typename dual_id<T>::type b) {
+  return (a.hi < b || (a.hi == b && a.lo <= 0));
+}
+
+template <class T> inline bool operator<=(const dual<T> &a, const dual<T> &b) {
+  return (a.hi < b.hi || (a.hi == b.hi && a.lo <= b.lo));
+}
+
+template <class T>
+inline bool operator<=(typename dual_id<T>::type a, const dual<T> &b) {
+  return (b >= a);
+}
+
+/* cmp_not_eq */
+template <class T>
+inline bool operator!=(const dual<T> &a, typename dual_id<T>::type b) {
+  return (a.hi != b || a.lo != 0);
+}
+
+template <class T> inline bool operator!=(const dual<T> &a, const dual<T> &b) {
+  return (a.hi != b.hi || a.lo != b.lo);
+}
+
+template <class T>
+inline bool operator!=(typename dual_id<T>::type a, const dual<T> &b) {
+  return (a != b.hi || b.lo != 0);
+}
+
+#endif
+#endif // !_DUALFLOAT_BASIC_H_
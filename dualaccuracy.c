@@ -0,0 +1,554 @@
+﻿/**
+ * dualfloat的精度与速度对照(需要GCC的__float128与libquadmath)
+ * 同一运算的各版本(fdf*,df*,sdf*等)以__float128为参照计算相对误差,
+ * 每类输入各取n个样本,输出误差分布,最坏情况与吞吐,
+ * 再按运算列出Pareto表: 没有另一个版本既更快又最坏精度更高的版本标记为*,
+ * 以及每个精度要求(最坏情况的位数)下最快的版本.
+ *
+ * 误差以u^2为单位(u=2^-53或2^-24,即双数的最低位附近),
+ * bits为-log2(最大相对误差),claim为dualdouble.h/dualfloat.h注释中
+ * 最坏情况的精度位数(sdf2add/sdf2sub只计绝对值增大的加减法,
+ * df*的注释为107位精度即略大于0.5ulps,这里取相对误差2^-106).
+ * __float128有113位精度,dualdouble乘除法的参照值本身有约2^-7 u^2的误差.
+ *
+ * 输入类别: random 随机符号与指数; samesign 同号且指数相近;
+ * cancel 两数几乎相反(加减法大量抵消); edge 高位为2的幂或全1尾数,
+ * 低位为0或半个ulp等边界情况.
+ *
+ * 用法: dualaccuracy [-n 每类样本数] [-o 详细结果的CSV文件]
+ */
+
+#include "dualdouble.h"
+#include "dualfloat.h"
+#include <quadmath.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+typedef __float128 da_q;
+
+#define DA_NCLS 4
+static const char *da_cls[DA_NCLS] = {"random", "samesign", "cancel", "edge"};
+
+/* 一个版本在一类输入上的误差统计(单位u^2) */
+typedef struct da_stat {
+  double max, mean, p50, p99, p999;
+  double grow; // 绝对值增大的加减法(|结果|不小于两运算数)的最大误差
+  size_t bad; // 结果为NaN或无穷大(参照值有限)的个数
+} da_stat;
+
+/* 测量的上下文: 每类输入的a,b,c(double与float各一组) */
+typedef struct da_ctx {
+  size_t n;  // 每类样本数
+  size_t nt; // 测吞吐的元素数
+  dualdouble *da[DA_NCLS], *db[DA_NCLS], *dc[DA_NCLS];
+  dualfloat *fa[DA_NCLS], *fb[DA_NCLS], *fc[DA_NCLS];
+  double *err;
+  double grow;
+  void *out;
+} da_ctx;
+
+typedef struct da_entry {
+  const char *op;
+  const char *name;
+  const char *type;
+  void (*eval)(da_ctx *ctx, int cls);
+  void (*thr)(da_ctx *ctx);
+  int claim; // 注释中最坏情况的精度位数,0为无
+  da_stat st[DA_NCLS];
+  double ns;
+} da_entry;
+
+/* 双数精确转为__float128(高低位相差不超过113位时) */
+#define DA_Q(a) ((da_q)(a).hi + (da_q)(a).lo)
+
+/*
+ * 一个版本: op为运算,claim为double的精度位数(float减58),
+ * expr为运算,可使用双数a,b,c,单数x,y(a,b的高位),除数dv与乘数mv(由b算出);
+ * ref为__float128的参照,可使用qa,qb,qc,qx,qy; 误差相对于den,可使用参照q.
+ */
+#define DA_KERNEL(op, name, S, claim, expr, ref, den)                          \
+  static void da_eval_##name##S(da_ctx *ctx, int cls) {                        \
+    const DA_D *pa = ctx->DA_A[cls], *pb = ctx->DA_B[cls];                     \
+    const DA_D *pc = ctx->DA_C[cls];                                           \
+    size_t i;                                                                  \
+    ctx->grow = 0;                                                             \
+    for (i = 0; i < ctx->n; i++) {                                             \
+      DA_D a = pa[i], b = pb[i], c = pc[i], r;                                 \
+      DA_T x = a.hi, y = b.hi;                                                 \
+      DA_DIVR dv = dfdivisor##S(b);                                            \
+      DA_MULR mv = dfmultiplier##S(b);                                         \
+      da_q qa = DA_Q(a), qb = DA_Q(b), qc = DA_Q(c), qx = x, qy = y, q;        \
+      r = (expr);                                                              \
+      q = (ref);                                                               \
+      ctx->err[i] = da_relerr(DA_Q(r), q, (den), r.hi - r.hi == 0, DA_U2);     \
+      if (fabsq(q) >= fabsq(qa) && fabsq(q) >= fabsq(qb) &&                    \
+          ctx->err[i] > ctx->grow)                                             \
+        ctx->grow = ctx->err[i];                                               \
+      (void)qa, (void)qb, (void)qc, (void)qx, (void)qy, (void)dv, (void)mv;    \
+    }                                                                          \
+  }                                                                            \
+  static void da_thr_##name##S(da_ctx *ctx) {                                  \
+    const DA_D *pa = ctx->DA_A[0], *pb = ctx->DA_B[0];                         \
+    const DA_D *pc = ctx->DA_C[0];                                             \
+    DA_D *out = (DA_D *)ctx->out;                                              \
+    DA_DIVR dv = dfdivisor##S(pb[0]);                                          \
+    DA_MULR mv = dfmultiplier##S(pb[0]);                                       \
+    size_t i;                                                                  \
+    for (i = 0; i < ctx->nt; i++) {                                            \
+      DA_D a = pa[i], b = pb[i], c = pc[i];                                    \
+      DA_T x = a.hi, y = b.hi;                                                 \
+      out[i] = (expr);                                                         \
+      (void)c, (void)x, (void)y, (void)dv, (void)mv;                           \
+    }                                                                          \
+  }
+
+#define DA_ENTRY(op, name, S, claim, ...)                                      \
+  {op, #name #S, DA_TNAME, da_eval_##name##S, da_thr_##name##S,                \
+   (claim) ? (claim)-DA_CLAIM_OFF : 0, {{0, 0, 0, 0, 0, 0, 0}}, 0},
+
+/*
+ * 各运算的版本,claim取自dualdouble.h的注释;
+ * dfmulby/dfdivby(a*m,a/d)的乘数/除数由b算出,吞吐以同一个乘数/除数测量;
+ * a*b+c大量抵消时没有相对误差的界,误差相对于|a*b|+|c|.
+ */
+#define DA_LIST(X, S)                                                          \
+  X("a+y", fdfadd, S, 105, fdfadd##S(a, y), qa + qy, q)                        \
+  X("a+y", dfadd, S, 106, dfadd##S(a, y), qa + qy, q)                          \
+  X("a-y", fdfsub, S, 105, fdfsub##S(a, y), qa - qy, q)                        \
+  X("a-y", dfsub, S, 106, dfsub##S(a, y), qa - qy, q)                          \
+  X("x-b", fdfsubr, S, 105, fdfsubr##S(x, b), qx - qb, q)                      \
+  X("x-b", dfsubr, S, 106, dfsubr##S(x, b), qx - qb, q)                        \
+  X("a+b", sdf2add, S, 103, sdf2add##S(a, b), qa + qb, q)                      \
+  X("a+b", fdf2add, S, 104, fdf2add##S(a, b), qa + qb, q)                      \
+  X("a+b", df2add, S, 106, df2add##S(a, b), qa + qb, q)                        \
+  X("a-b", sdf2sub, S, 103, sdf2sub##S(a, b), qa - qb, q)                      \
+  X("a-b", fdf2sub, S, 104, fdf2sub##S(a, b), qa - qb, q)                      \
+  X("a-b", df2sub, S, 106, df2sub##S(a, b), qa - qb, q)                        \
+  X("a*y", fdfmul, S, 104, fdfmul##S(a, y), qa * qy, q)                        \
+  X("a*y", dfmul, S, 106, dfmul##S(a, y), qa * qy, q)                          \
+  X("a*b", fdf2mul, S, 103, fdf2mul##S(a, b), qa * qb, q)                      \
+  X("a*b", df2mul, S, 106, df2mul##S(a, b), qa * qb, q)                        \
+  X("a*m", dfmulby, S, 0, dfmulby##S(a, &mv), qa * qb, q)                      \
+  X("a*a", fdfsqr, S, 103, fdfsqr##S(a), qa * qa, q)                           \
+  X("a*a", dfsqr, S, 106, dfsqr##S(a), qa * qa, q)                             \
+  X("a/y", fdfdiv, S, 104, fdfdiv##S(a, y), qa / qy, q)                        \
+  X("a/y", dfdiv, S, 106, dfdiv##S(a, y), qa / qy, q)                          \
+  X("x/b", fdfdivr, S, 103, fdfdivr##S(x, b), qx / qb, q)                      \
+  X("x/b", dfdivr, S, 106, dfdivr##S(x, b), qx / qb, q)                        \
+  X("a/b", fdf2div, S, 103, fdf2div##S(a, b), qa / qb, q)                      \
+  X("a/b", df2div, S, 106, df2div##S(a, b), qa / qb, q)                        \
+  X("a/d", dfdivby, S, 0, dfdivby##S(a, &dv), qa / qb, q)                      \
+  X("1/a", dfrcp, S, 0, dfrcp##S(a), 1 / qa, q)                                \
+  X("1/a", dfdivr_1, S, 0, dfdivr##S(1, a), 1 / qa, q)                         \
+  X("sqrt", dfsqrt, S, 0, dfsqrt##S(dfabs_##S(a)), sqrtq(fabsq(qa)), q)        \
+  X("a*b+c", df2fma, S, 0,                                                     \
+      df2fma##S(a, b, c), DA_FMAQ(a, b, c), DA_FMAD)                           \
+  X("a*b+c", df2mul_add, S, 0,                                                 \
+      df2add##S(df2mul##S(a, b), c), DA_FMAQ(a, b, c), DA_FMAD)                \
+  X("a*b+c", fdf2mul_add, S, 0,                                                \
+      fdf2add##S(fdf2mul##S(a, b), c), DA_FMAQ(a, b, c), DA_FMAD)
+
+/*
+ * 相对误差(单位u^2): 误差除以den(通常为|q|),den为0时只有结果为0才无误差,
+ * 结果非有限为无穷大
+ */
+static double da_relerr(da_q r, da_q q, da_q den, int finite, double u2) {
+  if (!finite)
+    return q - q == 0 ? HUGE_VAL : 0;
+  if (den == 0)
+    return r == q ? 0 : HUGE_VAL;
+  return (double)(fabsq(r - q) / fabsq(den)) / u2;
+}
+
+/*
+ * a*b+c的参照: 各部分的乘积在__float128中精确,
+ * 先加高位以免大量抵消时乘积的舍入误差超过结果
+ */
+static da_q da_fmaq(da_q ah, da_q al, da_q bh, da_q bl, da_q ch, da_q cl) {
+  return ((ah * bh + ch) + (ah * bl + al * bh)) + (al * bl + cl);
+}
+
+#define DA_FMAQ(a, b, c) da_fmaq(a.hi, a.lo, b.hi, b.lo, c.hi, c.lo)
+#define DA_FMAD (fabsq(qa * qb) + fabsq(qc))
+
+static dualdouble dfabs_(dualdouble a) { return a.hi < 0 ? dfneg(a) : a; }
+static dualfloat dfabs_f(dualfloat a) { return a.hi < 0 ? dfnegf(a) : a; }
+
+#define DA_T double
+#define DA_D dualdouble
+#define DA_DIVR dualdouble_divisor
+#define DA_MULR dualdouble_multiplier
+#define DA_A da
+#define DA_B db
+#define DA_C dc
+#define DA_TNAME "double"
+#define DA_U2 0x1p-106
+#define DA_CLAIM_OFF 0
+DA_LIST(DA_KERNEL, )
+static da_entry da_double_entries[] = {DA_LIST(DA_ENTRY, )};
+#undef DA_T
+#undef DA_D
+#undef DA_DIVR
+#undef DA_MULR
+#undef DA_A
+#undef DA_B
+#undef DA_C
+#undef DA_TNAME
+#undef DA_U2
+#undef DA_CLAIM_OFF
+
+#define DA_T float
+#define DA_D dualfloat
+#define DA_DIVR dualfloat_divisor
+#define DA_MULR dualfloat_multiplier
+#define DA_A fa
+#define DA_B fb
+#define DA_C fc
+#define DA_TNAME "float"
+#define DA_U2 0x1p-48
+#define DA_CLAIM_OFF 58
+DA_LIST(DA_KERNEL, f)
+static da_entry da_float_entries[] = {DA_LIST(DA_ENTRY, f)};
+#undef DA_T
+#undef DA_D
+#undef DA_DIVR
+#undef DA_MULR
+#undef DA_A
+#undef DA_B
+#undef DA_C
+#undef DA_TNAME
+#undef DA_U2
+#undef DA_CLAIM_OFF
+
+/* xorshift64*随机数 */
+static uint64_t da_next(uint64_t *s) {
+  *s ^= *s >> 12;
+  *s ^= *s << 25;
+  *s ^= *s >> 27;
+  return *s * 0x2545F4914F6CDD1DULL;
+}
+
+/* [0,1)的均匀分布 */
+static double da_rand(uint64_t *s) {
+  return (double)(da_next(s) >> 11) * 0x1p-53;
+}
+
+/*
+ * 生成一类输入的高位与低位(m为尾数位数): 返回高位,*lo为相对高位的低位
+ * (以高位的ulp为单位,规格化前); e为指数.
+ */
+static double da_hi(uint64_t *s, int cls, int m, int e) {
+  double x;
+  if (cls == 3) {
+    switch (da_next(s) % 3) {
+    case 0: // 2的幂
+      x = 1;
+      break;
+    case 1: // 全1尾数
+      x = 2 - ldexp(1, -m);
+      break;
+    default: // 尾数只有低几位
+      x = 1 + ldexp((double)(da_next(s) % 8), -m);
+      break;
+    }
+  } else {
+    x = 1 + ldexp(floor(ldexp(da_rand(s), m)), -m); // m+1位的尾数
+  }
+  return ldexp(x, e);
+}
+
+/*
+ * 低位: 绝对值为高位ulp的2^-6至1/2倍,使双数的精确值不超过113位,
+ * 可由__float128精确表示; edge类还取0与±半个ulp.
+ */
+static double da_lo(uint64_t *s, int cls, int m, double hi) {
+  double ulp = ldexp(fabs(hi), -m), u;
+  if (cls == 3) {
+    switch (da_next(s) % 4) {
+    case 0:
+      return 0;
+    case 1:
+      return ulp / 2;
+    case 2:
+      return -ulp / 2;
+    default:
+      break;
+    }
+  }
+  u = 0x1p-6 + da_rand(s) * (0.5 - 0x1p-6);
+  return da_next(s) & 1 ? -ulp * u : ulp * u;
+}
+
+/* 生成一组单数为double(m=52)或float(m=23)的输入a,b,c */
+static void da_gen(uint64_t *s, int cls, int m, int erange, double *v) {
+  int i, e[3];
+  double sg[3];
+  for (i = 0; i < 3; i++) {
+    if (cls == 1) {
+      e[i] = (int)(da_next(s) % 9) - 4;
+      sg[i] = 1;
+    } else {
+      e[i] = (int)(da_next(s) % (2 * erange + 1)) - erange;
+      sg[i] = da_next(s) & 1 ? -1 : 1;
+    }
+    v[2 * i] = sg[i] * da_hi(s, cls, m, e[i]);
+    v[2 * i + 1] = da_lo(s, cls, m, v[2 * i]);
+  }
+  if (cls == 2) {
+    /* b几乎为-a: 高位相同或相差几个ulp,低位随机 */
+    int k = (int)(da_next(s) % 9) - 4;
+    v[2] = -(v[0] + (double)k * ldexp(fabs(v[0]), -m));
+    v[3] = da_lo(s, 0, m, v[2]);
+  }
+}
+
+/* 生成各类输入: double与float的低位按各自的尾数生成并规格化 */
+static void da_fill(da_ctx *ctx) {
+  uint64_t s = 0x9E3779B97F4A7C15ULL;
+  int cls;
+  size_t i;
+  for (cls = 0; cls < DA_NCLS; cls++) {
+    for (i = 0; i < ctx->n; i++) {
+      double v[6];
+      da_gen(&s, cls, 52, 30, v);
+      ctx->da[cls][i] = dfnorm(ddual(v[0], v[1]));
+      ctx->db[cls][i] = dfnorm(ddual(v[2], v[3]));
+      ctx->dc[cls][i] = dfnorm(ddual(v[4], v[5]));
+      da_gen(&s, cls, 23, 30, v);
+      ctx->fa[cls][i] = dfnormf(ddualf((float)v[0], (float)v[1]));
+      ctx->fb[cls][i] = dfnormf(ddualf((float)v[2], (float)v[3]));
+      ctx->fc[cls][i] = dfnormf(ddualf((float)v[4], (float)v[5]));
+    }
+  }
+}
+
+static int da_cmp(const void *a, const void *b) {
+  double x = *(const double *)a, y = *(const double *)b;
+  return x < y ? -1 : x > y;
+}
+
+/* 统计ctx->err的分布 */
+static da_stat da_stats(da_ctx *ctx) {
+  da_stat st;
+  size_t i, n = ctx->n;
+  double sum = 0;
+  st.bad = 0;
+  for (i = 0; i < n; i++) {
+    if (ctx->err[i] == HUGE_VAL)
+      st.bad++;
+    else
+      sum += ctx->err[i];
+  }
+  qsort(ctx->err, n, sizeof(double), da_cmp);
+  st.mean = n > st.bad ? sum / (double)(n - st.bad) : 0;
+  st.max = ctx->err[n - 1];
+  st.p50 = ctx->err[n / 2];
+  st.p99 = ctx->err[(size_t)((double)n * 0.99)];
+  st.p999 = ctx->err[(size_t)((double)n * 0.999)];
+  st.grow = ctx->grow;
+  return st;
+}
+
+/* 单调时钟(纳秒) */
+static double da_now(void) {
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return (double)t.tv_sec * 1e9 + (double)t.tv_nsec;
+}
+
+/* 吞吐: random类的前nt个输入重复运算约2毫秒,每次运算的纳秒数,5次采样取最快 */
+static double da_time(da_ctx *ctx, void (*fn)(da_ctx *)) {
+  double best = HUGE_VAL;
+  size_t it, iters = 1;
+  int s;
+  for (;;) {
+    double t = da_now();
+    for (it = 0; it < iters; it++)
+      fn(ctx);
+    if (da_now() - t >= 2e6 || iters >= ((size_t)1 << 30))
+      break;
+    iters *= 2;
+  }
+  for (s = 0; s < 5; s++) {
+    double t = da_now();
+    for (it = 0; it < iters; it++)
+      fn(ctx);
+    t = (da_now() - t) / ((double)iters * (double)ctx->nt);
+    if (t < best)
+      best = t;
+  }
+  return best;
+}
+
+/* 最坏情况的精度位数,grow非0则只计绝对值增大的加减法 */
+static double da_bits(const da_entry *e, double u2, int grow) {
+  double m = 0;
+  int c;
+  for (c = 0; c < DA_NCLS; c++) {
+    double x = grow ? e->st[c].grow : e->st[c].max;
+    if (e->st[c].bad && !grow)
+      return 0;
+    if (x > m)
+      m = x;
+  }
+  return m > 0 ? -log2(m * u2) : 999;
+}
+
+/* 只对绝对值增大的加减法有精度保证的版本 */
+static int da_sloppy(const da_entry *e) {
+  return !strncmp(e->name, "sdf2", 4);
+}
+
+/* 运算的各版本与Pareto表 */
+static void da_report(da_entry *es, size_t m, double u2, const int *budgets,
+                      int nb) {
+  size_t i, j;
+  int k;
+  printf("\n%-6s %-6s %-13s %8s %9s %9s %9s %7s %6s %s\n", "type", "op",
+         "func", "ns", "mean", "p99.9", "max", "bits", "claim", "pareto");
+  for (i = 0; i < m; i++) {
+    da_entry *e = &es[i];
+    double bits = da_bits(e, u2, 0), mean = 0, p999 = 0, mx = 0;
+    int pareto = 1, c;
+    for (c = 0; c < DA_NCLS; c++) {
+      mean += e->st[c].mean / DA_NCLS;
+      if (e->st[c].p999 > p999)
+        p999 = e->st[c].p999;
+      if (e->st[c].max > mx)
+        mx = e->st[c].max;
+    }
+    for (j = 0; j < m; j++) {
+      if (j == i || strcmp(es[j].op, e->op))
+        continue;
+      double bj = da_bits(&es[j], u2, 0);
+      if (es[j].ns <= e->ns && bj >= bits && (es[j].ns < e->ns || bj > bits))
+        pareto = 0;
+    }
+    printf("%-6s %-6s %-13s %8.3f %9.3g %9.3g %9.3g %7.2f", e->type, e->op,
+           e->name, e->ns, mean, p999, mx, bits);
+    if (e->claim) {
+      double b = da_bits(e, u2, da_sloppy(e));
+      printf(" %4d%s", e->claim, b >= e->claim ? "  " : " !");
+    } else {
+      printf(" %6s", "-");
+    }
+    printf(" %s\n", pareto ? "*" : "");
+  }
+  /* 每个精度要求下最快的版本 */
+  printf("\n%-6s %-6s", "bits>=", "op");
+  for (k = 0; k < nb; k++)
+    printf(" %13d", budgets[k]);
+  printf("\n");
+  for (i = 0; i < m; i++) {
+    for (j = 0; j < i; j++)
+      if (!strcmp(es[j].op, es[i].op))
+        break;
+    if (j < i)
+      continue;
+    printf("%-6s %-6s", es[i].type, es[i].op);
+    for (k = 0; k < nb; k++) {
+      const da_entry *best = NULL;
+      for (j = i; j < m; j++) {
+        if (strcmp(es[j].op, es[i].op) ||
+            da_bits(&es[j], u2, 0) < budgets[k])
+          continue;
+        if (!best || es[j].ns < best->ns)
+          best = &es[j];
+      }
+      printf(" %13s", best ? best->name : "-");
+    }
+    printf("\n");
+  }
+}
+
+/* 计算一种类型的所有版本 */
+static void da_run(da_ctx *ctx, da_entry *es, size_t m, FILE *csv) {
+  size_t i;
+  int c;
+  for (i = 0; i < m; i++) {
+    for (c = 0; c < DA_NCLS; c++) {
+      es[i].eval(ctx, c);
+      es[i].st[c] = da_stats(ctx);
+      if (csv)
+        fprintf(csv, "%s,%s,%s,%s,%zu,%.6g,%.6g,%.6g,%.6g,%.6g,%zu\n",
+                es[i].type, es[i].op, es[i].name, da_cls[c], ctx->n,
+                es[i].st[c].mean, es[i].st[c].p50, es[i].st[c].p99,
+                es[i].st[c].p999, es[i].st[c].max, es[i].st[c].bad);
+    }
+    es[i].ns = da_time(ctx, es[i].thr);
+    if (csv)
+      fprintf(csv, "%s,%s,%s,thr,%zu,%.4f,,,,,\n", es[i].type, es[i].op,
+              es[i].name, ctx->n, es[i].ns);
+  }
+}
+
+int main(int argc, char **argv) {
+  static const int dbud[] = {100, 103, 104, 105, 106};
+  static const int fbud[] = {42, 45, 46, 47, 48};
+  da_ctx ctx;
+  size_t n = 1 << 18;
+  const char *path = NULL;
+  FILE *csv = NULL;
+  int i;
+  for (i = 1; i + 1 < argc; i += 2) {
+    if (!strcmp(argv[i], "-n"))
+      n = (size_t)strtoul(argv[i + 1], NULL, 10);
+    else if (!strcmp(argv[i], "-o"))
+      path = argv[i + 1];
+    else
+      break;
+  }
+  if (i < argc || n < 1000) {
+    fprintf(stderr, "usage: %s [-n samples(>=1000)] [-o file]\n", argv[0]);
+    return 2;
+  }
+  if (path && !(csv = fopen(path, "w"))) {
+    perror(path);
+    return 1;
+  }
+  ctx.n = n;
+  ctx.nt = n < 1024 ? n : 1024;
+  for (i = 0; i < DA_NCLS; i++) {
+    ctx.da[i] = (dualdouble *)malloc(3 * n * sizeof(dualdouble));
+    ctx.fa[i] = (dualfloat *)malloc(3 * n * sizeof(dualfloat));
+    if (!ctx.da[i] || !ctx.fa[i]) {
+      fprintf(stderr, "out of memory\n");
+      return 1;
+    }
+    ctx.db[i] = ctx.da[i] + n;
+    ctx.dc[i] = ctx.db[i] + n;
+    ctx.fb[i] = ctx.fa[i] + n;
+    ctx.fc[i] = ctx.fb[i] + n;
+  }
+  ctx.err = (double *)malloc(n * sizeof(double));
+  ctx.out = malloc(n * sizeof(dualdouble));
+  if (!ctx.err || !ctx.out) {
+    fprintf(stderr, "out of memory\n");
+    return 1;
+  }
+  da_fill(&ctx);
+  if (csv)
+    fprintf(csv, "type,op,func,input,n,mean,p50,p99,p99.9,max,bad\n");
+  da_run(&ctx, da_double_entries,
+         sizeof(da_double_entries) / sizeof(da_entry), csv);
+  da_run(&ctx, da_float_entries, sizeof(da_float_entries) / sizeof(da_entry),
+         csv);
+  printf("errors in u^2 (double u=2^-53, float u=2^-24), %zu samples per "
+         "input class\n",
+         n);
+  da_report(da_double_entries, sizeof(da_double_entries) / sizeof(da_entry),
+            0x1p-106, dbud, 5);
+  da_report(da_float_entries, sizeof(da_float_entries) / sizeof(da_entry),
+            0x1p-48, fbud, 5);
+  for (i = 0; i < DA_NCLS; i++) {
+    free(ctx.da[i]);
+    free(ctx.fa[i]);
+  }
+  free(ctx.err);
+  free(ctx.out);
+  if (csv)
+    fclose(csv);
+  return 0;
+}
@@ -0,0 +1,318 @@
+﻿#ifndef _DUAL_ARRAY_H_
+#define _DUAL_ARRAY_H_
+#include "dualbatch.h"
+#include <stdio.h>
+#include <string.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/**
+ * dualdouble数组的二进制文件格式(可内存映射)
+ * 所有字段与数据均为小端序,数据为IEEE754 binary64.
+ *
+ * 偏移          大小        内容
+ * 0             64          文件头(dualarray_header)
+ * hi_offset     count*8     高位平面,double[count]
+ * lo_offset     count*8     低位平面,double[count]
+ * index_offset  nchunks*32  块索引(可选),dualarray_chunk[nchunks]
+ *
+ * 各平面起始偏移均为64字节对齐,平面末尾以0填充至64字节的倍数,
+ * 这与Arrow定宽缓冲区的对齐和填充要求一致,平面可直接作为Arrow缓冲区使用.
+ * 块索引把数组按chunk_len个元素一块划分,记录每块的最小值和最大值,
+ * 读取时可据此跳过整块; 最後一块可能不足chunk_len个元素.
+ * 映射文件後直接得到零拷贝的SoA视图,可交由批量函数计算.
+ */
+
+#define DUALARR_MAGIC "DUALARR\0"
+#define DUALARR_VERSION 1
+#define DUALARR_ALIGN 64
+
+/* 元素类型 */
+#define DUALARR_DUALDOUBLE 2
+
+/* 错误码 */
+#define DUALARR_OK 0
+#define DUALARR_EIO (-1)     // 打开/读写/映射失败
+#define DUALARR_EFORMAT (-2) // 不是合法的数组文件
+#define DUALARR_EENDIAN (-3) // 大端平台不支持零拷贝
+#define DUALARR_EARG (-4)    // 参数错误
+
+/* 文件头,共64字节 */
+typedef struct dualarray_header {
+  char magic[8];         // "DUALARR\0"
+  uint32_t version;      // 格式版本
+  uint32_t elemtype;     // 元素类型
+  uint32_t align;        // 平面对齐字节数
+  uint32_t reserved;     // 保留,写0
+  uint64_t count;        // 元素个数
+  uint64_t hi_offset;    // 高位平面偏移
+  uint64_t lo_offset;    // 低位平面偏移
+  uint64_t chunk_len;    // 每块元素个数,0表示无块索引
+  uint64_t index_offset; // 块索引偏移,0表示无块索引
+} dualarray_header;
+
+/* 块索引项,共32字节 */
+typedef struct dualarray_chunk {
+  dualdouble min;
+  dualdouble max;
+} dualarray_chunk;
+
+/* 已映射的数组文件 */
+typedef struct dualarray {
+  void *base;                   // 映射基址
+  uint64_t size;                // 映射字节数
+  uint64_t count;               // 元素个数
+  uint64_t chunk_len;           // 每块元素个数,0表示无块索引
+  uint64_t nchunks;             // 块个数
+  const dualarray_chunk *index; // 块索引,无则为NULL
+  dualdouble_soa data;          // 整个数组的SoA视图
+#ifdef _WIN32
+  HANDLE hfile;
+  HANDLE hmap;
+#endif
+} dualarray;
+
+/* 按64字节向上取整 */
+static inline uint64_t dualarray_align(uint64_t x) {
+  return (x + (DUALARR_ALIGN - 1)) & ~(uint64_t)(DUALARR_ALIGN - 1);
+}
+
+/* 块个数 */
+static inline uint64_t dualarray_nchunks(uint64_t count, uint64_t chunk_len) {
+  return chunk_len ? (count + chunk_len - 1) / chunk_len : 0;
+}
+
+/* 写入0填充至64字节对齐 */
+static inline int dualarray_pad(FILE *fp, uint64_t *pos) {
+  static const char zeros[DUALARR_ALIGN] = {0};
+  size_t pad = (size_t)(dualarray_align(*pos) - *pos);
+  if (pad && fwrite(zeros, 1, pad, fp) != pad)
+    return DUALARR_EIO;
+  *pos += pad;
+  return DUALARR_OK;
+}
+
+/* 写入一个平面,元素间隔stride个double(SoA为1,AoS为2) */
+static inline int dualarray_plane(FILE *fp, uint64_t *pos, const double *p,
+                                  size_t stride, uint64_t n) {
+  double buf[1024];
+  uint64_t i, k;
+  if (stride == 1) {
+    if (n && fwrite(p, sizeof(double), (size_t)n, fp) != (size_t)n)
+      return DUALARR_EIO;
+  } else {
+    for (i = 0; i < n; i += k) {
+      k = n - i < 1024 ? n - i : 1024;
+      for (size_t j = 0; j < k; j++)
+        buf[j] = p[(i + j) * stride];
+      if (fwrite(buf, sizeof(double), (size_t)k, fp) != (size_t)k)
+        return DUALARR_EIO;
+    }
+  }
+  *pos += n * sizeof(double);
+  return dualarray_pad(fp, pos);
+}
+
+/* 写入数组文件,hi与lo是元素间隔stride个double的两个平面 */
+static inline int dualarray_write_strided(const char *path, const double *hi,
+                                          const double *lo, size_t stride,
+                                          uint64_t count, uint64_t chunk_len) {
+  dualarray_header h;
+  dualarray_chunk c;
+  uint64_t pos, i, j, end, nchunks = dualarray_nchunks(count, chunk_len);
+  FILE *fp;
+  int ret;
+#ifdef __BIG_ENDIAN__
+  return DUALARR_EENDIAN;
+#endif
+  if (!path || (count && (!hi || !lo)))
+    return DUALARR_EARG;
+  memset(&h, 0, sizeof(h));
+  memcpy(h.magic, DUALARR_MAGIC, 8);
+  h.version = DUALARR_VERSION;
+  h.elemtype = DUALARR_DUALDOUBLE;
+  h.align = DUALARR_ALIGN;
+  h.count = count;
+  h.hi_offset = dualarray_align(sizeof(h));
+  h.lo_offset = h.hi_offset + dualarray_align(count * sizeof(double));
+  h.chunk_len = nchunks ? chunk_len : 0;
+  h.index_offset =
+      nchunks ? h.lo_offset + dualarray_align(count * sizeof(double)) : 0;
+  fp = fopen(path, "wb");
+  if (!fp)
+    return DUALARR_EIO;
+  pos = sizeof(h);
+  ret = fwrite(&h, sizeof(h), 1, fp) == 1 ? DUALARR_OK : DUALARR_EIO;
+  if (ret == DUALARR_OK)
+    ret = dualarray_pad(fp, &pos);
+  if (ret == DUALARR_OK)
+    ret = dualarray_plane(fp, &pos, hi, stride, count);
+  if (ret == DUALARR_OK)
+    ret = dualarray_plane(fp, &pos, lo, stride, count);
+  for (i = 0; ret == DUALARR_OK && i < nchunks; i++) {
+    j = i * chunk_len;
+    end = j + chunk_len < count ? j + chunk_len : count;
+    c.min = c.max = ddual(hi[j * stride], lo[j * stride]);
+    for (j++; j < end; j++) {
+      dualdouble x = ddual(hi[j * stride], lo[j * stride]);
+      if (x.hi < c.min.hi || (x.hi == c.min.hi && x.lo < c.min.lo))
+        c.min = x;
+      if (x.hi > c.max.hi || (x.hi == c.max.hi && x.lo > c.max.lo))
+        c.max = x;
+    }
+    if (fwrite(&c, sizeof(c), 1, fp) != 1)
+      ret = DUALARR_EIO;
+  }
+  if (fclose(fp) != 0 && ret == DUALARR_OK)
+    ret = DUALARR_EIO;
+  return ret;
+}
+
+/* 将SoA数组写入文件,chunk_len为0则不写块索引 */
+static inline int dualarray_write(const char *path, dualdouble_soa a,
+                                  uint64_t count, uint64_t chunk_len) {
+  return dualarray_write_strided(path, a.hi, a.lo, 1, count, chunk_len);
+}
+
+/* 将AoS数组写入文件,chunk_len为0则不写块索引 */
+static inline int dualarray_write_aos(const char *path, const dualdouble *a,
+                                      uint64_t count, uint64_t chunk_len) {
+  return dualarray_write_strided(path, &a->hi, &a->lo, 2, count, chunk_len);
+}
+
+/* 检查文件头是否与文件大小相符 */
+static inline int dualarray_check(const dualarray_header *h, uint64_t size) {
+  uint64_t plane, nchunks;
+  if (memcmp(h->magic, DUALARR_MAGIC, 8) != 0 ||
+      h->version != DUALARR_VERSION || h->elemtype != DUALARR_DUALDOUBLE)
+    return DUALARR_EFORMAT;
+  if (h->count > size / sizeof(double) || h->hi_offset % DUALARR_ALIGN ||
+      h->lo_offset % DUALARR_ALIGN || h->index_offset % DUALARR_ALIGN)
+    return DUALARR_EFORMAT;
+  plane = h->count * sizeof(double);
+  if (h->hi_offset < sizeof(*h) || h->hi_offset > size - plane ||
+      h->lo_offset < sizeof(*h) || h->lo_offset > size - plane)
+    return DUALARR_EFORMAT;
+  if (h->index_offset) {
+    if (!h->chunk_len)
+      return DUALARR_EFORMAT;
+    nchunks = dualarray_nchunks(h->count, h->chunk_len);
+    if (h->index_offset > size ||
+        nchunks > (size - h->index_offset) / sizeof(dualarray_chunk))
+      return DUALARR_EFORMAT;
+  }
+  return DUALARR_OK;
+}
+
+/* 解除映射 */
+static inline void dualarray_unmap(dualarray *arr) {
+  if (!arr || !arr->base)
+    return;
+#ifdef _WIN32
+  UnmapViewOfFile(arr->base);
+  CloseHandle(arr->hmap);
+  CloseHandle(arr->hfile);
+#else
+  munmap(arr->base, (size_t)arr->size);
+#endif
+  memset(arr, 0, sizeof(*arr));
+}
+
+/**
+ * 映射数组文件,成功後arr->data即为零拷贝的SoA视图.
+ * 映射为写时复制,修改视图不会写回文件.
+ */
+static inline int dualarray_map(dualarray *arr, const char *path) {
+  const dualarray_header *h;
+  uint64_t size;
+  int ret;
+  if (!arr || !path)
+    return DUALARR_EARG;
+  memset(arr, 0, sizeof(*arr));
+#ifdef __BIG_ENDIAN__
+  return DUALARR_EENDIAN;
+#endif
+#ifdef _WIN32
+  LARGE_INTEGER li;
+  arr->hfile = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL,
+                           OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+  if (arr->hfile == INVALID_HANDLE_VALUE)
+    return DUALARR_EIO;
+  if (!GetFileSizeEx(arr->hfile, &li)) {
+    CloseHandle(arr->hfile);
+    return DUALARR_EIO;
+  }
+  if (li.QuadPart < (LONGLONG)sizeof(*h)) {
+    CloseHandle(arr->hfile);
+    return DUALARR_EFORMAT;
+  }
+  size = (uint64_t)li.QuadPart;
+  arr->hmap = CreateFileMappingA(arr->hfile, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+  if (arr->hmap)
+    arr->base = MapViewOfFile(arr->hmap, FILE_MAP_COPY, 0, 0, 0);
+  if (!arr->base) {
+    if (arr->hmap)
+      CloseHandle(arr->hmap);
+    CloseHandle(arr->hfile);
+    return DUALARR_EIO;
+  }
+#else
+  struct stat st;
+  int fd = open(path, O_RDONLY);
+  if (fd < 0)
+    return DUALARR_EIO;
+  if (fstat(fd, &st) != 0) {
+    close(fd);
+    return DUALARR_EIO;
+  }
+  if (st.st_size < (off_t)sizeof(*h)) {
+    close(fd);
+    return DUALARR_EFORMAT;
+  }
+  size = (uint64_t)st.st_size;
+  arr->base = mmap(NULL, (size_t)size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd,
+                   0);
+  close(fd);
+  if (arr->base == MAP_FAILED) {
+    arr->base = NULL;
+    return DUALARR_EIO;
+  }
+#endif
+  arr->size = size;
+  h = (const dualarray_header *)arr->base;
+  ret = dualarray_check(h, size);
+  if (ret != DUALARR_OK) {
+    dualarray_unmap(arr);
+    return ret;
+  }
+  arr->count = h->count;
+  arr->data = dsoa((double *)((char *)arr->base + h->hi_offset),
+                   (double *)((char *)arr->base + h->lo_offset));
+  if (h->index_offset) {
+    arr->chunk_len = h->chunk_len;
+    arr->nchunks = dualarray_nchunks(h->count, h->chunk_len);
+    arr->index =
+        (const dualarray_chunk *)((char *)arr->base + h->index_offset);
+  }
+  return DUALARR_OK;
+}
+
+/* 取第i块的SoA视图,返回块内元素个数(无此块则返回0) */
+static inline uint64_t dualarray_chunkview(const dualarray *arr, uint64_t i,
+                                           dualdouble_soa *view) {
+  uint64_t first;
+  if (i >= arr->nchunks)
+    return 0;
+  first = i * arr->chunk_len;
+  *view = dsoaoff(arr->data, (size_t)first);
+  return arr->count - first < arr->chunk_len ? arr->count - first
+                                             : arr->chunk_len;
+}
+
+#endif
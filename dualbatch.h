@@ -0,0 +1,83 @@
+﻿#ifndef _DUAL_BATCH_H_
+#define _DUAL_BATCH_H_
+#include "dualdouble.h"
+#include "dualfloat.h"
+#include <float.h>
+#include <math.h>
+#include <stddef.h>
+
+/**
+ * dualdouble与dualfloat批量运算
+ * 数组以SoA布局存储: 高位与低位分别存放在两个double(float)平面中,
+ * 这样SIMD可一次装载多个元素的高位(或低位),平面亦与Arrow定宽缓冲区兼容.
+ * 批量函数名以v开头,与标量函数一一对应,计算结果与标量函数逐位相同.
+ * dualfloat的函数名加f後缀,SIMD类型为dualfloat8,函数如df2add8f.
+ */
+
+/*
+ * 有AVX时启用SIMD批量运算,DUAL_BATCH_FMA表示使用FMA指令;
+ * 无FMA(FP_FMA_INTRINS未定义)时以Dekker算法计算乘法余数,
+ * 结果仍与标量函数逐位相同(乘法余数为非规格化数的情况除外).
+ */
+#if FP_FMA_INTRINS == 1 && defined(__AVX__)
+#define DUAL_BATCH_AVX 1
+#define DUAL_BATCH_FMA 1
+#elif FP_FMA_INTRINS != 2 && defined(__AVX__)
+#include <immintrin.h>
+#define DUAL_BATCH_AVX 1
+#define DUAL_BATCH_FMA 0
+#endif
+
+/* 归约(vdf2sum_acc等)最多的SIMD累加器组数 */
+#define DUAL_BATCH_MAXACC 8
+
+/* vdfstats分段计算离差平方和的段长(元素个数),一段的两遍扫描在缓存内 */
+#define DUAL_BATCH_STATBLOCK 4096
+
+#define DF_T double
+#define DF_D dualdouble
+#define DF_N(name) name
+#define DF_K(c) c
+#define DF_SOA dualdouble_soa
+#define DF_STATS dualdouble_stats
+#define DF_DIVR dualdouble_divisor
+#define DF_MULR dualdouble_multiplier
+#define DF_V dualdouble4
+#define DF_VT __m256d
+#define DF_W 4
+#define DF_VN(name) name##4
+#define DF_PS(op) _mm256_##op##_pd
+#define DF_MAX DBL_MAX
+#define DF_SPLITTER 134217729.0 // 2^27+1
+#define DF_MANT 52
+#define DF_EBIAS 1023
+#define DF_EPI(op) _mm256_##op##_epi64
+#define DF_SI(v) _mm256_castpd_si256(v)
+#include "dualbatchimpl.h"
+
+#define DF_T float
+#define DF_D dualfloat
+#define DF_N(name) name##f
+#define DF_K(c) c##f
+#define DF_SOA dualfloat_soa
+#define DF_STATS dualfloat_stats
+#define DF_DIVR dualfloat_divisor
+#define DF_MULR dualfloat_multiplier
+#define DF_V dualfloat8
+#define DF_VT __m256
+#define DF_W 8
+#define DF_VN(name) name##8f
+#define DF_PS(op) _mm256_##op##_ps
+#define DF_MAX FLT_MAX
+#define DF_SPLITTER 4097.0f // 2^12+1
+#define DF_MANT 23
+#define DF_EBIAS 127
+#define DF_EPI(op) _mm256_##op##_epi32
+#define DF_SI(v) _mm256_castps_si256(v)
+#include "dualbatchimpl.h"
+
+#if defined(__cplusplus) || defined(c_plusplus)
+#include "dualbatch_cxx.h"
+#endif
+
+#endif
@@ -0,0 +1,303 @@
+﻿#ifndef _DUAL_BATCH_H_
+#error "it must include by <dualbatch.h>"
+#else
+#ifndef _DUAL_BATCH_CXX_
+#define _DUAL_BATCH_CXX_
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+/**
+ * dd_vector: SoA布局的dualdouble数组与延迟求值的数组表达式
+ * y = a*x + b*z - w 不产生中间数组,而是在赋值时编译为一个循环:
+ * 每4个元素以dualdouble4核函数计算,尾部以标量函数计算,只读写内存一遍.
+ * 逐元素运算同vdf2add/vdf2sub/vdf2mul/vdf2div(常数c视为ddual(c,0)),
+ * 因此结果与逐个调用批量函数逐位相同.
+ * 表达式只保存数组的指针,数组销毁或改变大小後不能再求值.
+ * 运算数组的大小不同时,构造表达式与赋值均抛出std::length_error.
+ */
+
+template <class... X> struct dd_vvoid { typedef void type; };
+
+/* 常数的大小,表示与另一运算数相同 */
+#define DD_VANY ((size_t)-1)
+
+/* 二元运算的大小,两个运算数组的大小不同时抛出std::length_error */
+inline size_t dd_vsize(size_t a, size_t b) {
+  if (a != b && a != DD_VANY && b != DD_VANY)
+    throw std::length_error("dd_vector: operands differ in size");
+  return a == DD_VANY ? b : a;
+}
+
+/* 数组表达式的公共基类 */
+template <class E> struct dd_vexpr {
+  typedef void dd_vexpr_tag;
+  const E &self() const { return static_cast<const E &>(*this); }
+};
+
+/* 数组叶节点 */
+struct dd_vref : dd_vexpr<dd_vref> {
+  dualdouble_soa a;
+  size_t n;
+  dd_vref(dualdouble_soa x, size_t m) : a(x), n(m) {}
+  size_t size() const { return n; }
+  dualdouble at(size_t i) const { return dsoaget(a, i); }
+#ifdef DUAL_BATCH_AVX
+  dualdouble4 at4(size_t i) const { return dload4(a, i); }
+#endif
+};
+
+/* 常数叶节点,每个元素取同一个值,大小为DD_VANY */
+struct dd_vconst : dd_vexpr<dd_vconst> {
+  dualdouble c;
+  explicit dd_vconst(dualdouble x) : c(x) {}
+  size_t size() const { return DD_VANY; }
+  dualdouble at(size_t) const { return c; }
+#ifdef DUAL_BATCH_AVX
+  dualdouble4 at4(size_t) const {
+    return ddual4(_mm256_set1_pd(c.hi), _mm256_set1_pd(c.lo));
+  }
+#endif
+};
+
+template <class A> struct dd_vneg : dd_vexpr<dd_vneg<A> > {
+  A a;
+  explicit dd_vneg(const A &x) : a(x) {}
+  size_t size() const { return a.size(); }
+  dualdouble at(size_t i) const { return dfneg(a.at(i)); }
+#ifdef DUAL_BATCH_AVX
+  dualdouble4 at4(size_t i) const {
+    dualdouble4 x = a.at4(i);
+    __m256d sign = _mm256_set1_pd(-0.0);
+    return ddual4(_mm256_xor_pd(x.hi, sign), _mm256_xor_pd(x.lo, sign));
+  }
+#endif
+};
+
+#ifdef DUAL_BATCH_AVX
+#define DD_VBINARY(name, fn, fn4)                                              \
+  template <class A, class B> struct name : dd_vexpr<name<A, B> > {            \
+    A a;                                                                       \
+    B b;                                                                       \
+    name(const A &x, const B &y) : a(x), b(y) { size(); }                      \
+    size_t size() const { return dd_vsize(a.size(), b.size()); }              \
+    dualdouble at(size_t i) const { return fn(a.at(i), b.at(i)); }             \
+    dualdouble4 at4(size_t i) const { return fn4(a.at4(i), b.at4(i)); }        \
+  };
+#else
+#define DD_VBINARY(name, fn, fn4)                                              \
+  template <class A, class B> struct name : dd_vexpr<name<A, B> > {            \
+    A a;                                                                       \
+    B b;                                                                       \
+    name(const A &x, const B &y) : a(x), b(y) { size(); }                      \
+    size_t size() const { return dd_vsize(a.size(), b.size()); }              \
+    dualdouble at(size_t i) const { return fn(a.at(i), b.at(i)); }             \
+  };
+#endif
+DD_VBINARY(dd_vadd, df2add, df2add4)
+DD_VBINARY(dd_vsub, df2sub, df2sub4)
+DD_VBINARY(dd_vmul, df2mul, df2mul4)
+DD_VBINARY(dd_vdiv, df2div, df2div4)
+#undef DD_VBINARY
+
+/* 将表达式e求值写入r[0..n-1],r可以是e中的数组 */
+template <class E>
+inline void dd_veval(dualdouble_soa r, const dd_vexpr<E> &e, size_t n) {
+  const E &x = e.self();
+  size_t i = 0;
+#ifdef DUAL_BATCH_AVX
+  for (; i + 4 <= n; i += 4)
+    dstore4(r, i, x.at4(i));
+#endif
+  for (; i < n; i++)
+    dsoaset(r, i, x.at(i));
+}
+
+/* 表达式各元素之和,求和顺序同vdf2sum */
+template <class E> inline dualdouble dd_sum(const dd_vexpr<E> &e) {
+  const E &x = e.self();
+  size_t i = 0, n = x.size();
+  dualdouble ret = ddual(0.0, 0.0);
+#ifdef DUAL_BATCH_AVX
+  if (n >= 8) {
+    dualdouble4 s0 = x.at4(0), s1 = x.at4(4);
+    for (i = 8; i + 8 <= n; i += 8) {
+      s0 = df2add4(s0, x.at4(i));
+      s1 = df2add4(s1, x.at4(i + 4));
+    }
+    ret = dfhsum4(df2add4(s0, s1));
+  }
+#endif
+  for (; i < n; i++)
+    ret = df2add(ret, x.at(i));
+  return ret;
+}
+
+/* SoA布局的dualdouble数组 */
+class dd_vector : public dd_vexpr<dd_vector> {
+public:
+  dd_vector() {}
+  explicit dd_vector(size_t n, dualdouble x = ddual(0.0, 0.0))
+      : hi_(n, x.hi), lo_(n, x.lo) {}
+  template <class E> dd_vector(const dd_vexpr<E> &e) { assign(e.self()); }
+
+  template <class E> dd_vector &operator=(const dd_vexpr<E> &e) {
+    assign(e.self());
+    return *this;
+  }
+
+  size_t size() const { return hi_.size(); }
+  void resize(size_t n) {
+    hi_.resize(n);
+    lo_.resize(n);
+  }
+  dualdouble operator[](size_t i) const { return ddual(hi_[i], lo_[i]); }
+  void set(size_t i, dualdouble x) {
+    hi_[i] = x.hi;
+    lo_[i] = x.lo;
+  }
+  double *hi() { return hi_.data(); }
+  double *lo() { return lo_.data(); }
+  dualdouble_soa soa() { return dsoa(hi_.data(), lo_.data()); }
+
+  /* 作为表达式的叶节点 */
+  dd_vref ref() const {
+    return dd_vref(dsoa(const_cast<double *>(hi_.data()),
+                        const_cast<double *>(lo_.data())),
+                   size());
+  }
+  dualdouble at(size_t i) const { return (*this)[i]; }
+#ifdef DUAL_BATCH_AVX
+  dualdouble4 at4(size_t i) const { return ref().at4(i); }
+#endif
+
+private:
+  template <class E> void assign(const E &e) {
+    size_t n = e.size(); // 重新检查各运算数组的大小
+    if (n != size()) { // 大小不同时e不可能引用自身
+      dd_vector t(n);
+      dd_veval(t.soa(), e, n);
+      hi_.swap(t.hi_);
+      lo_.swap(t.lo_);
+    } else {
+      dd_veval(soa(), e, n);
+    }
+  }
+
+  std::vector<double> hi_, lo_;
+};
+
+/* 运算数X对应的叶节点,vec表示是否为数组或数组表达式 */
+template <class X, class Enable = void> struct dd_vterm {};
+
+template <> struct dd_vterm<dd_vector> {
+  typedef dd_vref type;
+  enum { vec = 1 };
+  static type wrap(const dd_vector &x) { return x.ref(); }
+};
+
+template <class X>
+struct dd_vterm<X, typename std::enable_if<
+                       !std::is_same<X, dd_vector>::value,
+                       typename dd_vvoid<typename X::dd_vexpr_tag>::type>::type> {
+  typedef X type;
+  enum { vec = 1 };
+  static const X &wrap(const X &x) { return x; }
+};
+
+template <> struct dd_vterm<dualdouble> {
+  typedef dd_vconst type;
+  enum { vec = 0 };
+  static type wrap(dualdouble x) { return type(x); }
+};
+
+template <class X>
+struct dd_vterm<X, typename std::enable_if<std::is_arithmetic<X>::value>::type> {
+  typedef dd_vconst type;
+  enum { vec = 0 };
+  static type wrap(X x) { return type(ddual((double)x, 0.0)); }
+};
+
+/* 二元运算Op<A,B>的结果类型,至少一个运算数为数组 */
+template <template <class, class> class Op, class A, class B,
+          class Enable = void>
+struct dd_vbinop {};
+
+template <template <class, class> class Op, class A, class B>
+struct dd_vbinop<
+    Op, A, B,
+    typename std::enable_if<
+        (dd_vterm<A>::vec || dd_vterm<B>::vec),
+        typename dd_vvoid<typename dd_vterm<A>::type,
+                          typename dd_vterm<B>::type>::type>::type> {
+  typedef Op<typename dd_vterm<A>::type, typename dd_vterm<B>::type> type;
+  static type make(const A &a, const B &b) {
+    return type(dd_vterm<A>::wrap(a), dd_vterm<B>::wrap(b));
+  }
+};
+
+template <class A, class B>
+inline typename dd_vbinop<dd_vadd, A, B>::type operator+(const A &a,
+                                                         const B &b) {
+  return dd_vbinop<dd_vadd, A, B>::make(a, b);
+}
+
+template <class A, class B>
+inline typename dd_vbinop<dd_vsub, A, B>::type operator-(const A &a,
+                                                         const B &b) {
+  return dd_vbinop<dd_vsub, A, B>::make(a, b);
+}
+
+template <class A, class B>
+inline typename dd_vbinop<dd_vmul, A, B>::type operator*(const A &a,
+                                                         const B &b) {
+  return dd_vbinop<dd_vmul, A, B>::make(a, b);
+}
+
+template <class A, class B>
+inline typename dd_vbinop<dd_vdiv, A, B>::type operator/(const A &a,
+                                                         const B &b) {
+  return dd_vbinop<dd_vdiv, A, B>::make(a, b);
+}
+
+template <class A>
+inline dd_vneg<typename dd_vterm<A>::type> operator-(const dd_vexpr<A> &a) {
+  return dd_vneg<typename dd_vterm<A>::type>(dd_vterm<A>::wrap(a.self()));
+}
+
+/* 复合赋值,右边可为数组,数组表达式或常数 */
+template <template <class, class> class Op, class B, class Enable = void>
+struct dd_vcompound {};
+
+template <template <class, class> class Op, class B>
+struct dd_vcompound<
+    Op, B, typename dd_vvoid<typename dd_vbinop<Op, dd_vector, B>::type>::type> {
+  typedef dd_vector &type;
+};
+
+template <class B>
+inline typename dd_vcompound<dd_vadd, B>::type operator+=(dd_vector &a,
+                                                          const B &b) {
+  return a = a + b;
+}
+
+template <class B>
+inline typename dd_vcompound<dd_vsub, B>::type operator-=(dd_vector &a,
+                                                          const B &b) {
+  return a = a - b;
+}
+
+template <class B>
+inline typename dd_vcompound<dd_vmul, B>::type operator*=(dd_vector &a,
+                                                          const B &b) {
+  return a = a * b;
+}
+
+template <class B>
+inline typename dd_vcompound<dd_vdiv, B>::type operator/=(dd_vector &a,
+                                                          const B &b) {
+  return a = a / b;
+}
+
+#endif
+#endif // !_DUAL_BATCH_H_
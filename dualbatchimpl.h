@@ -0,0 +1,1273 @@
+﻿#ifndef DF_T
+#error "it must include by <dualbatch.h>"
+#else
+
+/**
+ * 批量运算的类型无关实现,由dualbatch.h对double与float各包含一次.
+ * 除dualimpl.h的DF_T,DF_D,DF_N,DF_K,DF_DIVR,DF_MULR外还使用以下宏:
+ * DF_SOA为SoA视图类型,DF_STATS为统计量类型,
+ * DF_V为一组SIMD双数的类型,DF_VT为对应的ymm寄存器类型,DF_W为其路数,
+ * DF_VN(name)为SIMD函数名(加上路数与类型後缀),
+ * DF_PS(op)为对应类型的AVX指令函数_mm256_op_pd或_mm256_op_ps,
+ * DF_MAX为单数类型的最大值,DF_SPLITTER为Veltkamp分割的常数(无FMA时使用),
+ * DF_MANT与DF_EBIAS为尾数位数与指数偏置,DF_EPI(op)为对应宽度的AVX2整数指令,
+ * DF_SI(v)将DF_VT按位转为__m256i.
+ */
+
+/* SoA布局的双数数组视图 */
+typedef struct DF_SOA {
+  DF_T *hi;
+  DF_T *lo;
+} DF_SOA;
+
+/* 构造SoA视图 */
+static inline DF_SOA DF_N(dsoa)(DF_T *hi, DF_T *lo) {
+  DF_SOA ret;
+  ret.hi = hi;
+  ret.lo = lo;
+  return ret;
+}
+
+/* SoA视图偏移 */
+static inline DF_SOA DF_N(dsoaoff)(DF_SOA a, size_t i) {
+  return DF_N(dsoa)(a.hi + i, a.lo + i);
+}
+
+/* 读取SoA数组的一个元素 */
+static inline DF_D DF_N(dsoaget)(DF_SOA a, size_t i) {
+  return DF_N(ddual)(a.hi[i], a.lo[i]);
+}
+
+/* 写入SoA数组的一个元素 */
+static inline void DF_N(dsoaset)(DF_SOA a, size_t i, DF_D x) {
+  a.hi[i] = x.hi;
+  a.lo[i] = x.lo;
+}
+
+#ifdef DUAL_BATCH_AVX
+
+/* DF_W个双数(一个ymm寄存器装高位,一个装低位) */
+typedef struct DF_V {
+  DF_VT hi;
+  DF_VT lo;
+} DF_V;
+
+/* 构造DF_W路双数 */
+static inline DF_V DF_VN(ddual)(DF_VT hi, DF_VT lo) {
+  DF_V ret;
+  ret.hi = hi;
+  ret.lo = lo;
+  return ret;
+}
+
+/* 从SoA数组装载DF_W个元素(不要求对齐) */
+static inline DF_V DF_VN(dload)(DF_SOA a, size_t i) {
+  return DF_VN(ddual)(DF_PS(loadu)(a.hi + i), DF_PS(loadu)(a.lo + i));
+}
+
+/* 向SoA数组写入DF_W个元素(不要求对齐) */
+static inline void DF_VN(dstore)(DF_SOA a, size_t i, DF_V x) {
+  DF_PS(storeu)(a.hi + i, x.hi);
+  DF_PS(storeu)(a.lo + i, x.lo);
+}
+
+/* 规格化DF_W路双数 */
+static inline DF_V DF_VN(dfnorm)(DF_V x) {
+  DF_V ret;
+  ret.hi = DF_PS(add)(x.hi, x.lo);
+  ret.lo = DF_PS(add)(x.lo, DF_PS(sub)(x.hi, ret.hi));
+  return ret;
+}
+
+/* DF_W路单数相加得到双数(无分支) */
+static inline DF_V DF_VN(dadd)(DF_VT a, DF_VT b) {
+  DF_V ret;
+  DF_VT z;
+  ret.hi = DF_PS(add)(a, b);
+  z = DF_PS(sub)(ret.hi, a);
+  ret.lo = DF_PS(add)(DF_PS(sub)(a, DF_PS(sub)(ret.hi, z)),
+                      DF_PS(sub)(b, z));
+  return ret;
+}
+
+/* DF_W路单数相减得到双数(无分支) */
+static inline DF_V DF_VN(dsub)(DF_VT a, DF_VT b) {
+  DF_V ret;
+  DF_VT z;
+  ret.hi = DF_PS(sub)(a, b);
+  z = DF_PS(sub)(ret.hi, a);
+  ret.lo = DF_PS(sub)(DF_PS(sub)(a, DF_PS(sub)(ret.hi, z)),
+                      DF_PS(add)(b, z));
+  return ret;
+}
+
+#if DUAL_BATCH_FMA
+/* DF_W路单数相乘得到双数 */
+static inline DF_V DF_VN(dmul)(DF_VT a, DF_VT b) {
+  DF_V ret;
+  ret.hi = DF_PS(mul)(a, b);
+  ret.lo = DF_PS(fmsub)(a, b, ret.hi);
+  return ret;
+}
+#else
+/*
+ * 将DF_W路单数分为两半,两半之间的乘积没有舍入
+ * (Veltkamp分割,要求a*DF_SPLITTER不溢出)
+ */
+static inline DF_V DF_VN(dsplit)(DF_VT a) {
+  DF_V ret;
+  DF_VT t = DF_PS(mul)(a, DF_PS(set1)(DF_SPLITTER));
+  ret.hi = DF_PS(sub)(t, DF_PS(sub)(t, a));
+  ret.lo = DF_PS(sub)(a, ret.hi);
+  return ret;
+}
+
+/*
+ * DF_W路单数相乘得到双数(无FMA时以Dekker算法精确计算余数,同标量dmul),
+ * 分割会溢出的(包括无穷大)那一组改用标量dmul.
+ * 余数为非规格化数时与FMA的结果相同,而标量的整数算法不适用非规格化数.
+ */
+static inline DF_V DF_VN(dmul)(DF_VT a, DF_VT b) {
+  const DF_VT mask = DF_PS(set1)(DF_K(-0.0));
+  DF_V ret, as, bs;
+  DF_VT big = DF_PS(max)(DF_PS(andnot)(mask, a), DF_PS(andnot)(mask, b));
+  big = DF_PS(cmp)(big, DF_PS(set1)(DF_MAX / DF_SPLITTER), _CMP_GT_OQ);
+  if (!dual_likely(DF_PS(movemask)(big) == 0)) {
+    DF_T x[DF_W], y[DF_W], h[DF_W], l[DF_W];
+    DF_D p;
+    int k;
+    DF_PS(storeu)(x, a);
+    DF_PS(storeu)(y, b);
+    for (k = 0; k < DF_W; k++) {
+      p = DF_N(dmul)(x[k], y[k]);
+      h[k] = p.hi;
+      l[k] = p.lo;
+    }
+    return DF_VN(ddual)(DF_PS(loadu)(h), DF_PS(loadu)(l));
+  }
+  as = DF_VN(dsplit)(a);
+  bs = DF_VN(dsplit)(b);
+  ret.hi = DF_PS(mul)(a, b);
+  ret.lo = DF_PS(sub)(DF_PS(mul)(as.hi, bs.hi), ret.hi);
+  ret.lo = DF_PS(add)(ret.lo, DF_PS(mul)(as.hi, bs.lo));
+  ret.lo = DF_PS(add)(ret.lo, DF_PS(mul)(as.lo, bs.hi));
+  ret.lo = DF_PS(add)(ret.lo, DF_PS(mul)(as.lo, bs.lo));
+  return ret;
+}
+#endif
+
+/* DF_W路计算-(a*b-c)并只进行一次舍入,要求同DF_LIM(nfmulsub) */
+static inline DF_VT DF_VN(nfmulsub)(DF_VT a, DF_VT b, DF_VT c) {
+#if DUAL_BATCH_FMA
+  return DF_PS(fnmadd)(a, b, c);
+#else
+  DF_V p = DF_VN(dmul)(a, b);
+  return DF_PS(sub)(DF_PS(sub)(c, p.hi), p.lo); // c-p.hi无舍入
+#endif
+}
+
+/* DF_W路计算a*b+c,同标量的fmuladd */
+static inline DF_VT DF_VN(fmuladd)(DF_VT a, DF_VT b, DF_VT c) {
+#if DUAL_BATCH_FMA
+  return DF_PS(fmadd)(a, b, c);
+#else
+  DF_V p = DF_VN(dmul)(a, b);
+  DF_V t = DF_VN(dadd)(p.hi, c);
+  return DF_PS(add)(t.hi, DF_PS(add)(t.lo, p.lo));
+#endif
+}
+
+/* DF_W路单数相除得到商(ret.hi)和余数(ret.lo) */
+static inline DF_V DF_VN(dmdiv)(DF_VT a, DF_VT b) {
+  DF_V ret;
+  ret.hi = DF_PS(div)(a, b);
+  ret.lo = DF_VN(nfmulsub)(ret.hi, b, a);
+  return ret;
+}
+
+/* 按绝对值将{x,y}分为较大者与较小者,同df2reorder的不完全排序 */
+static inline void DF_VN(dminmax)(DF_VT *x, DF_VT *y) {
+  const DF_VT mask = DF_PS(set1)(DF_K(-0.0));
+  DF_VT gt = DF_PS(cmp)(DF_PS(andnot)(mask, *x),
+                        DF_PS(andnot)(mask, *y), _CMP_GT_OQ);
+  DF_VT big = DF_PS(blendv)(*y, *x, gt);
+  *y = DF_PS(blendv)(*x, *y, gt);
+  *x = big;
+}
+
+/* DF_W路双数加法,同df2add */
+static inline DF_V DF_VN(df2add)(DF_V a, DF_V b) {
+  DF_V ret, tmp, alt;
+  DF_VT r0, r1, r2, r3, zero;
+  DF_VN(dminmax)(&a.hi, &b.hi);
+  DF_VN(dminmax)(&a.lo, &b.lo);
+  ret = DF_VN(dfnorm)(DF_VN(ddual)(a.hi, b.hi));
+  tmp = DF_VN(dfnorm)(DF_VN(ddual)(a.lo, b.lo));
+  r3 = tmp.lo;
+  tmp = DF_VN(dadd)(ret.lo, tmp.hi);
+  r2 = tmp.lo;
+  ret = DF_VN(dfnorm)(DF_VN(ddual)(ret.hi, tmp.hi));
+  r1 = DF_PS(add)(r2, r3);
+  /* 标量版本的罕见分支(ret.lo==0)以混合代替 */
+  r0 = ret.hi;
+  alt.hi = DF_PS(add)(ret.hi, r1);
+  alt.lo = DF_PS(add)(DF_PS(add)(DF_PS(sub)(r0, alt.hi), r2), r3);
+  zero = DF_PS(cmp)(ret.lo, DF_PS(setzero)(), _CMP_EQ_OQ);
+  ret.lo = DF_PS(add)(ret.lo, r1);
+  ret.hi = DF_PS(blendv)(ret.hi, alt.hi, zero);
+  ret.lo = DF_PS(blendv)(ret.lo, alt.lo, zero);
+  return ret;
+}
+
+/* DF_W路双数减法,同df2sub */
+static inline DF_V DF_VN(df2sub)(DF_V a, DF_V b) {
+  const DF_VT mask = DF_PS(set1)(DF_K(-0.0));
+  b.hi = DF_PS(xor)(b.hi, mask);
+  b.lo = DF_PS(xor)(b.lo, mask);
+  return DF_VN(df2add)(a, b);
+}
+
+/* DF_W路双数乘法,同df2mul */
+static inline DF_V DF_VN(df2mul)(DF_V a, DF_V b) {
+  DF_V ret, tmp, tmp2;
+  DF_VT r0;
+  r0 = DF_PS(mul)(a.lo, b.lo);
+  tmp = DF_VN(dmul)(a.hi, b.lo);
+  tmp2 = DF_VN(dmul)(a.lo, b.hi);
+  ret = DF_VN(dmul)(a.hi, b.hi);
+  r0 = DF_PS(add)(r0, DF_PS(add)(tmp.lo, tmp2.lo));
+  tmp = DF_VN(dadd)(tmp.hi, tmp2.hi);
+  r0 = DF_PS(add)(r0, tmp.lo);
+  tmp = DF_VN(dadd)(ret.lo, tmp.hi);
+  tmp.lo = DF_PS(add)(tmp.lo, r0);
+  tmp = DF_VN(dfnorm)(tmp);
+  ret = DF_VN(dfnorm)(DF_VN(ddual)(ret.hi, tmp.hi));
+  ret.lo = DF_PS(add)(ret.lo, tmp.lo);
+  return ret;
+}
+
+/* DF_W路双数除法,同df2div */
+static inline DF_V DF_VN(df2div)(DF_V a, DF_V b) {
+  DF_V ret, tmp, tmp2;
+  DF_VT r0, r1, r2, r3;
+  ret = DF_VN(dmdiv)(a.hi, b.hi);
+  r0 = DF_PS(div)(DF_PS(set1)(DF_K(1.0)), b.hi);
+  r1 = ret.hi;
+  tmp2 = DF_VN(dfnorm)(DF_VN(ddual)(ret.lo, a.lo));
+  tmp = DF_VN(dmul)(r1, b.lo);
+  tmp2.lo = DF_PS(sub)(tmp2.lo, tmp.lo);
+  tmp = DF_VN(dsub)(tmp2.hi, tmp.hi);
+  tmp.lo = DF_PS(add)(tmp.lo, tmp2.lo);
+  r2 = DF_PS(mul)(tmp.hi, r0);
+  r3 = DF_VN(nfmulsub)(r2, b.hi, tmp.hi);
+#if DUAL_BATCH_FMA
+  r3 = DF_PS(sub)(r3, DF_PS(fmsub)(r2, b.lo, tmp.lo));
+#else
+  r3 = DF_PS(add)(r3, DF_PS(sub)(tmp.lo, DF_PS(mul)(r2, b.lo)));
+#endif
+  r3 = DF_PS(mul)(r3, r0);
+  tmp = DF_VN(dfnorm)(DF_VN(ddual)(r2, r3));
+  ret = DF_VN(dfnorm)(DF_VN(ddual)(r1, tmp.hi));
+  ret.lo = DF_PS(add)(ret.lo, tmp.lo);
+  return ret;
+}
+
+/*
+ * 低位为0(由单数转换而来)的运算数省去为0的项,结果的值与完整算法相同,
+ * 供运算数已知为单数的批量函数(vdf2add_exact等)使用.
+ */
+
+/* DF_W路双数加法,每路至少一个运算数的低位为0,lo为另一个低位 */
+static inline DF_V DF_VN(df2add_exact)(DF_VT ahi, DF_VT bhi, DF_VT lo) {
+  DF_V ret, tmp, alt;
+  DF_VT r2, zero;
+  DF_VN(dminmax)(&ahi, &bhi);
+  ret = DF_VN(dfnorm)(DF_VN(ddual)(ahi, bhi));
+  tmp = DF_VN(dadd)(ret.lo, lo);
+  r2 = tmp.lo;
+  ret = DF_VN(dfnorm)(DF_VN(ddual)(ret.hi, tmp.hi));
+  alt.hi = DF_PS(add)(ret.hi, r2);
+  alt.lo = DF_PS(add)(DF_PS(sub)(ret.hi, alt.hi), r2);
+  zero = DF_PS(cmp)(ret.lo, DF_PS(setzero)(), _CMP_EQ_OQ);
+  ret.lo = DF_PS(add)(ret.lo, r2);
+  ret.hi = DF_PS(blendv)(ret.hi, alt.hi, zero);
+  ret.lo = DF_PS(blendv)(ret.lo, alt.lo, zero);
+  return ret;
+}
+
+/* DF_W路双数乘以低位为0的双数(高位为b) */
+static inline DF_V DF_VN(df2mul_exact)(DF_V a, DF_VT b) {
+  DF_V ret, tmp, tmp2;
+  tmp2 = DF_VN(dmul)(a.lo, b);
+  ret = DF_VN(dmul)(a.hi, b);
+  tmp = DF_VN(dadd)(ret.lo, tmp2.hi);
+  tmp.lo = DF_PS(add)(tmp.lo, tmp2.lo);
+  tmp = DF_VN(dfnorm)(tmp);
+  ret = DF_VN(dfnorm)(DF_VN(ddual)(ret.hi, tmp.hi));
+  ret.lo = DF_PS(add)(ret.lo, tmp.lo);
+  return ret;
+}
+
+/* DF_W路双数除以低位为0的双数(高位为b) */
+static inline DF_V DF_VN(df2div_exact)(DF_V a, DF_VT b) {
+  DF_V ret, tmp, tmp2;
+  DF_VT r0, r1, r2, r3;
+  ret = DF_VN(dmdiv)(a.hi, b);
+  r0 = DF_PS(div)(DF_PS(set1)(DF_K(1.0)), b);
+  r1 = ret.hi;
+  tmp2 = DF_VN(dfnorm)(DF_VN(ddual)(ret.lo, a.lo));
+  r2 = DF_PS(mul)(tmp2.hi, r0);
+  r3 = DF_VN(nfmulsub)(r2, b, tmp2.hi);
+  r3 = DF_PS(add)(r3, tmp2.lo);
+  r3 = DF_PS(mul)(r3, r0);
+  tmp = DF_VN(dfnorm)(DF_VN(ddual)(r2, r3));
+  ret = DF_VN(dfnorm)(DF_VN(ddual)(r1, tmp.hi));
+  ret.lo = DF_PS(add)(ret.lo, tmp.lo);
+  return ret;
+}
+
+/* DF_W路双数乘加a*b+c,同df2fma */
+static inline DF_V DF_VN(df2fma)(DF_V a, DF_V b, DF_V c) {
+  DF_V ret, tmp, tmp2, s;
+  DF_VT r0;
+  r0 = DF_PS(mul)(a.lo, b.lo);
+  tmp = DF_VN(dmul)(a.hi, b.lo);
+  tmp2 = DF_VN(dmul)(a.lo, b.hi);
+  ret = DF_VN(dmul)(a.hi, b.hi);
+  r0 = DF_PS(add)(r0, DF_PS(add)(tmp.lo, tmp2.lo));
+  tmp = DF_VN(dadd)(tmp.hi, tmp2.hi);
+  r0 = DF_PS(add)(r0, tmp.lo);
+  tmp2 = DF_VN(dadd)(ret.lo, c.lo);
+  r0 = DF_PS(add)(r0, tmp2.lo);
+  tmp = DF_VN(dadd)(tmp.hi, tmp2.hi);
+  r0 = DF_PS(add)(r0, tmp.lo);
+  s = DF_VN(dadd)(ret.hi, c.hi);
+  tmp = DF_VN(dadd)(s.lo, tmp.hi);
+  r0 = DF_PS(add)(r0, tmp.lo);
+  ret = DF_VN(dadd)(s.hi, tmp.hi);
+  ret.lo = DF_PS(add)(ret.lo, r0);
+  return DF_VN(dfnorm)(ret);
+}
+
+/* DF_W路双数除以预先计算的除数(rcp为b.hi的倒数),同dfdivby */
+static inline DF_V DF_VN(dfdivby)(DF_V a, DF_V b, DF_V rcp) {
+  DF_V ret, tmp, tmp2;
+  DF_VT r0, r1, r2, r3;
+  r0 = rcp.hi;
+#if DUAL_BATCH_FMA
+  r1 = DF_PS(fmadd)(a.hi, r0, DF_PS(mul)(a.hi, rcp.lo));
+#else
+  r1 = DF_PS(add)(DF_PS(mul)(a.hi, r0), DF_PS(mul)(a.hi, rcp.lo));
+#endif
+  ret.lo = DF_VN(nfmulsub)(r1, b.hi, a.hi);
+  tmp2 = DF_VN(dfnorm)(DF_VN(ddual)(ret.lo, a.lo));
+  tmp = DF_VN(dmul)(r1, b.lo);
+  tmp2.lo = DF_PS(sub)(tmp2.lo, tmp.lo);
+  tmp = DF_VN(dsub)(tmp2.hi, tmp.hi);
+  tmp.lo = DF_PS(add)(tmp.lo, tmp2.lo);
+  r2 = DF_PS(mul)(tmp.hi, r0);
+  r3 = DF_VN(nfmulsub)(r2, b.hi, tmp.hi);
+#if DUAL_BATCH_FMA
+  r3 = DF_PS(sub)(r3, DF_PS(fmsub)(r2, b.lo, tmp.lo));
+#else
+  r3 = DF_PS(add)(r3, DF_PS(sub)(tmp.lo, DF_PS(mul)(r2, b.lo)));
+#endif
+  r3 = DF_PS(mul)(r3, r0);
+  tmp = DF_VN(dfnorm)(DF_VN(ddual)(r2, r3));
+  ret = DF_VN(dfnorm)(DF_VN(ddual)(r1, tmp.hi));
+  ret.lo = DF_PS(add)(ret.lo, tmp.lo);
+  return ret;
+}
+
+#endif
+
+/* 批量双数加法: r[i]=a[i]+b[i] */
+static inline void DF_N(vdf2add)(DF_SOA r, DF_SOA a, DF_SOA b,
+                                 size_t n) {
+  size_t i = 0;
+#ifdef DUAL_BATCH_AVX
+  for (; i + DF_W <= n; i += DF_W)
+    DF_VN(dstore)(r, i,
+                  DF_VN(df2add)(DF_VN(dload)(a, i), DF_VN(dload)(b, i)));
+#endif
+  for (; i < n; i++)
+    DF_N(dsoaset)(r, i,
+                  DF_N(df2add)(DF_N(dsoaget)(a, i), DF_N(dsoaget)(b, i)));
+}
+
+/* 批量双数减法: r[i]=a[i]-b[i] */
+static inline void DF_N(vdf2sub)(DF_SOA r, DF_SOA a, DF_SOA b,
+                                 size_t n) {
+  size_t i = 0;
+#ifdef DUAL_BATCH_AVX
+  for (; i + DF_W <= n; i += DF_W)
+    DF_VN(dstore)(r, i,
+                  DF_VN(df2sub)(DF_VN(dload)(a, i), DF_VN(dload)(b, i)));
+#endif
+  for (; i < n; i++)
+    DF_N(dsoaset)(r, i,
+                  DF_N(df2sub)(DF_N(dsoaget)(a, i), DF_N(dsoaget)(b, i)));
+}
+
+/*
+ * 批量双数加法(无分支): 不足DF_W的余下元素以bdf2add计算(数量级随机时
+ * df2add的分支难以预测),结果同vdf2add
+ */
+static inline void DF_N(vbdf2add)(DF_SOA r, DF_SOA a, DF_SOA b,
+                                  size_t n) {
+  size_t i = 0;
+#ifdef DUAL_BATCH_AVX
+  for (; i + DF_W <= n; i += DF_W)
+    DF_VN(dstore)(r, i, DF_VN(df2add)(DF_VN(dload)(a, i), DF_VN(dload)(b, i)));
+#endif
+  for (; i < n; i++)
+    DF_N(dsoaset)(r, i,
+                  DF_N(bdf2add)(DF_N(dsoaget)(a, i), DF_N(dsoaget)(b, i)));
+}
+
+/* 批量双数减法(无分支),结果同vdf2sub */
+static inline void DF_N(vbdf2sub)(DF_SOA r, DF_SOA a, DF_SOA b,
+                                  size_t n) {
+  size_t i = 0;
+#ifdef DUAL_BATCH_AVX
+  for (; i + DF_W <= n; i += DF_W)
+    DF_VN(dstore)(r, i, DF_VN(df2sub)(DF_VN(dload)(a, i), DF_VN(dload)(b, i)));
+#endif
+  for (; i < n; i++)
+    DF_N(dsoaset)(r, i,
+                  DF_N(bdf2sub)(DF_N(dsoaget)(a, i), DF_N(dsoaget)(b, i)));
+}
+
+/* 批量双数乘法: r[i]=a[i]*b[i] */
+static inline void DF_N(vdf2mul)(DF_SOA r, DF_SOA a, DF_SOA b,
+                                 size_t n) {
+  size_t i = 0;
+#ifdef DUAL_BATCH_AVX
+  for (; i + DF_W <= n; i += DF_W)
+    DF_VN(dstore)(r, i,
+                  DF_VN(df2mul)(DF_VN(dload)(a, i), DF_VN(dload)(b, i)));
+#endif
+  for (; i < n; i++)
+    DF_N(dsoaset)(r, i,
+                  DF_N(df2mul)(DF_N(dsoaget)(a, i), DF_N(dsoaget)(b, i)));
+}
+
+/* 批量双数乘加: r[i]=a[i]*b[i]+c[i] */
+static inline void DF_N(vdf2fma)(DF_SOA r, DF_SOA a, DF_SOA b, DF_SOA c,
+                                 size_t n) {
+  size_t i = 0;
+#ifdef DUAL_BATCH_AVX
+  for (; i + DF_W <= n; i += DF_W)
+    DF_VN(dstore)(r, i,
+                  DF_VN(df2fma)(DF_VN(dload)(a, i), DF_VN(dload)(b, i),
+                                DF_VN(dload)(c, i)));
+#endif
+  for (; i < n; i++)
+    DF_N(dsoaset)(r, i,
+                  DF_N(df2fma)(DF_N(dsoaget)(a, i), DF_N(dsoaget)(b, i),
+                               DF_N(dsoaget)(c, i)));
+}
+
+/* 批量双数除法: r[i]=a[i]/b[i] */
+static inline void DF_N(vdf2div)(DF_SOA r, DF_SOA a, DF_SOA b,
+                                 size_t n) {
+  size_t i = 0;
+#ifdef DUAL_BATCH_AVX
+  for (; i + DF_W <= n; i += DF_W)
+    DF_VN(dstore)(r, i,
+                  DF_VN(df2div)(DF_VN(dload)(a, i), DF_VN(dload)(b, i)));
+#endif
+  for (; i < n; i++)
+    DF_N(dsoaset)(r, i,
+                  DF_N(df2div)(DF_N(dsoaget)(a, i), DF_N(dsoaget)(b, i)));
+}
+
+/*
+ * 批量双数与单数的加减乘除: r[i]=a[i] op b[i],b[i]视为低位为0的双数
+ * (如由double转换而来),省去为0的项,结果与vdf2add等逐位相同
+ */
+static inline void DF_N(vdf2add_exact)(DF_SOA r, DF_SOA a, const DF_T *b,
+                                       size_t n) {
+  size_t i = 0;
+#ifdef DUAL_BATCH_AVX
+  for (; i + DF_W <= n; i += DF_W) {
+    DF_V x = DF_VN(dload)(a, i);
+    DF_VN(dstore)(r, i, DF_VN(df2add_exact)(x.hi, DF_PS(loadu)(b + i), x.lo));
+  }
+#endif
+  for (; i < n; i++)
+    DF_N(dsoaset)(r, i,
+                  DF_N(df2add)(DF_N(dsoaget)(a, i),
+                               DF_N(ddual)(b[i], DF_K(0.0))));
+}
+
+static inline void DF_N(vdf2sub_exact)(DF_SOA r, DF_SOA a, const DF_T *b,
+                                       size_t n) {
+  size_t i = 0;
+#ifdef DUAL_BATCH_AVX
+  const DF_VT mask = DF_PS(set1)(DF_K(-0.0));
+  for (; i + DF_W <= n; i += DF_W) {
+    DF_V x = DF_VN(dload)(a, i);
+    DF_VT y = DF_PS(xor)(DF_PS(loadu)(b + i), mask);
+    DF_VN(dstore)(r, i, DF_VN(df2add_exact)(x.hi, y, x.lo));
+  }
+#endif
+  for (; i < n; i++)
+    DF_N(dsoaset)(r, i,
+                  DF_N(df2sub)(DF_N(dsoaget)(a, i),
+                               DF_N(ddual)(b[i], DF_K(0.0))));
+}
+
+static inline void DF_N(vdf2mul_exact)(DF_SOA r, DF_SOA a, const DF_T *b,
+                                       size_t n) {
+  size_t i = 0;
+#ifdef DUAL_BATCH_AVX
+  for (; i + DF_W <= n; i += DF_W)
+    DF_VN(dstore)(r, i, DF_VN(df2mul_exact)(DF_VN(dload)(a, i),
+                                            DF_PS(loadu)(b + i)));
+#endif
+  for (; i < n; i++)
+    DF_N(dsoaset)(r, i,
+                  DF_N(df2mul)(DF_N(dsoaget)(a, i),
+                               DF_N(ddual)(b[i], DF_K(0.0))));
+}
+
+static inline void DF_N(vdf2div_exact)(DF_SOA r, DF_SOA a, const DF_T *b,
+                                       size_t n) {
+  size_t i = 0;
+#ifdef DUAL_BATCH_AVX
+  for (; i + DF_W <= n; i += DF_W)
+    DF_VN(dstore)(r, i, DF_VN(df2div_exact)(DF_VN(dload)(a, i),
+                                            DF_PS(loadu)(b + i)));
+#endif
+  for (; i < n; i++)
+    DF_N(dsoaset)(r, i,
+                  DF_N(df2div)(DF_N(dsoaget)(a, i),
+                               DF_N(ddual)(b[i], DF_K(0.0))));
+}
+
+/* 批量除以同一个预先计算的除数: r[i]=a[i]/d */
+static inline void DF_N(vdfdivby)(DF_SOA r, DF_SOA a, const DF_DIVR *d,
+                                  size_t n) {
+  size_t i = 0;
+#ifdef DUAL_BATCH_AVX
+  DF_V b = DF_VN(ddual)(DF_PS(set1)(d->b.hi), DF_PS(set1)(d->b.lo));
+  DF_V rcp = DF_VN(ddual)(DF_PS(set1)(d->rcp.hi), DF_PS(set1)(d->rcp.lo));
+  for (; i + DF_W <= n; i += DF_W)
+    DF_VN(dstore)(r, i, DF_VN(dfdivby)(DF_VN(dload)(a, i), b, rcp));
+#endif
+  for (; i < n; i++)
+    DF_N(dsoaset)(r, i, DF_N(dfdivby)(DF_N(dsoaget)(a, i), d));
+}
+
+/* 批量乘以同一个预先计算的乘数: r[i]=a[i]*m */
+static inline void DF_N(vdfmulby)(DF_SOA r, DF_SOA a, const DF_MULR *m,
+                                  size_t n) {
+  size_t i = 0;
+#ifdef DUAL_BATCH_AVX
+  DF_V b = DF_VN(ddual)(DF_PS(set1)(m->m.hi), DF_PS(set1)(m->m.lo));
+  if (m->m.lo == DF_K(0.0))
+    for (; i + DF_W <= n; i += DF_W)
+      DF_VN(dstore)(r, i, DF_VN(df2mul_exact)(DF_VN(dload)(a, i), b.hi));
+  else
+    for (; i + DF_W <= n; i += DF_W)
+      DF_VN(dstore)(r, i, DF_VN(df2mul)(DF_VN(dload)(a, i), b));
+#endif
+  for (; i < n; i++)
+    DF_N(dsoaset)(r, i, DF_N(dfmulby)(DF_N(dsoaget)(a, i), m));
+}
+
+#ifdef DUAL_BATCH_AVX
+/* DF_W路双数取整的合并: hi,lo为a.hi,a.lo各自取整,同dffloor与dfceil */
+static inline DF_V DF_VN(dfintpart)(DF_V a, DF_VT hi, DF_VT lo) {
+  DF_VT fin = DF_PS(cmp)(DF_PS(sub)(a.hi, a.hi), DF_PS(setzero)(),
+                         _CMP_EQ_OQ);
+  DF_V ret;
+  lo = DF_PS(blendv)(DF_PS(mul)(hi, DF_PS(setzero)()), lo,
+                     DF_PS(cmp)(hi, a.hi, _CMP_EQ_OQ));
+  ret = DF_VN(dfnorm)(DF_VN(ddual)(hi, lo));
+  ret.hi = DF_PS(blendv)(a.hi, ret.hi, fin);
+  ret.lo = DF_PS(blendv)(a.lo, ret.lo, fin);
+  return ret;
+}
+
+/* DF_W路双数向下取整,同dffloor */
+static inline DF_V DF_VN(dffloor)(DF_V a) {
+  return DF_VN(dfintpart)(a, DF_PS(floor)(a.hi), DF_PS(floor)(a.lo));
+}
+
+/* DF_W路双数向上取整,同dfceil */
+static inline DF_V DF_VN(dfceil)(DF_V a) {
+  return DF_VN(dfintpart)(a, DF_PS(ceil)(a.hi), DF_PS(ceil)(a.lo));
+}
+
+/* DF_W路双数向0取整,同dftrunc */
+static inline DF_V DF_VN(dftrunc)(DF_V a) {
+  DF_V f = DF_VN(dffloor)(a), c = DF_VN(dfceil)(a);
+  DF_VT neg = DF_PS(cmp)(a.hi, DF_PS(setzero)(), _CMP_LT_OQ);
+  return DF_VN(ddual)(DF_PS(blendv)(f.hi, c.hi, neg),
+                      DF_PS(blendv)(f.lo, c.lo, neg));
+}
+
+/* DF_W路双数四舍五入(恰为0.5时远离0),同dfround */
+static inline DF_V DF_VN(dfround)(DF_V a) {
+  const DF_VT half = DF_PS(set1)(DF_K(0.5)), one = DF_PS(set1)(DF_K(1.0));
+  const DF_VT zero = DF_PS(setzero)();
+  DF_VT sign = DF_PS(and)(DF_PS(cmp)(a.hi, zero, _CMP_LT_OQ),
+                          DF_PS(set1)(DF_K(-0.0)));
+  DF_VT fin = DF_PS(cmp)(DF_PS(sub)(a.hi, a.hi), zero, _CMP_EQ_OQ);
+  DF_V x = DF_VN(ddual)(DF_PS(xor)(a.hi, sign), DF_PS(xor)(a.lo, sign));
+  DF_VT hi = DF_PS(floor)(x.hi), lo = DF_PS(floor)(x.lo), fh, fl, up, isint;
+  DF_V ret;
+  isint = DF_PS(cmp)(hi, x.hi, _CMP_EQ_OQ);
+  lo = DF_PS(and)(lo, isint);
+  fh = DF_PS(sub)(x.hi, hi);
+  fl = DF_PS(sub)(x.lo, lo);
+  up = DF_PS(or)(
+      DF_PS(cmp)(fh, half, _CMP_GT_OQ),
+      DF_PS(or)(DF_PS(and)(DF_PS(cmp)(fh, half, _CMP_EQ_OQ),
+                           DF_PS(cmp)(fl, zero, _CMP_GE_OQ)),
+                DF_PS(and)(DF_PS(cmp)(fh, zero, _CMP_EQ_OQ),
+                           DF_PS(cmp)(fl, half, _CMP_GE_OQ))));
+  hi = DF_PS(blendv)(hi, DF_PS(add)(hi, one), DF_PS(andnot)(isint, up));
+  lo = DF_PS(blendv)(lo, DF_PS(add)(lo, one), DF_PS(and)(isint, up));
+  ret = DF_VN(dfnorm)(DF_VN(ddual)(hi, lo));
+  ret.hi = DF_PS(blendv)(a.hi, DF_PS(xor)(ret.hi, sign), fin);
+  ret.lo = DF_PS(blendv)(a.lo, DF_PS(xor)(ret.lo, sign), fin);
+  return ret;
+}
+
+/* DF_W路求余的一步,同dfrem_step */
+static inline DF_V DF_VN(dfrem_step)(DF_V a, DF_V b, DF_VT n) {
+  const DF_VT mask = DF_PS(set1)(DF_K(-0.0));
+  DF_V p = DF_VN(dmul)(n, b.hi), q = DF_VN(dmul)(n, b.lo), s, t;
+  s = DF_VN(dadd)(DF_PS(sub)(a.hi, p.hi), DF_PS(xor)(p.lo, mask));
+  t = DF_VN(dadd)(a.lo, DF_PS(xor)(q.hi, mask));
+  t.lo = DF_PS(sub)(t.lo, q.lo);
+  return DF_VN(df2add)(s, t);
+}
+
+/*
+ * DF_W路截断余数,同dfrem_loop(对|a|,*q为商): 只处理每路的商都小于
+ * 2^(DF_MANT-2)且一步即可约减的情况,返回0表示需要改用标量计算.
+ */
+static inline int DF_VN(dfrem_loop)(DF_V *r, DF_VT *q, DF_V a, DF_V b) {
+  const DF_VT mask = DF_PS(set1)(DF_K(-0.0)), zero = DF_PS(setzero)();
+  const DF_VT one = DF_PS(set1)(DF_K(1.0));
+  DF_VT sign = DF_PS(and)(DF_PS(cmp)(a.hi, zero, _CMP_LT_OQ), mask);
+  DF_VT ok, act, n;
+  DF_V x = DF_VN(ddual)(DF_PS(xor)(a.hi, sign), DF_PS(xor)(a.lo, sign)), y;
+  ok = DF_PS(and)(
+      DF_PS(cmp)(b.hi, zero, _CMP_GT_OQ),
+      DF_PS(cmp)(b.hi, DF_PS(set1)(DF_MAX), _CMP_LE_OQ));
+  ok = DF_PS(and)(ok, DF_PS(cmp)(DF_PS(andnot)(mask, x.hi),
+                                 DF_PS(mul)(b.hi, DF_PS(set1)(DF_N(df_ldexp)(
+                                                      DF_K(1.0), DF_MANT - 2))),
+                                 _CMP_LT_OQ));
+  if (DF_PS(movemask)(ok) != (1 << DF_W) - 1)
+    return 0;
+  act = DF_PS(or)(DF_PS(cmp)(x.hi, b.hi, _CMP_GT_OQ),
+                  DF_PS(and)(DF_PS(cmp)(x.hi, b.hi, _CMP_EQ_OQ),
+                             DF_PS(cmp)(x.lo, b.lo, _CMP_GE_OQ)));
+  n = DF_PS(floor)(DF_PS(div)(x.hi, b.hi));
+  n = DF_PS(blendv)(n, one, DF_PS(cmp)(n, zero, _CMP_EQ_OQ));
+  y = DF_VN(dfrem_step)(x, b, n);
+  x.hi = DF_PS(blendv)(x.hi, y.hi, act);
+  x.lo = DF_PS(blendv)(x.lo, y.lo, act);
+  n = DF_PS(and)(n, act);
+  y = DF_VN(ddual)(DF_PS(andnot)(mask, x.hi),
+                   DF_PS(xor)(x.lo, DF_PS(and)(x.hi, mask)));
+  if (DF_PS(movemask)(DF_PS(or)(
+          DF_PS(cmp)(y.hi, b.hi, _CMP_GT_OQ),
+          DF_PS(and)(DF_PS(cmp)(y.hi, b.hi, _CMP_EQ_OQ),
+                     DF_PS(cmp)(y.lo, b.lo, _CMP_GE_OQ)))))
+    return 0; // 还需约减
+  act = DF_PS(cmp)(x.hi, zero, _CMP_LT_OQ);
+  y = DF_VN(df2add)(x, b);
+  r->hi = DF_PS(blendv)(x.hi, y.hi, act);
+  r->lo = DF_PS(blendv)(x.lo, y.lo, act);
+  *q = DF_PS(sub)(n, DF_PS(and)(act, one));
+  return 1;
+}
+
+/* DF_W路双数截断余数,同dffmod,返回0表示需要改用标量计算 */
+static inline int DF_VN(dffmod)(DF_V *r, DF_V a, DF_V b) {
+  const DF_VT mask = DF_PS(set1)(DF_K(-0.0));
+  DF_VT sign = DF_PS(and)(
+      DF_PS(cmp)(a.hi, DF_PS(setzero)(), _CMP_LT_OQ), mask), q;
+  DF_VT bs = DF_PS(and)(
+      DF_PS(cmp)(b.hi, DF_PS(setzero)(), _CMP_LT_OQ), mask);
+  b = DF_VN(ddual)(DF_PS(xor)(b.hi, bs), DF_PS(xor)(b.lo, bs));
+  if (!DF_VN(dfrem_loop)(r, &q, a, b))
+    return 0;
+  r->hi = DF_PS(xor)(r->hi, sign);
+  r->lo = DF_PS(xor)(r->lo, sign);
+  return 1;
+}
+
+/* DF_W路双数就近余数,同dfremquo(商存于q,由调用者取低位),返回0表示需要改用标量计算 */
+static inline int DF_VN(dfremquo)(DF_V *r, DF_VT *q, DF_V a, DF_V b) {
+  const DF_VT mask = DF_PS(set1)(DF_K(-0.0)), one = DF_PS(set1)(DF_K(1.0));
+  DF_VT sign = DF_PS(and)(
+      DF_PS(cmp)(a.hi, DF_PS(setzero)(), _CMP_LT_OQ), mask), up, odd;
+  DF_VT bs = DF_PS(and)(
+      DF_PS(cmp)(b.hi, DF_PS(setzero)(), _CMP_LT_OQ), mask);
+  DF_V b2, y;
+  b = DF_VN(ddual)(DF_PS(xor)(b.hi, bs), DF_PS(xor)(b.lo, bs));
+  if (!DF_VN(dfrem_loop)(r, q, a, b))
+    return 0;
+  b2 = DF_VN(ddual)(DF_PS(add)(r->hi, r->hi), DF_PS(add)(r->lo, r->lo));
+  odd = DF_PS(cmp)(DF_PS(sub)(*q, DF_PS(mul)(DF_PS(set1)(DF_K(2.0)),
+                                            DF_PS(floor)(DF_PS(mul)(
+                                                *q, DF_PS(set1)(DF_K(0.5)))))),
+                   one, _CMP_EQ_OQ);
+  up = DF_PS(or)(
+      DF_PS(cmp)(b2.hi, b.hi, _CMP_GT_OQ),
+      DF_PS(and)(DF_PS(cmp)(b2.hi, b.hi, _CMP_EQ_OQ),
+                 DF_PS(or)(DF_PS(cmp)(b2.lo, b.lo, _CMP_GT_OQ),
+                           DF_PS(and)(DF_PS(cmp)(b2.lo, b.lo, _CMP_EQ_OQ),
+                                      odd))));
+  y = DF_VN(df2sub)(*r, b);
+  r->hi = DF_PS(xor)(DF_PS(blendv)(r->hi, y.hi, up), sign);
+  r->lo = DF_PS(xor)(DF_PS(blendv)(r->lo, y.lo, up), sign);
+  *q = DF_PS(add)(*q, DF_PS(and)(up, one));
+  return 1;
+}
+
+#ifdef __AVX2__
+/* DF_W路单数乘以2^e(e为整数值的浮点数),同df_ldexp */
+static inline DF_VT DF_VN(ldexp)(DF_VT a, DF_VT e) {
+  const DF_VT emax = DF_PS(set1)((DF_T)DF_EBIAS);
+  const DF_VT emin = DF_PS(set1)((DF_T)(1 - DF_EBIAS));
+  const DF_VT step = DF_PS(set1)((DF_T)(DF_EBIAS - DF_MANT - 2));
+  const DF_VT big = DF_PS(set1)(DF_N(df_ldexp)(DF_K(1.0), DF_EBIAS));
+  const DF_VT small =
+      DF_PS(set1)(DF_N(df_ldexp)(DF_K(1.0), DF_MANT + 2 - DF_EBIAS));
+  const DF_VT one = DF_PS(set1)(DF_K(1.0));
+  DF_VT gt, lt;
+  int k;
+  for (k = 0; k < 2; k++) { // 同df_ldexp的分步相乘
+    gt = DF_PS(cmp)(e, emax, _CMP_GT_OQ);
+    lt = DF_PS(cmp)(e, emin, _CMP_LT_OQ);
+    a = DF_PS(mul)(a, DF_PS(blendv)(DF_PS(blendv)(one, small, lt), big, gt));
+    e = DF_PS(add)(DF_PS(sub)(e, DF_PS(and)(gt, emax)),
+                   DF_PS(and)(lt, step));
+  }
+  e = DF_PS(min)(DF_PS(max)(e, emin), emax);
+  // e+偏置+2^DF_MANT的位表示左移DF_MANT位即为2^e
+  e = DF_PS(add)(e, DF_PS(set1)((DF_T)DF_EBIAS +
+                                DF_N(df_ldexp)(DF_K(1.0), DF_MANT)));
+  return DF_PS(mul)(a, DF_PS(castsi256)(DF_EPI(slli)(DF_SI(e), DF_MANT)));
+}
+
+/*
+ * DF_W路双数以2为底的指数(整数值的浮点数),同dfilogb,
+ * a.hi为0,非规格化数,无穷大或NaN时返回0表示需要改用标量计算.
+ */
+static inline int DF_VN(dfilogb)(DF_VT *e, DF_V a) {
+  const DF_VT mask = DF_PS(set1)(DF_K(-0.0)), zero = DF_PS(setzero)();
+  const DF_VT m2 = DF_PS(set1)(DF_N(df_ldexp)(DF_K(1.0), DF_MANT));
+  DF_VT ah = DF_PS(andnot)(mask, a.hi), eb, pow2;
+  if (DF_PS(movemask)(DF_PS(and)(
+          DF_PS(cmp)(ah, DF_PS(set1)(DF_N(df_ldexp)(DF_K(1.0),
+                                                    1 - DF_EBIAS)),
+                     _CMP_GE_OQ),
+          DF_PS(cmp)(ah, DF_PS(set1)(DF_MAX), _CMP_LE_OQ))) !=
+      (1 << DF_W) - 1)
+    return 0;
+  // 指数位右移後拼入2^DF_MANT的尾数,减去2^DF_MANT即为带偏置的指数
+  eb = DF_PS(castsi256)(DF_EPI(srli)(DF_SI(ah), DF_MANT));
+  eb = DF_PS(sub)(DF_PS(or)(eb, m2), m2);
+  pow2 = DF_PS(cmp)(DF_PS(and)(ah, DF_PS(set1)(INFINITY)), ah, _CMP_EQ_OQ);
+  pow2 = DF_PS(and)(pow2, DF_PS(xor)(DF_PS(cmp)(a.lo, zero, _CMP_LT_OQ),
+                                     DF_PS(cmp)(a.hi, zero, _CMP_LT_OQ)));
+  pow2 = DF_PS(and)(pow2, DF_PS(cmp)(a.lo, zero, _CMP_NEQ_UQ));
+  *e = DF_PS(sub)(DF_PS(sub)(eb, DF_PS(set1)((DF_T)DF_EBIAS)),
+                  DF_PS(and)(pow2, DF_PS(set1)(DF_K(1.0))));
+  return 1;
+}
+#endif
+#endif
+
+/* 批量双数向下取整: r[i]=floor(a[i]) */
+static inline void DF_N(vdffloor)(DF_SOA r, DF_SOA a, size_t n) {
+  size_t i = 0;
+#ifdef DUAL_BATCH_AVX
+  for (; i + DF_W <= n; i += DF_W)
+    DF_VN(dstore)(r, i, DF_VN(dffloor)(DF_VN(dload)(a, i)));
+#endif
+  for (; i < n; i++)
+    DF_N(dsoaset)(r, i, DF_N(dffloor)(DF_N(dsoaget)(a, i)));
+}
+
+/* 批量双数向上取整: r[i]=ceil(a[i]) */
+static inline void DF_N(vdfceil)(DF_SOA r, DF_SOA a, size_t n) {
+  size_t i = 0;
+#ifdef DUAL_BATCH_AVX
+  for (; i + DF_W <= n; i += DF_W)
+    DF_VN(dstore)(r, i, DF_VN(dfceil)(DF_VN(dload)(a, i)));
+#endif
+  for (; i < n; i++)
+    DF_N(dsoaset)(r, i, DF_N(dfceil)(DF_N(dsoaget)(a, i)));
+}
+
+/* 批量双数向0取整: r[i]=trunc(a[i]) */
+static inline void DF_N(vdftrunc)(DF_SOA r, DF_SOA a, size_t n) {
+  size_t i = 0;
+#ifdef DUAL_BATCH_AVX
+  for (; i + DF_W <= n; i += DF_W)
+    DF_VN(dstore)(r, i, DF_VN(dftrunc)(DF_VN(dload)(a, i)));
+#endif
+  for (; i < n; i++)
+    DF_N(dsoaset)(r, i, DF_N(dftrunc)(DF_N(dsoaget)(a, i)));
+}
+
+/* 批量双数四舍五入: r[i]=round(a[i]) */
+static inline void DF_N(vdfround)(DF_SOA r, DF_SOA a, size_t n) {
+  size_t i = 0;
+#ifdef DUAL_BATCH_AVX
+  for (; i + DF_W <= n; i += DF_W)
+    DF_VN(dstore)(r, i, DF_VN(dfround)(DF_VN(dload)(a, i)));
+#endif
+  for (; i < n; i++)
+    DF_N(dsoaset)(r, i, DF_N(dfround)(DF_N(dsoaget)(a, i)));
+}
+
+/* 批量双数截断余数: r[i]=fmod(a[i],b[i]),商较大的一组改用标量计算 */
+static inline void DF_N(vdffmod)(DF_SOA r, DF_SOA a, DF_SOA b, size_t n) {
+  size_t i = 0, j;
+#ifdef DUAL_BATCH_AVX
+  DF_V x;
+  for (; i + DF_W <= n; i += DF_W) {
+    DF_STAT(vdffmod, block);
+    if (DF_VN(dffmod)(&x, DF_VN(dload)(a, i), DF_VN(dload)(b, i)))
+      DF_VN(dstore)(r, i, x);
+    else {
+      DF_STAT(vdffmod, scalar);
+      for (j = i; j < i + DF_W; j++)
+        DF_N(dsoaset)(r, j, DF_N(dffmod)(DF_N(dsoaget)(a, j),
+                                         DF_N(dsoaget)(b, j)));
+    }
+  }
+#endif
+  for (j = i; j < n; j++)
+    DF_N(dsoaset)(r, j, DF_N(dffmod)(DF_N(dsoaget)(a, j),
+                                     DF_N(dsoaget)(b, j)));
+}
+
+/* 批量双数就近余数: r[i]=remquo(a[i],b[i],&quo[i]) */
+static inline void DF_N(vdfremquo)(DF_SOA r, int *quo, DF_SOA a, DF_SOA b,
+                                   size_t n) {
+  size_t i = 0, j;
+#ifdef DUAL_BATCH_AVX
+  DF_V x;
+  DF_VT q;
+  DF_T t[DF_W];
+  int v;
+  for (; i + DF_W <= n; i += DF_W) {
+    DF_STAT(vdfremquo, block);
+    if (DF_VN(dfremquo)(&x, &q, DF_VN(dload)(a, i), DF_VN(dload)(b, i))) {
+      DF_VN(dstore)(r, i, x);
+      DF_PS(storeu)(t, q);
+      for (j = 0; j < DF_W; j++) {
+        v = (int)((uint64_t)(int64_t)t[j] & 0x7fffffff);
+        quo[i + j] =
+            (a.hi[i + j] < DF_K(0.0)) != (b.hi[i + j] < DF_K(0.0)) ? -v : v;
+      }
+    } else {
+      DF_STAT(vdfremquo, scalar);
+      for (j = i; j < i + DF_W; j++)
+        DF_N(dsoaset)(r, j, DF_N(dfremquo)(DF_N(dsoaget)(a, j),
+                                           DF_N(dsoaget)(b, j), quo + j));
+    }
+  }
+#endif
+  for (j = i; j < n; j++)
+    DF_N(dsoaset)(r, j, DF_N(dfremquo)(DF_N(dsoaget)(a, j),
+                                       DF_N(dsoaget)(b, j), quo + j));
+}
+
+/* 批量双数乘以2的幂: r[i]=ldexp(a[i],e[i]) */
+static inline void DF_N(vdfldexp)(DF_SOA r, DF_SOA a, const int *e,
+                                  size_t n) {
+  size_t i = 0;
+#if defined(DUAL_BATCH_AVX) && defined(__AVX2__)
+  DF_T t[DF_W];
+  DF_VT ev;
+  DF_V x;
+  size_t j;
+  for (; i + DF_W <= n; i += DF_W) {
+    for (j = 0; j < DF_W; j++)
+      t[j] = (DF_T)e[i + j];
+    ev = DF_PS(loadu)(t);
+    x = DF_VN(dload)(a, i);
+    DF_VN(dstore)(r, i, DF_VN(ddual)(DF_VN(ldexp)(x.hi, ev),
+                                     DF_VN(ldexp)(x.lo, ev)));
+  }
+#endif
+  for (; i < n; i++)
+    DF_N(dsoaset)(r, i, DF_N(dfldexp)(DF_N(dsoaget)(a, i), e[i]));
+}
+
+/* 批量双数以2为底的指数: e[i]=ilogb(a[i]) */
+static inline void DF_N(vdfilogb)(int *e, DF_SOA a, size_t n) {
+  size_t i = 0, j;
+#if defined(DUAL_BATCH_AVX) && defined(__AVX2__)
+  DF_T t[DF_W];
+  DF_VT ev;
+  for (; i + DF_W <= n; i += DF_W) {
+    if (DF_VN(dfilogb)(&ev, DF_VN(dload)(a, i))) {
+      DF_PS(storeu)(t, ev);
+      for (j = 0; j < DF_W; j++)
+        e[i + j] = (int)t[j];
+    } else
+      for (j = i; j < i + DF_W; j++)
+        e[j] = DF_N(dfilogb)(DF_N(dsoaget)(a, j));
+  }
+#endif
+  for (j = i; j < n; j++)
+    e[j] = DF_N(dfilogb)(DF_N(dsoaget)(a, j));
+}
+
+/* 批量双数分解: r[i]=frexp(a[i],&e[i]) */
+static inline void DF_N(vdffrexp)(DF_SOA r, int *e, DF_SOA a, size_t n) {
+  size_t i = 0, j;
+#if defined(DUAL_BATCH_AVX) && defined(__AVX2__)
+  DF_T t[DF_W];
+  DF_VT ev;
+  DF_V x;
+  for (; i + DF_W <= n; i += DF_W) {
+    x = DF_VN(dload)(a, i);
+    if (DF_VN(dfilogb)(&ev, x)) {
+      ev = DF_PS(xor)(DF_PS(add)(ev, DF_PS(set1)(DF_K(1.0))),
+                      DF_PS(set1)(DF_K(-0.0)));
+      DF_VN(dstore)(r, i, DF_VN(ddual)(DF_VN(ldexp)(x.hi, ev),
+                                       DF_VN(ldexp)(x.lo, ev)));
+      DF_PS(storeu)(t, ev);
+      for (j = 0; j < DF_W; j++)
+        e[i + j] = -(int)t[j];
+    } else
+      for (j = i; j < i + DF_W; j++)
+        DF_N(dsoaset)(r, j, DF_N(dffrexp)(DF_N(dsoaget)(a, j), e + j));
+  }
+#endif
+  for (j = i; j < n; j++)
+    DF_N(dsoaset)(r, j, DF_N(dffrexp)(DF_N(dsoaget)(a, j), e + j));
+}
+
+/* 双数数组的统计量 */
+typedef struct DF_STATS {
+  uint64_t count;
+  DF_D sum;
+  DF_D m2; // 离差平方和: sum((x-均值)^2)
+  DF_D min;
+  DF_D max;
+} DF_STATS;
+
+/* 初始化统计量 */
+static inline void DF_N(dfstats_init)(DF_STATS *s) {
+  s->count = 0;
+  s->sum = s->m2 = DF_N(ddual)(DF_K(0.0), DF_K(0.0));
+  s->min = DF_N(ddual)(INFINITY, DF_K(0.0));
+  s->max = DF_N(ddual)(-INFINITY, DF_K(0.0));
+}
+
+/* 以x更新最小值与最大值(先比较高位,再比较低位) */
+static inline void DF_N(dfstats_minmax)(DF_STATS *s, DF_D x) {
+  if (x.hi < s->min.hi || (x.hi == s->min.hi && x.lo < s->min.lo))
+    s->min = x;
+  if (x.hi > s->max.hi || (x.hi == s->max.hi && x.lo > s->max.lo))
+    s->max = x;
+}
+
+/* 个数转为双数(2^48以内精确) */
+static inline DF_D DF_N(dfstats_n)(uint64_t n) {
+  DF_T hi = (DF_T)n;
+  return DF_N(ddual)(hi, (DF_T)((int64_t)n - (int64_t)hi));
+}
+
+/*
+ * 合并统计量: s+=t
+ * 离差平方和以Chan的公式合并: m2 = m2s + m2t + (均值差)^2*ns*nt/(ns+nt),
+ * 不像平方和减去和的平方那样在均值远大于离散程度时相消.
+ */
+static inline void DF_N(dfstats_merge)(DF_STATS *s, const DF_STATS *t) {
+  DF_D ns, nt, d;
+  if (!t->count)
+    return;
+  if (!s->count) {
+    *s = *t;
+    return;
+  }
+  ns = DF_N(dfstats_n)(s->count);
+  nt = DF_N(dfstats_n)(t->count);
+  d = DF_N(df2sub)(DF_N(df2div)(t->sum, nt), DF_N(df2div)(s->sum, ns));
+  d = DF_N(df2mul)(DF_N(df2mul)(d, d),
+                   DF_N(df2div)(DF_N(df2mul)(ns, nt), DF_N(df2add)(ns, nt)));
+  s->m2 = DF_N(df2add)(DF_N(df2add)(s->m2, t->m2), d);
+  s->count += t->count;
+  s->sum = DF_N(df2add)(s->sum, t->sum);
+  DF_N(dfstats_minmax)(s, t->min);
+  DF_N(dfstats_minmax)(s, t->max);
+}
+
+/* 均值,count为0时为NaN */
+static inline DF_D DF_N(dfstats_mean)(const DF_STATS *s) {
+  return DF_N(df2div)(s->sum, DF_N(dfstats_n)(s->count));
+}
+
+/* 样本方差(m2除以count-1),count不足2时样本方差无定义,返回NaN */
+static inline DF_D DF_N(dfstats_var)(const DF_STATS *s) {
+  if (s->count < 2)
+    return DF_N(ddual)((DF_T)NAN, DF_K(0.0));
+  return DF_N(df2div)(s->m2, DF_N(dfstats_n)(s->count - 1));
+}
+
+#ifdef DUAL_BATCH_AVX
+/* DF_W路双数横向求和,相邻两路两两相加: (0+1)+(2+3)... */
+static inline DF_D DF_VN(dfhsum)(DF_V x) {
+  DF_T hi[DF_W], lo[DF_W];
+  DF_D s[DF_W];
+  int i, w;
+  DF_PS(storeu)(hi, x.hi);
+  DF_PS(storeu)(lo, x.lo);
+  for (i = 0; i < DF_W; i++)
+    s[i] = DF_N(ddual)(hi[i], lo[i]);
+  for (w = 1; w < DF_W; w += w)
+    for (i = 0; i + w < DF_W; i += w + w)
+      s[i] = DF_N(df2add)(s[i], s[i + w]);
+  return s[0];
+}
+
+/* DF_W路取较小者(先比较高位,再比较低位) */
+static inline DF_V DF_VN(dfmin)(DF_V a, DF_V b) {
+  DF_VT lt = DF_PS(or)(
+      DF_PS(cmp)(b.hi, a.hi, _CMP_LT_OQ),
+      DF_PS(and)(DF_PS(cmp)(b.hi, a.hi, _CMP_EQ_OQ),
+                 DF_PS(cmp)(b.lo, a.lo, _CMP_LT_OQ)));
+  return DF_VN(ddual)(DF_PS(blendv)(a.hi, b.hi, lt),
+                      DF_PS(blendv)(a.lo, b.lo, lt));
+}
+
+/* DF_W路取较大者(先比较高位,再比较低位) */
+static inline DF_V DF_VN(dfmax)(DF_V a, DF_V b) {
+  DF_VT gt = DF_PS(or)(
+      DF_PS(cmp)(b.hi, a.hi, _CMP_GT_OQ),
+      DF_PS(and)(DF_PS(cmp)(b.hi, a.hi, _CMP_EQ_OQ),
+                 DF_PS(cmp)(b.lo, a.lo, _CMP_GT_OQ)));
+  return DF_VN(ddual)(DF_PS(blendv)(a.hi, b.hi, gt),
+                      DF_PS(blendv)(a.lo, b.lo, gt));
+}
+#endif
+
+#ifdef DUAL_BATCH_AVX
+/* 以k组SIMD累加器求和a[0..n-1]中的前若干组,*i为已累加的元素个数 */
+static inline DF_D DF_VN(dfsum_acc)(DF_SOA a, size_t n, size_t *i, int k) {
+  DF_V s[DUAL_BATCH_MAXACC];
+  int j, h;
+  for (j = 0; j < k; j++)
+    s[j] = DF_VN(dload)(a, (size_t)j * DF_W);
+  for (*i = k * DF_W; *i + k * DF_W <= n; *i += k * DF_W)
+    for (j = 0; j < k; j++)
+      s[j] = DF_VN(df2add)(s[j], DF_VN(dload)(a, *i + j * DF_W));
+  for (h = k / 2; h; h /= 2) // 两两合并
+    for (j = 0; j < h; j++)
+      s[j] = DF_VN(df2add)(s[j], s[j + h]);
+  return DF_VN(dfhsum)(s[0]);
+}
+
+/* 以k组SIMD累加器求a[0..n-1]与b[0..n-1]中的前若干组的点积 */
+static inline DF_D DF_VN(dfdot_acc)(DF_SOA a, DF_SOA b, size_t n, size_t *i,
+                                    int k) {
+  DF_V s[DUAL_BATCH_MAXACC];
+  int j, h;
+  for (j = 0; j < k; j++)
+    s[j] = DF_VN(df2mul)(DF_VN(dload)(a, (size_t)j * DF_W),
+                         DF_VN(dload)(b, (size_t)j * DF_W));
+  for (*i = k * DF_W; *i + k * DF_W <= n; *i += k * DF_W)
+    for (j = 0; j < k; j++)
+      s[j] = DF_VN(df2fma)(DF_VN(dload)(a, *i + j * DF_W),
+                           DF_VN(dload)(b, *i + j * DF_W), s[j]);
+  for (h = k / 2; h; h /= 2)
+    for (j = 0; j < h; j++)
+      s[j] = DF_VN(df2add)(s[j], s[j + h]);
+  return DF_VN(dfhsum)(s[0]);
+}
+#endif
+
+/*
+ * 批量求和,以k(1,2,4或8,其他值按2)组SIMD累加器交错累加以隐藏df2add的延迟,
+ * 最快的k与处理器有关(见dualtune.h); 累加次序随k而变,不同k的结果可能略有不同.
+ */
+static inline DF_D DF_N(vdf2sum_acc)(DF_SOA a, size_t n, int k) {
+  DF_D ret = DF_N(ddual)(DF_K(0.0), DF_K(0.0));
+  size_t i = 0;
+#ifdef DUAL_BATCH_AVX
+  if (k != 1 && k != 4 && k != DUAL_BATCH_MAXACC)
+    k = 2;
+  if (n >= (size_t)k * DF_W) // 分别展开以使累加器留在寄存器中
+    switch (k) {
+    case 1:
+      ret = DF_VN(dfsum_acc)(a, n, &i, 1);
+      break;
+    case 4:
+      ret = DF_VN(dfsum_acc)(a, n, &i, 4);
+      break;
+    case DUAL_BATCH_MAXACC:
+      ret = DF_VN(dfsum_acc)(a, n, &i, DUAL_BATCH_MAXACC);
+      break;
+    default:
+      ret = DF_VN(dfsum_acc)(a, n, &i, 2);
+    }
+#else
+  (void)k;
+#endif
+  for (; i < n; i++)
+    ret = DF_N(df2add)(ret, DF_N(dsoaget)(a, i));
+  return ret;
+}
+
+/* 批量求和(两组累加器) */
+static inline DF_D DF_N(vdf2sum)(DF_SOA a, size_t n) {
+  return DF_N(vdf2sum_acc)(a, n, 2);
+}
+
+/*
+ * 批量点积sum(a[i]*b[i]),以k组SIMD累加器累加,同vdf2sum_acc; 每项以df2fma累加,
+ * 第i项的误差不超过约u^2(|a[i]*b[i]|+|前i-1项的部分和|),因此总误差不超过约
+ * n*u^2*sum(|a[i]*b[i]|),大量相消时相对于结果的误差可能很大.
+ */
+static inline DF_D DF_N(vdf2dot_acc)(DF_SOA a, DF_SOA b, size_t n, int k) {
+  DF_D ret = DF_N(ddual)(DF_K(0.0), DF_K(0.0));
+  size_t i = 0;
+#ifdef DUAL_BATCH_AVX
+  if (k != 1 && k != 4 && k != DUAL_BATCH_MAXACC)
+    k = 2;
+  if (n >= (size_t)k * DF_W)
+    switch (k) {
+    case 1:
+      ret = DF_VN(dfdot_acc)(a, b, n, &i, 1);
+      break;
+    case 4:
+      ret = DF_VN(dfdot_acc)(a, b, n, &i, 4);
+      break;
+    case DUAL_BATCH_MAXACC:
+      ret = DF_VN(dfdot_acc)(a, b, n, &i, DUAL_BATCH_MAXACC);
+      break;
+    default:
+      ret = DF_VN(dfdot_acc)(a, b, n, &i, 2);
+    }
+#else
+  (void)k;
+#endif
+  for (; i < n; i++)
+    ret = DF_N(df2fma)(DF_N(dsoaget)(a, i), DF_N(dsoaget)(b, i), ret);
+  return ret;
+}
+
+/* 批量点积: sum(a[i]*b[i])(两组累加器) */
+static inline DF_D DF_N(vdf2dot)(DF_SOA a, DF_SOA b, size_t n) {
+  return DF_N(vdf2dot_acc)(a, b, n, 2);
+}
+
+/* 一段n个元素的统计量: 先求和与最值,再以该段的均值求离差平方和 */
+static inline void DF_N(dfstats_block)(DF_STATS *t, DF_SOA a, size_t n) {
+  DF_D mean;
+  size_t i = 0;
+  DF_N(dfstats_init)(t);
+  t->count = n;
+#ifdef DUAL_BATCH_AVX
+  if (n >= DF_W) {
+    DF_V x = DF_VN(dload)(a, 0), sum = x, mn = x, mx = x;
+    for (i = DF_W; i + DF_W <= n; i += DF_W) {
+      x = DF_VN(dload)(a, i);
+      sum = DF_VN(df2add)(sum, x);
+      mn = DF_VN(dfmin)(mn, x);
+      mx = DF_VN(dfmax)(mx, x);
+    }
+    DF_T hi[2 * DF_W], lo[2 * DF_W];
+    t->sum = DF_VN(dfhsum)(sum);
+    DF_PS(storeu)(hi, mn.hi);
+    DF_PS(storeu)(lo, mn.lo);
+    DF_PS(storeu)(hi + DF_W, mx.hi);
+    DF_PS(storeu)(lo + DF_W, mx.lo);
+    for (int j = 0; j < 2 * DF_W; j++)
+      DF_N(dfstats_minmax)(t, DF_N(ddual)(hi[j], lo[j]));
+  }
+#endif
+  for (; i < n; i++) {
+    DF_D x = DF_N(dsoaget)(a, i);
+    t->sum = DF_N(df2add)(t->sum, x);
+    DF_N(dfstats_minmax)(t, x);
+  }
+  mean = DF_N(dfstats_mean)(t);
+  i = 0;
+#ifdef DUAL_BATCH_AVX
+  if (n >= DF_W) {
+    DF_V m = DF_VN(ddual)(DF_PS(set1)(mean.hi), DF_PS(set1)(mean.lo));
+    DF_V d = DF_VN(df2sub)(DF_VN(dload)(a, 0), m), m2 = DF_VN(df2mul)(d, d);
+    for (i = DF_W; i + DF_W <= n; i += DF_W) {
+      d = DF_VN(df2sub)(DF_VN(dload)(a, i), m);
+      m2 = DF_VN(df2add)(m2, DF_VN(df2mul)(d, d));
+    }
+    t->m2 = DF_VN(dfhsum)(m2);
+  }
+#endif
+  for (; i < n; i++) {
+    DF_D d = DF_N(df2sub)(DF_N(dsoaget)(a, i), mean);
+    t->m2 = DF_N(df2add)(t->m2, DF_N(df2mul)(d, d));
+  }
+}
+
+/*
+ * 批量统计: 将n个元素的个数,和,离差平方和,最小值,最大值合并到s
+ * 每DUAL_BATCH_STATBLOCK个元素为一段,段内两遍扫描,段间以dfstats_merge合并.
+ */
+static inline void DF_N(vdfstats)(DF_STATS *s, DF_SOA a, size_t n) {
+  DF_STATS t;
+  size_t i, k;
+  for (i = 0; i < n; i += k) {
+    k = n - i < DUAL_BATCH_STATBLOCK ? n - i : DUAL_BATCH_STATBLOCK;
+    DF_N(dfstats_block)(&t, DF_N(dsoaoff)(a, i), k);
+    DF_N(dfstats_merge)(s, &t);
+  }
+}
+
+/* AoS数组转为SoA数组 */
+static inline void DF_N(vdfsplit)(DF_SOA r, const DF_D *a, size_t n) {
+  size_t i;
+  for (i = 0; i < n; i++) {
+    r.hi[i] = a[i].hi;
+    r.lo[i] = a[i].lo;
+  }
+}
+
+/* SoA数组转为AoS数组 */
+static inline void DF_N(vdfmerge)(DF_D *r, DF_SOA a, size_t n) {
+  size_t i;
+  for (i = 0; i < n; i++) {
+    r[i].hi = a.hi[i];
+    r[i].lo = a.lo[i];
+  }
+}
+
+#undef DF_T
+#undef DF_D
+#undef DF_N
+#undef DF_K
+#undef DF_SOA
+#undef DF_STATS
+#undef DF_DIVR
+#undef DF_MULR
+#undef DF_V
+#undef DF_VT
+#undef DF_W
+#undef DF_VN
+#undef DF_PS
+#undef DF_MAX
+#undef DF_SPLITTER
+#undef DF_MANT
+#undef DF_EBIAS
+#undef DF_EPI
+#undef DF_SI
+#endif // !DF_T
@@ -0,0 +1,713 @@
+﻿/**
+ * dualfloat的微基准测试(C与C++均可编译,C++中另测运算符)
+ * 测量dualdouble.h/dualfloat.h的函数,libdualmath的导出函数(dualmath.c)
+ * 与批量函数(dualbatch.h)每次运算的耗时; 配置宏不同则结果不同,
+ * Makefile的bench目标以DUALFLOAT_USER_CONFIG按各种配置各编译一个程序.
+ *
+ * 每个函数以两种方式测量:
+ * lat 延迟: 每次运算的第一个运算数依赖上一次的结果(加上由结果算出的0),
+ *     已减去只有这个依赖的空运算(输出中的dep行)的耗时;
+ * thr 吞吐: 各次运算互相独立,结果写入数组(批量函数只测吞吐).
+ * 输入有三组: fixed为正数且|a|>|b|,分支总能预测;
+ * random为随机符号与随机指数(2^-30至2^30),暴露分支预测失败的代价;
+ * mixed同random,但随机一半的b低位为0(由单数转换而来).
+ *
+ * 结果以CSV输出(默认为标准输出),每行为
+ * config,type,func,mode,input,ns,cycles,cycles_src,instructions,branch_misses
+ * 後5列为每次运算的值: Linux上以perf_event读取硬件计数器(cycles_src为perf),
+ * 不可用时cycles为时间戳计数器的值(cycles_src为tsc),其余计数器列为空.
+ *
+ * 用法: dualbench [-n 元素数] [-t 每次采样的毫秒数] [-f 函数名子串] [-o 文件]
+ */
+
+#include "dualbatch.h"
+#include "dualmath.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define DB_TSC 1
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define DB_TSC 1
+#endif
+
+/* 配置名,如fma1/branch/fastop */
+#if FP_FMA_INTRINS == 1
+#define DB_CFG_FMA "fma1"
+#elif FP_FMA_INTRINS == 2
+#define DB_CFG_FMA "fma2"
+#elif USE_DF_SPLIT_FMA
+#define DB_CFG_FMA "split"
+#else
+#define DB_CFG_FMA "nofma"
+#endif
+#ifdef USE_BRANCH_DADD
+#define DB_CFG_DADD "/branch"
+#else
+#define DB_CFG_DADD "/nobranch"
+#endif
+#ifdef FAST_DF_OPERATOR
+#define DB_CFG_OP "/fastop"
+#else
+#define DB_CFG_OP "/accop"
+#endif
+#define DB_CONFIG DB_CFG_FMA DB_CFG_DADD DB_CFG_OP
+
+/* 一种单数类型的输入,p为a的绝对值(用于开方),k为ldexp的指数 */
+typedef struct db_set_double {
+  dualdouble *a, *b, *c, *p;
+  dualdouble_soa sa, sb, sc, sr;
+  dualdouble_divisor div;
+  dualdouble_multiplier mul;
+} db_set_double;
+
+typedef struct db_set_float {
+  dualfloat *a, *b, *c, *p;
+  dualfloat_soa sa, sb, sc, sr;
+  dualfloat_divisor div;
+  dualfloat_multiplier mul;
+} db_set_float;
+
+/* 测量的上下文,out为结果数组(每元素至多16字节) */
+typedef struct db_ctx {
+  size_t n;
+  db_set_double d;
+  db_set_float f;
+  int *k;
+  int *e;
+  void *out;
+} db_ctx;
+
+/* 测量函数: 对n个元素运算一遍,lat非0则测延迟 */
+typedef void (*db_fn)(db_ctx *ctx, int lat);
+
+typedef struct db_entry {
+  const char *name;
+  const char *type;
+  db_fn fn;
+  int lat; // 是否测延迟
+} db_entry;
+
+/* 结果依赖: 由结果算出的单数,减去自身得到0(有限时) */
+#define DB_DEP_D(r) ((r).hi + (r).lo)
+#define DB_DEP_T(r) (r)
+#define DB_DEP_I(r) ((DB_T)(r))
+
+/*
+ * 单个函数的测量: A为a的来源(a或p),R为结果类型,expr为运算,
+ * 可使用双数a,b,cc,单数x,y,w(分别为其高位),指数k与输出的整数e.
+ */
+#define DB_KERNEL(name, S, A, R, expr, dep)                                    \
+  static void db_##name##S(db_ctx *ctx, int lat) {                             \
+    const DB_D *pa = ctx->DB_SET.A, *pb = ctx->DB_SET.b, *pc = ctx->DB_SET.c;  \
+    R *out = (R *)ctx->out;                                                    \
+    size_t i, n = ctx->n;                                                      \
+    int e = 0;                                                                 \
+    if (lat) {                                                                 \
+      DB_T z = 0;                                                              \
+      R r = out[0];                                                            \
+      for (i = 0; i < n; i++) {                                                \
+        DB_D a = pa[i], b = pb[i], cc = pc[i];                                 \
+        DB_T x, y, w;                                                          \
+        int k = ctx->k[i];                                                     \
+        a.hi += z;                                                             \
+        x = a.hi, y = b.hi, w = cc.hi;                                         \
+        r = (expr);                                                            \
+        z = dep(r);                                                            \
+        z -= z;                                                                \
+        (void)x, (void)y, (void)w, (void)k, (void)cc;                          \
+      }                                                                        \
+      out[0] = r;                                                              \
+    } else {                                                                   \
+      for (i = 0; i < n; i++) {                                                \
+        DB_D a = pa[i], b = pb[i], cc = pc[i];                                 \
+        DB_T x = a.hi, y = b.hi, w = cc.hi;                                    \
+        int k = ctx->k[i];                                                     \
+        out[i] = (expr);                                                       \
+        (void)x, (void)y, (void)w, (void)k, (void)cc;                          \
+      }                                                                        \
+    }                                                                          \
+    ctx->e[0] = e;                                                             \
+  }
+
+/* 累加器的测量: 延迟为一个累加器,吞吐为轮流使用4个累加器 */
+#define DB_KERNEL_ACC(name, S, ACC, expr)                                      \
+  static void db_##name##S(db_ctx *ctx, int lat) {                             \
+    const DB_D *pa = ctx->DB_SET.a, *pb = ctx->DB_SET.b;                       \
+    DB_D *out = (DB_D *)ctx->out;                                              \
+    size_t i, n = ctx->n, m = lat ? 0 : 3;                                     \
+    ACC acc[4];                                                                \
+    for (i = 0; i < 4; i++)                                                    \
+      dfacc_init##S(&acc[i]);                                                  \
+    for (i = 0; i < n; i++) {                                                  \
+      DB_D a = pa[i], b = pb[i];                                               \
+      ACC *p = &acc[i & m];                                                    \
+      expr;                                                                    \
+      (void)b;                                                                 \
+    }                                                                          \
+    for (i = 0; i < 4; i++)                                                    \
+      out[i] = dfacc_get##S(&acc[i]);                                          \
+  }
+
+/* 批量函数的测量(只测吞吐): r为结果,o为单个结果,n为元素数 */
+#define DB_KERNEL_V(name, S, expr)                                             \
+  static void db_##name##S(db_ctx *ctx, int lat) {                             \
+    DB_SOA a = ctx->DB_SET.sa, b = ctx->DB_SET.sb, cc = ctx->DB_SET.sc;        \
+    DB_SOA r = ctx->DB_SET.sr;                                                 \
+    DB_D *o = (DB_D *)ctx->out;                                                \
+    const int *k = ctx->k;                                                     \
+    int *e = ctx->e;                                                           \
+    size_t n = ctx->n;                                                         \
+    (void)lat, (void)b, (void)cc, (void)r, (void)o, (void)k, (void)e;          \
+    expr;                                                                      \
+  }
+
+/* 测量表的项 */
+#define DB_ENTRY(name, S, ...) {#name #S, DB_TNAME, db_##name##S, 1},
+#define DB_ENTRY_ACC(name, S, ...) {#name #S, DB_TNAME, db_##name##S, 1},
+#define DB_ENTRY_V(name, S, ...) {#name #S, DB_TNAME, db_##name##S, 0},
+
+/* 依赖的开销,延迟的结果减去它 */
+#define DB_LIST_DEP(X, S) X(dep, S, a, DB_D, a, DB_DEP_D)
+
+/* dualfloat_basic.h的单数运算 */
+#define DB_LIST_BASIC(X, S)                                                    \
+  X(dadd, S, a, DB_D, dadd##S(x, y), DB_DEP_D)                                 \
+  X(dsub, S, a, DB_D, dsub##S(x, y), DB_DEP_D)                                 \
+  X(bdadd, S, a, DB_D, bdadd##S(x, y), DB_DEP_D)                               \
+  X(bdsub, S, a, DB_D, bdsub##S(x, y), DB_DEP_D)                               \
+  X(dmul, S, a, DB_D, dmul##S(x, y), DB_DEP_D)                                 \
+  X(dsqr, S, a, DB_D, dsqr##S(x), DB_DEP_D)                                    \
+  X(dmdiv, S, a, DB_D, dmdiv##S(x, y), DB_DEP_D)                               \
+  X(ddiv, S, a, DB_D, ddiv##S(x, y), DB_DEP_D)                                 \
+  X(dfnorm, S, a, DB_D, dfnorm##S(ddual##S(x, y)), DB_DEP_D)                   \
+  X(fmuladd, S, a, DB_T, fmuladd##S(x, y, w), DB_DEP_T)                        \
+  X(df1add, S, a, DB_T, df1add##S(a, y), DB_DEP_T)
+
+/* dualimpl.h的双数运算 */
+#define DB_LIST_IMPL(X, S)                                                     \
+  X(fdfadd, S, a, DB_D, fdfadd##S(a, y), DB_DEP_D)                             \
+  X(fdfsub, S, a, DB_D, fdfsub##S(a, y), DB_DEP_D)                             \
+  X(fdfsubr, S, a, DB_D, fdfsubr##S(x, b), DB_DEP_D)                           \
+  X(dfadd, S, a, DB_D, dfadd##S(a, y), DB_DEP_D)                               \
+  X(dfsub, S, a, DB_D, dfsub##S(a, y), DB_DEP_D)                               \
+  X(dfsubr, S, a, DB_D, dfsubr##S(x, b), DB_DEP_D)                             \
+  X(sdf2add, S, a, DB_D, sdf2add##S(a, b), DB_DEP_D)                           \
+  X(sdf2sub, S, a, DB_D, sdf2sub##S(a, b), DB_DEP_D)                           \
+  X(fdf2add, S, a, DB_D, fdf2add##S(a, b), DB_DEP_D)                           \
+  X(fdf2sub, S, a, DB_D, fdf2sub##S(a, b), DB_DEP_D)                           \
+  X(df2add, S, a, DB_D, df2add##S(a, b), DB_DEP_D)                             \
+  X(df2sub, S, a, DB_D, df2sub##S(a, b), DB_DEP_D)                             \
+  X(bdfadd, S, a, DB_D, bdfadd##S(a, y), DB_DEP_D)                             \
+  X(bdfsub, S, a, DB_D, bdfsub##S(a, y), DB_DEP_D)                             \
+  X(bdfsubr, S, a, DB_D, bdfsubr##S(x, b), DB_DEP_D)                           \
+  X(bdf2add, S, a, DB_D, bdf2add##S(a, b), DB_DEP_D)                           \
+  X(bdf2sub, S, a, DB_D, bdf2sub##S(a, b), DB_DEP_D)                           \
+  X(fdfmul, S, a, DB_D, fdfmul##S(a, y), DB_DEP_D)                             \
+  X(fdfdiv, S, a, DB_D, fdfdiv##S(a, y), DB_DEP_D)                             \
+  X(fdfdivr, S, a, DB_D, fdfdivr##S(x, b), DB_DEP_D)                           \
+  X(fdf2mul, S, a, DB_D, fdf2mul##S(a, b), DB_DEP_D)                           \
+  X(fdf2div, S, a, DB_D, fdf2div##S(a, b), DB_DEP_D)                           \
+  X(fdfsqr, S, a, DB_D, fdfsqr##S(a), DB_DEP_D)                                \
+  X(dfmul, S, a, DB_D, dfmul##S(a, y), DB_DEP_D)                               \
+  X(dfdiv, S, a, DB_D, dfdiv##S(a, y), DB_DEP_D)                               \
+  X(dfdivr, S, a, DB_D, dfdivr##S(x, b), DB_DEP_D)                             \
+  X(df2mul, S, a, DB_D, df2mul##S(a, b), DB_DEP_D)                             \
+  X(df2div, S, a, DB_D, df2div##S(a, b), DB_DEP_D)                             \
+  X(cdf2add, S, a, DB_D, cdf2add##S(a, b), DB_DEP_D)                           \
+  X(cdf2sub, S, a, DB_D, cdf2sub##S(a, b), DB_DEP_D)                           \
+  X(cdf2mul, S, a, DB_D, cdf2mul##S(a, b), DB_DEP_D)                           \
+  X(cdf2div, S, a, DB_D, cdf2div##S(a, b), DB_DEP_D)                           \
+  X(dfsqr, S, a, DB_D, dfsqr##S(a), DB_DEP_D)                                  \
+  X(df2fma, S, a, DB_D, df2fma##S(a, b, cc), DB_DEP_D)                         \
+  X(drcp, S, a, DB_D, drcp##S(x), DB_DEP_D)                                    \
+  X(dfrcp, S, a, DB_D, dfrcp##S(a), DB_DEP_D)                                  \
+  X(dfsqrt, S, p, DB_D, dfsqrt##S(a), DB_DEP_D)                                \
+  X(dffloor, S, a, DB_D, dffloor##S(a), DB_DEP_D)                              \
+  X(dfceil, S, a, DB_D, dfceil##S(a), DB_DEP_D)                                \
+  X(dftrunc, S, a, DB_D, dftrunc##S(a), DB_DEP_D)                              \
+  X(dfround, S, a, DB_D, dfround##S(a), DB_DEP_D)                              \
+  X(dfldexp, S, a, DB_D, dfldexp##S(a, k), DB_DEP_D)                           \
+  X(dfilogb, S, a, int, dfilogb##S(a), DB_DEP_I)                               \
+  X(dffrexp, S, a, DB_D, dffrexp##S(a, &e), DB_DEP_D)                          \
+  X(dffmod, S, a, DB_D, dffmod##S(a, b), DB_DEP_D)                             \
+  X(dfremquo, S, a, DB_D, dfremquo##S(a, b, &e), DB_DEP_D)                     \
+  X(dfdivby, S, a, DB_D, dfdivby##S(a, &ctx->DB_SET.div), DB_DEP_D)            \
+  X(dfmulby, S, a, DB_D, dfmulby##S(a, &ctx->DB_SET.mul), DB_DEP_D)
+
+/* 累加器 */
+#define DB_LIST_ACC(X, S)                                                      \
+  X(dfacc_add, S, DB_ACC, dfacc_add##S(p, a))                                  \
+  X(dfacc_dot, S, DB_ACC, dfacc_dot##S(p, a, b))
+
+/* libdualmath的导出函数(不内联的函数调用) */
+#define DB_LIST_EXPORT(X, S)                                                   \
+  X(setdual, S, a, DB_D, setdual##S(x, y), DB_DEP_D)                           \
+  X(_dadd, S, a, DB_D, _dadd##S(x, y), DB_DEP_D)                               \
+  X(_dsub, S, a, DB_D, _dsub##S(x, y), DB_DEP_D)                               \
+  X(_dmul, S, a, DB_D, _dmul##S(x, y), DB_DEP_D)                               \
+  X(_dmdiv, S, a, DB_D, _dmdiv##S(x, y), DB_DEP_D)                             \
+  X(_ddiv, S, a, DB_D, _ddiv##S(x, y), DB_DEP_D)                               \
+  X(_dfadd, S, a, DB_D, _dfadd##S(a, y), DB_DEP_D)                             \
+  X(_dfsub, S, a, DB_D, _dfsub##S(a, y), DB_DEP_D)                             \
+  X(_dfsubr, S, a, DB_D, _dfsubr##S(x, b), DB_DEP_D)                           \
+  X(_df2add, S, a, DB_D, _df2add##S(a, b), DB_DEP_D)                           \
+  X(_df2sub, S, a, DB_D, _df2sub##S(a, b), DB_DEP_D)                           \
+  X(_dfmul, S, a, DB_D, _dfmul##S(a, y), DB_DEP_D)                             \
+  X(_dfdiv, S, a, DB_D, _dfdiv##S(a, y), DB_DEP_D)                             \
+  X(_dfdivr, S, a, DB_D, _dfdivr##S(x, b), DB_DEP_D)                           \
+  X(_df2mul, S, a, DB_D, _df2mul##S(a, b), DB_DEP_D)                           \
+  X(_df2div, S, a, DB_D, _df2div##S(a, b), DB_DEP_D)                           \
+  X(_dfsqr, S, a, DB_D, _dfsqr##S(a), DB_DEP_D)                                \
+  X(_drcp, S, a, DB_D, _drcp##S(x), DB_DEP_D)                                  \
+  X(_dfrcp, S, a, DB_D, _dfrcp##S(a), DB_DEP_D)
+
+/* C++的运算符(由FAST_DF_OPERATOR选择精度等级) */
+#if defined(__cplusplus) || defined(c_plusplus)
+#define DB_LIST_CXX(X, S)                                                      \
+  X(op_add, S, a, DB_D, a + b, DB_DEP_D)                                       \
+  X(op_sub, S, a, DB_D, a - b, DB_DEP_D)                                       \
+  X(op_mul, S, a, DB_D, a * b, DB_DEP_D)                                       \
+  X(op_div, S, a, DB_D, a / b, DB_DEP_D)                                       \
+  X(op_add1, S, a, DB_D, a + y, DB_DEP_D)                                      \
+  X(op_mul1, S, a, DB_D, a * y, DB_DEP_D)                                      \
+  X(op_muladd, S, a, DB_D, a * b + cc, DB_DEP_D)
+#else
+#define DB_LIST_CXX(X, S)
+#endif
+
+/* dualbatch.h的批量函数 */
+#define DB_LIST_BATCH(X, S)                                                    \
+  X(vdf2add, S, vdf2add##S(r, a, b, n))                                        \
+  X(vdf2sub, S, vdf2sub##S(r, a, b, n))                                        \
+  X(vbdf2add, S, vbdf2add##S(r, a, b, n))                                      \
+  X(vbdf2sub, S, vbdf2sub##S(r, a, b, n))                                      \
+  X(vdf2mul, S, vdf2mul##S(r, a, b, n))                                        \
+  X(vdf2div, S, vdf2div##S(r, a, b, n))                                        \
+  X(vdf2add_exact, S, vdf2add_exact##S(r, a, b.hi, n))                         \
+  X(vdf2sub_exact, S, vdf2sub_exact##S(r, a, b.hi, n))                         \
+  X(vdf2mul_exact, S, vdf2mul_exact##S(r, a, b.hi, n))                         \
+  X(vdf2div_exact, S, vdf2div_exact##S(r, a, b.hi, n))                         \
+  X(vdf2fma, S, vdf2fma##S(r, a, b, cc, n))                                    \
+  X(vdfdivby, S, vdfdivby##S(r, a, &ctx->DB_SET.div, n))                       \
+  X(vdfmulby, S, vdfmulby##S(r, a, &ctx->DB_SET.mul, n))                       \
+  X(vdffloor, S, vdffloor##S(r, a, n))                                         \
+  X(vdfround, S, vdfround##S(r, a, n))                                         \
+  X(vdffmod, S, vdffmod##S(r, a, b, n))                                        \
+  X(vdfldexp, S, vdfldexp##S(r, a, k, n))                                      \
+  X(vdfilogb, S, vdfilogb##S(e, a, n))                                         \
+  X(vdf2sum, S, o[0] = vdf2sum##S(a, n))                                       \
+  X(vdf2dot, S, o[0] = vdf2dot##S(a, b, n))
+
+/* 一种类型的全部测量函数与测量表 */
+#define DB_KERNELS(S)                                                          \
+  DB_LIST_DEP(DB_KERNEL, S)                                                    \
+  DB_LIST_BASIC(DB_KERNEL, S)                                                  \
+  DB_LIST_IMPL(DB_KERNEL, S)                                                   \
+  DB_LIST_ACC(DB_KERNEL_ACC, S)                                                \
+  DB_LIST_EXPORT(DB_KERNEL, S)                                                 \
+  DB_LIST_CXX(DB_KERNEL, S)                                                    \
+  DB_LIST_BATCH(DB_KERNEL_V, S)
+
+#define DB_ENTRIES(S)                                                          \
+  DB_LIST_DEP(DB_ENTRY, S)                                                     \
+  DB_LIST_BASIC(DB_ENTRY, S)                                                   \
+  DB_LIST_IMPL(DB_ENTRY, S)                                                    \
+  DB_LIST_ACC(DB_ENTRY_ACC, S)                                                 \
+  DB_LIST_EXPORT(DB_ENTRY, S)                                                  \
+  DB_LIST_CXX(DB_ENTRY, S)                                                     \
+  DB_LIST_BATCH(DB_ENTRY_V, S)
+
+#define DB_T double
+#define DB_D dualdouble
+#define DB_SOA dualdouble_soa
+#define DB_ACC dualdouble_acc
+#define DB_SET d
+#define DB_TNAME "double"
+DB_KERNELS()
+static const db_entry db_double_entries[] = {DB_ENTRIES()};
+#undef DB_T
+#undef DB_D
+#undef DB_SOA
+#undef DB_ACC
+#undef DB_SET
+#undef DB_TNAME
+
+#define DB_T float
+#define DB_D dualfloat
+#define DB_SOA dualfloat_soa
+#define DB_ACC dualfloat_acc
+#define DB_SET f
+#define DB_TNAME "float"
+DB_KERNELS(f)
+static const db_entry db_float_entries[] = {DB_ENTRIES(f)};
+#undef DB_T
+#undef DB_D
+#undef DB_SOA
+#undef DB_ACC
+#undef DB_SET
+#undef DB_TNAME
+
+/* 单调时钟(纳秒) */
+static double db_now(void) {
+#ifdef _WIN32
+  LARGE_INTEGER t, f;
+  QueryPerformanceCounter(&t);
+  QueryPerformanceFrequency(&f);
+  return (double)t.QuadPart * 1e9 / (double)f.QuadPart;
+#else
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return (double)t.tv_sec * 1e9 + (double)t.tv_nsec;
+#endif
+}
+
+/* 时间戳计数器,无则为0 */
+static uint64_t db_tsc(void) {
+#ifdef DB_TSC
+  return __rdtsc();
+#else
+  return 0;
+#endif
+}
+
+/* 硬件计数器: 周期,指令,分支预测失败,打不开的为-1 */
+#define DB_NPERF 3
+
+typedef struct db_perf {
+  int fd[DB_NPERF];
+} db_perf;
+
+static void db_perf_open(db_perf *p) {
+  int i;
+#ifdef __linux__
+  static const uint64_t cfg[DB_NPERF] = {PERF_COUNT_HW_CPU_CYCLES,
+                                         PERF_COUNT_HW_INSTRUCTIONS,
+                                         PERF_COUNT_HW_BRANCH_MISSES};
+  for (i = 0; i < DB_NPERF; i++) {
+    struct perf_event_attr at;
+    memset(&at, 0, sizeof(at));
+    at.type = PERF_TYPE_HARDWARE;
+    at.size = sizeof(at);
+    at.config = cfg[i];
+    at.disabled = 1;
+    at.exclude_kernel = 1;
+    at.exclude_hv = 1;
+    p->fd[i] = (int)syscall(__NR_perf_event_open, &at, 0, -1, -1, 0);
+  }
+#else
+  for (i = 0; i < DB_NPERF; i++)
+    p->fd[i] = -1;
+#endif
+}
+
+static void db_perf_close(db_perf *p) {
+#ifdef __linux__
+  int i;
+  for (i = 0; i < DB_NPERF; i++)
+    if (p->fd[i] >= 0)
+      close(p->fd[i]);
+#else
+  (void)p;
+#endif
+}
+
+static void db_perf_start(db_perf *p) {
+#ifdef __linux__
+  int i;
+  for (i = 0; i < DB_NPERF; i++) {
+    if (p->fd[i] < 0)
+      continue;
+    ioctl(p->fd[i], PERF_EVENT_IOC_RESET, 0);
+    ioctl(p->fd[i], PERF_EVENT_IOC_ENABLE, 0);
+  }
+#else
+  (void)p;
+#endif
+}
+
+/* 停止计数并读出,打不开的计数器为-1 */
+static void db_perf_stop(db_perf *p, double *v) {
+  int i;
+  for (i = 0; i < DB_NPERF; i++) {
+    v[i] = -1;
+#ifdef __linux__
+    if (p->fd[i] >= 0) {
+      uint64_t c;
+      ioctl(p->fd[i], PERF_EVENT_IOC_DISABLE, 0);
+      if (read(p->fd[i], &c, sizeof(c)) == (ssize_t)sizeof(c))
+        v[i] = (double)c;
+    }
+#endif
+  }
+}
+
+/* 一次测量的结果(每次运算): 时间,周期(perf或tsc),指令,分支预测失败 */
+typedef struct db_result {
+  double ns;
+  double cycles;
+  double instr;
+  double bmiss;
+  int perf; // cycles是否来自perf
+} db_result;
+
+/* 测量: 按目标时间确定重复次数,取若干次采样中最快的一次 */
+static db_result db_measure(db_ctx *ctx, db_perf *pf, db_fn fn, int lat,
+                            double target) {
+  db_result best;
+  size_t it, iters = 1;
+  int s;
+  for (;;) {
+    double t = db_now();
+    for (it = 0; it < iters; it++)
+      fn(ctx, lat);
+    t = db_now() - t;
+    if (t >= target || iters >= ((size_t)1 << 30))
+      break;
+    iters *= t < target / 16 ? 8 : 2;
+  }
+  best.ns = -1;
+  for (s = 0; s < 5; s++) {
+    double v[DB_NPERF], t, ops = (double)iters * (double)ctx->n;
+    uint64_t c;
+    db_perf_start(pf);
+    c = db_tsc();
+    t = db_now();
+    for (it = 0; it < iters; it++)
+      fn(ctx, lat);
+    t = db_now() - t;
+    c = db_tsc() - c;
+    db_perf_stop(pf, v);
+    if (best.ns >= 0 && t / ops >= best.ns)
+      continue;
+    best.ns = t / ops;
+    best.perf = v[0] >= 0;
+    best.cycles = best.perf ? v[0] / ops : c ? (double)c / ops : -1;
+    best.instr = v[1] >= 0 ? v[1] / ops : -1;
+    best.bmiss = v[2] >= 0 ? v[2] / ops : -1;
+  }
+  return best;
+}
+
+/* 可能为空的CSV数值列 */
+static void db_field(FILE *f, double v) {
+  if (v >= 0)
+    fprintf(f, ",%.3f", v);
+  else
+    fputc(',', f);
+}
+
+static void db_print(FILE *f, const db_entry *e, int lat, const char *input,
+                     db_result r) {
+  fprintf(f, "%s,%s,%s,%s,%s,%.3f", DB_CONFIG, e->type, e->name,
+          lat ? "lat" : "thr", input, r.ns);
+  db_field(f, r.cycles);
+  fprintf(f, ",%s", r.perf ? "perf" : r.cycles >= 0 ? "tsc" : "");
+  db_field(f, r.instr);
+  db_field(f, r.bmiss);
+  fputc('\n', f);
+}
+
+/* 减去依赖的开销(不小于0) */
+static double db_sub(double v, double d) {
+  if (v < 0 || d < 0)
+    return v;
+  return v > d ? v - d : 0;
+}
+
+/* 测量一组函数,第一项为dep */
+static void db_run(db_ctx *ctx, db_perf *pf, const db_entry *es, size_t m,
+                   const char *input, const char *filter, double target,
+                   FILE *f) {
+  db_result dep;
+  size_t i;
+  int lat;
+  dep = db_measure(ctx, pf, es[0].fn, 1, target);
+  db_print(f, &es[0], 1, input, dep);
+  for (i = 1; i < m; i++) {
+    if (filter && !strstr(es[i].name, filter))
+      continue;
+    for (lat = 1; lat >= 0; lat--) {
+      db_result r;
+      if (lat && !es[i].lat)
+        continue;
+      r = db_measure(ctx, pf, es[i].fn, lat, target);
+      if (lat) {
+        r.ns = db_sub(r.ns, dep.ns);
+        r.cycles = db_sub(r.cycles, dep.cycles);
+        r.instr = db_sub(r.instr, dep.instr);
+      }
+      db_print(f, &es[i], lat, input, r);
+    }
+  }
+  fflush(f);
+}
+
+/* xorshift64*随机数,均匀分布于[0,1) */
+static double db_rand(uint64_t *s) {
+  *s ^= *s >> 12;
+  *s ^= *s << 25;
+  *s ^= *s >> 27;
+  return (double)((*s * 0x2545F4914F6CDD1DULL) >> 11) * 0x1p-53;
+}
+
+/*
+ * 生成单数的输入: fixed时a,c在[1,2),b在[0.5,1);
+ * random时符号随机,指数在[-30,30]内随机.
+ */
+static double db_gen(uint64_t *s, int random, double lo) {
+  double x = 1 + db_rand(s);
+  if (!random)
+    return x * lo;
+  x = ldexp(x, (int)(db_rand(s) * 61) - 30);
+  return db_rand(s) < 0.5 ? -x : x;
+}
+
+/*
+ * 生成双数的输入,低位不超过高位的半个ulp;
+ * input为0,1,2分别为fixed,random,mixed(随机一半的b低位为0)
+ */
+static void db_fill(db_ctx *ctx, int input) {
+  uint64_t s = 0x9E3779B97F4A7C15ULL;
+  size_t i;
+  for (i = 0; i < ctx->n; i++) {
+    double a = db_gen(&s, input != 0, 1), b = db_gen(&s, input != 0, 0.5);
+    double c = db_gen(&s, input != 0, 1), u[3];
+    int j;
+    for (j = 0; j < 3; j++)
+      u[j] = db_rand(&s) - 0.5;
+    if (input == 2 && db_rand(&s) < 0.5)
+      u[1] = 0;
+    ctx->d.a[i] = ddual(a, a * u[0] * 0x1p-52);
+    ctx->d.b[i] = ddual(b, b * u[1] * 0x1p-52);
+    ctx->d.c[i] = ddual(c, c * u[2] * 0x1p-52);
+    ctx->f.a[i] = ddualf((float)a, (float)a * (float)u[0] * 0x1p-23f);
+    ctx->f.b[i] = ddualf((float)b, (float)b * (float)u[1] * 0x1p-23f);
+    ctx->f.c[i] = ddualf((float)c, (float)c * (float)u[2] * 0x1p-23f);
+    ctx->d.p[i] = a < 0 ? dfneg(ctx->d.a[i]) : ctx->d.a[i];
+    ctx->f.p[i] = a < 0 ? dfnegf(ctx->f.a[i]) : ctx->f.a[i];
+    ctx->k[i] = (int)(db_rand(&s) * 17) - 8;
+  }
+  vdfsplit(ctx->d.sa, ctx->d.a, ctx->n);
+  vdfsplit(ctx->d.sb, ctx->d.b, ctx->n);
+  vdfsplit(ctx->d.sc, ctx->d.c, ctx->n);
+  vdfsplitf(ctx->f.sa, ctx->f.a, ctx->n);
+  vdfsplitf(ctx->f.sb, ctx->f.b, ctx->n);
+  vdfsplitf(ctx->f.sc, ctx->f.c, ctx->n);
+  ctx->d.div = dfdivisor(ctx->d.b[0]);
+  ctx->d.mul = dfmultiplier(ctx->d.b[0]);
+  ctx->f.div = dfdivisorf(ctx->f.b[0]);
+  ctx->f.mul = dfmultiplierf(ctx->f.b[0]);
+}
+
+/* 分配n个元素的输入与输出,失败返回-1 */
+static int db_alloc(db_ctx *ctx, size_t n) {
+  double *dp = (double *)calloc(n, 4 * sizeof(dualdouble) +
+                                       8 * sizeof(double));
+  float *fp = (float *)calloc(n, 4 * sizeof(dualfloat) + 8 * sizeof(float));
+  int *ip = (int *)calloc(n, 2 * sizeof(int));
+  void *out = calloc(n, 2 * sizeof(double));
+  if (!dp || !fp || !ip || !out) {
+    free(dp);
+    free(fp);
+    free(ip);
+    free(out);
+    return -1;
+  }
+  ctx->n = n;
+  ctx->d.a = (dualdouble *)dp;
+  ctx->d.b = ctx->d.a + n;
+  ctx->d.c = ctx->d.b + n;
+  ctx->d.p = ctx->d.c + n;
+  dp = (double *)(ctx->d.p + n);
+  ctx->d.sa = dsoa(dp, dp + n);
+  ctx->d.sb = dsoa(dp + 2 * n, dp + 3 * n);
+  ctx->d.sc = dsoa(dp + 4 * n, dp + 5 * n);
+  ctx->d.sr = dsoa(dp + 6 * n, dp + 7 * n);
+  ctx->f.a = (dualfloat *)fp;
+  ctx->f.b = ctx->f.a + n;
+  ctx->f.c = ctx->f.b + n;
+  ctx->f.p = ctx->f.c + n;
+  fp = (float *)(ctx->f.p + n);
+  ctx->f.sa = dsoaf(fp, fp + n);
+  ctx->f.sb = dsoaf(fp + 2 * n, fp + 3 * n);
+  ctx->f.sc = dsoaf(fp + 4 * n, fp + 5 * n);
+  ctx->f.sr = dsoaf(fp + 6 * n, fp + 7 * n);
+  ctx->k = ip;
+  ctx->e = ip + n;
+  ctx->out = out;
+  return 0;
+}
+
+static void db_free(db_ctx *ctx) {
+  free(ctx->d.a);
+  free(ctx->f.a);
+  free(ctx->k);
+  free(ctx->out);
+}
+
+int main(int argc, char **argv) {
+  static const char *inputs[3] = {"fixed", "random", "mixed"};
+  size_t n = 1024;
+  double target = 2e6;
+  const char *filter = NULL, *path = NULL;
+  FILE *f = stdout;
+  db_ctx ctx;
+  db_perf pf;
+  int i;
+  for (i = 1; i + 1 < argc; i += 2) {
+    if (!strcmp(argv[i], "-n"))
+      n = (size_t)strtoul(argv[i + 1], NULL, 10);
+    else if (!strcmp(argv[i], "-t"))
+      target = atof(argv[i + 1]) * 1e6;
+    else if (!strcmp(argv[i], "-f"))
+      filter = argv[i + 1];
+    else if (!strcmp(argv[i], "-o"))
+      path = argv[i + 1];
+    else
+      break;
+  }
+  if (i < argc || n == 0 || !(target > 0)) {
+    fprintf(stderr, "usage: %s [-n count] [-t ms] [-f filter] [-o file]\n",
+            argv[0]);
+    return 2;
+  }
+  if (path && !(f = fopen(path, "w"))) {
+    perror(path);
+    return 1;
+  }
+  if (db_alloc(&ctx, n)) {
+    fprintf(stderr, "out of memory\n");
+    return 1;
+  }
+  db_perf_open(&pf);
+  fprintf(f, "config,type,func,mode,input,ns,cycles,cycles_src,instructions,"
+             "branch_misses\n");
+  for (i = 0; i < 3; i++) {
+    db_fill(&ctx, i);
+    db_run(&ctx, &pf, db_double_entries,
+           sizeof(db_double_entries) / sizeof(db_entry), inputs[i], filter,
+           target, f);
+    db_run(&ctx, &pf, db_float_entries,
+           sizeof(db_float_entries) / sizeof(db_entry), inputs[i], filter,
+           target, f);
+  }
+  db_perf_close(&pf);
+  db_free(&ctx);
+  if (f != stdout)
+    fclose(f);
+  return 0;
+}
@@ -0,0 +1,339 @@
+﻿#ifndef _DUAL_CODEC_H_
+#define _DUAL_CODEC_H_
+#include "dualbatch.h"
+#include <string.h>
+
+/**
+ * dualdouble数组的低位平面压缩编码
+ * 多数数据来自精确的double,低位为0或很小,低位平面的信息量远小于8字节/元素.
+ * 高位平面原样保存,低位平面按块编码:
+ *   零位图: 每元素1位,标记低位是否非0(按位判断,-0.0视为非0);
+ *   阶码差: 每个非0低位1字节,为高位与低位阶码之差(1~255),0表示原样保存;
+ *   字节平面: 非0低位的符号与52位尾数共7字节,按字节转置为7个平面,
+ *             全0的平面不保存(低位尾数较短时可省去若干平面);
+ *   原样区: 阶码差无法表示的低位(非规格化数,无穷,NaN等)按8字节保存.
+ * 若某块编码後反而更大,则该块低位平面原样保存.
+ * 有AVX2时零位图的生成与字节平面的合成以SIMD进行.
+ *
+ * 格式(小端序):
+ *   流头: "DDLC" | uint32 块长 | uint64 元素个数
+ *   每块: uint32 低位区字节数 | 高位 k*8字节 | 低位区
+ *   低位区: uint8 模式(0编码,1原样) | 原样: k*8字节
+ *           编码: 零位图(k+7)/8字节 | [uint8 平面掩码 | 阶码差 | 平面 | 原样区]
+ */
+
+#define DUALCODEC_MAGIC "DDLC"
+#define DUALCODEC_BLOCK 1024
+#define DUALCODEC_HEADER 16
+
+/* 错误码 */
+#define DUALCODEC_OK 0
+#define DUALCODEC_EFORMAT (-2) // 数据损坏或不是编码流
+#define DUALCODEC_EENDIAN (-3) // 大端平台不支持
+#define DUALCODEC_ESIZE (-4)   // 输出容量与元素个数不符
+
+/* 编码n个元素所需的最大字节数 */
+static inline size_t dualcodec_bound(size_t n) {
+  size_t nblocks = (n + DUALCODEC_BLOCK - 1) / DUALCODEC_BLOCK;
+  return DUALCODEC_HEADER + nblocks * 5 + n * 16;
+}
+
+static inline uint64_t dualcodec_bits(double x) {
+  uint64_t r;
+  memcpy(&r, &x, sizeof(r));
+  return r;
+}
+
+static inline double dualcodec_double(uint64_t x) {
+  double r;
+  memcpy(&r, &x, sizeof(r));
+  return r;
+}
+
+static inline uint32_t dualcodec_rd32(const unsigned char *p) {
+  uint32_t r;
+  memcpy(&r, p, sizeof(r));
+  return r;
+}
+
+/* x中1的位数 */
+static inline unsigned int dualcodec_popcount(unsigned int x) {
+  unsigned int n = 0;
+#if defined(__GNUC__) && defined(__has_builtin)
+#if __has_builtin(__builtin_popcount)
+  return (unsigned int)__builtin_popcount(x);
+#endif
+#endif
+  for (; x; x &= x - 1)
+    n++;
+  return n;
+}
+
+/* x最低的1所在的位,x不为0 */
+static inline unsigned int dualcodec_ctz(unsigned int x) {
+  unsigned int n = 0;
+#if defined(__GNUC__) && defined(__has_builtin)
+#if __has_builtin(__builtin_ctz)
+  return (unsigned int)__builtin_ctz(x);
+#endif
+#endif
+  for (; !(x & 1); x >>= 1)
+    n++;
+  return n;
+}
+
+/* 生成k个低位的零位图,返回非0低位个数 */
+static inline size_t dualcodec_bitmap(unsigned char *map, const double *lo,
+                                      size_t k) {
+  size_t i = 0, m = 0;
+  unsigned int bits;
+#if defined(DUAL_BATCH_AVX) && defined(__AVX2__)
+  const __m256i zero = _mm256_setzero_si256();
+  for (; i + 8 <= k; i += 8) {
+    __m256i v0 = _mm256_loadu_si256((const __m256i *)(lo + i));
+    __m256i v1 = _mm256_loadu_si256((const __m256i *)(lo + i + 4));
+    bits = (unsigned int)_mm256_movemask_pd(
+               _mm256_castsi256_pd(_mm256_cmpeq_epi64(v0, zero))) |
+           (unsigned int)_mm256_movemask_pd(
+               _mm256_castsi256_pd(_mm256_cmpeq_epi64(v1, zero)))
+               << 4;
+    bits = ~bits & 0xff;
+    map[i >> 3] = (unsigned char)bits;
+    m += dualcodec_popcount(bits);
+  }
+#endif
+  for (; i < k; i += 8) {
+    size_t j, e = k - i < 8 ? k - i : 8;
+    bits = 0;
+    for (j = 0; j < e; j++)
+      bits |= (dualcodec_bits(lo[i + j]) != 0) << j;
+    map[i >> 3] = (unsigned char)bits;
+    m += dualcodec_popcount(bits);
+  }
+  return m;
+}
+
+/* 编码一块的低位区,返回字节数 */
+static inline size_t dualcodec_encode_lo(unsigned char *dst, const double *hi,
+                                         const double *lo, size_t k) {
+  uint64_t field[DUALCODEC_BLOCK], any = 0;
+  unsigned char *map = dst + 1, *code, *p;
+  size_t i, j, m, nesc = 0, nplane = 0, size;
+  unsigned int planes = 0, bits;
+  m = dualcodec_bitmap(map, lo, k);
+  code = map + (k + 7) / 8 + 1;
+  for (i = 0, j = 0; i < k; i += 8) {
+    for (bits = map[i >> 3]; bits; bits &= bits - 1) {
+      size_t t = i + dualcodec_ctz(bits);
+      uint64_t lb = dualcodec_bits(lo[t]), hb = dualcodec_bits(hi[t]);
+      int64_t eh = (int64_t)(hb >> 52 & 0x7ff);
+      int64_t el = (int64_t)(lb >> 52 & 0x7ff);
+      int64_t d = eh - el;
+      if (el != 0 && eh != 0x7ff && d >= 1 && d <= 255) {
+        code[j] = (unsigned char)d;
+        field[j] = (lb >> 63) << 52 | (lb & 0xfffffffffffffULL);
+        any |= field[j];
+      } else {
+        code[j] = 0;
+        field[j] = 0;
+        nesc++;
+      }
+      j++;
+    }
+  }
+  for (i = 0; i < 7; i++)
+    if (any >> (i * 8) & 0xff) {
+      planes |= 1u << i;
+      nplane++;
+    }
+  size = 1 + (k + 7) / 8 + (m ? 1 + m * (1 + nplane) + nesc * 8 : 0);
+  if (size > 1 + k * 8) { // 原样保存
+    dst[0] = 1;
+    memcpy(dst + 1, lo, k * 8);
+    return 1 + k * 8;
+  }
+  dst[0] = 0;
+  if (!m)
+    return size;
+  code[-1] = (unsigned char)planes;
+  p = code + m;
+  for (bits = planes; bits; bits &= bits - 1) {
+    unsigned int shift = dualcodec_ctz(bits) * 8;
+    for (j = 0; j < m; j++)
+      p[j] = (unsigned char)(field[j] >> shift);
+    p += m;
+  }
+  for (i = 0, j = 0; i < k; i += 8) {
+    for (bits = map[i >> 3]; bits; bits &= bits - 1, j++) {
+      if (!code[j]) {
+        memcpy(p, lo + i + dualcodec_ctz(bits), 8);
+        p += 8;
+      }
+    }
+  }
+  return size;
+}
+
+/**
+ * 编码n个元素,dst至少有dualcodec_bound(n)字节,返回编码後的字节数.
+ * 大端平台返回0.
+ */
+static inline size_t dualcodec_encode(void *dst, dualdouble_soa a, size_t n) {
+  unsigned char *p = (unsigned char *)dst;
+  uint32_t blk = DUALCODEC_BLOCK, lobytes;
+  uint64_t cnt = n;
+  size_t i, k;
+#ifdef __BIG_ENDIAN__
+  return 0;
+#endif
+  memcpy(p, DUALCODEC_MAGIC, 4);
+  memcpy(p + 4, &blk, 4);
+  memcpy(p + 8, &cnt, 8);
+  p += DUALCODEC_HEADER;
+  for (i = 0; i < n; i += k) {
+    k = n - i < DUALCODEC_BLOCK ? n - i : DUALCODEC_BLOCK;
+    memcpy(p + 4, a.hi + i, k * 8);
+    lobytes =
+        (uint32_t)dualcodec_encode_lo(p + 4 + k * 8, a.hi + i, a.lo + i, k);
+    memcpy(p, &lobytes, 4);
+    p += 4 + k * 8 + lobytes;
+  }
+  return (size_t)(p - (unsigned char *)dst);
+}
+
+/* 读取编码流中的元素个数 */
+static inline int dualcodec_count(const void *src, size_t len, uint64_t *n) {
+  const unsigned char *p = (const unsigned char *)src;
+  if (len < DUALCODEC_HEADER || memcmp(p, DUALCODEC_MAGIC, 4) != 0 ||
+      dualcodec_rd32(p + 4) != DUALCODEC_BLOCK)
+    return DUALCODEC_EFORMAT;
+  memcpy(n, p + 8, 8);
+  return DUALCODEC_OK;
+}
+
+/* 由字节平面合成m个低位的符号与尾数(plane[b]为NULL表示该平面全0) */
+static inline void dualcodec_unplane(uint64_t *field,
+                                     const unsigned char *const *plane,
+                                     size_t m) {
+  size_t j = 0;
+  unsigned int b;
+#if defined(DUAL_BATCH_AVX) && defined(__AVX2__)
+  for (; j + 4 <= m; j += 4) {
+    __m256i f = _mm256_setzero_si256();
+    for (b = 0; b < 7; b++) {
+      __m256i v;
+      if (!plane[b])
+        continue;
+      v = _mm256_cvtepu8_epi64(
+          _mm_cvtsi32_si128((int)dualcodec_rd32(plane[b] + j)));
+      f = _mm256_or_si256(f, _mm256_sll_epi64(v, _mm_cvtsi32_si128(b * 8)));
+    }
+    _mm256_storeu_si256((__m256i *)(field + j), f);
+  }
+#endif
+  for (; j < m; j++) {
+    uint64_t f = 0;
+    for (b = 0; b < 7; b++)
+      if (plane[b])
+        f |= (uint64_t)plane[b][j] << (b * 8);
+    field[j] = f;
+  }
+}
+
+/* 解码一块的低位区 */
+static inline int dualcodec_decode_lo(double *lo, const double *hi, size_t k,
+                                      const unsigned char *src, size_t len) {
+  const unsigned char *map = src + 1, *code, *plane[7], *esc;
+  uint64_t field[DUALCODEC_BLOCK];
+  size_t i, j, m = 0, nesc = 0, nplane = 0, need;
+  unsigned int planes, bits, b;
+  if (len < 1)
+    return DUALCODEC_EFORMAT;
+  if (src[0] == 1) {
+    if (len != 1 + k * 8)
+      return DUALCODEC_EFORMAT;
+    memcpy(lo, src + 1, k * 8);
+    return DUALCODEC_OK;
+  }
+  need = 1 + (k + 7) / 8;
+  if (src[0] != 0 || len < need)
+    return DUALCODEC_EFORMAT;
+  memset(lo, 0, k * 8);
+  for (i = 0; i < (k + 7) / 8; i++)
+    m += dualcodec_popcount(map[i]);
+  if (!m)
+    return len == need ? DUALCODEC_OK : DUALCODEC_EFORMAT;
+  if (len < need + 1)
+    return DUALCODEC_EFORMAT;
+  planes = src[need];
+  if (planes & 0x80)
+    return DUALCODEC_EFORMAT;
+  code = src + need + 1;
+  nplane = dualcodec_popcount(planes);
+  if (len < need + 1 + m * (1 + nplane))
+    return DUALCODEC_EFORMAT;
+  for (j = 0; j < m; j++)
+    nesc += !code[j];
+  if (len != need + 1 + m * (1 + nplane) + nesc * 8)
+    return DUALCODEC_EFORMAT;
+  for (b = 0, j = 0; b < 7; b++)
+    plane[b] = planes >> b & 1 ? code + m * (1 + j++) : NULL;
+  esc = code + m * (1 + nplane);
+  dualcodec_unplane(field, plane, m);
+  for (i = 0, j = 0; i < k; i += 8) {
+    for (bits = map[i >> 3]; bits; bits &= bits - 1, j++) {
+      size_t t = i + dualcodec_ctz(bits);
+      uint64_t f = field[j], eh;
+      if (t >= k)
+        return DUALCODEC_EFORMAT;
+      if (!code[j]) {
+        memcpy(lo + t, esc, 8);
+        esc += 8;
+        continue;
+      }
+      eh = dualcodec_bits(hi[t]) >> 52 & 0x7ff;
+      if (eh <= code[j] || eh == 0x7ff || (f >> 53))
+        return DUALCODEC_EFORMAT;
+      lo[t] = dualcodec_double((f >> 52) << 63 | (eh - code[j]) << 52 |
+                               (f & 0xfffffffffffffULL));
+    }
+  }
+  return DUALCODEC_OK;
+}
+
+/* 解码n个元素到SoA数组,n必须与编码时的元素个数相同 */
+static inline int dualcodec_decode(dualdouble_soa r, size_t n, const void *src,
+                                   size_t len) {
+  const unsigned char *p = (const unsigned char *)src,
+                      *end = (const unsigned char *)src + len;
+  uint64_t cnt;
+  uint32_t lobytes;
+  size_t i, k;
+  int ret;
+#ifdef __BIG_ENDIAN__
+  return DUALCODEC_EENDIAN;
+#endif
+  ret = dualcodec_count(src, len, &cnt);
+  if (ret != DUALCODEC_OK)
+    return ret;
+  if (cnt != (uint64_t)n)
+    return DUALCODEC_ESIZE;
+  p += DUALCODEC_HEADER;
+  for (i = 0; i < n; i += k) {
+    k = n - i < DUALCODEC_BLOCK ? n - i : DUALCODEC_BLOCK;
+    if ((size_t)(end - p) < 4 + k * 8)
+      return DUALCODEC_EFORMAT;
+    lobytes = dualcodec_rd32(p);
+    memcpy(r.hi + i, p + 4, k * 8);
+    p += 4 + k * 8;
+    if ((size_t)(end - p) < lobytes)
+      return DUALCODEC_EFORMAT;
+    ret = dualcodec_decode_lo(r.lo + i, r.hi + i, k, p, lobytes);
+    if (ret != DUALCODEC_OK)
+      return ret;
+    p += lobytes;
+  }
+  return p == end ? DUALCODEC_OK : DUALCODEC_EFORMAT;
+}
+
+#endif
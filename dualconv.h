@@ -0,0 +1,863 @@
+﻿#ifndef _DUAL_CONV_H_
+#define _DUAL_CONV_H_
+#include "dualbatch.h"
+#include "dualfloat.h"
+#include <math.h>
+#include <string.h>
+
+/**
+ * 十进制字符串转换为dualdouble/dualfloat
+ * 结果为正确舍入: hi = RN(x), lo = RN(x - hi),其中x为字符串表示的精确值.
+ * 有效数字不超过19位且|x|不大时(Clinger快速路径)只需一次乘法或除法,
+ * 否则以大整数精确计算x的二进制展开,位数不足以确定舍入时加倍重算.
+ * 超过DUALCONV_MAXDIG位的有效数字截断,截去部分非0时追加一位1作为粘滞位,
+ * 舍入边界均为有限位的二进制小数,十进制有效数字远少于该位数,因此不影响结果.
+ * C++20中解析函数为constexpr,可在编译期由字符串得到dualdouble常量.
+ */
+
+#define DUALCONV_MAXDIG 1100
+#define DUALCONV_LIMBS 256
+
+static DF_CONSTDATA uint32_t dualconv_pow5[14] = {
+    1,      5,       25,       125,       625,       3125,      15625,
+    78125,  390625,  1953125,  9765625,   48828125,  244140625, 1220703125};
+
+static DF_CONSTDATA uint32_t dualconv_pow10u32[10] = {
+    1,      10,      100,      1000,      10000,
+    100000, 1000000, 10000000, 100000000, 1000000000};
+
+static DF_CONSTDATA uint64_t dualconv_pow10u64[20] = {
+    1ULL,
+    10ULL,
+    100ULL,
+    1000ULL,
+    10000ULL,
+    100000ULL,
+    1000000ULL,
+    10000000ULL,
+    100000000ULL,
+    1000000000ULL,
+    10000000000ULL,
+    100000000000ULL,
+    1000000000000ULL,
+    10000000000000ULL,
+    100000000000000ULL,
+    1000000000000000ULL,
+    10000000000000000ULL,
+    100000000000000000ULL,
+    1000000000000000000ULL,
+    10000000000000000000ULL};
+
+static DF_CONSTDATA double dualconv_pow10[23] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+/* 大整数,32位一组,低位在前 */
+typedef struct dualconv_big {
+  int n;
+  uint32_t d[DUALCONV_LIMBS];
+} dualconv_big;
+
+static DF_CONSTEXPR inline void dualconv_big_set(dualconv_big *a, uint64_t x) {
+  a->d[0] = (uint32_t)x;
+  a->d[1] = (uint32_t)(x >> 32);
+  a->n = a->d[1] ? 2 : a->d[0] ? 1 : 0;
+}
+
+/* a = b,只复制有效的部分 */
+static DF_CONSTEXPR inline void dualconv_big_copy(dualconv_big *a,
+                                                  const dualconv_big *b) {
+  int i;
+  for (i = 0; i < b->n; i++)
+    a->d[i] = b->d[i];
+  a->n = b->n;
+}
+
+/* a = a*mul + add */
+static DF_CONSTEXPR inline void dualconv_big_muladd(dualconv_big *a,
+                                                    uint32_t mul,
+                                                    uint32_t add) {
+  uint64_t carry = add;
+  int i;
+  for (i = 0; i < a->n; i++) {
+    carry += (uint64_t)a->d[i] * mul;
+    a->d[i] = (uint32_t)carry;
+    carry >>= 32;
+  }
+  if (carry)
+    a->d[a->n++] = (uint32_t)carry;
+}
+
+/* a = a*5^e */
+static DF_CONSTEXPR inline void dualconv_big_mulpow5(dualconv_big *a, int e) {
+  for (; e >= 13; e -= 13)
+    dualconv_big_muladd(a, dualconv_pow5[13], 0);
+  if (e)
+    dualconv_big_muladd(a, dualconv_pow5[e], 0);
+}
+
+/* r = a << s */
+static DF_CONSTEXPR inline void dualconv_big_shl(dualconv_big *r,
+                                                 const dualconv_big *a, int s) {
+  int w = s >> 5, b = s & 31, i;
+  if (!a->n) {
+    r->n = 0;
+    return;
+  }
+  r->d[a->n + w] = 0;
+  for (i = a->n - 1; i >= 0; i--) {
+    if (b)
+      r->d[i + w + 1] |= a->d[i] >> (32 - b);
+    r->d[i + w] = a->d[i] << b;
+  }
+  for (i = 0; i < w; i++)
+    r->d[i] = 0;
+  r->n = a->n + w + 1;
+  while (r->n && !r->d[r->n - 1])
+    r->n--;
+}
+
+static DF_CONSTEXPR inline int dualconv_big_bitlen(const dualconv_big *a) {
+  return a->n ? a->n * 32 - __builtin_clz(a->d[a->n - 1]) : 0;
+}
+
+static DF_CONSTEXPR inline uint64_t dualconv_big_limb(const dualconv_big *a,
+                                                      int i) {
+  return i < a->n ? a->d[i] : 0;
+}
+
+/* 取a的第pos位起的cnt位(cnt<=64) */
+static DF_CONSTEXPR inline uint64_t dualconv_big_bits(const dualconv_big *a,
+                                                      int pos, int cnt) {
+  int w = pos >> 5, b = pos & 31;
+  uint64_t r;
+  if (cnt <= 0)
+    return 0;
+  r = (dualconv_big_limb(a, w + 1) << 32 | dualconv_big_limb(a, w)) >> b;
+  if (b)
+    r |= dualconv_big_limb(a, w + 2) << (64 - b);
+  return cnt < 64 ? r & ((1ULL << cnt) - 1) : r;
+}
+
+/* a的低pos位是否有非0位 */
+static DF_CONSTEXPR inline int dualconv_big_any(const dualconv_big *a,
+                                                int pos) {
+  int i, w = pos >> 5;
+  for (i = 0; i < w && i < a->n; i++)
+    if (a->d[i])
+      return 1;
+  return w < a->n && (pos & 31) && (a->d[w] << (32 - (pos & 31)));
+}
+
+static DF_CONSTEXPR inline int dualconv_big_cmp(const dualconv_big *a,
+                                                const dualconv_big *b) {
+  int i;
+  if (a->n != b->n)
+    return a->n < b->n ? -1 : 1;
+  for (i = a->n - 1; i >= 0; i--)
+    if (a->d[i] != b->d[i])
+      return a->d[i] < b->d[i] ? -1 : 1;
+  return 0;
+}
+
+/* r = a - b - borrow,要求a >= b + borrow */
+static DF_CONSTEXPR inline void dualconv_big_sub(dualconv_big *r,
+                                                 const dualconv_big *a,
+                                                 const dualconv_big *b,
+                                                 uint32_t borrow) {
+  int64_t t = -(int64_t)borrow;
+  int i;
+  for (i = 0; i < a->n; i++) {
+    t += (int64_t)a->d[i] - (i < b->n ? (int64_t)b->d[i] : 0);
+    r->d[i] = (uint32_t)t;
+    t >>= 32;
+  }
+  r->n = a->n;
+  while (r->n && !r->d[r->n - 1])
+    r->n--;
+}
+
+/**
+ * q = u / v,返回余数是否非0(u被改写),v->n >= 1
+ * 即Knuth算法D(TAOCP 4.3.1),参照Hacker's Delight的divmnu.
+ */
+static DF_CONSTEXPR inline int dualconv_big_div(dualconv_big *q,
+                                                dualconv_big *u,
+                                                const dualconv_big *v) {
+  uint32_t vn[DUALCONV_LIMBS], *un = u->d;
+  int n = v->n, m = u->n - v->n, s, i, j;
+  if (m < 0) {
+    q->n = 0;
+    return u->n != 0;
+  }
+  if (n == 1) {
+    uint64_t r = 0;
+    for (j = u->n - 1; j >= 0; j--) {
+      r = r << 32 | un[j];
+      q->d[j] = (uint32_t)(r / v->d[0]);
+      r %= v->d[0];
+    }
+    q->n = u->n;
+    while (q->n && !q->d[q->n - 1])
+      q->n--;
+    return r != 0;
+  }
+  s = __builtin_clz(v->d[n - 1]);
+  for (i = n - 1; i > 0; i--)
+    vn[i] = v->d[i] << s | (s ? v->d[i - 1] >> (32 - s) : 0);
+  vn[0] = v->d[0] << s;
+  un[m + n] = s ? un[m + n - 1] >> (32 - s) : 0;
+  for (i = m + n - 1; i > 0; i--)
+    un[i] = un[i] << s | (s ? un[i - 1] >> (32 - s) : 0);
+  un[0] <<= s;
+  for (j = m; j >= 0; j--) {
+    uint64_t num = (uint64_t)un[j + n] << 32 | un[j + n - 1];
+    uint64_t qhat = num / vn[n - 1], rhat = num % vn[n - 1], p;
+    int64_t t, k = 0;
+    while (qhat >> 32 ||
+           qhat * vn[n - 2] > (rhat << 32 | un[j + n - 2])) {
+      qhat--;
+      rhat += vn[n - 1];
+      if (rhat >> 32)
+        break;
+    }
+    for (i = 0; i < n; i++) {
+      p = qhat * vn[i];
+      t = (int64_t)un[i + j] - k - (int64_t)(p & 0xffffffff);
+      un[i + j] = (uint32_t)t;
+      k = (int64_t)(p >> 32) - (t >> 32);
+    }
+    t = (int64_t)un[j + n] - k;
+    un[j + n] = (uint32_t)t;
+    q->d[j] = (uint32_t)qhat;
+    if (t < 0) { // 估商大了1,加回
+      q->d[j]--;
+      k = 0;
+      for (i = 0; i < n; i++) {
+        t = (int64_t)un[i + j] + vn[i] + k;
+        un[i + j] = (uint32_t)t;
+        k = t >> 32;
+      }
+      un[j + n] += (uint32_t)k;
+    }
+  }
+  q->n = m + 1;
+  while (q->n && !q->d[q->n - 1])
+    q->n--;
+  for (i = 0; i < n; i++)
+    if (un[i])
+      return 1;
+  return 0;
+}
+
+/**
+ * 将(a + f)*2^-k (0 <= f < 1,sticky表示f是否非0)舍入为prec位的二进制浮点数,
+ * 最小的最低位为2^emin(非规格化数),结果为*mant * 2^*exp.
+ * a中不含舍入位而f非0时信息不足,返回0.
+ */
+static DF_CONSTEXPR inline int dualconv_round(const dualconv_big *a, int k,
+                                              int sticky, int prec, int emin,
+                                              uint64_t *mant, int *exp) {
+  int bl = dualconv_big_bitlen(a), lsb, rpos;
+  if (!bl) {
+    *mant = 0;
+    *exp = 0;
+    return !sticky || -k <= emin - 1;
+  }
+  lsb = bl - 1 - k - (prec - 1);
+  if (lsb < emin)
+    lsb = emin;
+  rpos = lsb - 1 + k; // 舍入位在a中的位置
+  if (rpos < 0) {
+    if (sticky)
+      return 0;
+    *mant = dualconv_big_bits(a, 0, bl);
+    *exp = -k;
+    return 1;
+  }
+  *mant = dualconv_big_bits(a, rpos + 1, bl - rpos - 1);
+  *exp = lsb;
+  if (dualconv_big_bits(a, rpos, 1) &&
+      (sticky || (*mant & 1) || dualconv_big_any(a, rpos)))
+    ++*mant;
+  return 1;
+}
+
+/* 2^e(-1022 <= e <= 1023) */
+static DF_CONSTEXPR inline double dualconv_pow2(int e) {
+  return df_asdouble((uint64_t)(e + 1023) << 52);
+}
+
+/* m*2^e(m < 2^54),结果可精确表示(可为非规格化数) */
+static DF_CONSTEXPR inline double dualconv_ldexp(uint64_t m, int e) {
+  if (e < -1022)
+    return (double)m * dualconv_pow2(e + 54) * dualconv_pow2(-54);
+  return (double)m * dualconv_pow2(e);
+}
+
+/**
+ * 将D*10^E(D > 0)正确舍入为prec位的hi与lo,hi溢出时为无穷大.
+ * 2^emax为溢出阈值.
+ */
+static DF_CONSTEXPR inline void dualconv_decimal(const dualconv_big *D, int E,
+                                                 int prec, int emin, int emax,
+                                                 double *hi, double *lo) {
+  dualconv_big q, u, den, h;
+  uint64_t hm, lm;
+  int he, le, k = -E, s = 0, smax = 0, m = -E, rem = 0, neg;
+  q.n = 0;
+  den.n = 0;
+  if (E >= 0) {
+    dualconv_big_copy(&q, D);
+    dualconv_big_mulpow5(&q, E);
+  } else {
+    dualconv_big_set(&den, 1);
+    dualconv_big_mulpow5(&den, m);
+    // 商至少有2*prec+64位;k >= 1-emin时任何舍入位都在商中
+    s = 2 * prec + 64 + dualconv_big_bitlen(&den) - dualconv_big_bitlen(D);
+    if (s < 0)
+      s = 0;
+    smax = 1 - emin - m > s ? 1 - emin - m : s;
+  }
+  for (;; s = 2 * s + 64 < smax ? 2 * s + 64 : smax) {
+    if (E < 0) {
+      dualconv_big_shl(&u, D, s);
+      rem = dualconv_big_div(&q, &u, &den);
+      k = s + m;
+    }
+    if (!dualconv_round(&q, k, rem, prec, emin, &hm, &he))
+      continue;
+    if (hm && 64 - __builtin_clzll(hm) + he > emax) {
+      *hi = INFINITY;
+      *lo = 0.0;
+      return;
+    }
+    // q - hi,以2^-k为单位
+    dualconv_big_set(&h, hm);
+    dualconv_big_shl(&h, &h, he + k);
+    if (dualconv_big_cmp(&q, &h) >= 0) {
+      dualconv_big_sub(&u, &q, &h, 0);
+      neg = 0;
+    } else {
+      dualconv_big_sub(&u, &h, &q, (uint32_t)rem);
+      neg = 1;
+    }
+    if (!dualconv_round(&u, k, rem, prec, emin, &lm, &le))
+      continue; // 位数不足,加倍重算
+    *hi = dualconv_ldexp(hm, he);
+    *lo = dualconv_ldexp(lm, le);
+    if (neg)
+      *lo = -*lo;
+    return;
+  }
+}
+
+/* 解析的十进制数 */
+typedef struct dualconv_num {
+  const char *digits; // 第一个有效数字
+  uint64_t w;         // 第1~19位有效数字
+  uint64_t w2;        // 第20~38位有效数字
+  int nd;             // 去掉末尾0後的有效数字个数
+  int e;              // 十进制指数(相对于nd位整数)
+  int neg;
+  int special; // 0数值,1无穷大,2NaN
+} dualconv_num;
+
+static DF_CONSTEXPR inline int dualconv_match(const char *s, const char *end,
+                                              const char *word) {
+  for (; *word; s++, word++)
+    if (s >= end || (*s | 0x20) != *word)
+      return 0;
+  return 1;
+}
+
+/* 累加一位有效数字 */
+static DF_CONSTEXPR inline void dualconv_digit(dualconv_num *r, unsigned int d,
+                                               int *nz) {
+  if (r->nd < 19)
+    r->w = r->w * 10 + d;
+  else if (r->nd < 38)
+    r->w2 = r->w2 * 10 + d;
+  r->nd++;
+  *nz = d ? r->nd : *nz;
+}
+
+/* 解析[s,end)开头的十进制数,返回结束位置,无法解析时返回s */
+static DF_CONSTEXPR inline const char *dualconv_scan(const char *s,
+                                                     const char *end,
+                                                     dualconv_num *r) {
+  const char *p = s, *q, *ep;
+  int nz = 0, any, e = 0, eneg = 0, x;
+  r->digits = NULL;
+  r->w = 0;
+  r->w2 = 0;
+  r->nd = 0;
+  r->neg = 0;
+  r->special = 0;
+  while (p < end && (*p == ' ' || (*p >= '\t' && *p <= '\r')))
+    p++;
+  if (p < end && (*p == '+' || *p == '-'))
+    r->neg = *p++ == '-';
+  if (p < end && (*p | 0x20) >= 'i') {
+    if (dualconv_match(p, end, "inf")) {
+      r->special = 1;
+      return p + (dualconv_match(p, end, "infinity") ? 8 : 3);
+    }
+    if (dualconv_match(p, end, "nan")) {
+      r->special = 2;
+      return p + 3;
+    }
+    return s;
+  }
+  // 整数部分,跳过前导0
+  q = p;
+  while (p < end && *p == '0')
+    p++;
+  if (p < end && (unsigned int)(*p - '1') < 9)
+    r->digits = p;
+  for (; p < end && (unsigned int)(*p - '0') < 10; p++)
+    dualconv_digit(r, (unsigned int)(*p - '0'), &nz);
+  any = p > q;
+  // 小数部分,有效数字之前的0只影响指数
+  if (p < end && *p == '.') {
+    q = ++p;
+    if (!r->nd) {
+      while (p < end && *p == '0')
+        p++;
+      if (p < end && (unsigned int)(*p - '1') < 9)
+        r->digits = p;
+    }
+    for (; p < end && (unsigned int)(*p - '0') < 10; p++)
+      dualconv_digit(r, (unsigned int)(*p - '0'), &nz);
+    e = -(int)(p - q);
+    any |= p > q;
+  }
+  if (!any)
+    return s;
+  if (p < end && (*p | 0x20) == 'e') {
+    ep = p + 1;
+    if (ep < end && (*ep == '+' || *ep == '-'))
+      eneg = *ep++ == '-';
+    if (ep < end && (unsigned int)(*ep - '0') < 10) {
+      for (x = 0; ep < end && (unsigned int)(*ep - '0') < 10; ep++)
+        if (x < 100000)
+          x = x * 10 + (*ep - '0');
+      e += eneg ? -x : x;
+      p = ep;
+    }
+  }
+  // 去掉有效数字末尾的0
+  if (nz <= 19)
+    r->w /= dualconv_pow10u64[(r->nd < 19 ? r->nd : 19) - nz];
+  else if (nz <= 38)
+    r->w2 /= dualconv_pow10u64[(r->nd < 38 ? r->nd : 38) - nz];
+  r->e = e + (r->nd - nz);
+  r->nd = nz;
+  return p;
+}
+
+/* a = a*10^k + x,x < 10^k,k <= 19 */
+static DF_CONSTEXPR inline void dualconv_big_append(dualconv_big *a, int k,
+                                                    uint64_t x) {
+  for (; k > 9; k -= 9)
+    dualconv_big_muladd(a, dualconv_pow10u32[9], 0);
+  dualconv_big_muladd(a, dualconv_pow10u32[k], 0);
+  if (!a->n)
+    a->d[a->n++] = 0;
+  for (int i = 0; x; i++) {
+    if (i == a->n)
+      a->d[a->n++] = 0;
+    x += a->d[i];
+    a->d[i] = (uint32_t)x;
+    x >>= 32;
+  }
+  while (a->n && !a->d[a->n - 1])
+    a->n--;
+}
+
+/* 由有效数字构造大整数,返回十进制指数 */
+static DF_CONSTEXPR inline int dualconv_digits(dualconv_big *D,
+                                               const dualconv_num *r) {
+  const char *p = r->digits;
+  int i = 0, cnt = 0, keep = r->nd < DUALCONV_MAXDIG ? r->nd : DUALCONV_MAXDIG;
+  uint32_t chunk = 0;
+  dualconv_big_set(D, r->w);
+  if (r->nd <= 38) { // 已在扫描时累加
+    if (r->nd > 19)
+      dualconv_big_append(D, r->nd - 19, r->w2);
+    return r->e;
+  }
+  D->n = 0;
+  for (; i < keep; p++) {
+    if (*p == '.')
+      continue;
+    chunk = chunk * 10 + (uint32_t)(*p - '0');
+    i++;
+    if (++cnt == 9 || i == keep) {
+      dualconv_big_append(D, cnt, chunk);
+      chunk = 0;
+      cnt = 0;
+    }
+  }
+  if (keep == r->nd)
+    return r->e;
+  // 截去的数字中有非0数字(末尾的0已去掉),追加一位1
+  dualconv_big_append(D, 1, 1);
+  return r->e + (r->nd - keep) - 1;
+}
+
+/**
+ * 解析[s,end)开头的十进制数为dualdouble,*stop为结束位置(无法解析时为s)
+ * 接受前导空白,正负号,小数点,e指数,inf,infinity与nan(不区分大小写).
+ */
+static DF_CONSTEXPR inline dualdouble dualconv_parse(const char *s,
+                                                     const char *end,
+                                                     const char **stop) {
+  dualconv_num r;
+  dualconv_big D;
+  double hi, lo;
+  int E;
+  const char *p = dualconv_scan(s, end, &r);
+  if (stop)
+    *stop = p;
+  if (p == s)
+    return ddual(0.0, 0.0);
+  if (r.special) {
+    hi = r.special == 1 ? INFINITY : NAN;
+    lo = 0.0;
+  } else if (!r.nd) {
+    hi = 0.0;
+    lo = 0.0;
+  } else if (r.nd <= 19 && r.w < (1ULL << 53) && r.e >= -22 && r.e <= 22) {
+    // Clinger快速路径: w与10^|e|均可精确表示
+    double w = (double)r.w, t = dualconv_pow10[r.e < 0 ? -r.e : r.e];
+    if (r.e >= 0) {
+      hi = w * t;
+      lo = fmulsub(w, t, hi);
+    } else {
+      hi = w / t;
+      lo = nfmulsub(hi, t, w) / t; // 余数w-hi*t可精确表示
+    }
+  } else if (r.nd + r.e > 310) {
+    hi = INFINITY;
+    lo = 0.0;
+  } else if (r.nd + r.e < -324) {
+    hi = 0.0;
+    lo = 0.0;
+  } else {
+    E = dualconv_digits(&D, &r);
+    dualconv_decimal(&D, E, 53, -1074, 1024, &hi, &lo);
+  }
+  return r.neg ? ddual(-hi, -lo) : ddual(hi, lo);
+}
+
+static DF_CONSTEXPR inline size_t dualconv_strlen(const char *s) {
+  size_t n = 0;
+  if (!DF_CONSTEVAL())
+    return strlen(s);
+  while (s[n])
+    n++;
+  return n;
+}
+
+/* 与strtod相同的接口,字符串转换为dualdouble */
+static DF_CONSTEXPR inline dualdouble strtodual(const char *s, char **endp) {
+  const char *stop;
+  dualdouble r = dualconv_parse(s, s + dualconv_strlen(s), &stop);
+  if (endp)
+    *endp = (char *)stop;
+  return r;
+}
+
+/* 解析[s,end)开头的十进制数为dualfloat */
+static DF_CONSTEXPR inline dualfloat dualconv_parsef(const char *s,
+                                                     const char *end,
+                                                     const char **stop) {
+  dualconv_num r;
+  dualconv_big D;
+  double hi = 0.0, lo = 0.0;
+  int E;
+  const char *p = dualconv_scan(s, end, &r);
+  if (stop)
+    *stop = p;
+  if (p == s)
+    return ddualf(0.0f, 0.0f);
+  if (r.special) {
+    hi = r.special == 1 ? INFINITY : NAN;
+  } else if (r.nd && r.nd + r.e > 40) {
+    hi = INFINITY;
+  } else if (r.nd && r.nd + r.e >= -46) {
+    E = dualconv_digits(&D, &r);
+    dualconv_decimal(&D, E, 24, -149, 128, &hi, &lo);
+  }
+  if (r.neg) {
+    hi = -hi;
+    lo = -lo;
+  }
+  return ddualf((float)hi, (float)lo);
+}
+
+/* 与strtof相同的接口,字符串转换为dualfloat */
+static DF_CONSTEXPR inline dualfloat strtodualf(const char *s, char **endp) {
+  const char *stop;
+  dualfloat r = dualconv_parsef(s, s + dualconv_strlen(s), &stop);
+  if (endp)
+    *endp = (char *)stop;
+  return r;
+}
+
+/**
+ * dualdouble与其他数值类型的转换
+ * 整数转为dualdouble时分为高低32位分别精确转换,再以dfnorm合并,无舍入;
+ * dualdouble转为整数时向0取整(同C的转换),结果精确,超出范围时结果未定义.
+ * 浮点数转为dualdouble为正确舍入: hi = RN(a), lo = RN(a - hi),
+ * hi不是有限数时lo为0.
+ */
+
+/* int64转为dualdouble(精确) */
+static inline dualdouble df_from_int64(int64_t a) {
+  double h = (double)(int32_t)(a >> 32) * 4294967296.0;
+  double l = (double)(uint32_t)a;
+  return dfnorm(ddual(h, l)); // h为0或|h| >= 2^32 > l
+}
+
+/* uint64转为dualdouble(精确) */
+static inline dualdouble df_from_uint64(uint64_t a) {
+  double h = (double)(uint32_t)(a >> 32) * 4294967296.0;
+  double l = (double)(uint32_t)a;
+  return dfnorm(ddual(h, l));
+}
+
+/* dualdouble向0取整转为int64 */
+static inline int64_t df_to_int64(dualdouble a) {
+  // hi为整数时结果为hi与lo取整之和,否则|lo| < hi到相邻整数的距离
+  double adj = a.hi > 0 ? floor(a.lo) : ceil(a.lo);
+  uint64_t ih =
+      a.hi < 9223372036854775808.0 ? (uint64_t)(int64_t)a.hi : 1ULL << 63;
+  if (a.hi != floor(a.hi))
+    adj = 0.0;
+  return (int64_t)(ih + (uint64_t)(int64_t)adj);
+}
+
+/* dualdouble向0取整转为uint64 */
+static inline uint64_t df_to_uint64(dualdouble a) {
+  double adj = floor(a.lo);
+  uint64_t ih = a.hi < 18446744073709551616.0 ? (uint64_t)a.hi : 0;
+  if (a.hi != floor(a.hi))
+    adj = 0.0;
+  return ih + (uint64_t)(int64_t)adj;
+}
+
+/* long double转为dualdouble(正确舍入) */
+static inline dualdouble df_from_ldouble(long double a) {
+  double hi = (double)a;
+  return ddual(hi, hi - hi == 0 ? (double)(a - hi) : 0.0);
+}
+
+/* dualdouble转为long double(正确舍入) */
+static inline long double df_to_ldouble(dualdouble a) {
+  return (long double)a.hi + (long double)a.lo;
+}
+
+/* double转为dualfloat(正确舍入) */
+static inline dualfloat df_from_doublef(double a) {
+  float hi = (float)a;
+  return ddualf(hi, hi - hi == 0 ? (float)(a - hi) : 0.0f);
+}
+
+/* dualfloat转为double(正确舍入) */
+static inline double df_to_doublef(dualfloat a) {
+  return (double)a.hi + (double)a.lo;
+}
+
+#ifdef __SIZEOF_INT128__
+/* 无符号128位整数正确舍入为double,*r为余数u-ret */
+static inline double dualconv_round128(unsigned __int128 u, __int128 *r) {
+  uint64_t h = (uint64_t)(u >> 64), l = (uint64_t)u, m;
+  unsigned __int128 rem, half;
+  int sh =
+      (h ? 128 - __builtin_clzll(h) : l ? 64 - __builtin_clzll(l) : 0) - 53;
+  if (sh <= 0) {
+    *r = 0;
+    return (double)l;
+  }
+  m = (uint64_t)(u >> sh);
+  rem = u & (((unsigned __int128)1 << sh) - 1);
+  half = (unsigned __int128)1 << (sh - 1);
+  m += rem > half || (rem == half && (m & 1));
+  *r = (__int128)(u - ((unsigned __int128)m << sh));
+  return (double)m * dualconv_pow2(sh);
+}
+
+/* uint128转为dualdouble(正确舍入,不超过106位时精确) */
+static inline dualdouble df_from_uint128(unsigned __int128 a) {
+  __int128 r, t;
+  double hi = dualconv_round128(a, &r);
+  double lo = dualconv_round128(
+      r < 0 ? -(unsigned __int128)r : (unsigned __int128)r, &t);
+  return ddual(hi, r < 0 ? -lo : lo);
+}
+
+/* int128转为dualdouble(正确舍入,不超过106位时精确) */
+static inline dualdouble df_from_int128(__int128 a) {
+  dualdouble ret =
+      df_from_uint128(a < 0 ? -(unsigned __int128)a : (unsigned __int128)a);
+  return a < 0 ? dfneg(ret) : ret;
+}
+
+/* dualdouble向0取整转为int128 */
+static inline __int128 df_to_int128(dualdouble a) {
+  double adj = a.hi > 0 ? floor(a.lo) : ceil(a.lo);
+  unsigned __int128 ih = a.hi < 170141183460469231731687303715884105728.0
+                             ? (unsigned __int128)(__int128)a.hi
+                             : (unsigned __int128)1 << 127;
+  if (a.hi != floor(a.hi))
+    adj = 0.0;
+  return (__int128)(ih + (unsigned __int128)(__int128)adj);
+}
+
+/* dualdouble向0取整转为uint128 */
+static inline unsigned __int128 df_to_uint128(dualdouble a) {
+  double adj = floor(a.lo);
+  unsigned __int128 ih = a.hi < 340282366920938463463374607431768211456.0
+                             ? (unsigned __int128)a.hi
+                             : 0;
+  if (a.hi != floor(a.hi))
+    adj = 0.0;
+  return ih + (unsigned __int128)(__int128)adj;
+}
+#endif
+
+#if defined(__SIZEOF_FLOAT128__) && defined(__SIZEOF_INT128__)
+/* __float128转为dualdouble(正确舍入) */
+static inline dualdouble df_from_float128(__float128 a) {
+  unsigned __int128 b, mant;
+  uint64_t hm, hb;
+  int64_t rem;
+  double hi, lo;
+  int e;
+  memcpy(&b, &a, sizeof(b));
+  e = (int)(b >> 112 & 0x7fff) - 16383;
+  if (e < -910 || e > 1023) { // hi或lo不是规格化数
+    hi = (double)a;
+    return ddual(hi, hi - hi == 0 ? (double)(a - hi) : 0.0);
+  }
+  // 113位尾数的高53位舍入为hi,低60位(舍入後可为负)即lo
+  mant = b & (((unsigned __int128)1 << 112) - 1);
+  hm = (uint64_t)(mant >> 60) | 1ULL << 52;
+  rem = (int64_t)((uint64_t)mant & ((1ULL << 60) - 1));
+  if (rem > (1LL << 59) || (rem == (1LL << 59) && (hm & 1))) {
+    hm++;
+    rem -= 1LL << 60;
+  }
+  hb = ((uint64_t)(e + 1023) << 52) + (hm - (1ULL << 52));
+  memcpy(&hi, &hb, sizeof(hi)); // hm进位时阶码加1,溢出时为无穷大
+  lo = hi - hi == 0 ? (double)rem * dualconv_pow2(e - 112) : 0.0;
+  return b >> 127 ? ddual(-hi, -lo) : ddual(hi, lo);
+}
+
+/* dualdouble转为__float128(正确舍入) */
+static inline __float128 df_to_float128(dualdouble a) {
+  return (__float128)a.hi + (__float128)a.lo;
+}
+#endif
+
+#if defined(DUAL_BATCH_AVX) && defined(__AVX2__)
+/* 4个int64转为dualdouble,与df_from_int64逐位相同 */
+static inline dualdouble4 df_from_int64_4(__m256i a) {
+  // 高32位(有符号)与低32位分别拼入2^84与2^52的尾数,减去偏置後即精确值
+  const __m256i mhi = _mm256_set1_epi64x(0x4530000080000000LL);
+  const __m256i mlo = _mm256_set1_epi64x(0x4330000000000000LL);
+  __m256d h = _mm256_castsi256_pd(
+      _mm256_xor_si256(_mm256_srli_epi64(a, 32), mhi));
+  __m256d l = _mm256_castsi256_pd(_mm256_blend_epi32(a, mlo, 0xaa));
+  h = _mm256_sub_pd(h, _mm256_set1_pd(19342813113834066795298816.0 +
+                                       9223372036854775808.0)); // 2^84+2^63
+  l = _mm256_sub_pd(l, _mm256_set1_pd(4503599627370496.0));
+  return dfnorm4(ddual4(h, l));
+}
+
+/* 4个dualdouble向0取整转为int64,与df_to_int64结果相同 */
+static inline __m256i df_to_int64_4(dualdouble4 a) {
+  // hi = th*2^32 + hl,th为int32,hl与lo之和取整後小于2^33
+  const __m256d magic = _mm256_set1_pd(6755399441055744.0);
+  __m256d th = _mm256_round_pd(
+      _mm256_mul_pd(a.hi, _mm256_set1_pd(1.0 / 4294967296.0)),
+      _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC);
+  __m256d hl = // th*2^32无舍入,不需要FMA
+      _mm256_sub_pd(a.hi, _mm256_mul_pd(th, _mm256_set1_pd(4294967296.0)));
+  __m256d pos = _mm256_cmp_pd(a.hi, _mm256_setzero_pd(), _CMP_GT_OQ);
+  __m256d b = _mm256_blendv_pd(_mm256_ceil_pd(hl), _mm256_floor_pd(hl), pos);
+  __m256d blo =
+      _mm256_blendv_pd(_mm256_ceil_pd(a.lo), _mm256_floor_pd(a.lo), pos);
+  __m256d adj = _mm256_add_pd(
+      b, _mm256_and_pd(_mm256_cmp_pd(b, hl, _CMP_EQ_OQ), blo));
+  __m256i t = _mm256_slli_epi64(
+      _mm256_cvtepi32_epi64(_mm256_cvttpd_epi32(th)), 32);
+  __m256i ai = _mm256_sub_epi64(
+      _mm256_castpd_si256(_mm256_add_pd(adj, magic)),
+      _mm256_castpd_si256(magic));
+  return _mm256_add_epi64(t, ai);
+}
+#endif
+
+/* 批量int64转为dualdouble */
+static inline void vdf_from_int64(dualdouble_soa r, const int64_t *a,
+                                  size_t n) {
+  size_t i = 0;
+#if defined(DUAL_BATCH_AVX) && defined(__AVX2__)
+  for (; i + 4 <= n; i += 4)
+    dstore4(r, i,
+            df_from_int64_4(_mm256_loadu_si256((const __m256i *)(a + i))));
+#endif
+  for (; i < n; i++)
+    dsoaset(r, i, df_from_int64(a[i]));
+}
+
+/* 批量dualdouble向0取整转为int64 */
+static inline void vdf_to_int64(int64_t *r, dualdouble_soa a, size_t n) {
+  size_t i = 0;
+#if defined(DUAL_BATCH_AVX) && defined(__AVX2__)
+  for (; i + 4 <= n; i += 4)
+    _mm256_storeu_si256((__m256i *)(r + i), df_to_int64_4(dload4(a, i)));
+#endif
+  for (; i < n; i++)
+    r[i] = df_to_int64(dsoaget(a, i));
+}
+
+/* 批量double转为dualfloat,高位与低位分别存入hi与lo */
+static inline void vdf_from_doublef(float *hi, float *lo, const double *a,
+                                    size_t n) {
+  size_t i = 0;
+#ifdef DUAL_BATCH_AVX
+  for (; i + 4 <= n; i += 4) {
+    __m256d x = _mm256_loadu_pd(a + i);
+    __m128 h = _mm256_cvtpd_ps(x);
+    __m128 l = _mm256_cvtpd_ps(_mm256_sub_pd(x, _mm256_cvtps_pd(h)));
+    __m128 fin = _mm_cmpeq_ps(_mm_sub_ps(h, h), _mm_setzero_ps());
+    _mm_storeu_ps(hi + i, h);
+    _mm_storeu_ps(lo + i, _mm_and_ps(l, fin));
+  }
+#endif
+  for (; i < n; i++) {
+    dualfloat x = df_from_doublef(a[i]);
+    hi[i] = x.hi;
+    lo[i] = x.lo;
+  }
+}
+
+/* 批量dualfloat转为double */
+static inline void vdf_to_doublef(double *r, const float *hi, const float *lo,
+                                  size_t n) {
+  size_t i = 0;
+#ifdef DUAL_BATCH_AVX
+  for (; i + 4 <= n; i += 4)
+    _mm256_storeu_pd(r + i,
+                     _mm256_add_pd(_mm256_cvtps_pd(_mm_loadu_ps(hi + i)),
+                                   _mm256_cvtps_pd(_mm_loadu_ps(lo + i))));
+#endif
+  for (; i < n; i++)
+    r[i] = df_to_doublef(ddualf(hi[i], lo[i]));
+}
+
+#endif
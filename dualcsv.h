@@ -0,0 +1,406 @@
+﻿#ifndef _DUAL_CSV_H_
+#define _DUAL_CSV_H_
+#include "dualsys.h"
+#include "dualbatch.h"
+#include "dualconv.h"
+
+/**
+ * 多线程读取CSV文件中的十进制数值列到SoA数组
+ * 文件映射後按换行符切分为若干段,各线程并行解析各段,选中的列以正确舍入的
+ * dualconv_parse写入段内按需增长的高位与低位平面;求出每段的起始行号後
+ * 再并行拷贝到各列的数组,文件只读取一遍.无法解析或缺失的字段写入NaN
+ * 并记录位置,解析继续进行.
+ * 字段前後的空白与包围字段的一对双引号被忽略,不支持含换行符的引号字段;
+ * 空行被跳过,行尾的\r被忽略.
+ */
+
+/* 错误码 */
+#define DUALCSV_OK 0
+#define DUALCSV_EIO (-1)    // 文件打开,映射失败
+#define DUALCSV_EARG (-4)   // 参数错误
+#define DUALCSV_ENOMEM (-5) // 内存不足
+
+/* 读取选项,字段为0则取默认值 */
+typedef struct dualcsv_opts {
+  char delim;       // 分隔符,默认','
+  int header;       // 第一行为表头时为1
+  int nthreads;     // 线程数,默认为处理器个数
+  size_t maxerrors; // 最多记录的错误个数,默认1024
+} dualcsv_opts;
+
+/* 无法解析的字段 */
+typedef struct dualcsv_error {
+  uint64_t line; // 文件中的行号,从1开始(含表头与空行)
+  uint64_t row;  // 数据行号,从0开始
+  int col;       // 列号,从0开始
+} dualcsv_error;
+
+/* 读取结果 */
+typedef struct dualcsv_table {
+  uint64_t rows;         // 数据行数
+  int ncols;             // 选中的列数
+  dualdouble_soa *cols;  // 每个选中列的数组,各有rows个元素
+  dualcsv_error *errors; // 按行号排序的前nerrors个错误
+  size_t nerrors;
+  uint64_t total_errors; // 错误总数
+} dualcsv_table;
+
+/* 一段文件的解析结果与错误 */
+typedef struct dualcsv_seg {
+  const char *begin, *end;
+  uint64_t lines, rows; // 段内行数与数据行数
+  uint64_t line0, row0; // 段首的行号与数据行号
+  double *buf; // 选中列j的高位与低位平面为buf+2j*rcap与buf+(2j+1)*rcap
+  size_t rcap; // 每个平面的容量(行数)
+  dualcsv_error *errors; // 行号与数据行号先为段内的值,解析後加上段首的值
+  size_t nerrors, cap;
+  uint64_t total_errors;
+} dualcsv_seg;
+
+/* 多线程共享状态 */
+typedef struct dualcsv_job {
+  dual_mutex mu;
+  size_t next;
+  int pass;
+  dualcsv_seg *segs;
+  size_t nsegs;
+  const int *cols;
+  const int *map; // 列号到选中列序号,-1为未选中
+  int maxcol;
+  int ncols;
+  char delim;
+  size_t maxerrors;
+  dualcsv_table *t;
+  int nomem;
+} dualcsv_job;
+
+/* 下一行的开头,没有换行符时为end */
+static inline const char *dualcsv_eol(const char *p, const char *end) {
+  const char *q = (const char *)memchr(p, '\n', (size_t)(end - p));
+  return q ? q : end;
+}
+
+/* 去掉行尾的\r後行是否为空 */
+static inline int dualcsv_blank(const char *p, const char *eol) {
+  return eol == p || (eol == p + 1 && *p == '\r');
+}
+
+/* 扩大段内的平面,首次按段长与第一行的长度估计行数,失败返回-1 */
+static inline int dualcsv_grow(dualcsv_job *job, dualcsv_seg *g,
+                               const char *line, const char *eol) {
+  size_t cap = g->rcap * 2, k, n = (size_t)job->ncols * 2;
+  double *buf;
+  if (!g->rcap)
+    cap = (size_t)(g->end - g->begin) / (size_t)(eol - line + 1) + 64;
+  buf = (double *)malloc(n * cap * sizeof(double));
+  if (!buf) {
+    job->nomem = 1;
+    return -1;
+  }
+  for (k = 0; k < n && g->rows; k++)
+    memcpy(buf + k * cap, g->buf + k * g->rcap,
+           (size_t)g->rows * sizeof(double));
+  free(g->buf);
+  g->buf = buf;
+  g->rcap = cap;
+  return 0;
+}
+
+static inline void dualcsv_fail(dualcsv_job *job, dualcsv_seg *g,
+                                uint64_t line, uint64_t row, int col) {
+  dualcsv_error *e;
+  g->total_errors++;
+  if (g->nerrors >= job->maxerrors)
+    return;
+  if (g->nerrors == g->cap) {
+    size_t cap = g->cap ? g->cap * 2 : 16;
+    e = (dualcsv_error *)realloc(g->errors, cap * sizeof(*e));
+    if (!e) {
+      job->nomem = 1;
+      return;
+    }
+    g->errors = e;
+    g->cap = cap;
+  }
+  e = &g->errors[g->nerrors++];
+  e->line = line;
+  e->row = row;
+  e->col = col;
+}
+
+/* 解析一个字段,整个字段为数值时返回1 */
+static inline int dualcsv_field(const char *p, const char *end,
+                                dualdouble *x) {
+  const char *stop;
+  while (p < end && (*p == ' ' || *p == '\t'))
+    p++;
+  while (end > p && (end[-1] == ' ' || end[-1] == '\t' || end[-1] == '\r'))
+    end--;
+  if (end - p >= 2 && *p == '"' && end[-1] == '"') {
+    p++;
+    end--;
+  }
+  *x = dualconv_parse(p, end, &stop);
+  while (stop < end && (*stop == ' ' || *stop == '\t'))
+    stop++;
+  return stop != p && stop == end;
+}
+
+static inline void dualcsv_parse(dualcsv_job *job, dualcsv_seg *g) {
+  const char *p = g->begin, *eol, *f, *fe;
+  uint64_t line = 0, row = 0;
+  unsigned char seen[256], *done;
+  double *hi, *lo;
+  dualdouble x;
+  int c, j;
+  done = seen;
+  if (job->ncols > 256)
+    done = (unsigned char *)malloc((size_t)job->ncols);
+  if (!done) {
+    job->nomem = 1;
+    return;
+  }
+  for (; p < g->end; p = eol + 1, line++) {
+    eol = dualcsv_eol(p, g->end);
+    if (dualcsv_blank(p, eol))
+      continue;
+    if (row == g->rcap && dualcsv_grow(job, g, p, eol) != 0)
+      break;
+    memset(done, 0, (size_t)job->ncols);
+    for (f = p, c = 0; c <= job->maxcol; f = fe + 1, c++) {
+      fe = (const char *)memchr(f, job->delim, (size_t)(eol - f));
+      if (!fe)
+        fe = eol;
+      j = job->map[c];
+      if (j >= 0) {
+        done[j] = 1;
+        if (!dualcsv_field(f, fe, &x)) {
+          x = ddual(NAN, NAN);
+          dualcsv_fail(job, g, line + 1, row, c);
+        }
+        g->buf[2 * (size_t)j * g->rcap + row] = x.hi;
+        g->buf[(2 * (size_t)j + 1) * g->rcap + row] = x.lo;
+      }
+      if (fe == eol)
+        break;
+    }
+    for (j = 0; j < job->ncols; j++) {
+      if (done[j])
+        continue;
+      hi = g->buf + 2 * (size_t)j * g->rcap;
+      lo = hi + g->rcap;
+      hi[row] = lo[row] = NAN;
+      dualcsv_fail(job, g, line + 1, row, job->cols[j]);
+    }
+    g->rows = ++row;
+  }
+  g->lines = line;
+  if (done != seen)
+    free(done);
+}
+
+/* 将段内的平面拷贝到各列数组的第row0行起,然後释放 */
+static inline void dualcsv_copy(dualcsv_job *job, dualcsv_seg *g) {
+  size_t n = (size_t)g->rows * sizeof(double);
+  int j;
+  for (j = 0; j < job->ncols && n; j++) {
+    memcpy(job->t->cols[j].hi + g->row0, g->buf + 2 * (size_t)j * g->rcap, n);
+    memcpy(job->t->cols[j].lo + g->row0,
+           g->buf + (2 * (size_t)j + 1) * g->rcap, n);
+  }
+  free(g->buf);
+  g->buf = NULL;
+}
+
+/* 工作线程: 领取未处理的段 */
+static inline void dualcsv_worker(void *arg) {
+  dualcsv_job *job = (dualcsv_job *)arg;
+  for (;;) {
+    size_t i;
+    dual_mutex_lock(&job->mu);
+    i = job->next++;
+    dual_mutex_unlock(&job->mu);
+    if (i >= job->nsegs)
+      return;
+    if (job->pass == 0)
+      dualcsv_parse(job, &job->segs[i]);
+    else
+      dualcsv_copy(job, &job->segs[i]);
+  }
+}
+
+/* 以nthreads个线程(含当前线程)完成一遍处理 */
+static inline void dualcsv_run(dualcsv_job *job, int pass, int nthreads) {
+  dual_thread *th = NULL;
+  int i, n = 0;
+  job->pass = pass;
+  job->next = 0;
+  if (nthreads > 1)
+    th = (dual_thread *)malloc((size_t)(nthreads - 1) * sizeof(*th));
+  for (i = 1; th && i < nthreads; i++)
+    if (dual_thread_create(&th[n], dualcsv_worker, job) == 0)
+      n++;
+  dualcsv_worker(job);
+  for (i = 0; i < n; i++)
+    dual_thread_join(th[i]);
+  free(th);
+}
+
+static inline void dualcsv_free(dualcsv_table *t) {
+  int j;
+  if (t->cols)
+    for (j = 0; j < t->ncols; j++) {
+      dual_aligned_free(t->cols[j].hi);
+      dual_aligned_free(t->cols[j].lo);
+    }
+  free(t->cols);
+  free(t->errors);
+  memset(t, 0, sizeof(*t));
+}
+
+/**
+ * 读取CSV文件中列号为cols[0..ncols-1]的列(从0开始,不可重复).
+ * 成功返回DUALCSV_OK,字段错误不影响返回值,由t->total_errors给出.
+ */
+static inline int dualcsv_read(const char *path, const int *cols, int ncols,
+                               const dualcsv_opts *opts, dualcsv_table *t) {
+  dualcsv_job job;
+  dual_file f;
+  uint64_t size = 0, lines = 0, rows = 0;
+  const char *base = NULL, *p, *end;
+  int *map = NULL, nthreads, j, ret = DUALCSV_OK;
+  size_t i, nsegs;
+  memset(t, 0, sizeof(*t));
+  memset(&job, 0, sizeof(job));
+  if (!path || !cols || ncols < 1)
+    return DUALCSV_EARG;
+  job.maxcol = -1;
+  for (j = 0; j < ncols; j++) {
+    if (cols[j] < 0)
+      return DUALCSV_EARG;
+    if (cols[j] > job.maxcol)
+      job.maxcol = cols[j];
+  }
+  map = (int *)malloc(((size_t)job.maxcol + 1) * sizeof(int));
+  if (!map)
+    return DUALCSV_ENOMEM;
+  memset(map, 0xff, ((size_t)job.maxcol + 1) * sizeof(int));
+  for (j = 0; j < ncols; j++) {
+    if (map[cols[j]] >= 0) {
+      free(map);
+      return DUALCSV_EARG;
+    }
+    map[cols[j]] = j;
+  }
+  f = dual_file_open(path);
+  if (f == DUAL_FILE_INVALID || dual_file_size(f, &size) != 0 ||
+      (size && !(base = (const char *)dual_file_map(f, size)))) {
+    if (f != DUAL_FILE_INVALID)
+      dual_file_close(f);
+    free(map);
+    return DUALCSV_EIO;
+  }
+  p = base;
+  end = base + size;
+  if (opts && opts->header && p < end) { // 跳过表头
+    p = dualcsv_eol(p, end);
+    p += p < end;
+    lines = 1;
+  }
+  nthreads = opts && opts->nthreads > 0 ? opts->nthreads : dual_ncpu();
+  // 每段至少1MB,段数为线程数的若干倍以均衡负载
+  nsegs = (size_t)(end - p) >> 20;
+  if (nsegs > (size_t)nthreads * 8)
+    nsegs = (size_t)nthreads * 8;
+  if (!nsegs)
+    nsegs = 1;
+  job.segs = (dualcsv_seg *)calloc(nsegs, sizeof(dualcsv_seg));
+  t->cols = (dualdouble_soa *)calloc((size_t)ncols, sizeof(dualdouble_soa));
+  t->ncols = ncols;
+  if (!job.segs || !t->cols) {
+    ret = DUALCSV_ENOMEM;
+    goto done;
+  }
+  for (i = 0; i < nsegs; i++) {
+    const char *b = i ? job.segs[i - 1].end : p;
+    const char *e = p + (size_t)((double)(end - p) * (double)(i + 1) / nsegs);
+    if (i == nsegs - 1 || e >= end) {
+      e = end;
+    } else if (e > b) {
+      e = dualcsv_eol(e - 1, end); // 段在换行符之後结束
+      e += e < end;
+    } else {
+      e = b;
+    }
+    job.segs[i].begin = b;
+    job.segs[i].end = e;
+  }
+  job.nsegs = nsegs;
+  job.cols = cols;
+  job.map = map;
+  job.ncols = ncols;
+  job.delim = opts && opts->delim ? opts->delim : ',';
+  job.maxerrors = opts && opts->maxerrors ? opts->maxerrors : 1024;
+  job.t = t;
+  dual_mutex_init(&job.mu);
+  dualcsv_run(&job, 0, nthreads);
+  for (i = 0; i < nsegs; i++) {
+    dualcsv_seg *g = &job.segs[i];
+    size_t k;
+    g->line0 = lines;
+    g->row0 = rows;
+    lines += g->lines;
+    rows += g->rows;
+    for (k = 0; k < g->nerrors; k++) {
+      g->errors[k].line += g->line0;
+      g->errors[k].row += g->row0;
+    }
+  }
+  t->rows = rows;
+  for (j = 0; j < ncols && !job.nomem; j++) {
+    size_t bytes = (rows ? (size_t)rows : 1) * sizeof(double);
+    t->cols[j].hi = (double *)dual_aligned_alloc(bytes, 64);
+    t->cols[j].lo = (double *)dual_aligned_alloc(bytes, 64);
+    if (!t->cols[j].hi || !t->cols[j].lo)
+      ret = DUALCSV_ENOMEM;
+  }
+  if (ret == DUALCSV_OK && !job.nomem)
+    dualcsv_run(&job, 1, nthreads);
+  dual_mutex_destroy(&job.mu);
+  if (job.nomem)
+    ret = DUALCSV_ENOMEM;
+  // 按段的顺序合并错误
+  for (i = 0; i < nsegs && ret == DUALCSV_OK; i++)
+    t->total_errors += job.segs[i].total_errors;
+  if (ret == DUALCSV_OK && t->total_errors) {
+    size_t cap = t->total_errors < job.maxerrors ? (size_t)t->total_errors
+                                                 : job.maxerrors;
+    t->errors = (dualcsv_error *)malloc(cap * sizeof(dualcsv_error));
+    if (!t->errors)
+      ret = DUALCSV_ENOMEM;
+    for (i = 0; i < nsegs && t->errors && t->nerrors < cap; i++) {
+      size_t n = job.segs[i].nerrors;
+      if (n > cap - t->nerrors)
+        n = cap - t->nerrors;
+      memcpy(t->errors + t->nerrors, job.segs[i].errors,
+             n * sizeof(dualcsv_error));
+      t->nerrors += n;
+    }
+  }
+done:
+  if (job.segs)
+    for (i = 0; i < nsegs; i++) {
+      free(job.segs[i].buf);
+      free(job.segs[i].errors);
+    }
+  free(job.segs);
+  free(map);
+  if (base)
+    dual_file_unmap((void *)base, size);
+  dual_file_close(f);
+  if (ret != DUALCSV_OK)
+    dualcsv_free(t);
+  return ret;
+}
+
+#endif
@@ -0,0 +1,512 @@
+﻿#ifndef _DUALFLOAT_BASIC_H_
+#error "it must include by <dualdouble.h> or <dualfloat.h>"
+#else
+#ifndef _DUAL_EXPR_CXX_
+#define _DUAL_EXPR_CXX_
+#include <type_traits>
+
+/**
+ * 双数运算符的表达式模板
+ * +,-,*,/ 不立即计算,而是构造表达式,在赋值或转换时一次求值:
+ * 各项的高位以无误差加法链累加,低位在另一条无误差加法链中累加,
+ * 乘积展开後直接加入累加器,最後规格化一次(同df2mul分两步).
+ * 定义FAST_DF_OPERATOR时乘积的低位与交叉项以FMA合为一项(同fdf2mul),
+ * 如a*b+c*d为两次无误差乘法,四次FMA与四次无误差加法;否则交叉项也以
+ * 无误差乘法展开(同df2mul),a*b+c*d为六次无误差乘法与八次无误差加法.
+ * 只有一次运算的表达式(如a*b,a+b)直接调用对应的运算,结果与逐个运算相同;
+ * 多项的表达式误差不大于逐个运算.
+ * 除法以及作为乘数的和式先单独求值.基本运算由dual_traits<T>(见dual_cxx.h)提供.
+ * 仅在定义DF_EXPR_TEMPLATE时使用: 运算结果的类型是表达式而不是双数,
+ * (a+b).hi,std::max(a+b,c)与按参数推导类型的模板(如T f(T)以a*b调用)
+ * 需先转换为双数(如dualdouble(a+b)); auto变量保存的是表达式,每次使用都重新求值.
+ */
+
+/* 运算数类型X的标量类型,仅对双数类型与表达式有定义 */
+template <class X, class Enable = void> struct dualexpr_operand {};
+
+template <class... X> struct dualexpr_void { typedef void type; };
+
+/* 表达式的公共基类 */
+template <class T, class E> struct dualexpr {
+  typedef T scalar;
+  typedef typename dual_traits<T>::dual dual;
+  typedef void dualexpr_tag;
+  const E &self() const { return static_cast<const E &>(*this); }
+  dual value() const;
+  operator dual() const { return value(); }
+  operator T() const {
+    dual r = value();
+    return r.hi + r.lo;
+  }
+};
+
+/* 双数叶节点 */
+template <class T> struct dualexpr_leaf : dualexpr<T, dualexpr_leaf<T> > {
+  typename dual_traits<T>::dual v;
+  explicit dualexpr_leaf(const typename dual_traits<T>::dual &x) : v(x) {}
+};
+
+/* 标量叶节点 */
+template <class T> struct dualexpr_scalar : dualexpr<T, dualexpr_scalar<T> > {
+  T v;
+  explicit dualexpr_scalar(T x) : v(x) {}
+};
+
+template <class T, class A> struct dualexpr_neg : dualexpr<T, dualexpr_neg<T, A> > {
+  A a;
+  explicit dualexpr_neg(const A &x) : a(x) {}
+};
+
+#define DUALEXPR_BINARY(name)                                                  \
+  template <class T, class A, class B>                                         \
+  struct name : dualexpr<T, name<T, A, B> > {                                  \
+    A a;                                                                       \
+    B b;                                                                       \
+    name(const A &x, const B &y) : a(x), b(y) {}                               \
+  };
+DUALEXPR_BINARY(dualexpr_add)
+DUALEXPR_BINARY(dualexpr_sub)
+DUALEXPR_BINARY(dualexpr_mul)
+DUALEXPR_BINARY(dualexpr_div)
+#undef DUALEXPR_BINARY
+
+/* X是否为表达式 */
+template <class X, class Enable = void> struct dualexpr_is_expr {
+  enum { value = 0 };
+};
+
+template <class X>
+struct dualexpr_is_expr<X, typename dualexpr_void<typename X::dualexpr_tag>::type> {
+  enum { value = 1 };
+};
+
+/* 双数是运算数 */
+template <class T> struct dualexpr_operand<dual<T> > {
+  typedef T scalar;
+  typedef dualexpr_leaf<T> node;
+  static node wrap(const dual<T> &x) { return node(x); }
+  static const dual<T> &value(const dual<T> &x) { return x; }
+};
+
+/* 表达式本身也是运算数 */
+template <class X>
+struct dualexpr_operand<X, typename dualexpr_void<typename X::dualexpr_tag>::type> {
+  typedef typename X::scalar scalar;
+  typedef X node;
+  static const X &wrap(const X &x) { return x; }
+  static typename X::dual value(const X &x) { return x.value(); }
+};
+
+/* 双数的赋值运算符(见dualfloat_basic.h)接受元素类型相同的表达式 */
+template <class E, class D>
+struct dualexpr_assign<
+    E, D,
+    typename std::enable_if<dualexpr_is_expr<E>::value &&
+                            std::is_same<typename E::dual, D>::value>::type> {
+  typedef D type;
+};
+
+/* 标量类型为T时运算数X对应的节点,整数等算术类型转换为T */
+template <class X, class T, class Enable = void> struct dualexpr_node {};
+
+template <class X, class T>
+struct dualexpr_node<X, T,
+                     typename std::enable_if<std::is_arithmetic<X>::value>::type> {
+  typedef dualexpr_scalar<T> type;
+  static type wrap(X x) { return type((T)x); }
+  static T value(X x) { return (T)x; }
+};
+
+template <class X, class T>
+struct dualexpr_node<X, T,
+                     typename std::enable_if<std::is_same<
+                         typename dualexpr_operand<X>::scalar, T>::value>::type> {
+  typedef typename dualexpr_operand<X>::node type;
+  static type wrap(const X &x) { return dualexpr_operand<X>::wrap(x); }
+  static typename dual_traits<T>::dual value(const X &x) {
+    return dualexpr_operand<X>::value(x);
+  }
+};
+
+/* 二元运算的标量类型,至少一个运算数为双数或表达式 */
+template <class A, class B, class Enable = void> struct dualexpr_scalar_of {};
+
+template <class A, class B>
+struct dualexpr_scalar_of<
+    A, B, typename dualexpr_void<typename dualexpr_operand<A>::scalar>::type> {
+  typedef typename dualexpr_operand<A>::scalar type;
+};
+
+template <class A, class B>
+struct dualexpr_scalar_of<
+    A, B,
+    typename std::enable_if<
+        std::is_arithmetic<A>::value,
+        typename dualexpr_void<typename dualexpr_operand<B>::scalar>::type>::type> {
+  typedef typename dualexpr_operand<B>::scalar type;
+};
+
+/* 二元运算Op<T,A,B>的结果类型,运算数不合法时没有type */
+template <template <class, class, class> class Op, class A, class B,
+          class Enable = void>
+struct dualexpr_binop {};
+
+template <template <class, class, class> class Op, class A, class B>
+struct dualexpr_binop<
+    Op, A, B,
+    typename dualexpr_void<
+        typename dualexpr_node<A, typename dualexpr_scalar_of<A, B>::type>::type,
+        typename dualexpr_node<B, typename dualexpr_scalar_of<A, B>::type>::type>::
+        type> {
+  typedef typename dualexpr_scalar_of<A, B>::type T;
+  typedef dualexpr_node<A, T> NA;
+  typedef dualexpr_node<B, T> NB;
+  typedef Op<T, typename NA::type, typename NB::type> type;
+  static type make(const A &a, const B &b) {
+    return type(NA::wrap(a), NB::wrap(b));
+  }
+};
+
+/* 比较运算,至少一个运算数为表达式(双数之间的比较见dual_cxx.h) */
+template <class A, class B, class Enable = void> struct dualexpr_cmp {};
+
+template <class A, class B>
+struct dualexpr_cmp<
+    A, B,
+    typename std::enable_if<
+        dualexpr_is_expr<A>::value || dualexpr_is_expr<B>::value,
+        typename dualexpr_void<typename dualexpr_binop<dualexpr_add, A,
+                                                       B>::type>::type>::type> {
+  typedef typename dualexpr_scalar_of<A, B>::type T;
+  typedef dualexpr_node<A, T> NA;
+  typedef dualexpr_node<B, T> NB;
+  typedef bool type;
+};
+
+/* 复合赋值,左边为双数D */
+template <class D, class B, class Enable = void> struct dualexpr_compound {};
+
+template <class D, class B>
+struct dualexpr_compound<
+    D, B,
+    typename std::enable_if<
+        std::is_same<D, typename dual_traits<typename dualexpr_scalar_of<
+                            D, B>::type>::dual>::value,
+        typename dualexpr_void<typename dualexpr_binop<dualexpr_add, D,
+                                                       B>::type>::type>::type> {
+  typedef D &type;
+};
+
+/**
+ * 累加器: hi为高位的无误差加法链,lo为低位的无误差加法链,
+ * err为其余误差项(约为结果的u^2倍)的普通和.
+ * 模板参数F表示第一项,此时直接赋值而不做加法.
+ */
+template <class T> struct dualexpr_acc {
+  typedef dual_traits<T> tr;
+  typedef typename tr::dual dual;
+  T hi, lo, err;
+
+  dualexpr_acc() : hi(0), lo(0), err(0) {}
+
+  template <bool F> void put_hi(T v) {
+    if (F) {
+      hi = v;
+    } else {
+      dual t = tr::two_sum(hi, v);
+      hi = t.hi;
+      put_lo<false>(t.lo);
+    }
+  }
+
+  template <bool F> void put_lo(T v) {
+    if (F) {
+      lo = v;
+    } else {
+      dual t = tr::two_sum(lo, v);
+      lo = t.hi;
+      err += t.lo;
+    }
+  }
+
+  template <bool F> void put(dual x) {
+    put_hi<F>(x.hi);
+    put_lo<F>(x.lo);
+  }
+
+  template <bool F> void put(T x) { put_hi<F>(x); }
+
+  template <bool F> void prod(dual a, dual b) {
+    dual p = tr::two_prod(a.hi, b.hi);
+    put_hi<F>(p.hi);
+#ifdef FAST_DF_OPERATOR
+    put_lo<F>(p.lo + tr::fma(a.lo, b.hi, tr::fma(a.hi, b.lo, a.lo * b.lo)));
+#else
+    dual c1 = tr::two_prod(a.hi, b.lo), c2 = tr::two_prod(a.lo, b.hi);
+    put_lo<F>(p.lo);
+    put_lo<false>(c1.hi);
+    put_lo<false>(c2.hi);
+    err += c1.lo + c2.lo + a.lo * b.lo;
+#endif
+  }
+
+  template <bool F> void prod(dual a, T b) {
+    dual p = tr::two_prod(a.hi, b);
+    put_hi<F>(p.hi);
+#ifdef FAST_DF_OPERATOR
+    put_lo<F>(tr::fma(a.lo, b, p.lo));
+#else
+    dual c = tr::two_prod(a.lo, b);
+    put_lo<F>(p.lo);
+    put_lo<false>(c.hi);
+    err += c.lo;
+#endif
+  }
+
+  template <bool F> void prod(T a, dual b) { prod<F>(b, a); }
+
+  template <bool F> void prod(T a, T b) { put<F>(tr::two_prod(a, b)); }
+
+  /* 同df2mul: 低位先并入高位,余下的低位与误差项相加後再规格化 */
+  dual result() const {
+    dual t = tr::two_sum(hi, lo);
+    return tr::fast_two_sum(t.hi, t.lo + err);
+  }
+};
+
+/* 按符号N取值,取反是精确的 */
+template <bool N, class T> inline T dualexpr_sign(T x) { return N ? -x : x; }
+
+template <bool N, class T>
+inline typename dual_traits<T>::dual
+dualexpr_sign(const typename dual_traits<T>::dual &x) {
+  return N ? dual_traits<T>::neg(x) : x;
+}
+
+/* 乘数: 叶节点直接取值,其余表达式先求值 */
+template <class T>
+inline const typename dual_traits<T>::dual &
+dualexpr_factor(const dualexpr_leaf<T> &x) {
+  return x.v;
+}
+
+template <class T> inline T dualexpr_factor(const dualexpr_scalar<T> &x) {
+  return x.v;
+}
+
+template <class T, class E>
+inline typename dual_traits<T>::dual
+dualexpr_factor(const dualexpr<T, E> &x) {
+  return x.value();
+}
+
+/* 将表达式x(符号N)加入累加器s */
+template <bool N, bool F, class T, class E>
+inline void dualexpr_accum(dualexpr_acc<T> &s, const dualexpr<T, E> &x) {
+  s.template put<F>(dualexpr_sign<N, T>(x.value()));
+}
+
+template <bool N, bool F, class T>
+inline void dualexpr_accum(dualexpr_acc<T> &s, const dualexpr_leaf<T> &x) {
+  s.template put<F>(dualexpr_sign<N, T>(x.v));
+}
+
+template <bool N, bool F, class T>
+inline void dualexpr_accum(dualexpr_acc<T> &s, const dualexpr_scalar<T> &x) {
+  s.template put<F>(dualexpr_sign<N>(x.v));
+}
+
+template <bool N, bool F, class T, class A>
+inline void dualexpr_accum(dualexpr_acc<T> &s, const dualexpr_neg<T, A> &x) {
+  dualexpr_accum<!N, F>(s, x.a);
+}
+
+template <bool N, bool F, class T, class A, class B>
+inline void dualexpr_accum(dualexpr_acc<T> &s, const dualexpr_add<T, A, B> &x) {
+  dualexpr_accum<N, F>(s, x.a);
+  dualexpr_accum<N, false>(s, x.b);
+}
+
+template <bool N, bool F, class T, class A, class B>
+inline void dualexpr_accum(dualexpr_acc<T> &s, const dualexpr_sub<T, A, B> &x) {
+  dualexpr_accum<N, F>(s, x.a);
+  dualexpr_accum<!N, false>(s, x.b);
+}
+
+template <bool N, bool F, class T, class A, class B>
+inline void dualexpr_accum(dualexpr_acc<T> &s, const dualexpr_mul<T, A, B> &x) {
+  s.template prod<F>(dualexpr_sign<N, T>(dualexpr_factor(x.a)),
+                     dualexpr_factor(x.b));
+}
+
+/* X是否为叶节点(双数或标量) */
+template <class X> struct dualexpr_is_leaf {
+  enum { value = 0 };
+};
+
+template <class T> struct dualexpr_is_leaf<dualexpr_leaf<T> > {
+  enum { value = 1 };
+};
+
+template <class T> struct dualexpr_is_leaf<dualexpr_scalar<T> > {
+  enum { value = 1 };
+};
+
+/* 两个运算数均为叶节点时的结果类型 */
+template <class T, class A, class B>
+struct dualexpr_leaves
+    : std::enable_if<dualexpr_is_leaf<A>::value && dualexpr_is_leaf<B>::value,
+                     typename dual_traits<T>::dual> {};
+
+/* 一次运算,单数在前的加法与乘法交换运算数 */
+template <class T>
+inline typename dual_traits<T>::dual
+dualexpr_add1(const typename dual_traits<T>::dual &a,
+              const typename dual_traits<T>::dual &b) {
+  return dual_traits<T>::add(a, b);
+}
+
+template <class T>
+inline typename dual_traits<T>::dual
+dualexpr_add1(const typename dual_traits<T>::dual &a, T b) {
+  return dual_traits<T>::add(a, b);
+}
+
+template <class T>
+inline typename dual_traits<T>::dual
+dualexpr_add1(T a, const typename dual_traits<T>::dual &b) {
+  return dual_traits<T>::add(b, a);
+}
+
+template <class T>
+inline typename dual_traits<T>::dual
+dualexpr_mul1(const typename dual_traits<T>::dual &a,
+              const typename dual_traits<T>::dual &b) {
+  return dual_traits<T>::mul(a, b);
+}
+
+template <class T>
+inline typename dual_traits<T>::dual
+dualexpr_mul1(const typename dual_traits<T>::dual &a, T b) {
+  return dual_traits<T>::mul(a, b);
+}
+
+template <class T>
+inline typename dual_traits<T>::dual
+dualexpr_mul1(T a, const typename dual_traits<T>::dual &b) {
+  return dual_traits<T>::mul(b, a);
+}
+
+/* 求值 */
+template <class T, class E>
+inline typename dual_traits<T>::dual dualexpr_eval(const dualexpr<T, E> &x) {
+  dualexpr_acc<T> s;
+  dualexpr_accum<false, true>(s, x.self());
+  return s.result();
+}
+
+template <class T>
+inline typename dual_traits<T>::dual dualexpr_eval(const dualexpr_leaf<T> &x) {
+  return x.v;
+}
+
+/* 只有一次运算的表达式直接调用对应的运算 */
+template <class T, class A, class B>
+inline typename dualexpr_leaves<T, A, B>::type
+dualexpr_eval(const dualexpr_add<T, A, B> &x) {
+  return dualexpr_add1<T>(dualexpr_factor(x.a), dualexpr_factor(x.b));
+}
+
+template <class T, class A, class B>
+inline typename dualexpr_leaves<T, A, B>::type
+dualexpr_eval(const dualexpr_sub<T, A, B> &x) {
+  return dual_traits<T>::sub(dualexpr_factor(x.a), dualexpr_factor(x.b));
+}
+
+template <class T, class A, class B>
+inline typename dualexpr_leaves<T, A, B>::type
+dualexpr_eval(const dualexpr_mul<T, A, B> &x) {
+  return dualexpr_mul1<T>(dualexpr_factor(x.a), dualexpr_factor(x.b));
+}
+
+template <class T, class A, class B>
+inline typename dual_traits<T>::dual
+dualexpr_eval(const dualexpr_div<T, A, B> &x) {
+  return dual_traits<T>::div(dualexpr_factor(x.a), dualexpr_factor(x.b));
+}
+
+template <class T, class E>
+inline typename dualexpr<T, E>::dual dualexpr<T, E>::value() const {
+  return dualexpr_eval(self());
+}
+
+/* 运算符 */
+template <class A, class B>
+inline typename dualexpr_binop<dualexpr_add, A, B>::type operator+(const A &a,
+                                                                   const B &b) {
+  return dualexpr_binop<dualexpr_add, A, B>::make(a, b);
+}
+
+template <class A, class B>
+inline typename dualexpr_binop<dualexpr_sub, A, B>::type operator-(const A &a,
+                                                                   const B &b) {
+  return dualexpr_binop<dualexpr_sub, A, B>::make(a, b);
+}
+
+template <class A, class B>
+inline typename dualexpr_binop<dualexpr_mul, A, B>::type operator*(const A &a,
+                                                                   const B &b) {
+  return dualexpr_binop<dualexpr_mul, A, B>::make(a, b);
+}
+
+template <class A, class B>
+inline typename dualexpr_binop<dualexpr_div, A, B>::type operator/(const A &a,
+                                                                   const B &b) {
+  return dualexpr_binop<dualexpr_div, A, B>::make(a, b);
+}
+
+template <class A>
+inline dualexpr_neg<typename dualexpr_operand<A>::scalar,
+                    typename dualexpr_operand<A>::node>
+operator-(const A &a) {
+  return dualexpr_neg<typename dualexpr_operand<A>::scalar,
+                      typename dualexpr_operand<A>::node>(
+      dualexpr_operand<A>::wrap(a));
+}
+
+template <class D, class B>
+inline typename dualexpr_compound<D, B>::type operator+=(D &a, const B &b) {
+  return a = (a + b).value();
+}
+
+template <class D, class B>
+inline typename dualexpr_compound<D, B>::type operator-=(D &a, const B &b) {
+  return a = (a - b).value();
+}
+
+template <class D, class B>
+inline typename dualexpr_compound<D, B>::type operator*=(D &a, const B &b) {
+  return a = (a * b).value();
+}
+
+template <class D, class B>
+inline typename dualexpr_compound<D, B>::type operator/=(D &a, const B &b) {
+  return a = (a / b).value();
+}
+
+#define DUALEXPR_CMP(op)                                                       \
+  template <class A, class B>                                                  \
+  inline typename dualexpr_cmp<A, B>::type operator op(const A &a,             \
+                                                       const B &b) {           \
+    return dualexpr_cmp<A, B>::NA::value(a) op dualexpr_cmp<A, B>::NB::value(b); \
+  }
+DUALEXPR_CMP(==)
+DUALEXPR_CMP(!=)
+DUALEXPR_CMP(<)
+DUALEXPR_CMP(>)
+DUALEXPR_CMP(<=)
+DUALEXPR_CMP(>=)
+#undef DUALEXPR_CMP
+
+#endif
+#endif // !_DUALFLOAT_BASIC_H_
@@ -7,11 +7,20 @@
  * by 杨玉军, 2021/11/20.
  */
 
-/* __FMA__宏,适用于x86-CPU启用融合乘加指令 */
-#ifndef __FMA__
+/*
+ * __FMA__宏,适用于x86-CPU启用融合乘加指令,
+ * MSVC没有此宏因此在这里定义,GCC与Clang由-mfma等选项定义
+ */
+#if !defined(__FMA__) && defined(_MSC_VER)
 #define __FMA__
 #endif
 
+/*
+ * DUALFLOAT_USER_CONFIG宏,定义则不使用以下FP_FMA_INTRINS至USE_BRANCHLESS_ADD的
+ * 默认设置,改由使用者(如编译选项-D)定义,以便同一程序按不同配置编译
+ */
+#ifndef DUALFLOAT_USER_CONFIG
+
 /*
  * FP_FMA_INTRINS值1则使用FMA指令(x86)非x86平台则尝试math库的fma函数,
  * 其他值则使用math库的fma函数,未定义则不使用FMA加速
@@ -27,6 +36,7 @@
 /*
  * FAST_DF_OPERATOR宏,定义则运算符重载快速版本的双数运算(精度略低),
  * 未定义则重载达到精度要求的版本(误差等于或略大于0.5ulps)
+ * C++中还可以dual_t<T,P>为每个变量单独指定精度等级(见dual_cxx.h)
  */
 #define FAST_DF_OPERATOR
 
@@ -36,8 +46,30 @@
  */
 #define USE_BRANCH_DADD
 
+/*
+ * USE_BRANCHLESS_ADD宏,定义则加减法(dadd,dfadd,df2add等)使用无分支的b*版本
+ * (Knuth TwoSum与按绝对值的大小选择,结果与分支版本逐位相同),
+ * 适合符号与数量级随机而分支难以预测的数据,此时忽略USE_BRANCH_DADD
+ */
+//#define USE_BRANCHLESS_ADD
+
+#endif
+
+/* DF_ACC_RENORM宏,累加器(dfacc_add)每累加多少项规格化一次 */
+#define DF_ACC_RENORM 16
+
+/*
+ * DF_EXPR_TEMPLATE宏,定义则C++的运算符构造表达式模板(见dualexpr_cxx.h),
+ * 多项的表达式一次求值;运算结果不再是双数类型,与已有代码可能不兼容
+ */
+//#define DF_EXPR_TEMPLATE
+
+#include <limits.h>
+#include <math.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
+#include <string.h>
 #if (defined(__x86_64__) || defined(_M_X64) || defined(i386) ||                \
      defined(__i386__) || defined(__i386) || defined(_M_IX86)) &&              \
     defined(__FMA__)
@@ -48,6 +80,36 @@
 #define FP_FMA_INTRINS 2
 #endif
 
+/*
+ * C++20中DF_CONSTEXPR为constexpr,双数运算可在编译期求值以得到常量:
+ * 编译期以std::bit_cast读取浮点数的位,以软件算法代替FMA与SIMD指令,
+ * 结果与运行时逐位相同(编译期的乘法余数不处理溢出与非规格化数).
+ */
+#if defined(__cplusplus) &&                                                    \
+    (__cplusplus >= 202002L || (defined(_MSVC_LANG) && _MSVC_LANG >= 202002L))
+#include <bit>
+#include <type_traits>
+#endif
+#if defined(__cpp_lib_bit_cast) && defined(__cpp_lib_is_constant_evaluated)
+#define DF_CONSTEXPR constexpr
+#define DF_CONSTDATA constexpr
+#define DF_CONSTEVAL() std::is_constant_evaluated()
+#else
+#define DF_CONSTEXPR
+#define DF_CONSTDATA const
+#define DF_CONSTEVAL() 0
+#endif
+
+/*
+ * 库函数的存储类: C的inline函数没有外部定义,未被内联的调用(如冷路径中的调用)
+ * 无法链接,因此C中为static inline;C++中为inline(C++20为constexpr inline)
+ */
+#if defined(__cplusplus) || defined(c_plusplus)
+#define DF_INLINE DF_CONSTEXPR inline
+#else
+#define DF_INLINE static inline
+#endif
+
 /* define byte order macro */
 #if defined(__BYTE_ORDER) && __BYTE_ORDER == __BIG_ENDIAN ||                   \
     defined(__BIG_ENDIAN__) || defined(__ARMEB__) || defined(__THUMBEB__) ||   \
@@ -71,6 +133,29 @@
 #error "I don't know what architecture this is!"
 #endif
 
+#if defined(__cplusplus) || defined(c_plusplus)
+/* 表达式模板的赋值,由dualexpr_cxx.h特化 */
+template <class E, class D, class Enable = void> struct dualexpr_assign {};
+
+/* 双数,T为float或double,与C的dualfloat/dualdouble结构相同 */
+template <class T> struct dual {
+  T hi;
+  T lo;
+  operator T() { return hi + lo; }
+  dual &operator=(T a) {
+    hi = a;
+    lo = 0;
+    return *this;
+  }
+  template <class E>
+  typename dualexpr_assign<E, dual>::type &operator=(const E &e) {
+    return *this = e.value();
+  }
+};
+
+typedef dual<float> dualfloat;
+typedef dual<double> dualdouble;
+#else
 typedef struct dualfloat {
 #ifdef __LITTLE_ENDIAN__
   float hi;
@@ -80,14 +165,6 @@ typedef struct dualfloat {
   float hi; // should load in simd registers low bits.
   float lo;
 #endif
-#if defined(__cplusplus) || defined(c_plusplus)
-  operator float() { return hi + lo; }
-  dualfloat &operator=(float a) {
-    hi = a;
-    lo = 0.0f;
-    return *this;
-  }
-#endif
 } dualfloat;
 
 typedef struct dualdouble {
@@ -99,19 +176,12 @@ typedef struct dualdouble {
   double hi; // should load in simd registers low bits.
   double lo;
 #endif
-#if defined(__cplusplus) || defined(c_plusplus)
-  operator double() { return hi + lo; }
-  dualdouble &operator=(double a) {
-    hi = a;
-    lo = 0.0;
-    return *this;
-  }
-#endif
 } dualdouble;
+#endif
 
 typedef dualdouble quadfloat;
 
-inline long dual_likely(long x) {
+DF_INLINE long dual_likely(long x) {
 #if defined(__GNUC__) && defined(__has_builtin)
 #if __has_builtin(__builtin_expect)
   return __builtin_expect(!!(x), 1);
@@ -128,8 +198,157 @@ inline long dual_likely(long x) {
   return !!x;
 }
 
+/* 不内联: 很少执行的慢速路径不增大调用者的代码与栈帧 */
+#if defined(__GNUC__)
+#define DF_NOINLINE __attribute__((noinline))
+#elif defined(_MSC_VER)
+#define DF_NOINLINE __declspec(noinline)
+#else
+#define DF_NOINLINE
+#endif
+
+/*
+ * 不内联的库函数的声明: C中noinline与inline冲突,因此为static;C++中为inline,
+ * 以免具有外部链接的inline函数在各编译单元中引用不同的static函数(违反ODR)
+ */
+#if defined(__cplusplus) || defined(c_plusplus)
+#define DF_SLOWPATH DF_NOINLINE DF_CONSTEXPR inline
+#else
+#define DF_SLOWPATH static DF_NOINLINE
+#endif
+
+/*
+ * DUAL_STATS宏,定义则在各函数的分支处计数(默认不定义,计数代码完全不编译),
+ * 用于统计实际数据下罕见分支,二次规格化与特殊值的命中次数.
+ * 计数器按线程分开(thread_local),以dual_stats_snapshot读取当前线程的计数,
+ * dual_stats_reset清零. C++17以上计数器为inline变量无须定义,
+ * C与较早的C++须在某一个源文件的全局作用域写一次DUAL_STATS_DEFINE.
+ * 编译期求值(C++20 constexpr)不计数.
+ */
+
+/*
+ * 计数器列表X(函数名,事件),每项对应double与float两个计数器,
+ * 名称为"函数名_事件"与"函数名f_事件"(如dadd_swap与daddf_swap),
+ * call为调用次数,其他事件的比例以call为分母.
+ */
+#define DUAL_STATS_LIST(X)                                                     \
+  X(dadd, call)          /* USE_BRANCH_DADD时的dadd */                         \
+  X(dadd, swap)          /* |a|<|b|而交换 */                                   \
+  X(dsub, call)          /* USE_BRANCH_DADD时的dsub */                         \
+  X(dsub, swap)          /* |a|<|b|而交换 */                                   \
+  X(df2reorder, call)    /* 重排 */                                            \
+  X(df2reorder, swap)    /* 高位交换 */                                        \
+  X(df2reorder, loswap)  /* x.lo与y.hi再次比较後交换 */                        \
+  X(dfadd, call)         /* 双数与单数相加 */                                  \
+  X(dfadd, big)          /* b不小于a.hi */                                     \
+  X(dfadd, small)        /* b不大于a.lo */                                     \
+  X(dfsub, call)         /* 双数与单数相减 */                                  \
+  X(dfsub, big)          /* b不小于a.hi */                                     \
+  X(dfsub, small)        /* b不大于a.lo */                                     \
+  X(dfsubr, call)        /* 单数与双数相减 */                                  \
+  X(dfsubr, big)         /* a不小于b.hi */                                     \
+  X(dfsubr, small)       /* a不大于b.lo */                                     \
+  X(df2add, call)        /* 双数加法 */                                        \
+  X(df2add, lo0)         /* 规格化後低位为0的慢路径 */                         \
+  X(df2sub, call)        /* 双数减法 */                                        \
+  X(df2sub, lo0)         /* 规格化後低位为0的慢路径 */                         \
+  X(dfmul, call)         /* 双数与单数相乘 */                                  \
+  X(dfmul, renorm)       /* 低位积较大而再次规格化 */                          \
+  X(dfsqrt, call)        /* 双数开平方 */                                      \
+  X(dfsqrt, special)     /* 0,负数,无穷大与NaN */                              \
+  X(dffmod, call)        /* 截断余数 */                                        \
+  X(dffmod, special)     /* b为0或无穷大,a为无穷大或NaN */                     \
+  X(dfremquo, call)      /* 就近余数 */                                        \
+  X(dfremquo, special)   /* b为0或无穷大,a为无穷大或NaN */                     \
+  X(dfrem_loop, iter)    /* 余数的减法步数 */                                  \
+  X(dfrem_loop, scale)   /* 商较大而放大除数的步数 */                          \
+  X(dfacc_norm, call)    /* 累加器规格化 */                                    \
+  X(cdf2add, call)       /* 正确舍入的双数加减法 */                            \
+  X(cdf2add, slow)       /* 不能确定舍入而精确规格化 */                        \
+  X(cdf2mul, call)       /* 正确舍入的双数乘法 */                              \
+  X(cdf2mul, slow)       /* 不能确定舍入而精确规格化 */                        \
+  X(cdf2div, call)       /* 正确舍入的双数除法 */                              \
+  X(cdf2div, slow)       /* 不能确定舍入而以精确余数修正 */                    \
+  X(df_distill, pass)    /* 精确规格化的遍数 */                                \
+  X(vdffmod, block)      /* 批量截断余数的SIMD块 */                            \
+  X(vdffmod, scalar)     /* 商较大而改用标量的块 */                            \
+  X(vdfremquo, block)    /* 批量就近余数的SIMD块 */                            \
+  X(vdfremquo, scalar)   /* 商较大而改用标量的块 */
+
+/* 计数器编号dual_stat_函数名_事件,dual_stat_count为计数器个数 */
+#define DUAL_STAT_ENUM(fn, ev) dual_stat_##fn##_##ev, dual_stat_##fn##f_##ev,
+typedef enum dual_stat_id {
+  DUAL_STATS_LIST(DUAL_STAT_ENUM) dual_stat_count
+} dual_stat_id;
+#undef DUAL_STAT_ENUM
+
+/* 各计数器的值 */
+typedef struct dual_stats {
+  uint64_t count[dual_stat_count];
+} dual_stats;
+
+#ifdef DUAL_STATS
+#if defined(__cplusplus) && defined(__cpp_inline_variables)
+inline thread_local dual_stats dual_stats_tls;
+#define DUAL_STATS_DEFINE
+#else
+#if defined(__cplusplus)
+#define DUAL_STATS_TLS thread_local
+#elif defined(_MSC_VER)
+#define DUAL_STATS_TLS __declspec(thread)
+#else
+#define DUAL_STATS_TLS _Thread_local
+#endif
+extern DUAL_STATS_TLS dual_stats dual_stats_tls;
+#define DUAL_STATS_DEFINE DUAL_STATS_TLS dual_stats dual_stats_tls;
+#endif
+/* 计数器id加1,编译期求值时不计数 */
+#define DUAL_STAT(id) ((void)(DF_CONSTEVAL() || ++dual_stats_tls.count[id]))
+/* 条件c成立时计数器id加1,供无分支的选择代码计数 */
+#define DUAL_STAT_IF(c, id)                                                    \
+  ((void)(DF_CONSTEVAL() || !(c) || ++dual_stats_tls.count[id]))
+#else
+#define DUAL_STATS_DEFINE
+#define DUAL_STAT(id) ((void)0)
+#define DUAL_STAT_IF(c, id) ((void)0)
+#endif
+
+/* 在dualimpl.h等类型无关实现中以DF_N(fn)的计数器名计数 */
+#define DF_STAT(fn, ev) DUAL_STAT(DF_STAT_ID(DF_N(fn), ev))
+#define DF_STAT_IF(c, fn, ev) DUAL_STAT_IF(c, DF_STAT_ID(DF_N(fn), ev))
+#define DF_STAT_ID(fn, ev) DF_STAT_ID2(fn, ev)
+#define DF_STAT_ID2(fn, ev) dual_stat_##fn##_##ev
+
+/* 读取当前线程的计数器(未定义DUAL_STATS时全为0) */
+static inline void dual_stats_snapshot(dual_stats *s) {
+#ifdef DUAL_STATS
+  *s = dual_stats_tls;
+#else
+  int i;
+  for (i = 0; i < dual_stat_count; i++)
+    s->count[i] = 0;
+#endif
+}
+
+/* 将当前线程的计数器清零 */
+static inline void dual_stats_reset(void) {
+#ifdef DUAL_STATS
+  int i;
+  for (i = 0; i < dual_stat_count; i++)
+    dual_stats_tls.count[i] = 0;
+#endif
+}
+
+/* 计数器的名称,如"df2add_lo0",id无效时返回NULL */
+static inline const char *dual_stats_name(int id) {
+#define DUAL_STAT_NAME(fn, ev) #fn "_" #ev, #fn "f_" #ev,
+  static const char *const names[] = {DUAL_STATS_LIST(DUAL_STAT_NAME)};
+#undef DUAL_STAT_NAME
+  return id >= 0 && id < dual_stat_count ? names[id] : NULL;
+}
+
 /* 构造双数 */
-inline dualfloat ddualf(float hi, float lo) {
+DF_INLINE dualfloat ddualf(float hi, float lo) {
   dualfloat ret;
   ret.hi = hi;
   ret.lo = lo;
@@ -137,7 +356,7 @@ inline dualfloat ddualf(float hi, float lo) {
 }
 
 /* 构造双数 */
-inline dualdouble ddual(double hi, double lo) {
+DF_INLINE dualdouble ddual(double hi, double lo) {
   dualdouble ret;
   ret.hi = hi;
   ret.lo = lo;
@@ -145,17 +364,83 @@ inline dualdouble ddual(double hi, double lo) {
 }
 
 /* 取反 */
-inline dualfloat dfnegf(dualfloat x) { return ddualf(-x.hi, -x.lo); }
+DF_INLINE dualfloat dfnegf(dualfloat x) {
+  return ddualf(-x.hi, -x.lo);
+}
 
 /* 取反 */
-inline dualdouble dfneg(dualdouble x) { return ddual(-x.hi, -x.lo); }
+DF_INLINE dualdouble dfneg(dualdouble x) {
+  return ddual(-x.hi, -x.lo);
+}
+
+/*
+ * 浮点数与其位表示的转换: C++20以std::bit_cast(可在编译期求值),
+ * 否则以memcpy(不违反严格别名规则,编译器将其优化为寄存器间的移动,
+ * 也不妨碍含这些函数的循环自动向量化)
+ */
+
+/* float的位表示 */
+DF_INLINE uint32_t df_asuintf(float a) {
+#ifdef __cpp_lib_bit_cast
+  return std::bit_cast<uint32_t>(a);
+#else
+  uint32_t r;
+  memcpy(&r, &a, sizeof(r));
+  return r;
+#endif
+}
+
+/* double的位表示 */
+DF_INLINE uint64_t df_asuint(double a) {
+#ifdef __cpp_lib_bit_cast
+  return std::bit_cast<uint64_t>(a);
+#else
+  uint64_t r;
+  memcpy(&r, &a, sizeof(r));
+  return r;
+#endif
+}
+
+/* 位表示转为float */
+DF_INLINE float df_asfloat(uint32_t a) {
+#ifdef __cpp_lib_bit_cast
+  return std::bit_cast<float>(a);
+#else
+  float r;
+  memcpy(&r, &a, sizeof(r));
+  return r;
+#endif
+}
+
+/* 位表示转为double */
+DF_INLINE double df_asdouble(uint64_t a) {
+#ifdef __cpp_lib_bit_cast
+  return std::bit_cast<double>(a);
+#else
+  double r;
+  memcpy(&r, &a, sizeof(r));
+  return r;
+#endif
+}
+
+/* c为真时返回a否则返回b,以位掩码选择,编译器不会生成分支 */
+DF_INLINE float df_selectf(bool c, float a, float b) {
+  uint32_t m = 0u - (uint32_t)c;
+  return df_asfloat((df_asuintf(a) & m) | (df_asuintf(b) & ~m));
+}
+
+/* c为真时返回a否则返回b,以位掩码选择,编译器不会生成分支 */
+DF_INLINE double df_select(bool c, double a, double b) {
+  uint64_t m = (uint64_t)0 - (uint64_t)c;
+  return df_asdouble((df_asuint(a) & m) | (df_asuint(b) & ~m));
+}
 
 /*
  * 返回能比较浮点的erp(相当于ulp,最小精度单位)的标志,
  * 如:erpmarkf(a)>erpmarkf(b),在erp(a)<erp(b)时值为false.
  */
-inline uint32_t erpmarkf(float a) {
-  uint32_t ia = *(uint32_t *)&a;
+DF_INLINE uint32_t erpmarkf(float a) {
+  uint32_t ia = df_asuintf(a);
   return ia + ia;
 }
 
@@ -163,22 +448,29 @@ inline uint32_t erpmarkf(float a) {
  * 返回能比较浮点的erp(相当于ulp,最小精度单位)的标志,
  * 如:erpmark(a)>erpmark(b),在erp(a)<erp(b)时值为false.
  */
-inline size_t erpmark(double a) {
+DF_INLINE size_t erpmark(double a) {
   size_t ia;
   if (sizeof(ia) == 4)
-#ifdef __LITTLE_ENDIAN__
-    ia = ((uint32_t *)&a)[1];
-#elif defined(__BIG_ENDIAN__)
-    ia = ((uint32_t *)&a)[0];
-#endif
-  else if (sizeof(ia) == 8)
-    ia = *(uint64_t *)&a;
-  // else assert(0);
+    ia = (size_t)(df_asuint(a) >> 32); // 高32位
+  else
+    ia = (size_t)df_asuint(a);
   return ia + ia;
 }
 
+/* 按erp无分支地排序两个float: hi为erp较大者(相等时为a),lo为较小者 */
+DF_INLINE dualfloat dmagsortf(float a, float b) {
+  bool ge = erpmarkf(a) >= erpmarkf(b);
+  return ddualf(df_selectf(ge, a, b), df_selectf(ge, b, a));
+}
+
+/* 按erp无分支地排序两个double: hi为erp较大者(相等时为a),lo为较小者 */
+DF_INLINE dualdouble dmagsort(double a, double b) {
+  bool ge = erpmark(a) >= erpmark(b);
+  return ddual(df_select(ge, a, b), df_select(ge, b, a));
+}
+
 /* 规格化dualfloat */
-inline dualfloat dfnormf(dualfloat x) {
+DF_INLINE dualfloat dfnormf(dualfloat x) {
   dualfloat ret;
   ret.hi = x.hi + x.lo;
   ret.lo = x.lo + (x.hi - ret.hi);
@@ -186,7 +478,7 @@ inline dualfloat dfnormf(dualfloat x) {
 }
 
 /* 低位部分取反并规格化dualfloat */
-inline dualfloat dfnlonormf(dualfloat x) {
+DF_INLINE dualfloat dfnlonormf(dualfloat x) {
   dualfloat ret;
   ret.hi = x.hi - x.lo;
   ret.lo = (x.hi - ret.hi) - x.lo;
@@ -194,7 +486,7 @@ inline dualfloat dfnlonormf(dualfloat x) {
 }
 
 /* 高位部分取反并规格化dualfloat */
-inline dualfloat dfnhinormf(dualfloat x) {
+DF_INLINE dualfloat dfnhinormf(dualfloat x) {
   dualfloat ret;
   ret.hi = x.lo - x.hi;
   ret.lo = x.lo - (x.hi + ret.hi);
@@ -202,7 +494,7 @@ inline dualfloat dfnhinormf(dualfloat x) {
 }
 
 /* 规格化dualdouble */
-inline dualdouble dfnorm(dualdouble x) {
+DF_INLINE dualdouble dfnorm(dualdouble x) {
   dualdouble ret;
   ret.hi = x.hi + x.lo;
   ret.lo = x.lo + (x.hi - ret.hi);
@@ -210,7 +502,7 @@ inline dualdouble dfnorm(dualdouble x) {
 }
 
 /* 低位部分取反并规格化dualdouble */
-inline dualdouble dfnlonorm(dualdouble x) {
+DF_INLINE dualdouble dfnlonorm(dualdouble x) {
   dualdouble ret;
   ret.hi = x.hi - x.lo;
   ret.lo = (x.hi - ret.hi) - x.lo;
@@ -218,7 +510,7 @@ inline dualdouble dfnlonorm(dualdouble x) {
 }
 
 /* 高位部分取反并规格化dualdouble */
-inline dualdouble dfnhinorm(dualdouble x) {
+DF_INLINE dualdouble dfnhinorm(dualdouble x) {
   dualdouble ret;
   ret.hi = x.lo - x.hi;
   ret.lo = x.lo - (x.hi + ret.hi);
@@ -226,41 +518,68 @@ inline dualdouble dfnhinorm(dualdouble x) {
 }
 
 /* 分割float以进行无损乘法 */
-inline dualfloat df_split_float(float a) {
+DF_INLINE dualfloat df_split_float(float a) {
   dualfloat ret;
-  int32_t ix = *(int32_t *)&a;
-  ix &= (-1 << 12); // 12=(23+2)/2
-  ret.lo = a - *(float *)&ix;
+  uint32_t ix = df_asuintf(a);
+  ix &= 0xfffff000u; // 12=(23+2)/2
+  ret.lo = a - df_asfloat(ix);
   ret.hi = a - ret.lo; // prevent DAZ
   return ret;
 }
 
 /* 分割double以进行无损乘法 */
-inline dualdouble df_split_double(double a) {
+DF_INLINE dualdouble df_split_double(double a) {
   dualdouble ret;
-  static const int64_t cvt_const = 0x3fa8000000000000LL;
-  int64_t ix = *(int64_t *)&a;
-  int64_t ie = ix & (-1LL << 52);        // 取阶码和符号
-  int32_t it = (int32_t)ix << (32 - 27); // 27=(52+2)/2
-  if (it < 0) {                          // 如果高位非0,需要进位取反
-    ie ^= (1LL << 63);
-    it = -it; // 即使it为最小负数也没问题
+  const int64_t cvt_const = 0x3fa8000000000000LL;
+  int64_t ix = (int64_t)df_asuint(a);
+  int64_t ie = ix & (int64_t)0xfff0000000000000ULL; // 取阶码和符号
+  int32_t it = (int32_t)((uint32_t)ix << (32 - 27)); // 27=(52+2)/2
+  if (it < 0) { // 如果高位非0,需要进位取反
+    ie ^= INT64_MIN;
+    it = (int32_t)(0u - (uint32_t)it); // 即使it为最小负数也没问题
   }
   ix = cvt_const | it; // 进行转换,不会溢出
-  ret.lo = *(double *)&ie * (*(double *)&ix - *(double *)&cvt_const); // 2^(-57)
+  ret.lo = df_asdouble((uint64_t)ie) * // 2^(-57)
+           (df_asdouble((uint64_t)ix) - df_asdouble((uint64_t)cvt_const));
   ret.hi = a - ret.lo; // ret.lo可能会下溢
   return ret;
 }
 
+/* float相乘的积与余数(以double精确计算),供编译期求值 */
+DF_INLINE dualfloat dmulf_soft(float a, float b) {
+  dualfloat ret;
+  ret.hi = a * b;
+  ret.lo = (float)((double)a * b - ret.hi);
+  return ret;
+}
+
+/* double相乘的积与余数(Dekker分割),供编译期求值,不处理溢出 */
+DF_INLINE dualdouble dmul_soft(double a, double b) {
+  const double split = 134217729.0; // 2^27+1
+  double ta = split * a, tb = split * b;
+  double ah = ta - (ta - a), al = a - ah;
+  double bh = tb - (tb - b), bl = b - bh;
+  dualdouble ret;
+  ret.hi = a * b;
+  ret.lo = ((ah * bh - ret.hi) + ah * bl + al * bh) + al * bl;
+  return ret;
+}
+
 /**
  * 计算a*b-c并只进行一次舍入,要求c近似于a*b且正负同号(误差2^-17)
  * 可以用来计算浮点乘法的余数,例如:fmulsubf_lim(a,b,a*b)
  * 正确处理了溢出但不适用非规格化数
  */
-inline float fmulsubf_lim(float a, float b, float c) {
+DF_INLINE float fmulsubf_lim(float a, float b, float c) {
+  if (DF_CONSTEVAL())
+    return (float)((double)a * b - c);
 #if FP_FMA_INTRINS == 1
+#ifdef __GNUC__
+  return __builtin_fmaf(a, b, -c);
+#else
   __m128 ret = _mm_fmsub_ss(_mm_set_ss(a), _mm_set_ss(b), _mm_set_ss(c));
   return _mm_cvtss_f32(ret);
+#endif
 #elif FP_FMA_INTRINS == 2
   return fmaf(a, b, -c);
 #elif USE_DF_SPLIT_FMA
@@ -274,14 +593,14 @@ inline float fmulsubf_lim(float a, float b, float c) {
   float ra, rc; // o=17~20
   int32_t ap, bp, cp, am, bm, cm;
   int shift;
-  ap = *(int32_t *)&a;
-  bp = *(int32_t *)&b;
-  cp = *(int32_t *)&c;
+  ap = (int32_t)df_asuintf(a);
+  bp = (int32_t)df_asuintf(b);
+  cp = (int32_t)df_asuintf(c);
   /* 取阶码和符号 */
   am = ap & 0xff800000;
   bm = bp & 0xff800000;
   cm = cp & 0xff800000;
-  rc = *(float *)&cm;
+  rc = df_asfloat((uint32_t)cm);
   /* 取尾数 */
   ap &= 0x7fffff;
   bp &= 0x7fffff;
@@ -292,13 +611,13 @@ inline float fmulsubf_lim(float a, float b, float c) {
   if (!dual_likely(c == c))
     return c;
   /* 规格化处理 */
-  if (dual_likely(am << 1))
+  if (dual_likely((uint32_t)am << 1))
     ap |= 0x800000;
   else { // 处理非规格化数
     while ((ap <<= 1) < 0x800000)
       am -= 0x800000;
   }
-  if (dual_likely(bm << 1))
+  if (dual_likely((uint32_t)bm << 1))
     bp |= 0x800000;
   else {
     while ((bp <<= 1) < 0x800000)
@@ -311,11 +630,11 @@ inline float fmulsubf_lim(float a, float b, float c) {
   /* 计算移位 */
   am = am + bm - cm;
   shift = 150 - (am >> 23);
-  cp <<= shift;
+  cp = (int32_t)((uint32_t)cp << shift);
   am += 0xe9000000;
-  rc *= *(float *)&am;
+  rc *= df_asfloat((uint32_t)am);
   /* 计算误差 */
-  ap = ap * bp - cp;
+  ap = (int32_t)((uint32_t)ap * (uint32_t)bp - (uint32_t)cp);
   ra = (float)ap;
   /* 浮点乘法上阶码,能正确处理溢出 */
   ra *= rc; //上阶码,防止溢出
@@ -328,10 +647,16 @@ inline float fmulsubf_lim(float a, float b, float c) {
  * 可以用来计算浮点乘法的余数,例如:nfmulsubf_lim(a,b,a*b)
  * 正确处理了溢出但不适用非规格化数
  */
-inline float nfmulsubf_lim(float a, float b, float c) {
+DF_INLINE float nfmulsubf_lim(float a, float b, float c) {
+  if (DF_CONSTEVAL())
+    return (float)(c - (double)a * b);
 #if FP_FMA_INTRINS == 1
+#ifdef __GNUC__
+  return __builtin_fmaf(-a, b, c);
+#else
   __m128 ret = _mm_fnmadd_ss(_mm_set_ss(a), _mm_set_ss(b), _mm_set_ss(c));
   return _mm_cvtss_f32(ret);
+#endif
 #elif FP_FMA_INTRINS == 2
   return fmaf(-a, b, c);
 #elif USE_DF_SPLIT_FMA
@@ -345,14 +670,14 @@ inline float nfmulsubf_lim(float a, float b, float c) {
   float ra, rc; // o=17~20
   int32_t ap, bp, cp, am, bm, cm;
   int shift;
-  ap = *(int32_t *)&a;
-  bp = *(int32_t *)&b;
-  cp = *(int32_t *)&c;
+  ap = (int32_t)df_asuintf(a);
+  bp = (int32_t)df_asuintf(b);
+  cp = (int32_t)df_asuintf(c);
   /* 取阶码和符号 */
   am = ap & 0xff800000;
   bm = bp & 0xff800000;
   cm = cp & 0xff800000;
-  rc = *(float *)&cm;
+  rc = df_asfloat((uint32_t)cm);
   /* 取尾数 */
   ap &= 0x7fffff;
   bp &= 0x7fffff;
@@ -361,13 +686,13 @@ inline float nfmulsubf_lim(float a, float b, float c) {
     return rc;
   if (!dual_likely(c == c))
     return c;
-  if (dual_likely(am << 1))
+  if (dual_likely((uint32_t)am << 1))
     ap |= 0x800000;
   else { //处理非规格化数
     while ((ap <<= 1) < 0x800000)
       am -= 0x800000;
   }
-  if (dual_likely(bm << 1))
+  if (dual_likely((uint32_t)bm << 1))
     bp |= 0x800000;
   else { //处理非规格化数
     while ((bp <<= 1) < 0x800000)
@@ -380,11 +705,11 @@ inline float nfmulsubf_lim(float a, float b, float c) {
   /* 计算移位 */
   am = am + bm - cm;
   shift = 150 - (am >> 23);
-  cp <<= shift;
+  cp = (int32_t)((uint32_t)cp << shift);
   am += 0xe9000000;
-  rc *= *(float *)&am;
+  rc *= df_asfloat((uint32_t)am);
   /* 计算误差 */
-  ap = cp - ap * bp;
+  ap = (int32_t)((uint32_t)cp - (uint32_t)ap * (uint32_t)bp);
   ra = (float)ap;
   /* 浮点乘法上阶码,能正确处理溢出 */
   ra *= rc; //上阶码,防止溢出
@@ -397,10 +722,18 @@ inline float nfmulsubf_lim(float a, float b, float c) {
  * 可以用来计算浮点乘法的余数,例如:fmulsub_lim(a,b,a*b)
  * 正确处理了溢出但不适用非规格化数
  */
-inline double fmulsub_lim(double a, double b, double c) {
+DF_INLINE double fmulsub_lim(double a, double b, double c) {
+  if (DF_CONSTEVAL()) {
+    dualdouble p = dmul_soft(a, b);
+    return (p.hi - c) + p.lo;
+  }
 #if FP_FMA_INTRINS == 1
+#ifdef __GNUC__
+  return __builtin_fma(a, b, -c);
+#else
   __m128d ret = _mm_fmsub_sd(_mm_set_sd(a), _mm_set_sd(b), _mm_set_sd(c));
   return _mm_cvtsd_f64(ret);
+#endif
 #elif FP_FMA_INTRINS == 2
   return fma(a, b, -c);
 #elif USE_DF_SPLIT_FMA
@@ -414,14 +747,14 @@ inline double fmulsub_lim(double a, double b, double c) {
   double ra, rc; // o=17~20
   int64_t ap, bp, cp, am, bm, cm;
   int shift;
-  ap = *(int64_t *)&a;
-  bp = *(int64_t *)&b;
-  cp = *(int64_t *)&c;
+  ap = (int64_t)df_asuint(a);
+  bp = (int64_t)df_asuint(b);
+  cp = (int64_t)df_asuint(c);
   /* 取阶码和符号 */
   am = ap & 0xfff0000000000000LL;
   bm = bp & 0xfff0000000000000LL;
   cm = cp & 0xfff0000000000000LL;
-  rc = *(double *)&cm;
+  rc = df_asdouble((uint64_t)cm);
   /* 取尾数 */
   ap &= 0xfffffffffffffLL;
   bp &= 0xfffffffffffffLL;
@@ -430,13 +763,13 @@ inline double fmulsub_lim(double a, double b, double c) {
     return rc;
   if (!dual_likely(c == c))
     return c;
-  if (dual_likely(am << 1))
+  if (dual_likely((uint64_t)am << 1))
     ap |= 0x10000000000000LL;
   else { //处理非规格化数
     while ((ap <<= 1) < 0x10000000000000LL)
       am -= 0x10000000000000LL;
   }
-  if (dual_likely(bm << 1))
+  if (dual_likely((uint64_t)bm << 1))
     bp |= 0x10000000000000LL;
   else { //处理非规格化数
     while ((bp <<= 1) < 0x10000000000000LL)
@@ -450,10 +783,10 @@ inline double fmulsub_lim(double a, double b, double c) {
   am = am + bm - cm;
   shift = 1075 - (am >> 52);
   am += 0xf980000000000000LL;
-  rc *= *(double *)&am;
-  cp <<= shift;
+  rc *= df_asdouble((uint64_t)am);
+  cp = (int64_t)((uint64_t)cp << shift);
   /* 计算误差 */
-  ap = ap * bp - cp;
+  ap = (int64_t)((uint64_t)ap * (uint64_t)bp - (uint64_t)cp);
   ra = (double)ap;
   /* 浮点乘法上阶码,能正确处理溢出 */
   ra *= rc; //上阶码,防止溢出
@@ -466,10 +799,18 @@ inline double fmulsub_lim(double a, double b, double c) {
  * 可以用来计算浮点乘法的余数,例如:fmulsub_lim(a,b,a*b)
  * 正确处理了溢出但不适用非规格化数
  */
-inline double nfmulsub_lim(double a, double b, double c) {
+DF_INLINE double nfmulsub_lim(double a, double b, double c) {
+  if (DF_CONSTEVAL()) {
+    dualdouble p = dmul_soft(a, b);
+    return (c - p.hi) - p.lo;
+  }
 #if FP_FMA_INTRINS == 1
+#ifdef __GNUC__
+  return __builtin_fma(-a, b, c);
+#else
   __m128d ret = _mm_fnmadd_sd(_mm_set_sd(a), _mm_set_sd(b), _mm_set_sd(c));
   return _mm_cvtsd_f64(ret);
+#endif
 #elif FP_FMA_INTRINS == 2
   return fma(-a, b, c);
 #elif USE_DF_SPLIT_FMA
@@ -483,14 +824,14 @@ inline double nfmulsub_lim(double a, double b, double c) {
   double ra, rc; // o=17~20
   int64_t ap, bp, cp, am, bm, cm;
   int shift;
-  ap = *(int64_t *)&a;
-  bp = *(int64_t *)&b;
-  cp = *(int64_t *)&c;
+  ap = (int64_t)df_asuint(a);
+  bp = (int64_t)df_asuint(b);
+  cp = (int64_t)df_asuint(c);
   /* 取阶码和符号 */
   am = ap & 0xfff0000000000000LL;
   bm = bp & 0xfff0000000000000LL;
   cm = cp & 0xfff0000000000000LL;
-  rc = *(double *)&cm;
+  rc = df_asdouble((uint64_t)cm);
   /* 取尾数 */
   ap &= 0xfffffffffffffLL;
   bp &= 0xfffffffffffffLL;
@@ -499,13 +840,13 @@ inline double nfmulsub_lim(double a, double b, double c) {
     return rc;
   if (!dual_likely(c == c))
     return c;
-  if (dual_likely(am << 1))
+  if (dual_likely((uint64_t)am << 1))
     ap |= 0x10000000000000LL;
   else { //处理非规格化数
     while ((ap <<= 1) < 0x10000000000000LL)
       am -= 0x10000000000000LL;
   }
-  if (dual_likely(bm << 1))
+  if (dual_likely((uint64_t)bm << 1))
     bp |= 0x10000000000000LL;
   else { //处理非规格化数
     while ((bp <<= 1) < 0x10000000000000LL)
@@ -519,10 +860,10 @@ inline double nfmulsub_lim(double a, double b, double c) {
   am = am + bm - cm;
   shift = 1075 - (am >> 52);
   am += 0xf980000000000000LL;
-  rc *= *(double *)&am;
-  cp <<= shift;
+  rc *= df_asdouble((uint64_t)am);
+  cp = (int64_t)((uint64_t)cp << shift);
   /* 计算误差 */
-  ap = cp - ap * bp;
+  ap = (int64_t)((uint64_t)cp - (uint64_t)ap * (uint64_t)bp);
   ra = (double)ap;
   /* 浮点乘法上阶码,能正确处理溢出 */
   ra *= rc; //上阶码,防止溢出
@@ -535,10 +876,16 @@ inline double nfmulsub_lim(double a, double b, double c) {
  * 可以用来计算浮点乘法的余数,例如:fsqrsubf_lim(a,a*a)
  * 正确处理了溢出但不适用非规格化数
  */
-inline float fsqrsubf_lim(float a, float c) {
+DF_INLINE float fsqrsubf_lim(float a, float c) {
+  if (DF_CONSTEVAL())
+    return (float)((double)a * a - c);
 #if FP_FMA_INTRINS == 1
+#ifdef __GNUC__
+  return __builtin_fmaf(a, a, -c);
+#else
   __m128 ret = _mm_fmsub_ss(_mm_set_ss(a), _mm_set_ss(a), _mm_set_ss(c));
   return _mm_cvtss_f32(ret);
+#endif
 #elif FP_FMA_INTRINS == 2
   return fmaf(a, a, -c);
 #elif USE_DF_SPLIT_FMA
@@ -551,12 +898,12 @@ inline float fsqrsubf_lim(float a, float c) {
   float ra, rc; // o=17~20
   int32_t ap, cp, am, cm;
   int shift;
-  ap = *(int32_t *)&a;
-  cp = *(int32_t *)&c;
+  ap = (int32_t)df_asuintf(a);
+  cp = (int32_t)df_asuintf(c);
   /* 取阶码和符号 */
   am = ap & 0xff800000;
   cm = cp & 0xff800000;
-  rc = *(float *)&cm;
+  rc = df_asfloat((uint32_t)cm);
   /* 取尾数 */
   ap &= 0x7fffff;
 #ifdef SUBNORM_NO_DAZ
@@ -566,7 +913,7 @@ inline float fsqrsubf_lim(float a, float c) {
   if (!dual_likely(c == c))
     return c;
   /* 规格化处理 */
-  if (dual_likely(am << 1))
+  if (dual_likely((uint32_t)am << 1))
     ap |= 0x800000;
   else { //处理非规格化数
     while ((ap <<= 1) < 0x800000)
@@ -578,11 +925,11 @@ inline float fsqrsubf_lim(float a, float c) {
   /* 计算移位 */
   am = am + am - cm;
   shift = 150 - (am >> 23);
-  cp <<= shift;
+  cp = (int32_t)((uint32_t)cp << shift);
   am += 0xe9000000;
-  rc *= *(float *)&am;
+  rc *= df_asfloat((uint32_t)am);
   /* 计算误差 */
-  ap = ap * ap - cp;
+  ap = (int32_t)((uint32_t)ap * (uint32_t)ap - (uint32_t)cp);
   ra = (float)ap;
   /* 浮点乘法上阶码,能正确处理溢出 */
   ra *= rc; //上阶码,防止溢出
@@ -595,10 +942,16 @@ inline float fsqrsubf_lim(float a, float c) {
  * 可以用来计算浮点乘法的余数,例如:nfsqrsubf_lim(a,a*a)
  * 正确处理了溢出但不适用非规格化数
  */
-inline float nfsqrsubf_lim(float a, float c) {
+DF_INLINE float nfsqrsubf_lim(float a, float c) {
+  if (DF_CONSTEVAL())
+    return (float)(c - (double)a * a);
 #if FP_FMA_INTRINS == 1
+#ifdef __GNUC__
+  return __builtin_fmaf(-a, a, c);
+#else
   __m128 ret = _mm_fnmadd_ss(_mm_set_ss(a), _mm_set_ss(a), _mm_set_ss(c));
   return _mm_cvtss_f32(ret);
+#endif
 #elif FP_FMA_INTRINS == 2
   return fmaf(-a, a, c);
 #elif USE_DF_SPLIT_FMA
@@ -611,12 +964,12 @@ inline float nfsqrsubf_lim(float a, float c) {
   float ra, rc; // o=17~20
   int32_t ap, cp, am, cm;
   int shift;
-  ap = *(int32_t *)&a;
-  cp = *(int32_t *)&c;
+  ap = (int32_t)df_asuintf(a);
+  cp = (int32_t)df_asuintf(c);
   /* 取阶码和符号 */
   am = ap & 0xff800000;
   cm = cp & 0xff800000;
-  rc = *(float *)&cm;
+  rc = df_asfloat((uint32_t)cm);
   /* 取尾数 */
   ap &= 0x7fffff;
 #ifdef SUBNORM_NO_DAZ
@@ -626,7 +979,7 @@ inline float nfsqrsubf_lim(float a, float c) {
   if (!dual_likely(c == c))
     return c;
   /* 规格化处理 */
-  if (dual_likely(am << 1))
+  if (dual_likely((uint32_t)am << 1))
     ap |= 0x800000;
   else { //处理非规格化数
     while ((ap <<= 1) < 0x800000)
@@ -638,11 +991,11 @@ inline float nfsqrsubf_lim(float a, float c) {
   /* 计算移位 */
   am = am + am - cm;
   shift = 150 - (am >> 23);
-  cp <<= shift;
+  cp = (int32_t)((uint32_t)cp << shift);
   am += 0xe9000000;
-  rc *= *(float *)&am;
+  rc *= df_asfloat((uint32_t)am);
   /* 计算误差 */
-  ap = cp - ap * ap;
+  ap = (int32_t)((uint32_t)cp - (uint32_t)ap * (uint32_t)ap);
   ra = (float)ap;
   /* 浮点乘法上阶码,能正确处理溢出 */
   ra *= rc; //上阶码,防止溢出
@@ -655,10 +1008,18 @@ inline float nfsqrsubf_lim(float a, float c) {
  * 可以用来计算浮点乘法的余数,例如:fsqrsub_lim(a,a*a)
  * 正确处理了溢出但不适用非规格化数
  */
-inline double fsqrsub_lim(double a, double c) {
+DF_INLINE double fsqrsub_lim(double a, double c) {
+  if (DF_CONSTEVAL()) {
+    dualdouble p = dmul_soft(a, a);
+    return (p.hi - c) + p.lo;
+  }
 #if FP_FMA_INTRINS == 1
+#ifdef __GNUC__
+  return __builtin_fma(a, a, -c);
+#else
   __m128d ret = _mm_fmsub_sd(_mm_set_sd(a), _mm_set_sd(a), _mm_set_sd(c));
   return _mm_cvtsd_f64(ret);
+#endif
 #elif FP_FMA_INTRINS == 2
   return fma(a, a, -c);
 #elif USE_DF_SPLIT_FMA
@@ -671,12 +1032,12 @@ inline double fsqrsub_lim(double a, double c) {
   double ra, rc; // o=17~20
   int64_t ap, cp, am, cm;
   int shift;
-  ap = *(int64_t *)&a;
-  cp = *(int64_t *)&c;
+  ap = (int64_t)df_asuint(a);
+  cp = (int64_t)df_asuint(c);
   /* 取阶码和符号 */
   am = ap & 0xfff0000000000000LL;
   cm = cp & 0xfff0000000000000LL;
-  rc = *(double *)&cm;
+  rc = df_asdouble((uint64_t)cm);
   /* 取尾数 */
   ap &= 0xfffffffffffffLL;
 #ifdef SUBNORM_NO_DAZ
@@ -684,7 +1045,7 @@ inline double fsqrsub_lim(double a, double c) {
     return rc;
   if (!dual_likely(c == c))
     return c;
-  if (dual_likely(am << 1))
+  if (dual_likely((uint64_t)am << 1))
     ap |= 0x10000000000000LL;
   else { //处理非规格化数
     while ((ap <<= 1) < 0x10000000000000LL)
@@ -697,10 +1058,10 @@ inline double fsqrsub_lim(double a, double c) {
   am = am + am - cm;
   shift = 1075 - (am >> 52);
   am += 0xf980000000000000LL;
-  rc *= *(double *)&am;
-  cp <<= shift;
+  rc *= df_asdouble((uint64_t)am);
+  cp = (int64_t)((uint64_t)cp << shift);
   /* 计算误差 */
-  ap = ap * ap - cp;
+  ap = (int64_t)((uint64_t)ap * (uint64_t)ap - (uint64_t)cp);
   ra = (double)ap;
   /* 浮点乘法上阶码,能正确处理溢出 */
   ra *= rc; //上阶码,防止溢出
@@ -713,10 +1074,18 @@ inline double fsqrsub_lim(double a, double c) {
  * 可以用来计算浮点乘法的余数,例如:fsqrsub_lim(a,a*a)
  * 正确处理了溢出但不适用非规格化数
  */
-inline double nfsqrsub_lim(double a, double c) {
+DF_INLINE double nfsqrsub_lim(double a, double c) {
+  if (DF_CONSTEVAL()) {
+    dualdouble p = dmul_soft(a, a);
+    return (c - p.hi) - p.lo;
+  }
 #if FP_FMA_INTRINS == 1
+#ifdef __GNUC__
+  return __builtin_fma(-a, a, c);
+#else
   __m128d ret = _mm_fnmadd_sd(_mm_set_sd(a), _mm_set_sd(a), _mm_set_sd(c));
   return _mm_cvtsd_f64(ret);
+#endif
 #elif FP_FMA_INTRINS == 2
   return fma(-a, a, c);
 #elif USE_DF_SPLIT_FMA
@@ -729,12 +1098,12 @@ inline double nfsqrsub_lim(double a, double c) {
   double ra, rc; // o=17~20
   int64_t ap, cp, am, cm;
   int shift;
-  ap = *(int64_t *)&a;
-  cp = *(int64_t *)&c;
+  ap = (int64_t)df_asuint(a);
+  cp = (int64_t)df_asuint(c);
   /* 取阶码和符号 */
   am = ap & 0xfff0000000000000LL;
   cm = cp & 0xfff0000000000000LL;
-  rc = *(double *)&cm;
+  rc = df_asdouble((uint64_t)cm);
   /* 取尾数 */
   ap &= 0xfffffffffffffLL;
 #ifdef SUBNORM_NO_DAZ
@@ -742,7 +1111,7 @@ inline double nfsqrsub_lim(double a, double c) {
     return rc;
   if (!dual_likely(c == c))
     return c;
-  if (dual_likely(am << 1))
+  if (dual_likely((uint64_t)am << 1))
     ap |= 0x10000000000000LL;
   else { //处理非规格化数
     while ((ap <<= 1) < 0x10000000000000LL)
@@ -755,10 +1124,10 @@ inline double nfsqrsub_lim(double a, double c) {
   am = am + am - cm;
   shift = 1075 - (am >> 52);
   am += 0xf980000000000000LL;
-  rc *= *(double *)&am;
-  cp <<= shift;
+  rc *= df_asdouble((uint64_t)am);
+  cp = (int64_t)((uint64_t)cp << shift);
   /* 计算误差 */
-  ap = cp - ap * ap;
+  ap = (int64_t)((uint64_t)cp - (uint64_t)ap * (uint64_t)ap);
   ra = (double)ap;
   /* 浮点乘法上阶码,能正确处理溢出 */
   ra *= rc; //上阶码,防止溢出
@@ -766,115 +1135,217 @@ inline double nfsqrsub_lim(double a, double c) {
 #endif
 }
 
-/* float相加得到dualfloat */
-inline dualfloat daddf(float a, float b) {
-#ifdef USE_BRANCH_DADD
-  if (erpmarkf(a) >= erpmarkf(b))
-    return dfnormf(ddualf(a, b));
-  else
-    return dfnormf(ddualf(b, a));
-#else
+/* float相加得到dualfloat(Knuth TwoSum,无分支,不要求|a|>=|b|) */
+DF_INLINE dualfloat bdaddf(float a, float b) {
   dualfloat ret;
   float z;
   ret.hi = a + b;
   z = ret.hi - a;
   ret.lo = (a - (ret.hi - z)) + (b - z);
   return ret;
-#endif
 }
 
-/* float相减得到dualfloat */
-inline dualfloat dsubf(float a, float b) {
-#ifdef USE_BRANCH_DADD
-  if (erpmarkf(a) >= erpmarkf(b))
-    return dfnlonormf(ddualf(a, b));
-  else
-    return dfnhinormf(ddualf(b, a));
-#else
+/* float相减得到dualfloat(Knuth TwoSum,无分支,不要求|a|>=|b|) */
+DF_INLINE dualfloat bdsubf(float a, float b) {
   dualfloat ret;
   float z;
   ret.hi = a - b;
   z = ret.hi - a;
   ret.lo = (a - (ret.hi - z)) - (b + z);
   return ret;
-#endif
 }
 
-/* double相加得到dualdouble */
-inline dualdouble dadd(double a, double b) {
-#ifdef USE_BRANCH_DADD
-  if (erpmark(a) >= erpmark(b))
-    return dfnorm(ddual(a, b));
-  else
-    return dfnorm(ddual(b, a));
-#else
+/* double相加得到dualdouble(Knuth TwoSum,无分支,不要求|a|>=|b|) */
+DF_INLINE dualdouble bdadd(double a, double b) {
   dualdouble ret;
   double z;
   ret.hi = a + b;
   z = ret.hi - a;
   ret.lo = (a - (ret.hi - z)) + (b - z);
   return ret;
-#endif
 }
 
-/* double相减得到dualdouble */
-inline dualdouble dsub(double a, double b) {
-#ifdef USE_BRANCH_DADD
-  if (erpmark(a) >= erpmark(b))
-    return dfnlonorm(ddual(a, b));
-  else
-    return dfnhinorm(ddual(b, a));
-#else
+/* double相减得到dualdouble(Knuth TwoSum,无分支,不要求|a|>=|b|) */
+DF_INLINE dualdouble bdsub(double a, double b) {
   dualdouble ret;
   double z;
   ret.hi = a - b;
   z = ret.hi - a;
   ret.lo = (a - (ret.hi - z)) - (b + z);
   return ret;
+}
+
+/* float相加得到dualfloat */
+DF_INLINE dualfloat daddf(float a, float b) {
+#if defined(USE_BRANCH_DADD) && !defined(USE_BRANCHLESS_ADD)
+  bool ge = erpmarkf(a) >= erpmarkf(b); // 以选择代替分支,可自动向量化
+  DUAL_STAT(dual_stat_daddf_call);
+  DUAL_STAT_IF(!ge, dual_stat_daddf_swap);
+  return dfnormf(ddualf(ge ? a : b, ge ? b : a));
+#else
+  return bdaddf(a, b);
+#endif
+}
+
+/* float相减得到dualfloat */
+DF_INLINE dualfloat dsubf(float a, float b) {
+#if defined(USE_BRANCH_DADD) && !defined(USE_BRANCHLESS_ADD)
+  dualfloat ret;
+  float s, t;
+  bool ge = erpmarkf(a) >= erpmarkf(b);
+  DUAL_STAT(dual_stat_dsubf_call);
+  DUAL_STAT_IF(!ge, dual_stat_dsubf_swap);
+  ret.hi = a - b; // 两种情况的项都算出再选择(dfnlonormf或dfnhinormf)
+  s = a - ret.hi;
+  t = b + ret.hi;
+  ret.lo = (ge ? s : a) - (ge ? b : t);
+  return ret;
+#else
+  return bdsubf(a, b);
+#endif
+}
+
+/* double相加得到dualdouble */
+DF_INLINE dualdouble dadd(double a, double b) {
+#if defined(USE_BRANCH_DADD) && !defined(USE_BRANCHLESS_ADD)
+  bool ge = erpmark(a) >= erpmark(b); // 以选择代替分支,可自动向量化
+  DUAL_STAT(dual_stat_dadd_call);
+  DUAL_STAT_IF(!ge, dual_stat_dadd_swap);
+  return dfnorm(ddual(ge ? a : b, ge ? b : a));
+#else
+  return bdadd(a, b);
+#endif
+}
+
+/* double相减得到dualdouble */
+DF_INLINE dualdouble dsub(double a, double b) {
+#if defined(USE_BRANCH_DADD) && !defined(USE_BRANCHLESS_ADD)
+  dualdouble ret;
+  double s, t;
+  bool ge = erpmark(a) >= erpmark(b);
+  DUAL_STAT(dual_stat_dsub_call);
+  DUAL_STAT_IF(!ge, dual_stat_dsub_swap);
+  ret.hi = a - b; // 两种情况的项都算出再选择(dfnlonorm或dfnhinorm)
+  s = a - ret.hi;
+  t = b + ret.hi;
+  ret.lo = (ge ? s : a) - (ge ? b : t);
+  return ret;
+#else
+  return bdsub(a, b);
 #endif
 }
 
 /* dualfloat与float相加得到float */
-inline float df1addf(dualfloat a, float b) {
+DF_INLINE float df1addf(dualfloat a, float b) {
   dualfloat ret = daddf(a.hi, b);
   return ret.hi + (ret.lo + a.lo);
 }
 
 /* dualfloat与float相减得到float */
-inline float df1subf(dualfloat a, float b) {
+DF_INLINE float df1subf(dualfloat a, float b) {
   dualfloat ret = dsubf(a.hi, b);
   return ret.hi + (ret.lo + a.lo);
 }
 
 /* float与dualfloat相减得到float */
-inline float df1subrf(float a, dualfloat b) {
+DF_INLINE float df1subrf(float a, dualfloat b) {
   dualfloat ret = dsubf(a, b.hi);
   return ret.hi + (ret.lo - b.lo);
 }
 
 /* dualdouble与double相加得到double */
-inline double df1add(dualdouble a, double b) {
+DF_INLINE double df1add(dualdouble a, double b) {
   dualdouble ret = dadd(a.hi, b);
   return ret.hi + (ret.lo + a.lo);
 }
 
 /* dualdouble与double相减得到double */
-inline double df1sub(dualdouble a, double b) {
+DF_INLINE double df1sub(dualdouble a, double b) {
   dualdouble ret = dsub(a.hi, b);
   return ret.hi + (ret.lo + a.lo);
 }
 
 /* double与dualdouble相减得到double */
-inline double df1subr(double a, dualdouble b) {
+DF_INLINE double df1subr(double a, dualdouble b) {
   dualdouble ret = dsub(a, b.hi);
   return ret.hi + (ret.lo - b.lo);
 }
 
+/* 将非0有限的s向t的符号方向移动一位(一个ulp) */
+DF_INLINE float df_ulpstepf(float s, float t) {
+  uint32_t u = df_asuintf(s);
+  return df_asfloat((t > 0.0f) == (s > 0.0f) ? u + 1 : u - 1);
+}
+
+/* 将非0有限的s向t的符号方向移动一位(一个ulp) */
+DF_INLINE double df_ulpstep(double s, double t) {
+  uint64_t u = df_asuint(s);
+  return df_asdouble((t > 0.0) == (s > 0.0) ? u + 1 : u - 1);
+}
+
+/*
+ * t非0且s的最低位为0时,将s向t的方向移动一位,即s+t舍入到奇数,
+ * 最低位的奇偶不可预测,以整数运算选择而不分支
+ */
+DF_INLINE float df_round_oddf(float s, float t) {
+  uint32_t u = df_asuintf(s), k = (uint32_t)(t != 0.0f) & ~u & 1;
+  return df_asfloat((t > 0.0f) == (s > 0.0f) ? u + k : u - k);
+}
+
+/* t非0且s的最低位为0时,将s向t的方向移动一位,即s+t舍入到奇数(无分支) */
+DF_INLINE double df_round_odd(double s, double t) {
+  uint64_t u = df_asuint(s), k = (uint64_t)(t != 0.0) & ~u & 1;
+  return df_asdouble((t > 0.0) == (s > 0.0) ? u + k : u - k);
+}
+
+/* 半个ulp: |s|的2的幂部分乘以2^-24,s为0或非规格化数时为0 */
+DF_INLINE float df_halfulpf(float s) {
+  return df_asfloat(df_asuintf(s) & 0x7f800000u) *
+         df_asfloat((uint32_t)(127 - 24) << 23);
+}
+
+/* 半个ulp: |s|的2的幂部分乘以2^-53,s为0或非规格化数时为0 */
+DF_INLINE double df_halfulp(double s) {
+  return df_asdouble(df_asuint(s) & 0x7ff0000000000000ULL) *
+         df_asdouble((uint64_t)(1023 - 53) << 52);
+}
+
+/* 软件实现的a*b+c(一次舍入),供编译期求值 */
+DF_INLINE float fmuladdf_soft(float a, float b, float c) {
+  double p = (double)a * b; // double的积精确
+  dualdouble s;
+  if (!(p - p == 0.0) || !(c - c == 0.0f))
+    return (float)(p + c);
+  s = dadd(p, c);
+  return (float)df_round_odd(s.hi, s.lo);
+}
+
+/**
+ * 软件实现的a*b+c(一次舍入),供编译期求值
+ * 即Boldo与Melquiond以舍入到奇数模拟FMA的算法.
+ */
+DF_INLINE double fmuladd_soft(double a, double b, double c) {
+  dualdouble p, s, v;
+  if (a == 0.0 || b == 0.0 || c == 0.0 || !(a * b - a * b == 0.0) ||
+      !(c - c == 0.0))
+    return a * b + c;
+  p = dmul_soft(a, b);
+  s = dadd(c, p.hi);
+  v = dadd(s.lo, p.lo);
+  return s.hi + df_round_odd(v.hi, v.lo);
+}
+
 /* 计算a*b+c并只进行一次舍入 */
-inline float fmuladdf(float a, float b, float c) {
+DF_INLINE float fmuladdf(float a, float b, float c) {
+  if (DF_CONSTEVAL())
+    return fmuladdf_soft(a, b, c);
 #if FP_FMA_INTRINS == 1
+#ifdef __GNUC__
+  return __builtin_fmaf(a, b, c);
+#else
   __m128 ret = _mm_fmadd_ss(_mm_set_ss(a), _mm_set_ss(b), _mm_set_ss(c));
   return _mm_cvtss_f32(ret);
+#endif
 #elif FP_FMA_INTRINS == 2
   return fmaf(a, b, c);
 #else
@@ -885,10 +1356,16 @@ inline float fmuladdf(float a, float b, float c) {
 }
 
 /* 计算a*b+c并只进行一次舍入 */
-inline double fmuladd(double a, double b, double c) {
+DF_INLINE double fmuladd(double a, double b, double c) {
+  if (DF_CONSTEVAL())
+    return fmuladd_soft(a, b, c);
 #if FP_FMA_INTRINS == 1
+#ifdef __GNUC__
+  return __builtin_fma(a, b, c);
+#else
   __m128d ret = _mm_fmadd_sd(_mm_set_sd(a), _mm_set_sd(b), _mm_set_sd(c));
   return _mm_cvtsd_f64(ret);
+#endif
 #elif FP_FMA_INTRINS == 2
   return fma(a, b, c);
 #else
@@ -899,10 +1376,16 @@ inline double fmuladd(double a, double b, double c) {
 }
 
 /* 计算a*b-c并只进行一次舍入 */
-inline float fmulsubf(float a, float b, float c) {
+DF_INLINE float fmulsubf(float a, float b, float c) {
+  if (DF_CONSTEVAL())
+    return fmuladdf_soft(a, b, -c);
 #if FP_FMA_INTRINS == 1
+#ifdef __GNUC__
+  return __builtin_fmaf(a, b, -c);
+#else
   __m128 ret = _mm_fmsub_ss(_mm_set_ss(a), _mm_set_ss(b), _mm_set_ss(c));
   return _mm_cvtss_f32(ret);
+#endif
 #elif FP_FMA_INTRINS == 2
   return fmaf(a, b, -c);
 #else
@@ -913,10 +1396,16 @@ inline float fmulsubf(float a, float b, float c) {
 }
 
 /* 计算a*b-c并只进行一次舍入 */
-inline double fmulsub(double a, double b, double c) {
+DF_INLINE double fmulsub(double a, double b, double c) {
+  if (DF_CONSTEVAL())
+    return fmuladd_soft(a, b, -c);
 #if FP_FMA_INTRINS == 1
+#ifdef __GNUC__
+  return __builtin_fma(a, b, -c);
+#else
   __m128d ret = _mm_fmsub_sd(_mm_set_sd(a), _mm_set_sd(b), _mm_set_sd(c));
   return _mm_cvtsd_f64(ret);
+#endif
 #elif FP_FMA_INTRINS == 2
   return fma(a, b, -c);
 #else
@@ -927,10 +1416,16 @@ inline double fmulsub(double a, double b, double c) {
 }
 
 /* 计算-(a*b+c)并只进行一次舍入 */
-inline float nfmuladdf(float a, float b, float c) {
+DF_INLINE float nfmuladdf(float a, float b, float c) {
+  if (DF_CONSTEVAL())
+    return -fmuladdf_soft(a, b, c);
 #if FP_FMA_INTRINS == 1
+#ifdef __GNUC__
+  return __builtin_fmaf(-a, b, -c);
+#else
   __m128 ret = _mm_fnmsub_ss(_mm_set_ss(a), _mm_set_ss(b), _mm_set_ss(c));
   return _mm_cvtss_f32(ret);
+#endif
 #elif FP_FMA_INTRINS == 2
   return -fmaf(a, b, c);
 #else
@@ -941,10 +1436,16 @@ inline float nfmuladdf(float a, float b, float c) {
 }
 
 /* 计算-(a*b+c)并只进行一次舍入 */
-inline double nfmuladd(double a, double b, double c) {
+DF_INLINE double nfmuladd(double a, double b, double c) {
+  if (DF_CONSTEVAL())
+    return -fmuladd_soft(a, b, c);
 #if FP_FMA_INTRINS == 1
+#ifdef __GNUC__
+  return __builtin_fma(-a, b, -c);
+#else
   __m128d ret = _mm_fnmsub_sd(_mm_set_sd(a), _mm_set_sd(b), _mm_set_sd(c));
   return _mm_cvtsd_f64(ret);
+#endif
 #elif FP_FMA_INTRINS == 2
   return -fma(a, b, c);
 #else
@@ -955,10 +1456,16 @@ inline double nfmuladd(double a, double b, double c) {
 }
 
 /* 计算-(a*b-c)并只进行一次舍入 */
-inline float nfmulsubf(float a, float b, float c) {
+DF_INLINE float nfmulsubf(float a, float b, float c) {
+  if (DF_CONSTEVAL())
+    return fmuladdf_soft(-a, b, c);
 #if FP_FMA_INTRINS == 1
+#ifdef __GNUC__
+  return __builtin_fmaf(-a, b, c);
+#else
   __m128 ret = _mm_fnmadd_ss(_mm_set_ss(a), _mm_set_ss(b), _mm_set_ss(c));
   return _mm_cvtss_f32(ret);
+#endif
 #elif FP_FMA_INTRINS == 2
   return fmaf(-a, b, c);
 #else
@@ -969,10 +1476,16 @@ inline float nfmulsubf(float a, float b, float c) {
 }
 
 /* 计算-(a*b-c)并只进行一次舍入 */
-inline double nfmulsub(double a, double b, double c) {
+DF_INLINE double nfmulsub(double a, double b, double c) {
+  if (DF_CONSTEVAL())
+    return fmuladd_soft(-a, b, c);
 #if FP_FMA_INTRINS == 1
+#ifdef __GNUC__
+  return __builtin_fma(-a, b, c);
+#else
   __m128d ret = _mm_fnmadd_sd(_mm_set_sd(a), _mm_set_sd(b), _mm_set_sd(c));
   return _mm_cvtsd_f64(ret);
+#endif
 #elif FP_FMA_INTRINS == 2
   return fma(-a, b, c);
 #else
@@ -983,7 +1496,7 @@ inline double nfmulsub(double a, double b, double c) {
 }
 
 /* float自乘得到dualfloat */
-inline dualfloat dsqrf(float a) {
+DF_INLINE dualfloat dsqrf(float a) {
   dualfloat ret;
   ret.hi = a * a;
   ret.lo = fsqrsubf_lim(a, ret.hi);
@@ -991,7 +1504,7 @@ inline dualfloat dsqrf(float a) {
 }
 
 /* float相乘得到dualfloat */
-inline dualfloat dmulf(float a, float b) {
+DF_INLINE dualfloat dmulf(float a, float b) {
   dualfloat ret;
   ret.hi = a * b;
   ret.lo = fmulsubf_lim(a, b, ret.hi);
@@ -999,7 +1512,7 @@ inline dualfloat dmulf(float a, float b) {
 }
 
 /* float相除得到商(ret.hi)和余数(ret.lo) */
-inline dualfloat dmdivf(float a, float b) {
+DF_INLINE dualfloat dmdivf(float a, float b) {
   dualfloat ret;
   ret.hi = a / b;
   ret.lo = nfmulsubf_lim(ret.hi, b, a);
@@ -1007,7 +1520,7 @@ inline dualfloat dmdivf(float a, float b) {
 }
 
 /* double自乘得到dualdouble */
-inline dualdouble dsqr(double a) {
+DF_INLINE dualdouble dsqr(double a) {
   dualdouble ret;
   ret.hi = a * a;
   ret.lo = fsqrsub_lim(a, ret.hi);
@@ -1015,7 +1528,7 @@ inline dualdouble dsqr(double a) {
 }
 
 /* double相乘得到dualdouble */
-inline dualdouble dmul(double a, double b) {
+DF_INLINE dualdouble dmul(double a, double b) {
   dualdouble ret;
   ret.hi = a * b;
   ret.lo = fmulsub_lim(a, b, ret.hi);
@@ -1023,7 +1536,7 @@ inline dualdouble dmul(double a, double b) {
 }
 
 /* double相除得到商(ret.hi)和余数(ret.lo) */
-inline dualdouble dmdiv(double a, double b) {
+DF_INLINE dualdouble dmdiv(double a, double b) {
   dualdouble ret;
   ret.hi = a / b;
   ret.lo = nfmulsub_lim(ret.hi, b, a);
@@ -1031,47 +1544,273 @@ inline dualdouble dmdiv(double a, double b) {
 }
 
 /* float相除得到(正确舍入)dualfloat */
-inline dualfloat ddivf(float a, float b) {
+DF_INLINE dualfloat ddivf(float a, float b) {
   dualfloat ret = dmdivf(a, b);
   ret.lo /= b;
   return ret;
 }
 
 /* double相除得到(正确舍入)dualdouble */
-inline dualdouble ddiv(double a, double b) {
+DF_INLINE dualdouble ddiv(double a, double b) {
   dualdouble ret = dmdiv(a, b);
   ret.lo /= b;
   return ret;
 }
 
-/* 将{x,y}的数据按erp重排,若(mode&1)则先对y取反,若(mode&2)则进行不完全排序 */
-inline void df2reorderf(dualfloat *x, dualfloat *y, const int mode) {
+/**
+ * double开平方(正确舍入)的软件实现,供编译期求值
+ * 逐位求尾数的整数平方根,再按余数舍入.
+ */
+DF_INLINE double df_sqrt_soft(double a) {
+  uint64_t m, q = 0, r = 0;
+  int e, i;
+  if (a == 0.0 || a != a || (a - a != 0.0 && a > 0.0))
+    return a; // 0,NaN与正无穷大
+  if (a < 0.0)
+    return (a - a) / (a - a);
+  m = df_asuint(a);
+  e = (int)(m >> 52);
+  m &= 0xfffffffffffffULL;
+  if (e)
+    m |= 1ULL << 52;
+  else // 非规格化数
+    for (e = 1; !(m >> 52); e--)
+      m <<= 1;
+  e -= 1075; // a = m*2^e
+  if (e & 1) {
+    m <<= 1;
+    e--;
+  }
+  // q = floor(sqrt(m*2^54)),在[2^53,2^54)中,r为余数
+  for (i = 0; i < 54; i++) {
+    uint64_t t = q << 2 | 1;
+    r = r << 2 | (i < 27 ? (m >> (52 - 2 * i)) & 3 : 0);
+    q <<= 1;
+    if (r >= t) {
+      r -= t;
+      q |= 1;
+    }
+  }
+  m = (q >> 1) + ((q & 1) && (r || (q & 2))); // 舍去最低位
+  return (double)m * df_asdouble((uint64_t)(e / 2 - 26 + 1023) << 52);
+}
+
+/* double开平方 */
+DF_INLINE double df_sqrt(double a) {
+  if (DF_CONSTEVAL())
+    return df_sqrt_soft(a);
 #if FP_FMA_INTRINS == 1
-  __m128 mask = _mm_set1_ps(-0.0f); // 绝对值掩码
-  __m128 mx = _mm_set_ps(0, 0, x->lo, x->hi);
-  __m128 my = _mm_set_ps(0, 0, y->lo, y->hi);
-  if (mode & 1)
-    my = _mm_xor_ps(my, mask);
-  mask = _mm_cmpgt_ps(_mm_andnot_ps(mx, mask),
-                      _mm_andnot_ps(my, mask));            // 大于比较
-  _mm_storel_pi((__m64 *)&x, _mm_blendv_ps(my, mx, mask)); // 大于
-  _mm_storel_pi((__m64 *)&y, _mm_blendv_ps(mx, my, mask)); // 小于
+  return _mm_cvtsd_f64(_mm_sqrt_sd(_mm_setzero_pd(), _mm_set_sd(a)));
+#else
+  return sqrt(a);
+#endif
+}
+
+/* float开平方,编译期经double计算,两次舍入不影响结果 */
+DF_INLINE float df_sqrtf(float a) {
+  if (DF_CONSTEVAL())
+    return (float)df_sqrt_soft(a);
+#if FP_FMA_INTRINS == 1
+  return _mm_cvtss_f32(_mm_sqrt_ss(_mm_set_ss(a)));
+#else
+  return sqrtf(a);
+#endif
+}
+
+/* double向下取整的软件实现,供编译期求值: 加减2^52舍入为整数再修正 */
+DF_INLINE double df_floor_soft(double a) {
+  double r;
+  if (a - a != 0.0 || (a < 0.0 ? -a : a) >= 4503599627370496.0)
+    return a; // 已是整数,无穷大与NaN
+  r = a < 0.0 ? (a - 4503599627370496.0) + 4503599627370496.0
+              : (a + 4503599627370496.0) - 4503599627370496.0;
+  if (r > a)
+    r -= 1.0;
+  return r == 0.0 ? a * 0.0 : r; // 保留0的符号
+}
+
+/* double向下取整 */
+DF_INLINE double df_floor(double a) {
+  if (DF_CONSTEVAL())
+    return df_floor_soft(a);
+#if FP_FMA_INTRINS == 1
+  return _mm_cvtsd_f64(_mm_round_sd(_mm_setzero_pd(), _mm_set_sd(a),
+                                    _MM_FROUND_FLOOR));
+#else
+  return floor(a);
+#endif
+}
+
+/* float向下取整,编译期经double计算 */
+DF_INLINE float df_floorf(float a) {
+  if (DF_CONSTEVAL())
+    return (float)df_floor_soft(a);
+#if FP_FMA_INTRINS == 1
+  return _mm_cvtss_f32(
+      _mm_round_ss(_mm_setzero_ps(), _mm_set_ss(a), _MM_FROUND_FLOOR));
+#else
+  return floorf(a);
+#endif
+}
+
+/* double向上取整 */
+DF_INLINE double df_ceil(double a) {
+  if (DF_CONSTEVAL())
+    return -df_floor_soft(-a);
+#if FP_FMA_INTRINS == 1
+  return _mm_cvtsd_f64(_mm_round_sd(_mm_setzero_pd(), _mm_set_sd(a),
+                                    _MM_FROUND_CEIL));
+#else
+  return ceil(a);
+#endif
+}
+
+/* float向上取整,编译期经double计算 */
+DF_INLINE float df_ceilf(float a) {
+  if (DF_CONSTEVAL())
+    return (float)-df_floor_soft(-a);
+#if FP_FMA_INTRINS == 1
+  return _mm_cvtss_f32(
+      _mm_round_ss(_mm_setzero_ps(), _mm_set_ss(a), _MM_FROUND_CEIL));
+#else
+  return ceilf(a);
+#endif
+}
+
+/*
+ * double乘以2^e,由位构造2的幂,超出规格化数范围时分步相乘,
+ * 下溢方向先乘2^-969(=2^-1022*2^53)以避免两次舍入.
+ */
+DF_INLINE double df_ldexp(double a, int e) {
+  if (e > 1023) {
+    a *= df_asdouble((uint64_t)(1023 + 1023) << 52);
+    e -= 1023;
+    if (e > 1023) {
+      a *= df_asdouble((uint64_t)(1023 + 1023) << 52);
+      e -= 1023;
+      if (e > 1023)
+        e = 1023;
+    }
+  } else if (e < -1022) {
+    a *= df_asdouble((uint64_t)(1023 - 969) << 52);
+    e += 969;
+    if (e < -1022) {
+      a *= df_asdouble((uint64_t)(1023 - 969) << 52);
+      e += 969;
+      if (e < -1022)
+        e = -1022;
+    }
+  }
+  return a * df_asdouble((uint64_t)(1023 + e) << 52);
+}
+
+/* float乘以2^e,同df_ldexp(下溢方向先乘2^-102=2^-126*2^24) */
+DF_INLINE float df_ldexpf(float a, int e) {
+  if (e > 127) {
+    a *= df_asfloat((uint32_t)(127 + 127) << 23);
+    e -= 127;
+    if (e > 127) {
+      a *= df_asfloat((uint32_t)(127 + 127) << 23);
+      e -= 127;
+      if (e > 127)
+        e = 127;
+    }
+  } else if (e < -126) {
+    a *= df_asfloat((uint32_t)(127 - 102) << 23);
+    e += 102;
+    if (e < -126) {
+      a *= df_asfloat((uint32_t)(127 - 102) << 23);
+      e += 102;
+      if (e < -126)
+        e = -126;
+    }
+  }
+  return a * df_asfloat((uint32_t)(127 + e) << 23);
+}
+
+/* double以2为底的指数(同ilogb),直接读取指数位 */
+DF_INLINE int df_ilogb(double a) {
+  uint64_t ia = df_asuint(a) << 1; // 去掉符号位
+  int e = (int)(ia >> 53);
+  if (e == 0) { // 0与非规格化数
+    if (ia == 0)
+      return FP_ILOGB0;
+    for (e = -1023; !(ia >> 52 & 1); e--)
+      ia <<= 1;
+    return e;
+  }
+  if (e == 0x7ff)
+    return ia << 11 ? FP_ILOGBNAN : INT_MAX;
+  return e - 1023;
+}
+
+/* float以2为底的指数(同ilogbf),直接读取指数位 */
+DF_INLINE int df_ilogbf(float a) {
+  uint32_t ia = df_asuintf(a) << 1; // 即erpmarkf(a)
+  int e = (int)(ia >> 24);
+  if (e == 0) {
+    if (ia == 0)
+      return FP_ILOGB0;
+    for (e = -127; !(ia >> 23 & 1); e--)
+      ia <<= 1;
+    return e;
+  }
+  if (e == 0xff)
+    return ia << 8 ? FP_ILOGBNAN : INT_MAX;
+  return e - 127;
+}
+
+/*
+ * 同df2reorderf的无分支版本: 高位与低位各按erp选出较大者与较小者,
+ * 完全排序时再将x.lo与y.hi按erp选择,都以位掩码选择而不交换
+ */
+DF_INLINE void bdf2reorderf(dualfloat *x, dualfloat *y,
+                            const int mode) {
+  dualfloat ty = (mode & 1) ? dfnegf(*y) : *y;
+  dualfloat h = dmagsortf(x->hi, ty.hi), l = dmagsortf(x->lo, ty.lo);
+  bool sw;
+  *x = ddualf(h.hi, l.hi);
+  *y = ddualf(h.lo, l.lo);
+  if (mode & 2)
+    return;
+  sw = erpmarkf(l.hi) < erpmarkf(h.lo);
+  x->lo = df_selectf(sw, h.lo, l.hi);
+  y->hi = df_selectf(sw, l.hi, h.lo);
+}
+
+/* 将{x,y}的数据按erp重排,若(mode&1)则先对y取反,若(mode&2)则进行不完全排序 */
+DF_INLINE void df2reorderf(dualfloat *x, dualfloat *y,
+                           const int mode) {
+#ifdef USE_BRANCHLESS_ADD
+  bdf2reorderf(x, y, mode);
+#elif FP_FMA_INTRINS == 1
+  /* 以比较与选择实现,编译器可将调用处的循环自动向量化 */
+  dualfloat tx = *x, ty = (mode & 1) ? dfnegf(*y) : *y;
+  bool gh = (tx.hi < 0 ? -tx.hi : tx.hi) > (ty.hi < 0 ? -ty.hi : ty.hi);
+  bool gl = (tx.lo < 0 ? -tx.lo : tx.lo) > (ty.lo < 0 ? -ty.lo : ty.lo);
+  bool sw;
+  DUAL_STAT(dual_stat_df2reorderf_call);
+  DUAL_STAT_IF(!gh, dual_stat_df2reorderf_swap);
+  *x = ddualf(gh ? tx.hi : ty.hi, gl ? tx.lo : ty.lo);
+  *y = ddualf(gh ? ty.hi : tx.hi, gl ? ty.lo : tx.lo);
   if (mode & 2)
     return;
-  uint32_t r1 = *(uint32_t *)&x->lo, r2 = *(uint32_t *)&y->hi;
-  if (!dual_likely(r1 + r1 < r2 + r2))
-    return; // 再次比较
-  *(uint32_t *)&x->lo = r2;
-  *(uint32_t *)&y->hi = r1;
+  sw = erpmarkf(x->lo) < erpmarkf(y->hi); // 再次比较
+  DUAL_STAT_IF(sw, dual_stat_df2reorderf_loswap);
+  tx = *x;
+  x->lo = sw ? y->hi : tx.lo;
+  y->hi = sw ? tx.lo : y->hi;
 #else
   uint32_t erpxh, erpxl, erpyh, erpyl;
   float tmp;
+  DUAL_STAT(dual_stat_df2reorderf_call);
   erpxh = erpmarkf(x->hi);
   erpyh = erpmarkf(y->hi);
   if (mode & 1)
     *y = dfnegf(*y);
   if (mode & 2) {
     if (erpxh < erpyh) {
+      DUAL_STAT(dual_stat_df2reorderf_swap);
       tmp = x->hi;
       x->hi = y->hi;
       y->hi = tmp;
@@ -1088,6 +1827,7 @@ inline void df2reorderf(dualfloat *x, dualfloat *y, const int mode) {
   if (erpxh >= erpyh) {
     erpxl = erpmarkf(x->lo);
     if (erpxl < erpyh) {
+      DUAL_STAT(dual_stat_df2reorderf_loswap);
       erpyl = erpmarkf(y->lo);
       tmp = x->lo;
       x->lo = y->hi;
@@ -1099,6 +1839,7 @@ inline void df2reorderf(dualfloat *x, dualfloat *y, const int mode) {
       }
     }
   } else {
+    DUAL_STAT(dual_stat_df2reorderf_swap);
     erpyl = erpmarkf(y->lo);
     tmp = x->hi;
     x->hi = y->hi;
@@ -1108,6 +1849,7 @@ inline void df2reorderf(dualfloat *x, dualfloat *y, const int mode) {
       x->lo = y->lo;
       y->lo = tmp;
     } else {
+      DUAL_STAT(dual_stat_df2reorderf_loswap);
       erpxl = erpmarkf(x->lo);
       tmp = x->lo;
       x->lo = y->hi;
@@ -1122,34 +1864,57 @@ inline void df2reorderf(dualfloat *x, dualfloat *y, const int mode) {
 #endif
 }
 
+/*
+ * 同df2reorder的无分支版本: 高位与低位各按erp选出较大者与较小者,
+ * 完全排序时再将x.lo与y.hi按erp选择,都以位掩码选择而不交换
+ */
+DF_INLINE void bdf2reorder(dualdouble *x, dualdouble *y,
+                           const int mode) {
+  dualdouble ty = (mode & 1) ? dfneg(*y) : *y;
+  dualdouble h = dmagsort(x->hi, ty.hi), l = dmagsort(x->lo, ty.lo);
+  bool sw;
+  *x = ddual(h.hi, l.hi);
+  *y = ddual(h.lo, l.lo);
+  if (mode & 2)
+    return;
+  sw = erpmark(l.hi) < erpmark(h.lo);
+  x->lo = df_select(sw, h.lo, l.hi);
+  y->hi = df_select(sw, l.hi, h.lo);
+}
+
 /* 将{x,y}的数据按erp重排,若(mode&1)则先对y取反,若(mode&2)则进行不完全排序 */
-inline void df2reorder(dualdouble *x, dualdouble *y, const int mode) {
-#if FP_FMA_INTRINS == 1
-  __m128d mask = _mm_set1_pd(-0.0); // 绝对值掩码
-  __m128d mx = _mm_set_pd(x->lo, x->hi);
-  __m128d my = _mm_set_pd(y->lo, y->hi);
-  if (mode & 1)
-    my = _mm_xor_pd(my, mask);
-  mask = _mm_cmpgt_pd(_mm_andnot_pd(mx, mask),
-                      _mm_andnot_pd(my, mask));           // 大于比较
-  _mm_store_pd((double *)x, _mm_blendv_pd(my, mx, mask)); // 大于
-  _mm_store_pd((double *)y, _mm_blendv_pd(mx, my, mask)); // 小于
+DF_INLINE void df2reorder(dualdouble *x, dualdouble *y,
+                          const int mode) {
+#ifdef USE_BRANCHLESS_ADD
+  bdf2reorder(x, y, mode);
+#elif FP_FMA_INTRINS == 1
+  /* 以比较与选择实现,编译器可将调用处的循环自动向量化 */
+  dualdouble tx = *x, ty = (mode & 1) ? dfneg(*y) : *y;
+  bool gh = (tx.hi < 0 ? -tx.hi : tx.hi) > (ty.hi < 0 ? -ty.hi : ty.hi);
+  bool gl = (tx.lo < 0 ? -tx.lo : tx.lo) > (ty.lo < 0 ? -ty.lo : ty.lo);
+  bool sw;
+  DUAL_STAT(dual_stat_df2reorder_call);
+  DUAL_STAT_IF(!gh, dual_stat_df2reorder_swap);
+  *x = ddual(gh ? tx.hi : ty.hi, gl ? tx.lo : ty.lo);
+  *y = ddual(gh ? ty.hi : tx.hi, gl ? ty.lo : tx.lo);
   if (mode & 2)
     return;
-  uint64_t r1 = *(uint64_t *)&x->lo, r2 = *(uint64_t *)&y->hi;
-  if (!dual_likely(r1 + r1 < r2 + r2))
-    return; // 再次比较
-  *(uint64_t *)&x->lo = r2;
-  *(uint64_t *)&y->hi = r1;
+  sw = erpmark(x->lo) < erpmark(y->hi); // 再次比较
+  DUAL_STAT_IF(sw, dual_stat_df2reorder_loswap);
+  tx = *x;
+  x->lo = sw ? y->hi : tx.lo;
+  y->hi = sw ? tx.lo : y->hi;
 #else
   size_t erpxh, erpxl, erpyh, erpyl;
   double tmp;
+  DUAL_STAT(dual_stat_df2reorder_call);
   erpxh = erpmark(x->hi);
   erpyh = erpmark(y->hi);
   if (mode & 1)
     *y = dfneg(*y);
   if (mode & 2) {
     if (erpxh < erpyh) {
+      DUAL_STAT(dual_stat_df2reorder_swap);
       tmp = x->hi;
       x->hi = y->hi;
       y->hi = tmp;
@@ -1166,6 +1931,7 @@ inline void df2reorder(dualdouble *x, dualdouble *y, const int mode) {
   if (erpxh >= erpyh) {
     erpxl = erpmark(x->lo);
     if (erpxl < erpyh) {
+      DUAL_STAT(dual_stat_df2reorder_loswap);
       erpyl = erpmark(y->lo);
       tmp = x->lo;
       x->lo = y->hi;
@@ -1177,6 +1943,7 @@ inline void df2reorder(dualdouble *x, dualdouble *y, const int mode) {
       }
     }
   } else {
+    DUAL_STAT(dual_stat_df2reorder_swap);
     erpyl = erpmark(y->lo);
     tmp = x->hi;
     x->hi = y->hi;
@@ -1186,6 +1953,7 @@ inline void df2reorder(dualdouble *x, dualdouble *y, const int mode) {
       x->lo = y->lo;
       y->lo = tmp;
     } else {
+      DUAL_STAT(dual_stat_df2reorder_loswap);
       erpxl = erpmark(x->lo);
       tmp = x->lo;
       x->lo = y->hi;
@@ -0,0 +1,1333 @@
+﻿#ifndef DF_T
+#error "it must include by <dualdouble.h> or <dualfloat.h>"
+#else
+
+/**
+ * 双数运算的类型无关实现,由dualdouble.h与dualfloat.h各包含一次,
+ * 相当于C的模板: 包含前定义以下宏,包含後这些宏被取消定义.
+ * DF_T单数类型,DF_D双数类型,DF_N(name)加上类型後缀的函数名,
+ * DF_LIM(name)加上类型後缀的name_lim函数名,
+ * DF_K(c)单数类型的常数,DF_ERP为erpmark的返回类型,DF_ACC为累加器类型,
+ * DF_DIVR与DF_MULR为预先计算的除数与乘数类型,DF_SPLIT为单数的分割函数,
+ * DF_MANT为单数尾数的位数(不含隐含位),DF_FAST_FMA为1表示有快速的FMA.
+ * C++中同时特化dual_traits<DF_T>,使dual<T>的运算符与泛型代码共用这些函数.
+ */
+
+/* 双数与单数相加(精度略低但更快)得到双数 */
+DF_INLINE DF_D DF_N(fdfadd)(DF_D a, DF_T b) {
+  DF_D ret = DF_N(dadd)(a.hi, b);
+  ret.lo += a.lo; // this is err come
+  return DF_N(dfnorm)(ret);
+}
+
+/* 双数与单数相减(精度略低但更快)得到双数 */
+DF_INLINE DF_D DF_N(fdfsub)(DF_D a, DF_T b) {
+  DF_D ret = DF_N(dsub)(a.hi, b);
+  ret.lo += a.lo;
+  return DF_N(dfnorm)(ret);
+}
+
+/* 单数与双数相减(精度略低但更快)得到双数 */
+DF_INLINE DF_D DF_N(fdfsubr)(DF_T a, DF_D b) {
+  DF_D ret = DF_N(dsub)(a, b.hi);
+  ret.lo -= b.lo;
+  return DF_N(dfnorm)(ret);
+}
+
+/*
+ * 以下b*为加减法的无分支版本,结果与对应的分支版本逐位相同(±0与NaN的符号除外):
+ * 按erp的比较只用于以位掩码选择运算数,无须有序的部分以Knuth TwoSum代替.
+ * 用于符号与数量级随机而分支难以预测的数据,定义USE_BRANCHLESS_ADD则
+ * 对应的分支版本(dfadd,df2add等)直接调用这些函数.
+ */
+
+/* 双数与单数相加得到双数(无分支,同dfadd) */
+DF_INLINE DF_D DF_N(bdfadd)(DF_D a, DF_T b) {
+  bool big = DF_N(erpmark)(b) >= DF_N(erpmark)(a.hi);
+  DF_D ret, s = DF_N(bdadd)(a.lo, b);
+  DF_T r0 = DF_N(df_select)(big, b, a.hi);
+  s.hi = DF_N(df_select)(big, a.hi, s.hi); // b较大时先加a.hi再加a.lo
+  s.lo = DF_N(df_select)(big, a.lo, s.lo);
+  ret = DF_N(dfnorm)(DF_N(ddual)(r0, s.hi));
+  r0 = ret.lo;
+  ret = DF_N(dfnorm)(DF_N(ddual)(ret.hi, s.lo));
+  ret.lo += r0;
+  return ret;
+}
+
+/* 双数与单数相减得到双数(无分支,同dfsub) */
+DF_INLINE DF_D DF_N(bdfsub)(DF_D a, DF_T b) {
+  return DF_N(bdfadd)(a, -b);
+}
+
+/* 单数与双数相减得到双数(无分支,同dfsubr) */
+DF_INLINE DF_D DF_N(bdfsubr)(DF_T a, DF_D b) {
+  return DF_N(bdfadd)(DF_N(dfneg)(b), a);
+}
+
+/* 双数与单数相加得到双数 */
+DF_INLINE DF_D DF_N(dfadd)(DF_D a, DF_T b) {
+#ifdef USE_BRANCHLESS_ADD
+  return DF_N(bdfadd)(a, b);
+#else
+  DF_D ret;
+  DF_T r0;
+  DF_ERP erpb = DF_N(erpmark)(b);
+  DF_STAT(dfadd, call);
+  if (erpb >= DF_N(erpmark)(a.hi)) {
+    DF_STAT(dfadd, big);
+    r0 = b;
+    ret = a;
+  } else {
+    if (erpb <= DF_N(erpmark)(a.lo)) {
+      DF_STAT(dfadd, small);
+      ret = DF_N(dfnorm)(DF_N(ddual)(a.lo, b));
+    } else
+      ret = DF_N(dfnorm)(DF_N(ddual)(b, a.lo));
+    r0 = a.hi;
+  }
+  b = ret.lo;
+  ret = DF_N(dfnorm)(DF_N(ddual)(r0, ret.hi));
+  r0 = ret.lo;
+  ret = DF_N(dfnorm)(DF_N(ddual)(ret.hi, b));
+  ret.lo += r0; // this err is correct rounding
+  return ret;
+#endif
+}
+
+/* 双数与单数相减得到双数 */
+DF_INLINE DF_D DF_N(dfsub)(DF_D a, DF_T b) {
+#ifdef USE_BRANCHLESS_ADD
+  return DF_N(bdfsub)(a, b);
+#else
+  DF_D ret;
+  DF_T r0;
+  DF_ERP erpb = DF_N(erpmark)(b);
+  DF_STAT(dfsub, call);
+  if (erpb >= DF_N(erpmark)(a.hi)) {
+    DF_STAT(dfsub, big);
+    r0 = -b;
+    ret = a;
+  } else {
+    if (erpb <= DF_N(erpmark)(a.lo)) {
+      DF_STAT(dfsub, small);
+      ret = DF_N(dfnlonorm)(DF_N(ddual)(a.lo, b));
+    } else
+      ret = DF_N(dfnhinorm)(DF_N(ddual)(b, a.lo));
+    r0 = a.hi;
+  }
+  b = ret.lo;
+  ret = DF_N(dfnorm)(DF_N(ddual)(r0, ret.hi));
+  r0 = ret.lo;
+  ret = DF_N(dfnorm)(DF_N(ddual)(ret.hi, b));
+  ret.lo += r0;
+  return ret;
+#endif
+}
+
+/* 单数与双数相减得到双数 */
+DF_INLINE DF_D DF_N(dfsubr)(DF_T a, DF_D b) {
+#ifdef USE_BRANCHLESS_ADD
+  return DF_N(bdfsubr)(a, b);
+#else
+  DF_D ret;
+  DF_T r0;
+  DF_ERP erpa = DF_N(erpmark)(a);
+  DF_STAT(dfsubr, call);
+  if (erpa >= DF_N(erpmark)(b.hi)) {
+    DF_STAT(dfsubr, big);
+    r0 = a;
+    ret = b;
+  } else {
+    if (erpa <= DF_N(erpmark)(b.lo)) {
+      DF_STAT(dfsubr, small);
+      ret = DF_N(dfnlonorm)(DF_N(ddual)(b.lo, a));
+    } else
+      ret = DF_N(dfnhinorm)(DF_N(ddual)(a, b.lo));
+    r0 = -b.hi;
+  }
+  a = ret.lo;
+  ret = DF_N(dfnlonorm)(DF_N(ddual)(r0, ret.hi));
+  r0 = ret.lo;
+  ret = DF_N(dfnlonorm)(DF_N(ddual)(ret.hi, a));
+  ret.lo += r0;
+  return ret;
+#endif
+}
+
+/* 双数加法(低精度但很快,只遵循源误差) */
+DF_INLINE DF_D DF_N(sdf2add)(DF_D a, DF_D b) {
+  DF_D ret = DF_N(dadd)(a.hi, b.hi);
+  ret.lo += (a.lo + b.lo);
+  return DF_N(dfnorm)(ret);
+}
+
+/* 双数减法(低精度但很快,只遵循源误差) */
+DF_INLINE DF_D DF_N(sdf2sub)(DF_D a, DF_D b) {
+  DF_D ret = DF_N(dsub)(a.hi, b.hi);
+  ret.lo += (a.lo - b.lo);
+  return DF_N(dfnorm)(ret);
+}
+
+/* 双数加法(精度略低但更快) */
+DF_INLINE DF_D DF_N(fdf2add)(DF_D a, DF_D b) {
+  DF_D ret, tmp;
+  DF_N(df2reorder)(&a, &b, 2);
+  ret = DF_N(dfnorm)(DF_N(ddual)(a.hi, b.hi));
+  tmp = DF_N(dfnorm)(DF_N(ddual)(a.lo, b.lo));
+  ret = DF_N(dfnorm)(DF_N(ddual)(ret.hi, ret.lo + tmp.hi));
+  ret = DF_N(dfnorm)(DF_N(ddual)(ret.hi, ret.lo + tmp.lo));
+  return ret;
+}
+
+/* 双数减法(精度略低但更快) */
+DF_INLINE DF_D DF_N(fdf2sub)(DF_D a, DF_D b) {
+  DF_D ret, tmp;
+  DF_N(df2reorder)(&a, &b, 3);
+  ret = DF_N(dfnorm)(DF_N(ddual)(a.hi, b.hi));
+  tmp = DF_N(dfnorm)(DF_N(ddual)(a.lo, b.lo));
+  ret = DF_N(dfnorm)(DF_N(ddual)(ret.hi, ret.lo + tmp.hi));
+  ret = DF_N(dfnorm)(DF_N(ddual)(ret.hi, ret.lo + tmp.lo));
+  return ret;
+}
+
+/* 双数加法(无分支,同df2add) */
+DF_INLINE DF_D DF_N(bdf2add)(DF_D a, DF_D b) {
+  DF_D ret, tmp;
+  DF_T r0, r1, r2, r3;
+  bool z;
+  DF_N(bdf2reorder)(&a, &b, 2);
+  ret = DF_N(dfnorm)(DF_N(ddual)(a.hi, b.hi));
+  tmp = DF_N(dfnorm)(DF_N(ddual)(a.lo, b.lo));
+  r3 = tmp.lo;
+  tmp = DF_N(bdadd)(ret.lo, tmp.hi);
+  r2 = tmp.lo;
+  ret = DF_N(dfnorm)(DF_N(ddual)(ret.hi, tmp.hi));
+  r1 = r2 + r3;
+  z = ret.lo == DF_K(0.0); // 同df2add
+  r0 = DF_N(df_select)(z, r1, DF_K(0.0));
+  r2 = DF_N(df_select)(z, r2, ret.lo);
+  r3 = DF_N(df_select)(z, r3, r1);
+  r1 = ret.hi + r0;
+  ret.lo = ((ret.hi - r1) + r2) + r3;
+  ret.hi = r1;
+  return ret;
+}
+
+/* 双数减法(无分支,同df2sub) */
+DF_INLINE DF_D DF_N(bdf2sub)(DF_D a, DF_D b) {
+  return DF_N(bdf2add)(a, DF_N(dfneg)(b));
+}
+
+/* 双数加法 */
+DF_INLINE DF_D DF_N(df2add)(DF_D a, DF_D b) {
+#ifdef USE_BRANCHLESS_ADD
+  return DF_N(bdf2add)(a, b);
+#else
+  DF_D ret, tmp;
+  DF_T r0, r1, r2, r3;
+  bool z;
+  DF_STAT(df2add, call);
+  DF_N(df2reorder)(&a, &b, 2);
+  ret = DF_N(dfnorm)(DF_N(ddual)(a.hi, b.hi));
+  tmp = DF_N(dfnorm)(DF_N(ddual)(a.lo, b.lo));
+  r3 = tmp.lo;
+  tmp = DF_N(dadd)(ret.lo, tmp.hi);
+  r2 = tmp.lo;
+  ret = DF_N(dfnorm)(DF_N(ddual)(ret.hi, tmp.hi));
+  r1 = r2 + r3;
+  /*
+   * ret.lo为0(罕见)时须将r1并入高位,以选择操作数代替分支:
+   * 否则高位不变,ret.lo=(0+ret.lo)+r1,结果与分支实现逐位相同
+   */
+  z = ret.lo == DF_K(0.0);
+  DF_STAT_IF(z, df2add, lo0);
+  r0 = z ? r1 : DF_K(0.0); // 先选出全部操作数再运算,否则仍会被编译成分支
+  r2 = z ? r2 : ret.lo;
+  r3 = z ? r3 : r1;
+  r1 = ret.hi + r0;
+  ret.lo = ((ret.hi - r1) + r2) + r3;
+  ret.hi = r1;
+  return ret;
+#endif
+}
+
+/* 双数减法 */
+DF_INLINE DF_D DF_N(df2sub)(DF_D a, DF_D b) {
+#ifdef USE_BRANCHLESS_ADD
+  return DF_N(bdf2sub)(a, b);
+#else
+  DF_D ret, tmp;
+  DF_T r0, r1, r2, r3;
+  bool z;
+  DF_STAT(df2sub, call);
+  DF_N(df2reorder)(&a, &b, 3);
+  ret = DF_N(dfnorm)(DF_N(ddual)(a.hi, b.hi));
+  tmp = DF_N(dfnorm)(DF_N(ddual)(a.lo, b.lo));
+  r3 = tmp.lo;
+  tmp = DF_N(dadd)(ret.lo, tmp.hi);
+  r2 = tmp.lo;
+  ret = DF_N(dfnorm)(DF_N(ddual)(ret.hi, tmp.hi));
+  r1 = r2 + r3;
+  z = ret.lo == DF_K(0.0); // 同df2add
+  DF_STAT_IF(z, df2sub, lo0);
+  r0 = z ? r1 : DF_K(0.0);
+  r2 = z ? r2 : ret.lo;
+  r3 = z ? r3 : r1;
+  r1 = ret.hi + r0;
+  ret.lo = ((ret.hi - r1) + r2) + r3;
+  ret.hi = r1;
+  return ret;
+#endif
+}
+
+/* 双数与单数相乘(精度略低但更快)得到双数 */
+DF_INLINE DF_D DF_N(fdfmul)(DF_D a, DF_T b) {
+  DF_D ret = DF_N(dmul)(a.hi, b);
+#if DF_FAST_FMA
+  ret.lo = DF_N(fmuladd)(a.lo, b, ret.lo);
+#else
+  ret.lo += b * a.lo;
+#endif
+  return DF_N(dfnorm)(ret);
+}
+
+/* 双数与单数相除(精度略低但更快)得到双数 */
+DF_INLINE DF_D DF_N(fdfdiv)(DF_D a, DF_T b) {
+  DF_D ret;
+  ret = DF_N(dmdiv)(a.hi, b);
+  ret.lo = (ret.lo + a.lo) / b;
+  return DF_N(dfnorm)(ret);
+}
+
+/* 单数与双数相除(精度略低但更快)得到双数 */
+DF_INLINE DF_D DF_N(fdfdivr)(DF_T a, DF_D b) {
+  DF_D ret;
+  ret = DF_N(dmdiv)(a, b.hi);
+#if DF_FAST_FMA
+  ret.lo = DF_N(nfmulsub)(ret.hi, b.lo, ret.lo) / b.hi;
+#else
+  ret.lo = (ret.lo - ret.hi * b.lo) / b.hi;
+#endif
+  return DF_N(dfnorm)(ret);
+}
+
+/* 双数乘法(精度略低但更快) */
+DF_INLINE DF_D DF_N(fdf2mul)(DF_D a, DF_D b) {
+  DF_D ret = DF_N(dmul)(a.hi, b.hi);
+#if DF_FAST_FMA
+  ret.lo += DF_N(fmuladd)(a.lo, b.hi, DF_N(fmuladd)(a.hi, b.lo, a.lo * b.lo));
+#else
+  ret.lo += a.hi * b.lo + b.hi * a.lo;
+#endif
+  return DF_N(dfnorm)(ret);
+}
+
+/* 双数除法(精度略低但更快) */
+DF_INLINE DF_D DF_N(fdf2div)(DF_D a, DF_D b) {
+  DF_D ret;
+  ret = DF_N(dmdiv)(a.hi, b.hi);
+#if DF_FAST_FMA
+  ret.lo = (ret.lo + DF_N(nfmulsub)(ret.hi, b.lo, a.lo)) / b.hi;
+#else
+  ret.lo = (ret.lo + a.lo - ret.hi * b.lo) / b.hi;
+#endif
+  return DF_N(dfnorm)(ret);
+}
+
+/* 双数平方(精度略低但更快) */
+DF_INLINE DF_D DF_N(fdfsqr)(DF_D a) {
+  DF_D ret = DF_N(dsqr)(a.hi);
+#if DF_FAST_FMA
+  ret.lo = DF_N(fmuladd)(a.hi + a.hi, a.lo, ret.lo);
+#else
+  ret.lo += (a.hi + a.hi) * a.lo;
+#endif
+  return DF_N(dfnorm)(ret);
+}
+
+/* 双数与单数相乘得到双数 */
+DF_INLINE DF_D DF_N(dfmul)(DF_D a, DF_T b) {
+  DF_D ret, tmp, tmp2;
+  DF_STAT(dfmul, call);
+  ret = DF_N(dmul)(a.hi, b);
+  tmp = DF_N(dmul)(a.lo, b);
+  if (DF_N(erpmark)(ret.lo) > DF_N(erpmark)(tmp.hi)) {
+    tmp2 = DF_N(dfnorm)(DF_N(ddual)(ret.lo, tmp.hi));
+    /* 双舍入需要舍入到奇数以保证正确舍入，而默认浮点环境不保证这一点 */
+    tmp2.lo += tmp.lo;
+  } else {
+    DF_STAT(dfmul, renorm);
+    tmp2 = DF_N(dfnorm)(DF_N(ddual)(tmp.hi, ret.lo));
+    tmp2.lo += tmp.lo;
+    tmp2 = DF_N(dfnorm)(tmp2);
+  }
+  ret = DF_N(dfnorm)(DF_N(ddual)(ret.hi, tmp2.hi));
+  ret.lo += tmp2.lo;
+  return ret;
+}
+
+/* 双数与单数相除得到双数 */
+DF_INLINE DF_D DF_N(dfdiv)(DF_D a, DF_T b) {
+  DF_D ret, tmp;
+  ret = DF_N(dmdiv)(a.hi, b);
+  a = DF_N(dfnorm)(DF_N(ddual)(ret.lo, a.lo));
+  DF_T rb = DF_K(1.0) / b;
+  tmp.hi = a.hi * rb;
+  tmp.lo = DF_LIM(nfmulsub)(tmp.hi, b, a.hi);
+  tmp.lo = (tmp.lo + a.lo) * rb;
+  tmp = DF_N(dfnorm)(tmp);
+  ret = DF_N(dfnorm)(DF_N(ddual)(ret.hi, tmp.hi));
+  ret.lo += tmp.lo;
+  return ret;
+}
+
+/* 单数与双数相除得到双数 */
+DF_INLINE DF_D DF_N(dfdivr)(DF_T a, DF_D b) {
+  DF_D ret, tmp, tmp2;
+  DF_T r0, r1, r2, r3;
+  ret = DF_N(dmdiv)(a, b.hi);
+  r0 = DF_K(1.0) / b.hi;
+  r1 = ret.hi;
+  tmp2 = DF_N(dmul)(r1, b.lo);
+  tmp = DF_N(dsub)(ret.lo, tmp2.hi);
+  tmp.lo -= tmp2.lo;
+  r2 = tmp.hi * r0;
+  r3 = DF_LIM(nfmulsub)(r2, b.hi, tmp.hi);
+#if DF_FAST_FMA
+  r3 -= DF_N(fmulsub)(r2, b.lo, tmp.lo);
+#else
+  r3 += tmp.lo - r2 * b.lo;
+#endif
+  r3 *= r0;
+  tmp = DF_N(dfnorm)(DF_N(ddual)(r2, r3));
+  ret = DF_N(dfnorm)(DF_N(ddual)(r1, tmp.hi));
+  ret.lo += tmp.lo;
+  return ret;
+}
+
+/* 双数乘法 */
+DF_INLINE DF_D DF_N(df2mul)(DF_D a, DF_D b) {
+  DF_D ret, tmp, tmp2;
+  DF_T r0;
+  r0 = a.lo * b.lo;
+  tmp = DF_N(dmul)(a.hi, b.lo);
+  tmp2 = DF_N(dmul)(a.lo, b.hi);
+  ret = DF_N(dmul)(a.hi, b.hi);
+  r0 += tmp.lo + tmp2.lo;
+  tmp = DF_N(dadd)(tmp.hi, tmp2.hi);
+  r0 += tmp.lo;
+  tmp = DF_N(dadd)(ret.lo, tmp.hi);
+  tmp.lo += r0;
+  tmp = DF_N(dfnorm)(tmp);
+  ret = DF_N(dfnorm)(DF_N(ddual)(ret.hi, tmp.hi));
+  ret.lo += tmp.lo;
+  return ret;
+}
+
+/* 双数除法 */
+DF_INLINE DF_D DF_N(df2div)(DF_D a, DF_D b) {
+  DF_D ret, tmp, tmp2;
+  DF_T r0, r1, r2, r3;
+  ret = DF_N(dmdiv)(a.hi, b.hi);
+  r0 = DF_K(1.0) / b.hi;
+  r1 = ret.hi;
+  tmp2 = DF_N(dfnorm)(DF_N(ddual)(ret.lo, a.lo));
+  tmp = DF_N(dmul)(r1, b.lo);
+  tmp2.lo -= tmp.lo;
+  tmp = DF_N(dsub)(tmp2.hi, tmp.hi);
+  tmp.lo += tmp2.lo;
+  r2 = tmp.hi * r0;
+  r3 = DF_LIM(nfmulsub)(r2, b.hi, tmp.hi);
+#if DF_FAST_FMA
+  r3 -= DF_N(fmulsub)(r2, b.lo, tmp.lo);
+#else
+  r3 += tmp.lo - r2 * b.lo;
+#endif
+  r3 *= r0;
+  tmp = DF_N(dfnorm)(DF_N(ddual)(r2, r3));
+  ret = DF_N(dfnorm)(DF_N(ddual)(r1, tmp.hi));
+  ret.lo += tmp.lo;
+  return ret;
+}
+
+/* 双数平方 */
+DF_INLINE DF_D DF_N(dfsqr)(DF_D a) {
+  DF_D ret, tmp;
+  DF_T r0;
+  r0 = a.lo * a.lo;
+  tmp = DF_N(dmul)(a.hi, a.lo);
+  tmp.hi += tmp.hi;
+  tmp.lo += tmp.lo;
+  ret = DF_N(dsqr)(a.hi);
+  r0 += tmp.lo;
+  tmp = DF_N(dadd)(ret.lo, tmp.hi);
+  tmp.lo += r0;
+  tmp = DF_N(dfnorm)(tmp);
+  ret = DF_N(dfnorm)(DF_N(ddual)(ret.hi, tmp.hi));
+  ret.lo += tmp.lo;
+  return ret;
+}
+
+/*
+ * 双数乘加a*b+c: 零阶与一阶项无误差地相加,二阶项(a.lo*b.lo与各次相加的误差)
+ * 以普通加法累加,最後只规格化一次,比df2mul後再df2add少一次规格化与一次舍入.
+ * 实测误差不超过约u^2(|a*b|+|c|)(u^2=2^-106,dualfloat为2^-48),与df2mul後再
+ * df2add相同; a*b与c大量相消时相对于结果的误差可能远大于u^2.
+ */
+DF_INLINE DF_D DF_N(df2fma)(DF_D a, DF_D b, DF_D c) {
+  DF_D ret, tmp, tmp2, s;
+  DF_T r0;
+  r0 = a.lo * b.lo;
+  tmp = DF_N(dmul)(a.hi, b.lo);
+  tmp2 = DF_N(dmul)(a.lo, b.hi);
+  ret = DF_N(dmul)(a.hi, b.hi);
+  r0 += tmp.lo + tmp2.lo;
+  tmp = DF_N(dadd)(tmp.hi, tmp2.hi); // 一阶项
+  r0 += tmp.lo;
+  tmp2 = DF_N(dadd)(ret.lo, c.lo);
+  r0 += tmp2.lo;
+  tmp = DF_N(dadd)(tmp.hi, tmp2.hi);
+  r0 += tmp.lo;
+  s = DF_N(dadd)(ret.hi, c.hi); // 零阶项
+  tmp = DF_N(dadd)(s.lo, tmp.hi);
+  r0 += tmp.lo;
+  ret = DF_N(dadd)(s.hi, tmp.hi); // 相消时s.hi可能小于tmp.hi
+  ret.lo += r0;
+  return DF_N(dfnorm)(ret);
+}
+
+/* 单数倒数 */
+DF_INLINE DF_D DF_N(drcp)(DF_T a) {
+  DF_D ret, tmp;
+  DF_T r0, r1, r2, r3;
+  r1 = r0 = DF_K(1.0) / a;
+  r3 = r2 = DF_LIM(nfmulsub)(r0, a, DF_K(1.0));
+  r2 *= r0;
+  r3 = DF_LIM(nfmulsub)(r2, a, r3);
+  r3 *= r0;
+  tmp = DF_N(dfnorm)(DF_N(ddual)(r2, r3));
+  ret = DF_N(dfnorm)(DF_N(ddual)(r1, tmp.hi));
+  ret.lo += tmp.lo;
+  return ret;
+}
+
+/* 双数倒数 */
+DF_INLINE DF_D DF_N(dfrcp)(DF_D a) {
+  DF_D ret, tmp, tmp2;
+  DF_T r0, r1, r2, r3;
+  r1 = r0 = DF_K(1.0) / a.hi;
+  r2 = DF_LIM(nfmulsub)(r0, a.hi, DF_K(1.0));
+  tmp2 = DF_N(dmul)(r1, a.lo);
+  tmp = DF_N(dsub)(r2, tmp2.hi);
+  tmp.lo -= tmp2.lo;
+  r2 = tmp.hi * r0;
+  r3 = DF_LIM(nfmulsub)(r2, a.hi, tmp.hi);
+#if DF_FAST_FMA
+  r3 -= DF_N(fmulsub)(r2, a.lo, tmp.lo);
+#else
+  r3 += tmp.lo - r2 * a.lo;
+#endif
+  r3 *= r0;
+  tmp = DF_N(dfnorm)(DF_N(ddual)(r2, r3));
+  ret = DF_N(dfnorm)(DF_N(ddual)(r1, tmp.hi));
+  ret.lo += tmp.lo;
+  return ret;
+}
+
+/* 双数开平方,以一步牛顿迭代修正a.hi的平方根r0(余数a-r0*r0精确计算) */
+DF_INLINE DF_D DF_N(dfsqrt)(DF_D a) {
+  DF_D tmp;
+  DF_T r0, r1;
+  DF_STAT(dfsqrt, call);
+  if (!(a.hi > DF_K(0.0)) || a.hi - a.hi != DF_K(0.0)) { // 0,负数,无穷大与NaN
+    DF_STAT(dfsqrt, special);
+    return DF_N(ddual)(DF_N(df_sqrt)(a.hi), DF_K(0.0));
+  }
+  r0 = DF_N(df_sqrt)(a.hi);
+  tmp = DF_N(dsqr)(r0);
+  r1 = ((a.hi - tmp.hi) - tmp.lo + a.lo) / (r0 + r0);
+  return DF_N(dfnorm)(DF_N(ddual)(r0, r1));
+}
+
+/* 双数向下取整: a.hi不是整数时即为floor(a.hi),否则再对a.lo取整 */
+DF_INLINE DF_D DF_N(dffloor)(DF_D a) {
+  DF_T hi = DF_N(df_floor)(a.hi), lo = DF_N(df_floor)(a.lo);
+  if (a.hi - a.hi != DF_K(0.0)) // 无穷大与NaN
+    return a;
+  if (hi != a.hi)
+    lo = hi * DF_K(0.0); // 保留-0的符号
+  return DF_N(dfnorm)(DF_N(ddual)(hi, lo));
+}
+
+/* 双数向上取整 */
+DF_INLINE DF_D DF_N(dfceil)(DF_D a) {
+  DF_T hi = DF_N(df_ceil)(a.hi), lo = DF_N(df_ceil)(a.lo);
+  if (a.hi - a.hi != DF_K(0.0))
+    return a;
+  if (hi != a.hi)
+    lo = hi * DF_K(0.0); // 保留-0的符号
+  return DF_N(dfnorm)(DF_N(ddual)(hi, lo));
+}
+
+/* 双数向0取整 */
+DF_INLINE DF_D DF_N(dftrunc)(DF_D a) {
+  return a.hi < DF_K(0.0) ? DF_N(dfceil)(a) : DF_N(dffloor)(a);
+}
+
+/*
+ * 双数四舍五入(恰为0.5时远离0),对|a|计算:
+ * 小数部分为fh+fl(fh为整数位以下的高位,fl为低位),按(fh,fl)依次比较0.5,
+ * 因a已规格化,fh不为0时|fl|不超过fh的erp的一半,比较结果与fh+fl相同.
+ */
+DF_INLINE DF_D DF_N(dfround)(DF_D a) {
+  DF_D x = a.hi < DF_K(0.0) ? DF_N(dfneg)(a) : a, ret;
+  DF_T hi = DF_N(df_floor)(x.hi), lo = DF_N(df_floor)(x.lo), fh, fl;
+  if (a.hi - a.hi != DF_K(0.0))
+    return a;
+  if (hi != x.hi)
+    lo = DF_K(0.0);
+  fh = x.hi - hi;
+  fl = x.lo - lo;
+  if (fh > DF_K(0.5) || (fh == DF_K(0.5) && fl >= DF_K(0.0)) ||
+      (fh == DF_K(0.0) && fl >= DF_K(0.5))) {
+    if (hi != x.hi)
+      hi += DF_K(1.0);
+    else
+      lo += DF_K(1.0);
+  }
+  ret = DF_N(dfnorm)(DF_N(ddual)(hi, lo));
+  return a.hi < DF_K(0.0) ? DF_N(dfneg)(ret) : ret;
+}
+
+/* 双数乘以2^e(两部分分别乘以2的幂,无上溢与下溢时精确) */
+DF_INLINE DF_D DF_N(dfldexp)(DF_D a, int e) {
+  return DF_N(ddual)(DF_N(df_ldexp)(a.hi, e), DF_N(df_ldexp)(a.lo, e));
+}
+
+/*
+ * 双数以2为底的指数floor(log2|a|),取自a.hi的指数位,
+ * a.hi为2的幂且a.lo与a.hi异号时|a|小于|a.hi|,指数减1.
+ */
+DF_INLINE int DF_N(dfilogb)(DF_D a) {
+  int e = DF_N(df_ilogb)(a.hi);
+  DF_T ah = a.hi < DF_K(0.0) ? -a.hi : a.hi;
+  if (a.hi - a.hi == DF_K(0.0) && ah != DF_K(0.0) &&
+      ah == DF_N(df_ldexp)(DF_K(1.0), e) &&
+      (a.lo < DF_K(0.0)) != (a.hi < DF_K(0.0)) && a.lo != DF_K(0.0))
+    e--;
+  return e;
+}
+
+/* 双数分解为a=m*2^e,|m|在[0.5,1)中(0,无穷大与NaN返回a,e为0) */
+DF_INLINE DF_D DF_N(dffrexp)(DF_D a, int *e) {
+  if (a.hi == DF_K(0.0) || a.hi - a.hi != DF_K(0.0)) {
+    *e = 0;
+    return a;
+  }
+  *e = DF_N(dfilogb)(a) + 1;
+  return DF_N(dfldexp)(a, -*e);
+}
+
+/*
+ * 求余的一步: 返回a-n*b,n为整数且a-n*b的高位相消(|a/b|<2^DF_MANT).
+ * n*b.hi与n*b.lo以dmul精确表示,a.hi-n*b.hi无误差(Sterbenz引理),
+ * 余数只在最後求和时舍入一次,b为单数(b.lo为0)时余数精确.
+ */
+DF_INLINE DF_D DF_N(dfrem_step)(DF_D a, DF_D b, DF_T n) {
+  DF_D p = DF_N(dmul)(n, b.hi), q = DF_N(dmul)(n, b.lo), s, t;
+  s = DF_N(dadd)(a.hi - p.hi, -p.lo);
+  t = DF_N(dadd)(a.lo, -q.hi);
+  t.lo -= q.lo;
+  return DF_N(df2add)(s, t);
+}
+
+/*
+ * 截断余数的主循环: b>0,r为|a|,返回r-n*b(n=trunc(r/b))并累计n的低位到*quo.
+ * 商较大时把b放大2^k使每步商少于DF_MANT-1位,中间余数可为负(继续约减),
+ * 最後余数为负时加上b. b为单数时每步余数都精确(同dmdiv的余数);
+ * b为双数且商不少于2^(DF_MANT-2)时中间余数要舍入,误差约为2^(-3*DF_MANT)|a|.
+ */
+DF_INLINE DF_D DF_N(dfrem_loop)(DF_D r, DF_D b, uint64_t *quo) {
+  DF_D d, x;
+  DF_T n;
+  int k;
+  for (;;) {
+    x = r.hi < DF_K(0.0) ? DF_N(dfneg)(r) : r;
+    if (x.hi < b.hi || (x.hi == b.hi && x.lo < b.lo))
+      break;
+    DF_STAT(dfrem_loop, iter);
+    k = 0;
+    if (!dual_likely(x.hi < b.hi * DF_N(df_ldexp)(DF_K(1.0), DF_MANT - 2))) {
+      DF_STAT(dfrem_loop, scale);
+      k = DF_N(df_ilogb)(x.hi) - DF_N(df_ilogb)(b.hi) - DF_MANT + 2;
+    }
+    d = k > 0 ? DF_N(dfldexp)(b, k) : b;
+    n = r.hi / d.hi;
+    n = r.hi < DF_K(0.0) ? DF_N(df_ceil)(n) : DF_N(df_floor)(n);
+    if (n == DF_K(0.0)) // |r|>=b时商至少为1
+      n = r.hi < DF_K(0.0) ? DF_K(-1.0) : DF_K(1.0);
+    r = DF_N(dfrem_step)(r, d, n);
+    if (k < 64)
+      *quo += (uint64_t)(int64_t)n << (k > 0 ? k : 0);
+  }
+  if (r.hi < DF_K(0.0)) {
+    r = DF_N(df2add)(r, b);
+    *quo -= 1;
+  }
+  return r;
+}
+
+/* 双数截断余数a-trunc(a/b)*b(同fmod),符号与a相同 */
+DF_INLINE DF_D DF_N(dffmod)(DF_D a, DF_D b) {
+  DF_D r;
+  uint64_t quo = 0;
+  DF_STAT(dffmod, call);
+  if (b.hi < DF_K(0.0))
+    b = DF_N(dfneg)(b);
+  if (!(b.hi > DF_K(0.0)) || a.hi - a.hi != DF_K(0.0)) { // b为0,a为无穷大与NaN
+    DF_T z = a.hi * b.hi - a.hi * b.hi;
+    DF_STAT(dffmod, special);
+    return DF_N(ddual)(z / z, z / z);
+  }
+  if (b.hi - b.hi != DF_K(0.0)) { // b为无穷大
+    DF_STAT(dffmod, special);
+    return a;
+  }
+  r = DF_N(dfrem_loop)(a.hi < DF_K(0.0) ? DF_N(dfneg)(a) : a, b, &quo);
+  return a.hi < DF_K(0.0) ? DF_N(dfneg)(r) : r;
+}
+
+/*
+ * 双数就近余数a-n*b(同remquo,n为最接近a/b的整数,相等时取偶数),
+ * *quo为n的低31位,符号与a/b相同.
+ */
+DF_INLINE DF_D DF_N(dfremquo)(DF_D a, DF_D b, int *quo) {
+  DF_D r, b2;
+  uint64_t q = 0;
+  int neg = (a.hi < DF_K(0.0)) != (b.hi < DF_K(0.0));
+  *quo = 0;
+  DF_STAT(dfremquo, call);
+  if (b.hi < DF_K(0.0))
+    b = DF_N(dfneg)(b);
+  if (!(b.hi > DF_K(0.0)) || a.hi - a.hi != DF_K(0.0)) {
+    DF_T z = a.hi * b.hi - a.hi * b.hi;
+    DF_STAT(dfremquo, special);
+    return DF_N(ddual)(z / z, z / z);
+  }
+  if (b.hi - b.hi != DF_K(0.0)) {
+    DF_STAT(dfremquo, special);
+    return a;
+  }
+  r = DF_N(dfrem_loop)(a.hi < DF_K(0.0) ? DF_N(dfneg)(a) : a, b, &q);
+  b2 = DF_N(dfldexp)(r, 1); // 2r与b比较,2r上溢时必大于b
+  if (b2.hi > b.hi || (b2.hi == b.hi && (b2.lo > b.lo ||
+                                         (b2.lo == b.lo && (q & 1))))) {
+    r = DF_N(df2sub)(r, b);
+    q++;
+  }
+  q &= 0x7fffffff;
+  *quo = neg ? -(int)q : (int)q;
+  return a.hi < DF_K(0.0) ? DF_N(dfneg)(r) : r;
+}
+
+/*
+ * 延迟规格化的累加器: 每加一项以dadd把误差分离到lo,lo的相加再以dadd补偿,
+ * 其舍入误差累加到err,每DF_ACC_RENORM项或读取时才规格化,
+ * 比逐项df2add省去大部分规格化,实测误差不大于逐项df2add.
+ */
+typedef struct DF_ACC {
+  DF_T hi;
+  DF_T lo;
+  DF_T err;   // lo各次相加的舍入误差之和
+  unsigned n; // 自上次规格化以来的项数
+} DF_ACC;
+
+/* 初始化累加器 */
+DF_INLINE void DF_N(dfacc_init)(DF_ACC *acc) {
+  acc->hi = acc->lo = acc->err = DF_K(0.0);
+  acc->n = 0;
+}
+
+/* 规格化累加器 */
+DF_INLINE void DF_N(dfacc_norm)(DF_ACC *acc) {
+  DF_D t = DF_N(dadd)(acc->hi, acc->lo); // 相减抵消时lo可能大于hi
+  DF_STAT(dfacc_norm, call);
+  t.lo += acc->err;
+  t = DF_N(dfnorm)(t);
+  acc->hi = t.hi;
+  acc->lo = t.lo;
+  acc->err = DF_K(0.0);
+  acc->n = 0;
+}
+
+/* lo加上两个误差项,lo的舍入误差计入err */
+DF_INLINE void DF_N(dfacc_addlo)(DF_ACC *acc, DF_T e1, DF_T e2) {
+  DF_D s = DF_N(dadd)(acc->lo, e1);
+  DF_D t = DF_N(dadd)(s.hi, e2);
+  acc->lo = t.hi;
+  acc->err += s.lo + t.lo;
+  if (++acc->n >= DF_ACC_RENORM)
+    DF_N(dfacc_norm)(acc);
+}
+
+/* 累加单数 */
+DF_INLINE void DF_N(dfacc_add1)(DF_ACC *acc, DF_T b) {
+  DF_D t = DF_N(dadd)(acc->hi, b);
+  DF_D s = DF_N(dadd)(acc->lo, t.lo);
+  acc->hi = t.hi;
+  acc->lo = s.hi;
+  acc->err += s.lo;
+  if (++acc->n >= DF_ACC_RENORM)
+    DF_N(dfacc_norm)(acc);
+}
+
+/* 累加双数 */
+DF_INLINE void DF_N(dfacc_add)(DF_ACC *acc, DF_D b) {
+  DF_D t = DF_N(dadd)(acc->hi, b.hi);
+  acc->hi = t.hi;
+  DF_N(dfacc_addlo)(acc, t.lo, b.lo);
+}
+
+/* 累加双数的积(点积的一步): acc+=x*y,乘积的二阶项只做普通乘加 */
+DF_INLINE void DF_N(dfacc_dot)(DF_ACC *acc, DF_D x, DF_D y) {
+  DF_D p = DF_N(dmul)(x.hi, y.hi);
+  DF_D t = DF_N(dadd)(acc->hi, p.hi);
+#if DF_FAST_FMA
+  p.lo += DF_N(fmuladd)(x.hi, y.lo, x.lo * y.hi);
+#else
+  p.lo += x.hi * y.lo + x.lo * y.hi;
+#endif
+  acc->hi = t.hi;
+  DF_N(dfacc_addlo)(acc, t.lo, p.lo);
+}
+
+/* 减去双数 */
+DF_INLINE void DF_N(dfacc_sub)(DF_ACC *acc, DF_D b) {
+  DF_N(dfacc_add)(acc, DF_N(dfneg)(b));
+}
+
+/* 合并累加器: acc+=b */
+DF_INLINE void DF_N(dfacc_merge)(DF_ACC *acc, const DF_ACC *b) {
+  acc->err += b->err;
+  DF_N(dfacc_add)(acc, DF_N(ddual)(b->hi, b->lo));
+}
+
+/* 读取累加器的值 */
+DF_INLINE DF_D DF_N(dfacc_get)(const DF_ACC *acc) {
+  DF_D t = DF_N(dadd)(acc->hi, acc->lo);
+  t.lo += acc->err;
+  return DF_N(dfnorm)(t);
+}
+
+/*
+ * 与DF_LIM(fmulsub)同样在无FMA时使用分割浮点算法(USE_DF_SPLIT_FMA)的情况下,
+ * 乘数b的分割bs=DF_SPLIT(b)可以预先计算,以下两个函数省去b的分割,
+ * 其他情况忽略bs,分别同dmul与DF_LIM(nfmulsub)
+ */
+#if !(FP_FMA_INTRINS == 1 || FP_FMA_INTRINS == 2) && USE_DF_SPLIT_FMA
+#define DF_PRESPLIT 1
+#else
+#define DF_PRESPLIT 0
+#endif
+
+/* 单数相乘得到积与余数,bs为b的分割 */
+DF_INLINE DF_D DF_N(dmul_presplit)(DF_T a, DF_T b, DF_D bs) {
+#if DF_PRESPLIT
+  DF_D ret, as = DF_SPLIT(a);
+  ret.hi = a * b;
+  ret.lo = (((as.hi * bs.hi - ret.hi) + as.hi * bs.lo) + as.lo * bs.hi) +
+           as.lo * bs.lo;
+  return ret;
+#else
+  (void)bs;
+  return DF_N(dmul)(a, b);
+#endif
+}
+
+/* 计算-(a*b-c),要求同DF_LIM(nfmulsub),bs为b的分割 */
+DF_INLINE DF_T DF_N(nfmulsub_presplit)(DF_T a, DF_T b, DF_D bs,
+                                       DF_T c) {
+#if DF_PRESPLIT
+  DF_D as = DF_SPLIT(a);
+  (void)b;
+  return (((c - as.hi * bs.hi) - as.hi * bs.lo) - as.lo * bs.hi) -
+         as.lo * bs.lo;
+#else
+  (void)bs;
+  return DF_LIM(nfmulsub)(a, b, c);
+#endif
+}
+#undef DF_PRESPLIT
+
+/*
+ * 预先计算的除数: 以同一双数除多个数时,近似商由乘以b.hi的倒数得到,
+ * 省去df2div的两次除法,精度同df2div(结果不一定逐位相同).
+ * 除数须有限非零且倒数不溢出.
+ */
+typedef struct DF_DIVR {
+  DF_D b;   // 除数
+  DF_D rcp; // b.hi的倒数drcp(b.hi)
+  DF_D hs;  // DF_SPLIT(b.hi)
+  DF_D ls;  // DF_SPLIT(b.lo)
+} DF_DIVR;
+
+/* 构造预先计算的除数 */
+DF_INLINE DF_DIVR DF_N(dfdivisor)(DF_D b) {
+  DF_DIVR d;
+  d.b = b;
+  d.rcp = DF_N(drcp)(b.hi);
+  d.hs = DF_SPLIT(b.hi);
+  d.ls = DF_SPLIT(b.lo);
+  return d;
+}
+
+/* 双数除以预先计算的除数 */
+DF_INLINE DF_D DF_N(dfdivby)(DF_D a, const DF_DIVR *d) {
+  DF_D ret, tmp, tmp2;
+  DF_T r0, r1, r2, r3;
+  r0 = d->rcp.hi;
+#if DF_FAST_FMA
+  r1 = DF_N(fmuladd)(a.hi, r0, a.hi * d->rcp.lo); // 忠实舍入,余数精确
+#else
+  r1 = a.hi * r0 + a.hi * d->rcp.lo;
+#endif
+  ret.lo = DF_N(nfmulsub_presplit)(r1, d->b.hi, d->hs, a.hi);
+  tmp2 = DF_N(dfnorm)(DF_N(ddual)(ret.lo, a.lo));
+  tmp = DF_N(dmul_presplit)(r1, d->b.lo, d->ls);
+  tmp2.lo -= tmp.lo;
+  tmp = DF_N(dsub)(tmp2.hi, tmp.hi);
+  tmp.lo += tmp2.lo;
+  r2 = tmp.hi * r0;
+  r3 = DF_N(nfmulsub_presplit)(r2, d->b.hi, d->hs, tmp.hi);
+#if DF_FAST_FMA
+  r3 -= DF_N(fmulsub)(r2, d->b.lo, tmp.lo);
+#else
+  r3 += tmp.lo - r2 * d->b.lo;
+#endif
+  r3 *= r0;
+  tmp = DF_N(dfnorm)(DF_N(ddual)(r2, r3));
+  ret = DF_N(dfnorm)(DF_N(ddual)(r1, tmp.hi));
+  ret.lo += tmp.lo;
+  return ret;
+}
+
+/* 预先计算的乘数: 以同一双数乘多个数,结果与df2mul逐位相同 */
+typedef struct DF_MULR {
+  DF_D m;  // 乘数
+  DF_D hs; // DF_SPLIT(m.hi)
+  DF_D ls; // DF_SPLIT(m.lo)
+} DF_MULR;
+
+/* 构造预先计算的乘数 */
+DF_INLINE DF_MULR DF_N(dfmultiplier)(DF_D m) {
+  DF_MULR r;
+  r.m = m;
+  r.hs = DF_SPLIT(m.hi);
+  r.ls = DF_SPLIT(m.lo);
+  return r;
+}
+
+/* 双数乘以预先计算的乘数,同df2mul */
+DF_INLINE DF_D DF_N(dfmulby)(DF_D a, const DF_MULR *m) {
+  DF_D ret, tmp, tmp2;
+  DF_T r0;
+  r0 = a.lo * m->m.lo;
+  tmp = DF_N(dmul_presplit)(a.hi, m->m.lo, m->ls);
+  tmp2 = DF_N(dmul_presplit)(a.lo, m->m.hi, m->hs);
+  ret = DF_N(dmul_presplit)(a.hi, m->m.hi, m->hs);
+  r0 += tmp.lo + tmp2.lo;
+  tmp = DF_N(dadd)(tmp.hi, tmp2.hi);
+  r0 += tmp.lo;
+  tmp = DF_N(dadd)(ret.lo, tmp.hi);
+  tmp.lo += r0;
+  tmp = DF_N(dfnorm)(tmp);
+  ret = DF_N(dfnorm)(DF_N(ddual)(ret.hi, tmp.hi));
+  ret.lo += tmp.lo;
+  return ret;
+}
+
+/*
+ * 以下cdf*为正确舍入的双数运算: 结果hi为精确值x舍入到最近,lo为x-hi舍入到最近.
+ * 先得到hi再舍入lo是两次舍入,须以舍入到奇数(round-to-odd)保留粘滞位才不出错,
+ * 默认浮点环境不提供这种舍入;这里不改变MXCSR,而在无误差变换得到的精确分量上
+ * 以整数修正模拟(df_round_odd: 其後分量非0且前一分量为偶数时向其方向移动一位).
+ * 快速路径由无误差变换得到三个精确分量与有界的尾项,能确定舍入时直接返回;
+ * 否则(x靠近舍入边界,极少)精确规格化全部分量,除法则以精确余数的符号修正商.
+ * 不考虑下溢;运算数或结果不是有限数时同df2add等.
+ */
+
+/* 精确规格化n个分量(和不变): 由大到小,相邻两项相加不改变前一项,0在末尾 */
+DF_INLINE void DF_N(df_distill)(DF_T *z, int n) {
+  DF_D s;
+  int i, ok;
+  do {
+    DF_STAT(df_distill, pass);
+    for (i = n - 2; i >= 0; i--) {
+      s = DF_N(bdadd)(z[i], z[i + 1]);
+      z[i] = s.hi;
+      z[i + 1] = s.lo;
+    }
+    if (!(z[0] - z[0] == DF_K(0.0)))
+      return;
+    for (i = 0; i < n - 1; i++) {
+      s = DF_N(bdadd)(z[i], z[i + 1]);
+      z[i] = s.hi;
+      z[i + 1] = s.lo;
+    }
+    ok = 1;
+    for (i = 0; i < n - 1; i++)
+      ok &= (z[i] + z[i + 1] == z[i]) &
+            (z[i] != DF_K(0.0) || z[i + 1] == DF_K(0.0));
+  } while (!ok);
+}
+
+/* 由规格化的分量(至少4个)得到正确舍入的双数 */
+DF_INLINE DF_D DF_N(df_crround)(const DF_T *z) {
+  DF_D r;
+  r.hi = z[0] + DF_N(df_round_odd)(z[1], z[2]);
+  r.lo = ((z[0] - r.hi) + z[1]) + DF_N(df_round_odd)(z[2], z[3]);
+  return r;
+}
+
+/*
+ * 快速路径的舍入: z0,z1,z2为精确分量,其余尾项之和的绝对值不超过e
+ * (e为0表示没有尾项),能确定正确舍入时写入r并返回1.
+ */
+DF_INLINE int DF_N(df_crfast)(DF_T z0, DF_T z1, DF_T z2, DF_T e,
+                              DF_D *r) {
+  DF_T a1 = z1 < DF_K(0.0) ? -z1 : z1, a2 = z2 < DF_K(0.0) ? -z2 : z2;
+  DF_T h = DF_N(df_halfulp)(z0);
+  if (!(z0 - z0 == DF_K(0.0) && z0 + z1 == z0 && z1 + z2 == z1))
+    return 0;
+  /* 已规格化则z0+z1舍入为z0,只在恰为舍入边界时以尾项的符号舍入到奇数 */
+  r->hi = z0;
+  r->lo = z1;
+  if (a1 == h || a1 + a1 == h) {
+    if (e != DF_K(0.0) && !(a2 > e))
+      return 0;
+    r->hi = z0 + DF_N(df_round_odd)(z1, z2);
+    r->lo = (z0 - r->hi) + z1;
+  }
+  /* lo+z2与lo的舍入边界的距离须大于误差 */
+  if (e != DF_K(0.0)) {
+    h = DF_N(df_halfulp)(r->lo);
+    a1 = a2 - h;
+    h = a2 - h * DF_K(0.5);
+    if (!((a1 < DF_K(0.0) ? -a1 : a1) > e && (h < DF_K(0.0) ? -h : h) > e))
+      return 0;
+  }
+  r->lo += z2;
+  return 1;
+}
+
+/* 正确舍入的双数加法,不能确定舍入时精确规格化全部分量 */
+DF_SLOWPATH DF_D DF_N(cdf2add_slow)(DF_D a, DF_D b) {
+  DF_T z[4] = {a.hi, b.hi, a.lo, b.lo};
+  DF_STAT(cdf2add, slow);
+  DF_N(df_distill)(z, 4);
+  if (!(z[0] - z[0] == DF_K(0.0)))
+    return DF_N(df2add)(a, b);
+  return DF_N(df_crround)(z);
+}
+
+/* 正确舍入的双数加法 */
+DF_INLINE DF_D DF_N(cdf2add)(DF_D a, DF_D b) {
+  DF_D s, t, g, z, w, y, v, r;
+  DF_STAT(cdf2add, call);
+  /* 全部以TwoSum精确求和,尾项v.lo也是精确的(常见的恰在舍入边界上的和) */
+  s = DF_N(bdadd)(a.hi, b.hi);
+  t = DF_N(bdadd)(a.lo, b.lo);
+  g = DF_N(bdadd)(s.lo, t.hi);
+  z = DF_N(bdadd)(s.hi, g.hi);
+  w = DF_N(bdadd)(g.lo, t.lo);
+  y = DF_N(bdadd)(z.lo, w.hi);
+  v = DF_N(bdadd)(y.lo, w.lo);
+  if (dual_likely(DF_N(df_crfast)(z.hi, y.hi, v.hi,
+                                  v.lo < DF_K(0.0) ? -v.lo : v.lo, &r)))
+    return r;
+  return DF_N(cdf2add_slow)(a, b);
+}
+
+/* 正确舍入的双数减法 */
+DF_INLINE DF_D DF_N(cdf2sub)(DF_D a, DF_D b) {
+  return DF_N(cdf2add)(a, DF_N(dfneg)(b));
+}
+
+/* 正确舍入的双数与单数相加 */
+DF_INLINE DF_D DF_N(cdfadd)(DF_D a, DF_T b) {
+  return DF_N(cdf2add)(a, DF_N(ddual)(b, DF_K(0.0)));
+}
+
+/* 正确舍入的双数与单数相减 */
+DF_INLINE DF_D DF_N(cdfsub)(DF_D a, DF_T b) {
+  return DF_N(cdf2add)(a, DF_N(ddual)(-b, DF_K(0.0)));
+}
+
+/* 正确舍入的单数与双数相减 */
+DF_INLINE DF_D DF_N(cdfsubr)(DF_T a, DF_D b) {
+  return DF_N(cdf2add)(DF_N(ddual)(a, DF_K(0.0)), DF_N(dfneg)(b));
+}
+
+/* 正确舍入的双数乘法,不能确定舍入时精确规格化全部分量 */
+DF_SLOWPATH DF_D DF_N(cdf2mul_slow)(DF_D a, DF_D b) {
+  DF_D p0 = DF_N(dmul)(a.hi, b.hi), p1 = DF_N(dmul)(a.hi, b.lo);
+  DF_D p2 = DF_N(dmul)(a.lo, b.hi), p3 = DF_N(dmul)(a.lo, b.lo);
+  DF_T z[8] = {p0.hi, p1.hi, p2.hi, p0.lo, p1.lo, p2.lo, p3.hi, p3.lo};
+  DF_STAT(cdf2mul, slow);
+  DF_N(df_distill)(z, 8);
+  if (!(z[0] - z[0] == DF_K(0.0)))
+    return DF_N(df2mul)(a, b);
+  return DF_N(df_crround)(z);
+}
+
+/* 正确舍入的双数乘法 */
+DF_INLINE DF_D DF_N(cdf2mul)(DF_D a, DF_D b) {
+  DF_D p0, p1, p2, c, u, z, y, r;
+  DF_T w0, w1, w2, w;
+  DF_STAT(cdf2mul, call);
+  p0 = DF_N(dmul)(a.hi, b.hi);
+  p1 = DF_N(dmul)(a.hi, b.lo);
+  p2 = DF_N(dmul)(a.lo, b.hi);
+  c = DF_N(bdadd)(p1.hi, p2.hi);
+  u = DF_N(bdadd)(p0.lo, c.hi);
+  w0 = u.lo + c.lo;
+  w1 = p1.lo + p2.lo;
+  w2 = a.lo * b.lo;
+  w = (w0 + w1) + w2;
+  z = DF_N(dfnorm)(DF_N(ddual)(p0.hi, u.hi));
+  y = DF_N(bdadd)(z.lo, w);
+  /* w的误差不超过3u(|w0|+|w1|+|w2|),u=2^-(DF_MANT+1),取16u */
+  w = ((w0 < DF_K(0.0) ? -w0 : w0) + (w1 < DF_K(0.0) ? -w1 : w1) +
+       (w2 < DF_K(0.0) ? -w2 : w2)) *
+      DF_N(df_ldexp)(DF_K(1.0), 3 - DF_MANT);
+  if (dual_likely(DF_N(df_crfast)(z.hi, y.hi, y.lo, w, &r)))
+    return r;
+  return DF_N(cdf2mul_slow)(a, b);
+}
+
+/* 正确舍入的双数与单数相乘 */
+DF_INLINE DF_D DF_N(cdfmul)(DF_D a, DF_T b) {
+  return DF_N(cdf2mul)(a, DF_N(ddual)(b, DF_K(0.0)));
+}
+
+/*
+ * 正确舍入的除法中修正商: e[0..*n-1]为a-c*b的精确分量,c与a/b相差不到一位,
+ * 返回a/b舍入到最近的商,e随之更新为a-商*b.
+ */
+DF_INLINE DF_T DF_N(df_crquot)(DF_T c, DF_T *e, int *n, DF_D b) {
+  DF_T f[16] = {DF_K(0.0)}, nb, d;
+  int i;
+  DF_N(df_distill)(e, *n);
+  if (e[0] == DF_K(0.0))
+    return c;
+  /* 商在c与nb之间,以中点c+d处的余数的符号选择 */
+  nb = DF_N(df_ulpstep)(c, (e[0] > DF_K(0.0)) == (b.hi > DF_K(0.0))
+                               ? DF_K(1.0)
+                               : DF_K(-1.0));
+  d = (nb - c) * DF_K(0.5);
+  for (i = 0; i < *n; i++)
+    f[i] = e[i];
+  f[i++] = -d * b.hi;
+  f[i++] = -d * b.lo;
+  DF_N(df_distill)(f, i);
+  if (f[0] != DF_K(0.0) ? (f[0] > DF_K(0.0)) == (e[0] > DF_K(0.0))
+                        : DF_N(df_round_odd)(c, DF_K(1.0)) == c) {
+    e[(*n)++] = -(d + d) * b.hi;
+    e[(*n)++] = -(d + d) * b.lo;
+    c = nb;
+  }
+  return c;
+}
+
+/* 正确舍入的双数除法,不能确定舍入时以精确余数修正,h为近似的商 */
+DF_SLOWPATH DF_D DF_N(cdf2div_slow)(DF_D a, DF_D b, DF_T h) {
+  DF_T e[16] = {DF_K(0.0)};
+  DF_D p, q, r;
+  int n = 0;
+  DF_STAT(cdf2div, slow);
+  if (!(h - h == DF_K(0.0)) || h == DF_K(0.0))
+    return DF_N(df2div)(a, b);
+  p = DF_N(dmul)(h, b.hi);
+  q = DF_N(dmul)(h, b.lo);
+  e[n++] = a.hi;
+  e[n++] = a.lo;
+  e[n++] = -p.hi;
+  e[n++] = -p.lo;
+  e[n++] = -q.hi;
+  e[n++] = -q.lo;
+  r.hi = DF_N(df_crquot)(h, e, &n, b);
+  /* lo为(a-hi*b)/b舍入到最近,同样以近似值修正 */
+  DF_N(df_distill)(e, n);
+  h = DF_N(df2div)(DF_N(ddual)(e[0], e[1]), b).hi;
+  if (h != DF_K(0.0)) {
+    p = DF_N(dmul)(h, b.hi);
+    q = DF_N(dmul)(h, b.lo);
+    e[n++] = -p.hi;
+    e[n++] = -p.lo;
+    e[n++] = -q.hi;
+    e[n++] = -q.lo;
+    h = DF_N(df_crquot)(h, e, &n, b);
+  }
+  r.lo = h;
+  return r;
+}
+
+/* 正确舍入的双数除法 */
+DF_INLINE DF_D DF_N(cdf2div)(DF_D a, DF_D b) {
+  DF_D d0, m, s1, s2, d1, z, y, r;
+  DF_T w0, w1, w2, w;
+  DF_STAT(cdf2div, call);
+  d0 = DF_N(dmdiv)(a.hi, b.hi);
+  m = DF_N(dmul)(d0.hi, b.lo);
+  s1 = DF_N(bdadd)(d0.lo, a.lo);
+  s2 = DF_N(bdadd)(s1.hi, -m.hi);
+  d1 = DF_N(dmdiv)(s2.hi, b.hi);
+  /* 余数a-(q0+q1)*b = w0+w1-w2 */
+  w0 = d1.lo + s1.lo;
+  w1 = s2.lo - m.lo;
+  w2 = d1.hi * b.lo;
+  w = ((w0 + w1) - w2) / b.hi;
+  z = DF_N(dfnorm)(DF_N(ddual)(d0.hi, d1.hi));
+  y = DF_N(bdadd)(z.lo, w);
+  /* 商的尾项的误差不超过8u(|w0|+|w1|+|w2|)/|b.hi|,取16u */
+  w = ((w0 < DF_K(0.0) ? -w0 : w0) + (w1 < DF_K(0.0) ? -w1 : w1) +
+       (w2 < DF_K(0.0) ? -w2 : w2)) /
+      (b.hi < DF_K(0.0) ? -b.hi : b.hi) *
+      DF_N(df_ldexp)(DF_K(1.0), 3 - DF_MANT);
+  if (dual_likely(DF_N(df_crfast)(z.hi, y.hi, y.lo, w, &r)))
+    return r;
+  return DF_N(cdf2div_slow)(a, b, z.hi);
+}
+
+/* 正确舍入的双数除以单数 */
+DF_INLINE DF_D DF_N(cdfdiv)(DF_D a, DF_T b) {
+  return DF_N(cdf2div)(a, DF_N(ddual)(b, DF_K(0.0)));
+}
+
+/* 正确舍入的单数除以双数 */
+DF_INLINE DF_D DF_N(cdfdivr)(DF_T a, DF_D b) {
+  return DF_N(cdf2div)(DF_N(ddual)(a, DF_K(0.0)), b);
+}
+
+#if defined(__cplusplus) || defined(c_plusplus)
+#include "dual_cxx.h"
+
+/* 单数类型DF_T对应的双数类型与运算 */
+template <> struct dual_tier<DF_T, df_fast> {
+  static DF_D add(DF_D a, DF_T b) { return DF_N(fdfadd)(a, b); }
+  static DF_D add(DF_D a, DF_D b) { return DF_N(fdf2add)(a, b); }
+  static DF_D sub(DF_D a, DF_T b) { return DF_N(fdfsub)(a, b); }
+  static DF_D sub(DF_T a, DF_D b) { return DF_N(fdfsubr)(a, b); }
+  static DF_D sub(DF_D a, DF_D b) { return DF_N(fdf2sub)(a, b); }
+  static DF_D mul(DF_D a, DF_T b) { return DF_N(fdfmul)(a, b); }
+  static DF_D mul(DF_D a, DF_D b) { return DF_N(fdf2mul)(a, b); }
+  static DF_D div(DF_D a, DF_T b) { return DF_N(fdfdiv)(a, b); }
+  static DF_D div(DF_T a, DF_D b) { return DF_N(fdfdivr)(a, b); }
+  static DF_D div(DF_D a, DF_D b) { return DF_N(fdf2div)(a, b); }
+};
+
+template <> struct dual_tier<DF_T, df_accurate> {
+  static DF_D add(DF_D a, DF_T b) { return DF_N(dfadd)(a, b); }
+  static DF_D add(DF_D a, DF_D b) { return DF_N(df2add)(a, b); }
+  static DF_D sub(DF_D a, DF_T b) { return DF_N(dfsub)(a, b); }
+  static DF_D sub(DF_T a, DF_D b) { return DF_N(dfsubr)(a, b); }
+  static DF_D sub(DF_D a, DF_D b) { return DF_N(df2sub)(a, b); }
+  static DF_D mul(DF_D a, DF_T b) { return DF_N(dfmul)(a, b); }
+  static DF_D mul(DF_D a, DF_D b) { return DF_N(df2mul)(a, b); }
+  static DF_D div(DF_D a, DF_T b) { return DF_N(dfdiv)(a, b); }
+  static DF_D div(DF_T a, DF_D b) { return DF_N(dfdivr)(a, b); }
+  static DF_D div(DF_D a, DF_D b) { return DF_N(df2div)(a, b); }
+};
+
+template <> struct dual_tier<DF_T, df_sloppy> : dual_tier<DF_T, df_fast> {
+  using dual_tier<DF_T, df_fast>::add;
+  using dual_tier<DF_T, df_fast>::sub;
+  static DF_D add(DF_D a, DF_D b) { return DF_N(sdf2add)(a, b); }
+  static DF_D sub(DF_D a, DF_D b) { return DF_N(sdf2sub)(a, b); }
+};
+
+template <> struct dual_tier<DF_T, df_correct> {
+  static DF_D add(DF_D a, DF_T b) { return DF_N(cdfadd)(a, b); }
+  static DF_D add(DF_D a, DF_D b) { return DF_N(cdf2add)(a, b); }
+  static DF_D sub(DF_D a, DF_T b) { return DF_N(cdfsub)(a, b); }
+  static DF_D sub(DF_T a, DF_D b) { return DF_N(cdfsubr)(a, b); }
+  static DF_D sub(DF_D a, DF_D b) { return DF_N(cdf2sub)(a, b); }
+  static DF_D mul(DF_D a, DF_T b) { return DF_N(cdfmul)(a, b); }
+  static DF_D mul(DF_D a, DF_D b) { return DF_N(cdf2mul)(a, b); }
+  static DF_D div(DF_D a, DF_T b) { return DF_N(cdfdiv)(a, b); }
+  static DF_D div(DF_T a, DF_D b) { return DF_N(cdfdivr)(a, b); }
+  static DF_D div(DF_D a, DF_D b) { return DF_N(cdf2div)(a, b); }
+};
+
+/* 运算符使用的运算(add,sub,mul,div)的精度为df_default */
+template <> struct dual_traits<DF_T> : dual_tier<DF_T, df_default> {
+  typedef DF_T scalar;
+  typedef DF_D dual;
+  /* 表达式模板使用的基本运算 */
+  static DF_D two_sum(DF_T a, DF_T b) { return DF_N(dadd)(a, b); }
+  static DF_D fast_two_sum(DF_T a, DF_T b) {
+    return DF_N(dfnorm)(DF_N(ddual)(a, b));
+  }
+  static DF_D two_prod(DF_T a, DF_T b) { return DF_N(dmul)(a, b); }
+  static DF_T fma(DF_T a, DF_T b, DF_T c) { return DF_N(fmuladd)(a, b, c); }
+  static DF_D neg(DF_D a) { return DF_N(dfneg)(a); }
+  static DF_T add1(DF_D a, DF_T b) { return DF_N(df1add)(a, b); }
+  static DF_T sub1r(DF_T a, DF_D b) { return DF_N(df1subr)(a, b); }
+  static DF_D sqrt(DF_D a) { return DF_N(dfsqrt)(a); }
+};
+
+inline DF_ACC &operator+=(DF_ACC &acc, DF_T b) {
+  DF_N(dfacc_add1)(&acc, b);
+  return acc;
+}
+
+inline DF_ACC &operator+=(DF_ACC &acc, DF_D b) {
+  DF_N(dfacc_add)(&acc, b);
+  return acc;
+}
+
+inline DF_ACC &operator-=(DF_ACC &acc, DF_T b) {
+  DF_N(dfacc_add1)(&acc, -b);
+  return acc;
+}
+
+inline DF_ACC &operator-=(DF_ACC &acc, DF_D b) {
+  DF_N(dfacc_sub)(&acc, b);
+  return acc;
+}
+
+inline DF_D operator/(DF_D a, const DF_DIVR &d) {
+  return DF_N(dfdivby)(a, &d);
+}
+
+inline DF_D &operator/=(DF_D &a, const DF_DIVR &d) {
+  return a = DF_N(dfdivby)(a, &d);
+}
+
+inline DF_D operator*(DF_D a, const DF_MULR &m) {
+  return DF_N(dfmulby)(a, &m);
+}
+
+inline DF_D operator*(const DF_MULR &m, DF_D a) {
+  return DF_N(dfmulby)(a, &m);
+}
+
+inline DF_D &operator*=(DF_D &a, const DF_MULR &m) {
+  return a = DF_N(dfmulby)(a, &m);
+}
+#endif
+
+#undef DF_T
+#undef DF_D
+#undef DF_N
+#undef DF_LIM
+#undef DF_K
+#undef DF_ERP
+#undef DF_ACC
+#undef DF_DIVR
+#undef DF_MULR
+#undef DF_SPLIT
+#undef DF_MANT
+#undef DF_FAST_FMA
+#endif // !DF_T
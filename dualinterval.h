@@ -0,0 +1,591 @@
+﻿#ifndef _DUAL_INTERVAL_H_
+#define _DUAL_INTERVAL_H_
+#include "dualbatch.h"
+#include <math.h>
+
+/**
+ * dualinterval双数区间,端点为规格化的dualdouble,用于有保证的包含(验证计算):
+ * 运算结果一定包含运算数区间内所有精确结果.
+ * 端点由无误差变换(bdadd,dmul,dmdiv)得到两个精确分量与尾项,尾项的误差界
+ * 严格推导,再向外移动至少一位舍入(di_dn,di_up),结果约宽几个2^-104的相对量.
+ * 不改变MXCSR的舍入模式: 有向舍入下无误差变换不再精确,逐批切换也较慢.
+ * 假定默认浮点环境(舍入到最近,不清零非规格化数),误差界另含下溢的绝对误差;
+ * 无FMA时标量dmul不适用非规格化数(见fmulsub_lim),乘积的分量为非规格化数时
+ * 不保证包含.
+ * 端点上溢时为对应方向的无穷大(另一方向取DI_OVERFLOW_MIN),结果为NaN(inf*0等)
+ * 时为对应方向的无穷大;
+ * 除数区间含0时结果为(-inf,inf),开平方的区间全为负数时结果的端点为NaN.
+ * 乘除法按运算数的符号选择端点(无分支),因此批量版本的结果逐位相同.
+ */
+
+typedef struct dualinterval {
+  dualdouble inf; // 下界
+  dualdouble sup; // 上界
+} dualinterval;
+
+/* 构造区间[inf,sup] */
+DF_INLINE dualinterval dinterval(dualdouble inf, dualdouble sup) {
+  dualinterval ret;
+  ret.inf = inf;
+  ret.sup = sup;
+  return ret;
+}
+
+/* 只含一点的区间 */
+DF_INLINE dualinterval dipoint(dualdouble a) {
+  return dinterval(a, a);
+}
+
+/* 规格化的双数a<b(依次比较hi与lo) */
+DF_INLINE bool di_less(dualdouble a, dualdouble b) {
+  return a.hi < b.hi || (a.hi == b.hi && a.lo < b.lo);
+}
+
+/* 区间是否包含x */
+DF_INLINE bool dicontains(dualinterval a, dualdouble x) {
+  return !di_less(x, a.inf) && !di_less(a.sup, x) && a.inf.hi == a.inf.hi &&
+         a.sup.hi == a.sup.hi && x.hi == x.hi;
+}
+
+/* 区间取反 */
+DF_INLINE dualinterval dineg(dualinterval a) {
+  return dinterval(dfneg(a.sup), dfneg(a.inf));
+}
+
+/* 绝对值(不需要-0的符号) */
+DF_INLINE double di_abs(double x) { return x < 0.0 ? -x : x; }
+
+/*
+ * x为一次运算舍入到最近的结果时,返回不大于舍入前精确值的数:
+ * |x|*2^-52不小于x的一位,减去後至少向下移动一位(x为0时移到-2^-1074)
+ */
+DF_INLINE double di_dn(double x) {
+  return x - (di_abs(x) * DBL_EPSILON + DBL_MIN * DBL_EPSILON);
+}
+
+/* 同di_dn,返回不小于舍入前精确值的数 */
+DF_INLINE double di_up(double x) {
+  return x + (di_abs(x) * DBL_EPSILON + DBL_MIN * DBL_EPSILON);
+}
+
+/*
+ * 以下di_*parts返回精确值x的分量: x=z.hi+z.lo+τ,z.hi与z.lo精确,
+ * 尾项τ与*t相差不超过*e(*e为0时*t为τ只经一次舍入的结果,
+ * di_lower与di_upper的外移包括这次舍入).
+ * 运算数须为规格化的双数.
+ */
+
+/* 主要分量h不是有限数时分量改为(h,0),尾项为0,以便di_lower等判断上溢 */
+DF_INLINE dualdouble di_special(double h, dualdouble z, double *t,
+                               double *e) {
+  bool ok = h - h == 0.0;
+  *t = ok ? *t : 0.0;
+  *e = ok ? *e : 0.0;
+  return ok ? z : ddual(h, 0.0);
+}
+
+/* 加法: 以TwoSum精确求和(同cdf2add),尾项为两个精确分量之和 */
+DF_INLINE dualdouble di_addparts(dualdouble a, dualdouble b,
+                                double *t, double *e) {
+  dualdouble s = bdadd(a.hi, b.hi), u = bdadd(a.lo, b.lo);
+  dualdouble g = bdadd(s.lo, u.hi), z = bdadd(s.hi, g.hi);
+  *t = g.lo + u.lo;
+  *e = 0.0;
+  return di_special(s.hi, z, t, e);
+}
+
+/*
+ * 乘法: a*b = p0+p1+p2+a.lo*b.lo,三个乘积以dmul精确分解(同cdf2mul),
+ * 低位之和w=(w0+w1)+w2的误差不超过3u(|w0|+|w1|+|w2|)(u=2^-53),取16u,
+ * 每次下溢至多再有2^-1075的误差,取16*2^-1074.
+ */
+DF_INLINE dualdouble di_mulparts(dualdouble a, dualdouble b,
+                                double *t, double *e) {
+  dualdouble p0 = dmul(a.hi, b.hi), p1 = dmul(a.hi, b.lo);
+  dualdouble p2 = dmul(a.lo, b.hi), c = bdadd(p1.hi, p2.hi);
+  dualdouble u = bdadd(p0.lo, c.hi), z = bdadd(p0.hi, u.hi);
+  double w0 = u.lo + c.lo, w1 = p1.lo + p2.lo, w2 = a.lo * b.lo;
+  *t = (w0 + w1) + w2;
+  *e = (di_abs(w0) + di_abs(w1) + di_abs(w2)) * (DBL_EPSILON * 8) +
+       DBL_MIN * DBL_EPSILON * 16;
+  return di_special(p0.hi, z, t, e);
+}
+
+/*
+ * 除法: 商q0,q1的余数a-(q0+q1)*b = w0+w1-w2精确到3u(|w0|+|w1|+|w2|),
+ * 乘以1/b.hi(|b.lo|不超过u|b.hi|,倒数的舍入可能因下溢到4u)
+ * 共不超过11u(...)/|b.hi|,取16u;下溢的误差除以|b.hi|,商本身下溢另加一次.
+ */
+DF_INLINE dualdouble di_divparts(dualdouble a, dualdouble b,
+                                double *t, double *e) {
+  dualdouble d0 = dmdiv(a.hi, b.hi), m = dmul(d0.hi, b.lo);
+  dualdouble s1 = bdadd(d0.lo, a.lo), s2 = bdadd(s1.hi, -m.hi);
+  dualdouble d1 = dmdiv(s2.hi, b.hi), z = bdadd(d0.hi, d1.hi);
+  double w0 = d1.lo + s1.lo, w1 = s2.lo - m.lo, w2 = d1.hi * b.lo;
+  double rb = 1.0 / b.hi;
+  *t = ((w0 + w1) - w2) * rb;
+  *e = ((di_abs(w0) + di_abs(w1) + di_abs(w2)) * (DBL_EPSILON * 8) +
+        DBL_MIN * DBL_EPSILON * 16) *
+           di_abs(rb) +
+       DBL_MIN * DBL_EPSILON * 16;
+  return di_special(d0.hi, z, t, e);
+}
+
+/*
+ * 开平方(a.hi>0): 近似值y同dfsqrt,sqrt(a)-y = (a-y*y)/(sqrt(a)+y),
+ * 以TwoSum精确计算余数a-y*y的主要分量,其余6个小分量之和的误差不超过8u倍
+ * 其绝对值之和,因此|sqrt(a)-y| <= (|r|(1+16u)+16u*小分量+下溢)/y.hi*(1+4u).
+ */
+DF_INLINE dualdouble di_sqrtparts(dualdouble a, double *t,
+                                 double *e) {
+  double r0 = df_sqrt(a.hi), s, r;
+  dualdouble p = dmul(r0, r0), y, q, c0, c1, c2, c3;
+  y = dfnorm(ddual(r0, ((a.hi - p.hi) - p.lo + a.lo) / (r0 + r0)));
+  p = dmul(y.hi, y.hi);
+  q = dmul(y.hi, y.lo);
+  c0 = bdadd(a.hi, -p.hi);
+  c1 = bdadd(c0.hi, a.lo);
+  c2 = bdadd(p.lo, q.hi + q.hi);
+  c3 = bdadd(c1.hi, -c2.hi);
+  r = (((c3.lo + c1.lo) - c2.lo) + c0.lo) - (q.lo + q.lo + y.lo * y.lo);
+  s = di_abs(c3.lo) + di_abs(c1.lo) + di_abs(c2.lo) + di_abs(c0.lo) +
+      di_abs(q.lo + q.lo) + y.lo * y.lo;
+  r = di_abs(c3.hi + r);
+  *t = 0.0;
+  *e = (r + (r + s) * (DBL_EPSILON * 8) + DBL_MIN * DBL_EPSILON * 16) /
+       y.hi * (1.0 + DBL_EPSILON * 2);
+  return y;
+}
+
+/*
+ * 上溢的结果(hi为无穷大)的精确值的绝对值不小于此数:
+ * 主要分量舍入为无穷大时不小于(1-2^-54)2^1024,其余分量不超过其2^-51倍
+ */
+#define DI_OVERFLOW_MIN (DBL_MAX * (1.0 - DBL_EPSILON * 8))
+
+/* 由分量得到精确值的下界,上溢为inf时取DI_OVERFLOW_MIN,NaN或-inf时为-inf */
+DF_INLINE dualdouble di_lower(dualdouble z, double t, double e) {
+  dualdouble r = bdadd(z.hi, di_dn(z.lo + di_dn(t - e)));
+  if (r.hi - r.hi == 0.0)
+    return r;
+  return ddual(r.hi == INFINITY ? DI_OVERFLOW_MIN : -INFINITY, 0.0);
+}
+
+/* 由分量得到精确值的上界,上溢为-inf时取-DI_OVERFLOW_MIN,NaN或inf时为inf */
+DF_INLINE dualdouble di_upper(dualdouble z, double t, double e) {
+  dualdouble r = bdadd(z.hi, di_up(z.lo + di_up(t + e)));
+  if (r.hi - r.hi == 0.0)
+    return r;
+  return ddual(r.hi == -INFINITY ? -DI_OVERFLOW_MIN : INFINITY, 0.0);
+}
+
+/* 区间加法 */
+DF_INLINE dualinterval di2add(dualinterval a, dualinterval b) {
+  double t = 0.0, e = 0.0;
+  dualdouble z, lo;
+  z = di_addparts(a.inf, b.inf, &t, &e);
+  lo = di_lower(z, t, e);
+  z = di_addparts(a.sup, b.sup, &t, &e);
+  return dinterval(lo, di_upper(z, t, e));
+}
+
+/* 区间减法 */
+DF_INLINE dualinterval di2sub(dualinterval a, dualinterval b) {
+  return di2add(a, dineg(b));
+}
+
+/*
+ * 区间乘法: 固定a的端点x时x*y的最小值在b.inf(x>=0)或b.sup(x<0)处,
+ * 最大值反之,下界与上界各为两个乘积中的较小者与较大者.
+ */
+DF_INLINE dualinterval di2mul(dualinterval a, dualinterval b) {
+  double t = 0.0, e = 0.0;
+  bool p0 = a.inf.hi >= 0.0, p1 = a.sup.hi >= 0.0;
+  dualdouble z, l0, l1, u0, u1;
+  z = di_mulparts(a.inf, p0 ? b.inf : b.sup, &t, &e);
+  l0 = di_lower(z, t, e);
+  z = di_mulparts(a.sup, p1 ? b.inf : b.sup, &t, &e);
+  l1 = di_lower(z, t, e);
+  z = di_mulparts(a.inf, p0 ? b.sup : b.inf, &t, &e);
+  u0 = di_upper(z, t, e);
+  z = di_mulparts(a.sup, p1 ? b.sup : b.inf, &t, &e);
+  u1 = di_upper(z, t, e);
+  return dinterval(di_less(l1, l0) ? l1 : l0, di_less(u0, u1) ? u1 : u0);
+}
+
+/*
+ * 区间除法: b不含0时x/y对x单调(b>0递增,b<0递减),
+ * 固定x时对y单调(x>=0递减,x<0递增),下界与上界各只需一个商.
+ */
+DF_INLINE dualinterval di2div(dualinterval a, dualinterval b) {
+  double t = 0.0, e = 0.0;
+  bool pos = b.inf.hi > 0.0;
+  dualdouble nl = pos ? a.inf : a.sup, nu = pos ? a.sup : a.inf;
+  dualdouble z, lo, hi;
+  z = di_divparts(nl, nl.hi >= 0.0 ? b.sup : b.inf, &t, &e);
+  lo = di_lower(z, t, e);
+  z = di_divparts(nu, nu.hi >= 0.0 ? b.inf : b.sup, &t, &e);
+  hi = di_upper(z, t, e);
+  if (!(pos || b.sup.hi < 0.0)) { // 含0
+    lo = ddual(-INFINITY, 0.0);
+    hi = ddual(INFINITY, 0.0);
+  }
+  return dinterval(lo, hi);
+}
+
+/* 区间开平方,负数部分不计 */
+DF_INLINE dualinterval disqrt(dualinterval a) {
+  double t = 0.0, e = 0.0;
+  dualdouble z, lo, hi;
+  z = di_sqrtparts(a.inf, &t, &e);
+  lo = di_lower(z, t, e);
+  z = di_sqrtparts(a.sup, &t, &e);
+  hi = di_upper(z, t, e);
+  if (!(a.inf.hi > 0.0 && lo.hi > 0.0)) // 平方根不小于0
+    lo = ddual(0.0, 0.0);
+  if (!(a.sup.hi > 0.0))
+    hi = a.sup.hi == 0.0 ? ddual(0.0, 0.0) : ddual(NAN, NAN);
+  if (!(a.sup.hi >= 0.0))
+    lo = hi;
+  return dinterval(lo, hi);
+}
+
+/* SoA布局的区间数组视图,下界与上界各为一个dualdouble_soa */
+typedef struct dualinterval_soa {
+  dualdouble_soa inf;
+  dualdouble_soa sup;
+} dualinterval_soa;
+
+/* 构造SoA视图 */
+static inline dualinterval_soa disoa(dualdouble_soa inf, dualdouble_soa sup) {
+  dualinterval_soa ret;
+  ret.inf = inf;
+  ret.sup = sup;
+  return ret;
+}
+
+/* 读取SoA数组的一个元素 */
+static inline dualinterval disoaget(dualinterval_soa a, size_t i) {
+  return dinterval(dsoaget(a.inf, i), dsoaget(a.sup, i));
+}
+
+/* 写入SoA数组的一个元素 */
+static inline void disoaset(dualinterval_soa a, size_t i, dualinterval x) {
+  dsoaset(a.inf, i, x.inf);
+  dsoaset(a.sup, i, x.sup);
+}
+
+#ifdef DUAL_BATCH_AVX
+/* 4个区间 */
+typedef struct dualinterval4 {
+  dualdouble4 inf;
+  dualdouble4 sup;
+} dualinterval4;
+
+/* 构造4路区间 */
+static inline dualinterval4 dinterval4(dualdouble4 inf, dualdouble4 sup) {
+  dualinterval4 ret;
+  ret.inf = inf;
+  ret.sup = sup;
+  return ret;
+}
+
+/* 从SoA数组装载4个元素(不要求对齐) */
+static inline dualinterval4 diload4(dualinterval_soa a, size_t i) {
+  return dinterval4(dload4(a.inf, i), dload4(a.sup, i));
+}
+
+/* 向SoA数组写入4个元素(不要求对齐) */
+static inline void distore4(dualinterval_soa a, size_t i, dualinterval4 x) {
+  dstore4(a.inf, i, x.inf);
+  dstore4(a.sup, i, x.sup);
+}
+
+/* 4路di_abs */
+static inline __m256d di_abs4(__m256d x) {
+  return _mm256_andnot_pd(_mm256_set1_pd(-0.0), x);
+}
+
+/* 4路di_dn */
+static inline __m256d di_dn4(__m256d x) {
+  return _mm256_sub_pd(
+      x, _mm256_add_pd(_mm256_mul_pd(di_abs4(x), _mm256_set1_pd(DBL_EPSILON)),
+                       _mm256_set1_pd(DBL_MIN * DBL_EPSILON)));
+}
+
+/* 4路di_up */
+static inline __m256d di_up4(__m256d x) {
+  return _mm256_add_pd(
+      x, _mm256_add_pd(_mm256_mul_pd(di_abs4(x), _mm256_set1_pd(DBL_EPSILON)),
+                       _mm256_set1_pd(DBL_MIN * DBL_EPSILON)));
+}
+
+/* 4路di_less,返回掩码 */
+static inline __m256d di_less4(dualdouble4 a, dualdouble4 b) {
+  return _mm256_or_pd(_mm256_cmp_pd(a.hi, b.hi, _CMP_LT_OQ),
+                      _mm256_and_pd(_mm256_cmp_pd(a.hi, b.hi, _CMP_EQ_OQ),
+                                    _mm256_cmp_pd(a.lo, b.lo, _CMP_LT_OQ)));
+}
+
+/* 按掩码m选择: 为真的路取a,否则取b */
+static inline dualdouble4 di_select4(__m256d m, dualdouble4 a, dualdouble4 b) {
+  return ddual4(_mm256_blendv_pd(b.hi, a.hi, m),
+                _mm256_blendv_pd(b.lo, a.lo, m));
+}
+
+/* 4路区间取反,同dineg */
+static inline dualinterval4 dineg4(dualinterval4 a) {
+  const __m256d mask = _mm256_set1_pd(-0.0);
+  return dinterval4(ddual4(_mm256_xor_pd(a.sup.hi, mask),
+                           _mm256_xor_pd(a.sup.lo, mask)),
+                    ddual4(_mm256_xor_pd(a.inf.hi, mask),
+                           _mm256_xor_pd(a.inf.lo, mask)));
+}
+
+/* 4路di_special */
+static inline dualdouble4 di_special4(__m256d h, dualdouble4 z, __m256d *t,
+                                      __m256d *e) {
+  __m256d ok = _mm256_cmp_pd(_mm256_sub_pd(h, h), _mm256_setzero_pd(),
+                             _CMP_EQ_OQ);
+  *t = _mm256_and_pd(*t, ok);
+  *e = _mm256_and_pd(*e, ok);
+  return ddual4(_mm256_blendv_pd(h, z.hi, ok), _mm256_and_pd(z.lo, ok));
+}
+
+/* 4路di_addparts */
+static inline dualdouble4 di_addparts4(dualdouble4 a, dualdouble4 b,
+                                       __m256d *t, __m256d *e) {
+  dualdouble4 s = dadd4(a.hi, b.hi), u = dadd4(a.lo, b.lo);
+  dualdouble4 g = dadd4(s.lo, u.hi), z = dadd4(s.hi, g.hi);
+  *t = _mm256_add_pd(g.lo, u.lo);
+  *e = _mm256_setzero_pd();
+  return di_special4(s.hi, z, t, e);
+}
+
+/* 4路di_mulparts */
+static inline dualdouble4 di_mulparts4(dualdouble4 a, dualdouble4 b,
+                                       __m256d *t, __m256d *e) {
+  dualdouble4 p0 = dmul4(a.hi, b.hi), p1 = dmul4(a.hi, b.lo);
+  dualdouble4 p2 = dmul4(a.lo, b.hi), c = dadd4(p1.hi, p2.hi);
+  dualdouble4 u = dadd4(p0.lo, c.hi), z = dadd4(p0.hi, u.hi);
+  __m256d w0 = _mm256_add_pd(u.lo, c.lo), w1 = _mm256_add_pd(p1.lo, p2.lo);
+  __m256d w2 = _mm256_mul_pd(a.lo, b.lo);
+  *t = _mm256_add_pd(_mm256_add_pd(w0, w1), w2);
+  *e = _mm256_add_pd(
+      _mm256_mul_pd(_mm256_add_pd(_mm256_add_pd(di_abs4(w0), di_abs4(w1)),
+                                  di_abs4(w2)),
+                    _mm256_set1_pd(DBL_EPSILON * 8)),
+      _mm256_set1_pd(DBL_MIN * DBL_EPSILON * 16));
+  return di_special4(p0.hi, z, t, e);
+}
+
+/* 4路di_divparts */
+static inline dualdouble4 di_divparts4(dualdouble4 a, dualdouble4 b,
+                                       __m256d *t, __m256d *e) {
+  const __m256d tiny = _mm256_set1_pd(DBL_MIN * DBL_EPSILON * 16);
+  dualdouble4 d0 = dmdiv4(a.hi, b.hi), m = dmul4(d0.hi, b.lo);
+  dualdouble4 s1 = dadd4(d0.lo, a.lo), s2 = dsub4(s1.hi, m.hi);
+  dualdouble4 d1 = dmdiv4(s2.hi, b.hi), z = dadd4(d0.hi, d1.hi);
+  __m256d w0 = _mm256_add_pd(d1.lo, s1.lo), w1 = _mm256_sub_pd(s2.lo, m.lo);
+  __m256d w2 = _mm256_mul_pd(d1.hi, b.lo);
+  __m256d rb = _mm256_div_pd(_mm256_set1_pd(1.0), b.hi);
+  *t = _mm256_mul_pd(_mm256_sub_pd(_mm256_add_pd(w0, w1), w2), rb);
+  w0 = _mm256_add_pd(_mm256_add_pd(di_abs4(w0), di_abs4(w1)), di_abs4(w2));
+  w0 = _mm256_add_pd(_mm256_mul_pd(w0, _mm256_set1_pd(DBL_EPSILON * 8)), tiny);
+  *e = _mm256_add_pd(_mm256_mul_pd(w0, di_abs4(rb)), tiny);
+  return di_special4(d0.hi, z, t, e);
+}
+
+/* 4路di_sqrtparts */
+static inline dualdouble4 di_sqrtparts4(dualdouble4 a, __m256d *t,
+                                        __m256d *e) {
+  __m256d r0 = _mm256_sqrt_pd(a.hi), r, s;
+  dualdouble4 p = dmul4(r0, r0), y, q, c0, c1, c2, c3;
+  r = _mm256_add_pd(_mm256_sub_pd(_mm256_sub_pd(a.hi, p.hi), p.lo), a.lo);
+  y = dfnorm4(ddual4(r0, _mm256_div_pd(r, _mm256_add_pd(r0, r0))));
+  p = dmul4(y.hi, y.hi);
+  q = dmul4(y.hi, y.lo);
+  c0 = dsub4(a.hi, p.hi);
+  c1 = dadd4(c0.hi, a.lo);
+  c2 = dadd4(p.lo, _mm256_add_pd(q.hi, q.hi));
+  c3 = dsub4(c1.hi, c2.hi);
+  q.hi = _mm256_add_pd(q.lo, q.lo);
+  q.lo = _mm256_mul_pd(y.lo, y.lo);
+  r = _mm256_add_pd(_mm256_sub_pd(_mm256_add_pd(c3.lo, c1.lo), c2.lo), c0.lo);
+  r = _mm256_sub_pd(r, _mm256_add_pd(q.hi, q.lo));
+  s = _mm256_add_pd(_mm256_add_pd(di_abs4(c3.lo), di_abs4(c1.lo)),
+                    di_abs4(c2.lo));
+  s = _mm256_add_pd(_mm256_add_pd(s, di_abs4(c0.lo)), di_abs4(q.hi));
+  s = _mm256_add_pd(s, q.lo);
+  r = di_abs4(_mm256_add_pd(c3.hi, r));
+  s = _mm256_mul_pd(_mm256_add_pd(r, s), _mm256_set1_pd(DBL_EPSILON * 8));
+  s = _mm256_add_pd(_mm256_add_pd(r, s),
+                    _mm256_set1_pd(DBL_MIN * DBL_EPSILON * 16));
+  *t = _mm256_setzero_pd();
+  *e = _mm256_mul_pd(_mm256_div_pd(s, y.hi),
+                     _mm256_set1_pd(1.0 + DBL_EPSILON * 2));
+  return y;
+}
+
+/* 4路di_lower */
+static inline dualdouble4 di_lower4(dualdouble4 z, __m256d t, __m256d e) {
+  dualdouble4 r = dadd4(
+      z.hi, di_dn4(_mm256_add_pd(z.lo, di_dn4(_mm256_sub_pd(t, e)))));
+  __m256d ok = _mm256_cmp_pd(_mm256_sub_pd(r.hi, r.hi), _mm256_setzero_pd(),
+                             _CMP_EQ_OQ);
+  __m256d of = _mm256_cmp_pd(r.hi, _mm256_set1_pd(INFINITY), _CMP_EQ_OQ);
+  of = _mm256_blendv_pd(_mm256_set1_pd(-INFINITY),
+                        _mm256_set1_pd(DI_OVERFLOW_MIN), of);
+  return ddual4(_mm256_blendv_pd(of, r.hi, ok), _mm256_and_pd(r.lo, ok));
+}
+
+/* 4路di_upper */
+static inline dualdouble4 di_upper4(dualdouble4 z, __m256d t, __m256d e) {
+  dualdouble4 r = dadd4(
+      z.hi, di_up4(_mm256_add_pd(z.lo, di_up4(_mm256_add_pd(t, e)))));
+  __m256d ok = _mm256_cmp_pd(_mm256_sub_pd(r.hi, r.hi), _mm256_setzero_pd(),
+                             _CMP_EQ_OQ);
+  __m256d of = _mm256_cmp_pd(r.hi, _mm256_set1_pd(-INFINITY), _CMP_EQ_OQ);
+  of = _mm256_blendv_pd(_mm256_set1_pd(INFINITY),
+                        _mm256_set1_pd(-DI_OVERFLOW_MIN), of);
+  return ddual4(_mm256_blendv_pd(of, r.hi, ok), _mm256_and_pd(r.lo, ok));
+}
+
+/* 4路区间加法,同di2add */
+static inline dualinterval4 di2add4(dualinterval4 a, dualinterval4 b) {
+  __m256d t, e;
+  dualdouble4 z, lo;
+  z = di_addparts4(a.inf, b.inf, &t, &e);
+  lo = di_lower4(z, t, e);
+  z = di_addparts4(a.sup, b.sup, &t, &e);
+  return dinterval4(lo, di_upper4(z, t, e));
+}
+
+/* 4路区间减法,同di2sub */
+static inline dualinterval4 di2sub4(dualinterval4 a, dualinterval4 b) {
+  return di2add4(a, dineg4(b));
+}
+
+/* 4路区间乘法,同di2mul */
+static inline dualinterval4 di2mul4(dualinterval4 a, dualinterval4 b) {
+  const __m256d zero = _mm256_setzero_pd();
+  __m256d p0 = _mm256_cmp_pd(a.inf.hi, zero, _CMP_GE_OQ);
+  __m256d p1 = _mm256_cmp_pd(a.sup.hi, zero, _CMP_GE_OQ), t, e;
+  dualdouble4 z, l0, l1, u0, u1;
+  z = di_mulparts4(a.inf, di_select4(p0, b.inf, b.sup), &t, &e);
+  l0 = di_lower4(z, t, e);
+  z = di_mulparts4(a.sup, di_select4(p1, b.inf, b.sup), &t, &e);
+  l1 = di_lower4(z, t, e);
+  z = di_mulparts4(a.inf, di_select4(p0, b.sup, b.inf), &t, &e);
+  u0 = di_upper4(z, t, e);
+  z = di_mulparts4(a.sup, di_select4(p1, b.sup, b.inf), &t, &e);
+  u1 = di_upper4(z, t, e);
+  return dinterval4(di_select4(di_less4(l1, l0), l1, l0),
+                    di_select4(di_less4(u0, u1), u1, u0));
+}
+
+/* 4路区间除法,同di2div */
+static inline dualinterval4 di2div4(dualinterval4 a, dualinterval4 b) {
+  const __m256d zero = _mm256_setzero_pd();
+  __m256d pos = _mm256_cmp_pd(b.inf.hi, zero, _CMP_GT_OQ), ok, t, e;
+  dualdouble4 nl = di_select4(pos, a.inf, a.sup);
+  dualdouble4 nu = di_select4(pos, a.sup, a.inf), z, lo, hi;
+  ok = _mm256_cmp_pd(nl.hi, zero, _CMP_GE_OQ);
+  z = di_divparts4(nl, di_select4(ok, b.sup, b.inf), &t, &e);
+  lo = di_lower4(z, t, e);
+  ok = _mm256_cmp_pd(nu.hi, zero, _CMP_GE_OQ);
+  z = di_divparts4(nu, di_select4(ok, b.inf, b.sup), &t, &e);
+  hi = di_upper4(z, t, e);
+  ok = _mm256_or_pd(pos, _mm256_cmp_pd(b.sup.hi, zero, _CMP_LT_OQ));
+  lo.hi = _mm256_blendv_pd(_mm256_set1_pd(-INFINITY), lo.hi, ok);
+  hi.hi = _mm256_blendv_pd(_mm256_set1_pd(INFINITY), hi.hi, ok);
+  lo.lo = _mm256_and_pd(lo.lo, ok);
+  hi.lo = _mm256_and_pd(hi.lo, ok);
+  return dinterval4(lo, hi);
+}
+
+/* 4路区间开平方,同disqrt */
+static inline dualinterval4 disqrt4(dualinterval4 a) {
+  const __m256d zero = _mm256_setzero_pd();
+  const dualdouble4 dz = ddual4(zero, zero);
+  __m256d ok, t, e;
+  dualdouble4 z, lo, hi;
+  z = di_sqrtparts4(a.inf, &t, &e);
+  lo = di_lower4(z, t, e);
+  z = di_sqrtparts4(a.sup, &t, &e);
+  hi = di_upper4(z, t, e);
+  ok = _mm256_and_pd(_mm256_cmp_pd(a.inf.hi, zero, _CMP_GT_OQ),
+                     _mm256_cmp_pd(lo.hi, zero, _CMP_GT_OQ));
+  lo = di_select4(ok, lo, dz);
+  z = di_select4(_mm256_cmp_pd(a.sup.hi, zero, _CMP_EQ_OQ), dz,
+                 ddual4(_mm256_set1_pd(NAN), _mm256_set1_pd(NAN)));
+  hi = di_select4(_mm256_cmp_pd(a.sup.hi, zero, _CMP_GT_OQ), hi, z);
+  lo = di_select4(_mm256_cmp_pd(a.sup.hi, zero, _CMP_GE_OQ), lo, hi);
+  return dinterval4(lo, hi);
+}
+#endif
+
+/* 批量区间加法: r[i]=a[i]+b[i] */
+static inline void vdi2add(dualinterval_soa r, dualinterval_soa a,
+                           dualinterval_soa b, size_t n) {
+  size_t i = 0;
+#ifdef DUAL_BATCH_AVX
+  for (; i + 4 <= n; i += 4)
+    distore4(r, i, di2add4(diload4(a, i), diload4(b, i)));
+#endif
+  for (; i < n; i++)
+    disoaset(r, i, di2add(disoaget(a, i), disoaget(b, i)));
+}
+
+/* 批量区间减法: r[i]=a[i]-b[i] */
+static inline void vdi2sub(dualinterval_soa r, dualinterval_soa a,
+                           dualinterval_soa b, size_t n) {
+  size_t i = 0;
+#ifdef DUAL_BATCH_AVX
+  for (; i + 4 <= n; i += 4)
+    distore4(r, i, di2sub4(diload4(a, i), diload4(b, i)));
+#endif
+  for (; i < n; i++)
+    disoaset(r, i, di2sub(disoaget(a, i), disoaget(b, i)));
+}
+
+/* 批量区间乘法: r[i]=a[i]*b[i] */
+static inline void vdi2mul(dualinterval_soa r, dualinterval_soa a,
+                           dualinterval_soa b, size_t n) {
+  size_t i = 0;
+#ifdef DUAL_BATCH_AVX
+  for (; i + 4 <= n; i += 4)
+    distore4(r, i, di2mul4(diload4(a, i), diload4(b, i)));
+#endif
+  for (; i < n; i++)
+    disoaset(r, i, di2mul(disoaget(a, i), disoaget(b, i)));
+}
+
+/* 批量区间除法: r[i]=a[i]/b[i] */
+static inline void vdi2div(dualinterval_soa r, dualinterval_soa a,
+                           dualinterval_soa b, size_t n) {
+  size_t i = 0;
+#ifdef DUAL_BATCH_AVX
+  for (; i + 4 <= n; i += 4)
+    distore4(r, i, di2div4(diload4(a, i), diload4(b, i)));
+#endif
+  for (; i < n; i++)
+    disoaset(r, i, di2div(disoaget(a, i), disoaget(b, i)));
+}
+
+/* 批量区间开平方: r[i]=sqrt(a[i]) */
+static inline void vdisqrt(dualinterval_soa r, dualinterval_soa a, size_t n) {
+  size_t i = 0;
+#ifdef DUAL_BATCH_AVX
+  for (; i + 4 <= n; i += 4)
+    distore4(r, i, disqrt4(diload4(a, i)));
+#endif
+  for (; i < n; i++)
+    disoaset(r, i, disqrt(disoaget(a, i)));
+}
+
+#if defined(__cplusplus) || defined(c_plusplus)
+#include "dualinterval_cxx.h"
+#endif
+
+#endif
@@ -0,0 +1,146 @@
+﻿#ifndef _DUAL_INTERVAL_H_
+#error "it must include by <dualinterval.h>"
+#else
+#ifndef _DUAL_INTERVAL_CXX_
+#define _DUAL_INTERVAL_CXX_
+
+/**
+ * dualinterval的运算符,double与dualdouble运算数视为只含一点的区间
+ */
+
+/* add */
+inline dualinterval operator+(dualinterval a, double b) {
+  return di2add(a, dipoint(ddual(b, 0.0)));
+}
+
+inline dualinterval operator+(double a, dualinterval b) {
+  return di2add(dipoint(ddual(a, 0.0)), b);
+}
+
+inline dualinterval operator+(dualinterval a, dualdouble b) {
+  return di2add(a, dipoint(b));
+}
+
+inline dualinterval operator+(dualdouble a, dualinterval b) {
+  return di2add(dipoint(a), b);
+}
+
+inline dualinterval operator+(dualinterval a, dualinterval b) {
+  return di2add(a, b);
+}
+
+inline dualinterval &operator+=(dualinterval &a, double b) {
+  return a = a + b;
+}
+
+inline dualinterval &operator+=(dualinterval &a, dualdouble b) {
+  return a = a + b;
+}
+
+inline dualinterval &operator+=(dualinterval &a, dualinterval b) {
+  return a = di2add(a, b);
+}
+
+/* sub */
+inline dualinterval operator-(dualinterval a, double b) {
+  return di2sub(a, dipoint(ddual(b, 0.0)));
+}
+
+inline dualinterval operator-(double a, dualinterval b) {
+  return di2sub(dipoint(ddual(a, 0.0)), b);
+}
+
+inline dualinterval operator-(dualinterval a, dualdouble b) {
+  return di2sub(a, dipoint(b));
+}
+
+inline dualinterval operator-(dualdouble a, dualinterval b) {
+  return di2sub(dipoint(a), b);
+}
+
+inline dualinterval operator-(dualinterval a, dualinterval b) {
+  return di2sub(a, b);
+}
+
+inline dualinterval operator-(dualinterval a) { return dineg(a); }
+
+inline dualinterval &operator-=(dualinterval &a, double b) {
+  return a = a - b;
+}
+
+inline dualinterval &operator-=(dualinterval &a, dualdouble b) {
+  return a = a - b;
+}
+
+inline dualinterval &operator-=(dualinterval &a, dualinterval b) {
+  return a = di2sub(a, b);
+}
+
+/* mul */
+inline dualinterval operator*(dualinterval a, double b) {
+  return di2mul(a, dipoint(ddual(b, 0.0)));
+}
+
+inline dualinterval operator*(double a, dualinterval b) {
+  return di2mul(dipoint(ddual(a, 0.0)), b);
+}
+
+inline dualinterval operator*(dualinterval a, dualdouble b) {
+  return di2mul(a, dipoint(b));
+}
+
+inline dualinterval operator*(dualdouble a, dualinterval b) {
+  return di2mul(dipoint(a), b);
+}
+
+inline dualinterval operator*(dualinterval a, dualinterval b) {
+  return di2mul(a, b);
+}
+
+inline dualinterval &operator*=(dualinterval &a, double b) {
+  return a = a * b;
+}
+
+inline dualinterval &operator*=(dualinterval &a, dualdouble b) {
+  return a = a * b;
+}
+
+inline dualinterval &operator*=(dualinterval &a, dualinterval b) {
+  return a = di2mul(a, b);
+}
+
+/* div */
+inline dualinterval operator/(dualinterval a, double b) {
+  return di2div(a, dipoint(ddual(b, 0.0)));
+}
+
+inline dualinterval operator/(double a, dualinterval b) {
+  return di2div(dipoint(ddual(a, 0.0)), b);
+}
+
+inline dualinterval operator/(dualinterval a, dualdouble b) {
+  return di2div(a, dipoint(b));
+}
+
+inline dualinterval operator/(dualdouble a, dualinterval b) {
+  return di2div(dipoint(a), b);
+}
+
+inline dualinterval operator/(dualinterval a, dualinterval b) {
+  return di2div(a, b);
+}
+
+inline dualinterval &operator/=(dualinterval &a, double b) {
+  return a = a / b;
+}
+
+inline dualinterval &operator/=(dualinterval &a, dualdouble b) {
+  return a = a / b;
+}
+
+inline dualinterval &operator/=(dualinterval &a, dualinterval b) {
+  return a = di2div(a, b);
+}
+
+#endif
+#endif // !_DUAL_INTERVAL_H_
@@ -0,0 +1,313 @@
+﻿#ifndef _DUAL_STREAM_H_
+#define _DUAL_STREAM_H_
+#include "dualsys.h"
+#include "dualarray.h"
+
+/**
+ * 超过内存的dualarray文件的流式归约
+ * 一个读取线程按块顺序预读到若干轮转的缓冲区,若干计算线程同时归约已读入的块,
+ * 读取与计算相互重叠,吞吐量取决于磁盘带宽与计算速度中较慢的一方.
+ * 每块的部分结果最後按块顺序合并(内置归约以df2add合并),因此结果与线程数无关.
+ */
+
+#define DUALSTREAM_MAXIN 4
+
+/* 块归约函数: in[0..nin-1]为各输入文件第chunk块的n个元素,结果写入part */
+typedef void (*dualstream_reduce_fn)(void *ctx, const dualdouble_soa *in,
+                                     size_t n, uint64_t chunk, void *part);
+
+/* 合并函数: 在调用线程中按块顺序依次调用 */
+typedef void (*dualstream_merge_fn)(void *ctx, const void *part);
+
+/* 流式归约选项,字段为0则取默认值 */
+typedef struct dualstream_opts {
+  size_t chunk; // 每块元素个数,默认1<<20
+  int nthreads; // 计算线程数,默认为处理器个数
+  int nbuffers; // 缓冲块个数,默认为nthreads+2
+} dualstream_opts;
+
+/* 缓冲块 */
+typedef struct dualstream_slot {
+  double *buf;    // 各输入的高位与低位,共2*nin*chunk个double
+  uint64_t chunk; // 块号
+  size_t n;       // 元素个数
+  int state;      // 0空闲,1读取中,2已读入,3计算中
+} dualstream_slot;
+
+/* 流式归约的共享状态 */
+typedef struct dualstream {
+  dual_mutex mu;
+  dual_cond cv;
+  dualstream_slot *slots;
+  int nslots;
+  int nin;
+  dual_file fin[DUALSTREAM_MAXIN];
+  uint64_t hi_offset[DUALSTREAM_MAXIN];
+  uint64_t lo_offset[DUALSTREAM_MAXIN];
+  uint64_t count;
+  uint64_t nchunks;
+  size_t chunk;
+  int done;  // 读取线程已结束
+  int error; // 读取失败
+  char *parts;
+  size_t part_size;
+  dualstream_reduce_fn reduce;
+  void *ctx;
+} dualstream;
+
+/* 读取线程: 依次将每块读入空闲的缓冲块 */
+static inline void dualstream_reader(void *arg) {
+  dualstream *s = (dualstream *)arg;
+  uint64_t c;
+  int i, k;
+  for (c = 0; c < s->nchunks; c++) {
+    dualstream_slot *slot = NULL;
+    uint64_t first = c * s->chunk, off;
+    size_t n = (size_t)(s->count - first < s->chunk ? s->count - first
+                                                    : s->chunk);
+    int ok = 1;
+    dual_mutex_lock(&s->mu);
+    while (!slot && !s->error) {
+      for (i = 0; i < s->nslots && !slot; i++)
+        if (s->slots[i].state == 0)
+          slot = &s->slots[i];
+      if (!slot)
+        dual_cond_wait(&s->cv, &s->mu);
+    }
+    if (slot)
+      slot->state = 1;
+    dual_mutex_unlock(&s->mu);
+    if (!slot)
+      break;
+    for (k = 0; k < s->nin && ok; k++) {
+      double *hi = slot->buf + (size_t)k * 2 * s->chunk, *lo = hi + s->chunk;
+      off = first * sizeof(double);
+      ok = dual_file_pread(s->fin[k], hi, n * sizeof(double),
+                           s->hi_offset[k] + off) == 0 &&
+           dual_file_pread(s->fin[k], lo, n * sizeof(double),
+                           s->lo_offset[k] + off) == 0;
+    }
+    dual_mutex_lock(&s->mu);
+    slot->chunk = c;
+    slot->n = n;
+    slot->state = ok ? 2 : 0;
+    if (!ok)
+      s->error = 1;
+    dual_cond_broadcast(&s->cv);
+    dual_mutex_unlock(&s->mu);
+    if (!ok)
+      break;
+  }
+  dual_mutex_lock(&s->mu);
+  s->done = 1;
+  dual_cond_broadcast(&s->cv);
+  dual_mutex_unlock(&s->mu);
+}
+
+/* 计算线程: 归约已读入的块,完成後释放缓冲块 */
+static inline void dualstream_worker(void *arg) {
+  dualstream *s = (dualstream *)arg;
+  dualdouble_soa in[DUALSTREAM_MAXIN];
+  int i, k;
+  for (;;) {
+    dualstream_slot *slot = NULL;
+    dual_mutex_lock(&s->mu);
+    for (;;) {
+      for (i = 0; i < s->nslots && !slot; i++)
+        if (s->slots[i].state == 2)
+          slot = &s->slots[i];
+      if (slot || s->error || s->done)
+        break;
+      dual_cond_wait(&s->cv, &s->mu);
+    }
+    if (slot && !s->error)
+      slot->state = 3;
+    else
+      slot = NULL;
+    dual_mutex_unlock(&s->mu);
+    if (!slot)
+      return;
+    for (k = 0; k < s->nin; k++) {
+      double *hi = slot->buf + (size_t)k * 2 * s->chunk;
+      in[k] = dsoa(hi, hi + s->chunk);
+    }
+    s->reduce(s->ctx, in, slot->n, slot->chunk,
+              s->parts + slot->chunk * s->part_size);
+    dual_mutex_lock(&s->mu);
+    slot->state = 0;
+    dual_cond_broadcast(&s->cv);
+    dual_mutex_unlock(&s->mu);
+  }
+}
+
+/* 打开dualarray文件并读取文件头 */
+static inline int dualstream_open(dualstream *s, int k, const char *path) {
+  dualarray_header h;
+  uint64_t size;
+  int ret;
+  s->fin[k] = dual_file_open(path);
+  if (s->fin[k] == DUAL_FILE_INVALID)
+    return DUALARR_EIO;
+  if (dual_file_size(s->fin[k], &size) != 0)
+    return DUALARR_EIO;
+  if (size < sizeof(h))
+    return DUALARR_EFORMAT;
+  if (dual_file_pread(s->fin[k], &h, sizeof(h), 0) != 0)
+    return DUALARR_EIO;
+  ret = dualarray_check(&h, size);
+  if (ret != DUALARR_OK)
+    return ret;
+  if (k && h.count != s->count)
+    return DUALARR_EARG;
+  s->count = h.count;
+  s->hi_offset[k] = h.hi_offset;
+  s->lo_offset[k] = h.lo_offset;
+  return DUALARR_OK;
+}
+
+/**
+ * 对npaths个等长的dualarray文件进行流式归约.
+ * 每块调用reduce得到part_size字节的部分结果,全部读完後按块顺序调用merge.
+ */
+static inline int dualstream_run(const char *const *paths, int npaths,
+                                 const dualstream_opts *opts,
+                                 dualstream_reduce_fn reduce,
+                                 dualstream_merge_fn merge, size_t part_size,
+                                 void *ctx) {
+  dualstream s;
+  dual_thread reader, *workers = NULL;
+  int i, nthreads, nstarted = 0, ret = DUALARR_OK;
+#ifdef __BIG_ENDIAN__
+  return DUALARR_EENDIAN;
+#endif
+  if (!paths || npaths < 1 || npaths > DUALSTREAM_MAXIN || !reduce || !merge)
+    return DUALARR_EARG;
+  memset(&s, 0, sizeof(s));
+  s.nin = npaths;
+  s.chunk = opts && opts->chunk ? opts->chunk : (size_t)1 << 20;
+  nthreads = opts && opts->nthreads > 0 ? opts->nthreads : dual_ncpu();
+  s.nslots = opts && opts->nbuffers > 0 ? opts->nbuffers : nthreads + 2;
+  s.part_size = part_size;
+  s.reduce = reduce;
+  s.ctx = ctx;
+  for (i = 0; i < npaths; i++)
+    s.fin[i] = DUAL_FILE_INVALID;
+  for (i = 0; i < npaths && ret == DUALARR_OK; i++)
+    ret = dualstream_open(&s, i, paths[i]);
+  if (ret != DUALARR_OK)
+    goto close_files;
+  s.nchunks = dualarray_nchunks(s.count, s.chunk);
+  s.slots = (dualstream_slot *)calloc((size_t)s.nslots, sizeof(*s.slots));
+  s.parts = (char *)calloc(s.nchunks ? (size_t)s.nchunks : 1, part_size);
+  workers = (dual_thread *)calloc((size_t)nthreads, sizeof(*workers));
+  if (!s.slots || !s.parts || !workers) {
+    ret = DUALARR_EIO;
+    goto free_mem;
+  }
+  for (i = 0; i < s.nslots; i++) {
+    s.slots[i].buf = (double *)dual_aligned_alloc(
+        (size_t)npaths * 2 * s.chunk * sizeof(double), DUALARR_ALIGN);
+    if (!s.slots[i].buf) {
+      ret = DUALARR_EIO;
+      goto free_mem;
+    }
+  }
+  dual_mutex_init(&s.mu);
+  dual_cond_init(&s.cv);
+  if (dual_thread_create(&reader, dualstream_reader, &s) != 0) {
+    ret = DUALARR_EIO;
+  } else {
+    for (nstarted = 0; nstarted < nthreads; nstarted++)
+      if (dual_thread_create(&workers[nstarted], dualstream_worker, &s) != 0)
+        break;
+    if (!nstarted) { // 无计算线程则在当前线程计算
+      dualstream_worker(&s);
+    } else {
+      for (i = 0; i < nstarted; i++)
+        dual_thread_join(workers[i]);
+    }
+    dual_thread_join(reader);
+    if (s.error)
+      ret = DUALARR_EIO;
+  }
+  dual_cond_destroy(&s.cv);
+  dual_mutex_destroy(&s.mu);
+  if (ret == DUALARR_OK)
+    for (uint64_t c = 0; c < s.nchunks; c++)
+      merge(ctx, s.parts + c * part_size);
+free_mem:
+  if (s.slots)
+    for (i = 0; i < s.nslots; i++)
+      dual_aligned_free(s.slots[i].buf);
+  free(s.slots);
+  free(s.parts);
+  free(workers);
+close_files:
+  for (i = 0; i < npaths; i++)
+    if (s.fin[i] != DUAL_FILE_INVALID)
+      dual_file_close(s.fin[i]);
+  return ret;
+}
+
+static inline void dualstream_stats_reduce(void *ctx, const dualdouble_soa *in,
+                                           size_t n, uint64_t chunk,
+                                           void *part) {
+  (void)ctx;
+  (void)chunk;
+  dfstats_init((dualdouble_stats *)part);
+  vdfstats((dualdouble_stats *)part, in[0], n);
+}
+
+static inline void dualstream_stats_merge(void *ctx, const void *part) {
+  dfstats_merge((dualdouble_stats *)ctx, (const dualdouble_stats *)part);
+}
+
+/* 流式统计一个dualarray文件的个数,和,离差平方和,最小值与最大值 */
+static inline int dualstream_stats(const char *path,
+                                   const dualstream_opts *opts,
+                                   dualdouble_stats *out) {
+  dfstats_init(out);
+  return dualstream_run(&path, 1, opts, dualstream_stats_reduce,
+                        dualstream_stats_merge, sizeof(dualdouble_stats), out);
+}
+
+static inline void dualstream_sum_reduce(void *ctx, const dualdouble_soa *in,
+                                         size_t n, uint64_t chunk,
+                                         void *part) {
+  (void)ctx;
+  (void)chunk;
+  *(dualdouble *)part = vdf2sum(in[0], n);
+}
+
+static inline void dualstream_dot_reduce(void *ctx, const dualdouble_soa *in,
+                                         size_t n, uint64_t chunk,
+                                         void *part) {
+  (void)ctx;
+  (void)chunk;
+  *(dualdouble *)part = vdf2dot(in[0], in[1], n);
+}
+
+static inline void dualstream_sum_merge(void *ctx, const void *part) {
+  *(dualdouble *)ctx = df2add(*(dualdouble *)ctx, *(const dualdouble *)part);
+}
+
+/* 流式求一个dualarray文件的和 */
+static inline int dualstream_sum(const char *path, const dualstream_opts *opts,
+                                 dualdouble *out) {
+  *out = ddual(0.0, 0.0);
+  return dualstream_run(&path, 1, opts, dualstream_sum_reduce,
+                        dualstream_sum_merge, sizeof(dualdouble), out);
+}
+
+/* 流式求两个等长dualarray文件的点积 */
+static inline int dualstream_dot(const char *xpath, const char *ypath,
+                                 const dualstream_opts *opts, dualdouble *out) {
+  const char *paths[2];
+  paths[0] = xpath;
+  paths[1] = ypath;
+  *out = ddual(0.0, 0.0);
+  return dualstream_run(paths, 2, opts, dualstream_dot_reduce,
+                        dualstream_sum_merge, sizeof(dualdouble), out);
+}
+
+#endif
@@ -0,0 +1,308 @@
+﻿#ifndef _DUAL_SYS_H_
+#define _DUAL_SYS_H_
+/*
+ * 严格的ISO C模式(如-std=c11)不声明POSIX的clock_gettime,gethostname与madvise,
+ * 需在第一个系统头文件之前打开,因此使用本头文件的头文件应最先包含它
+ */
+#if !defined(_WIN32) && defined(__STRICT_ANSI__)
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200809L
+#endif
+#ifndef _DEFAULT_SOURCE
+#define _DEFAULT_SOURCE
+#endif
+#endif
+#include <stdint.h>
+#include <stdlib.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+/**
+ * 与系统相关的线程,同步与文件读取接口(Windows与POSIX)
+ * 仅供批量读取与并行计算的头文件使用,函数成功返回0,失败返回-1.
+ */
+
+typedef void (*dual_thread_fn)(void *);
+
+#ifdef _WIN32
+typedef HANDLE dual_thread;
+typedef CRITICAL_SECTION dual_mutex;
+typedef CONDITION_VARIABLE dual_cond;
+typedef HANDLE dual_file;
+#define DUAL_FILE_INVALID INVALID_HANDLE_VALUE
+#else
+typedef pthread_t dual_thread;
+typedef pthread_mutex_t dual_mutex;
+typedef pthread_cond_t dual_cond;
+typedef int dual_file;
+#define DUAL_FILE_INVALID (-1)
+#endif
+
+/* 线程入口与参数 */
+typedef struct dual_thread_start {
+  dual_thread_fn fn;
+  void *arg;
+} dual_thread_start;
+
+#ifdef _WIN32
+static inline DWORD WINAPI dual_thread_entry(LPVOID p) {
+#else
+static inline void *dual_thread_entry(void *p) {
+#endif
+  dual_thread_start s = *(dual_thread_start *)p;
+  free(p);
+  s.fn(s.arg);
+  return 0;
+}
+
+/* 创建线程 */
+static inline int dual_thread_create(dual_thread *t, dual_thread_fn fn,
+                                     void *arg) {
+  dual_thread_start *s = (dual_thread_start *)malloc(sizeof(*s));
+  if (!s)
+    return -1;
+  s->fn = fn;
+  s->arg = arg;
+#ifdef _WIN32
+  *t = CreateThread(NULL, 0, dual_thread_entry, s, 0, NULL);
+  if (*t)
+    return 0;
+#else
+  if (pthread_create(t, NULL, dual_thread_entry, s) == 0)
+    return 0;
+#endif
+  free(s);
+  return -1;
+}
+
+/* 等待线程结束 */
+static inline void dual_thread_join(dual_thread t) {
+#ifdef _WIN32
+  WaitForSingleObject(t, INFINITE);
+  CloseHandle(t);
+#else
+  pthread_join(t, NULL);
+#endif
+}
+
+/* 处理器个数 */
+static inline int dual_ncpu(void) {
+#ifdef _WIN32
+  SYSTEM_INFO si;
+  GetSystemInfo(&si);
+  return (int)si.dwNumberOfProcessors;
+#else
+  long n = sysconf(_SC_NPROCESSORS_ONLN);
+  return n > 0 ? (int)n : 1;
+#endif
+}
+
+/* 单调时钟,单位纳秒 */
+static inline uint64_t dual_time_ns(void) {
+#ifdef _WIN32
+  LARGE_INTEGER f, c;
+  QueryPerformanceFrequency(&f);
+  QueryPerformanceCounter(&c);
+  return (uint64_t)((double)c.QuadPart * 1e9 / (double)f.QuadPart);
+#else
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+/* 主机名(最多size-1字节) */
+static inline int dual_hostname(char *buf, size_t size) {
+#ifdef _WIN32
+  DWORD n = (DWORD)size;
+  if (!size || !GetComputerNameA(buf, &n))
+    return -1;
+#else
+  if (!size || gethostname(buf, size) != 0)
+    return -1;
+  buf[size - 1] = 0;
+#endif
+  return 0;
+}
+
+static inline void dual_mutex_init(dual_mutex *m) {
+#ifdef _WIN32
+  InitializeCriticalSection(m);
+#else
+  pthread_mutex_init(m, NULL);
+#endif
+}
+
+static inline void dual_mutex_destroy(dual_mutex *m) {
+#ifdef _WIN32
+  DeleteCriticalSection(m);
+#else
+  pthread_mutex_destroy(m);
+#endif
+}
+
+static inline void dual_mutex_lock(dual_mutex *m) {
+#ifdef _WIN32
+  EnterCriticalSection(m);
+#else
+  pthread_mutex_lock(m);
+#endif
+}
+
+static inline void dual_mutex_unlock(dual_mutex *m) {
+#ifdef _WIN32
+  LeaveCriticalSection(m);
+#else
+  pthread_mutex_unlock(m);
+#endif
+}
+
+static inline void dual_cond_init(dual_cond *c) {
+#ifdef _WIN32
+  InitializeConditionVariable(c);
+#else
+  pthread_cond_init(c, NULL);
+#endif
+}
+
+static inline void dual_cond_destroy(dual_cond *c) {
+#ifdef _WIN32
+  (void)c;
+#else
+  pthread_cond_destroy(c);
+#endif
+}
+
+static inline void dual_cond_wait(dual_cond *c, dual_mutex *m) {
+#ifdef _WIN32
+  SleepConditionVariableCS(c, m, INFINITE);
+#else
+  pthread_cond_wait(c, m);
+#endif
+}
+
+static inline void dual_cond_broadcast(dual_cond *c) {
+#ifdef _WIN32
+  WakeAllConditionVariable(c);
+#else
+  pthread_cond_broadcast(c);
+#endif
+}
+
+/* 以只读方式打开文件 */
+static inline dual_file dual_file_open(const char *path) {
+#ifdef _WIN32
+  return CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+                     FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+#else
+  return open(path, O_RDONLY);
+#endif
+}
+
+static inline void dual_file_close(dual_file f) {
+#ifdef _WIN32
+  CloseHandle(f);
+#else
+  close(f);
+#endif
+}
+
+/* 文件字节数 */
+static inline int dual_file_size(dual_file f, uint64_t *size) {
+#ifdef _WIN32
+  LARGE_INTEGER li;
+  if (!GetFileSizeEx(f, &li))
+    return -1;
+  *size = (uint64_t)li.QuadPart;
+#else
+  struct stat st;
+  if (fstat(f, &st) != 0)
+    return -1;
+  *size = (uint64_t)st.st_size;
+#endif
+  return 0;
+}
+
+/* 从偏移off读取len字节,可被多个线程同时调用 */
+static inline int dual_file_pread(dual_file f, void *buf, size_t len,
+                                  uint64_t off) {
+  char *p = (char *)buf;
+  while (len) {
+#ifdef _WIN32
+    OVERLAPPED ov = {0};
+    DWORD got, want = len > 0x40000000 ? 0x40000000 : (DWORD)len;
+    ov.Offset = (DWORD)off;
+    ov.OffsetHigh = (DWORD)(off >> 32);
+    if (!ReadFile(f, p, want, &got, &ov) || got == 0)
+      return -1;
+#else
+    ssize_t got = pread(f, p, len, (off_t)off);
+    if (got < 0 && errno == EINTR) // 被信号中断则重试
+      continue;
+    if (got <= 0)
+      return -1;
+#endif
+    p += got;
+    len -= (size_t)got;
+    off += (uint64_t)got;
+  }
+  return 0;
+}
+
+/* 以只读方式映射整个文件,失败返回NULL */
+static inline void *dual_file_map(dual_file f, uint64_t size) {
+  void *p;
+  if (!size || size > (size_t)-1)
+    return NULL;
+#ifdef _WIN32
+  HANDLE h = CreateFileMappingA(f, NULL, PAGE_READONLY, 0, 0, NULL);
+  if (!h)
+    return NULL;
+  p = MapViewOfFile(h, FILE_MAP_READ, 0, 0, (SIZE_T)size);
+  CloseHandle(h); // 视图保持映射对象有效
+#else
+  p = mmap(NULL, (size_t)size, PROT_READ, MAP_SHARED, f, 0);
+  if (p == MAP_FAILED)
+    return NULL;
+  madvise(p, (size_t)size, MADV_SEQUENTIAL);
+#endif
+  return p;
+}
+
+static inline void dual_file_unmap(void *p, uint64_t size) {
+#ifdef _WIN32
+  (void)size;
+  UnmapViewOfFile(p);
+#else
+  munmap(p, (size_t)size);
+#endif
+}
+
+/* 分配按align字节对齐的内存 */
+static inline void *dual_aligned_alloc(size_t size, size_t align) {
+#ifdef _WIN32
+  return _aligned_malloc(size, align);
+#else
+  void *p;
+  return posix_memalign(&p, align, size) == 0 ? p : NULL;
+#endif
+}
+
+static inline void dual_aligned_free(void *p) {
+#ifdef _WIN32
+  _aligned_free(p);
+#else
+  free(p);
+#endif
+}
+
+#endif
@@ -0,0 +1,42 @@
+﻿/**
+ * 批量运算的离线调优工具(C与C++均可编译)
+ * 以dualtune_run在本机计时各调优参数的候选值并输出其耗时(*为选中者),
+ * 结果写入缓存文件,之後本机的程序以dualtune_load或dualtune_init读取.
+ * 缓存记录编译配置(AVX与FMA),须与使用缓存的程序以相同的配置编译.
+ *
+ * 用法: dualtune [-o 缓存文件]
+ * 默认为环境变量DUALTUNE_CACHE,也未设置则为dualtune.<主机名>.txt
+ */
+
+#include "dualtune.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+int main(int argc, char **argv) {
+  char host[128], def[160];
+  const char *path = getenv("DUALTUNE_CACHE");
+  dualtune t;
+  if (argc == 3 && !strcmp(argv[1], "-o"))
+    path = argv[2];
+  else if (argc != 1) {
+    fprintf(stderr, "usage: %s [-o file]\n", argv[0]);
+    return 2;
+  }
+  if (!path) {
+    if (dual_hostname(host, sizeof(host)) != 0)
+      snprintf(host, sizeof(host), "unknown");
+    snprintf(def, sizeof(def), "dualtune.%s.txt", host);
+    path = def;
+  }
+  if (dualtune_run(&t, stdout) != 0) {
+    fprintf(stderr, "out of memory\n");
+    return 1;
+  }
+  if (dualtune_save(&t, path) != 0) {
+    perror(path);
+    return 1;
+  }
+  printf("saved to %s\n", path);
+  return 0;
+}
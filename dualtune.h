@@ -0,0 +1,314 @@
+﻿#ifndef _DUAL_TUNE_H_
+#define _DUAL_TUNE_H_
+#include "dualsys.h"
+#include "dualbatch.h"
+#include <stdio.h>
+#include <string.h>
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#elif defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <cpuid.h>
+#endif
+
+/**
+ * 批量运算的自动调优
+ * 最快的实现与处理器有关(如归约的累加器组数),dualtune_run在本机计时各候选值
+ * 选出最快者,dualtune_save将其连同主机名,处理器型号与编译配置写入缓存文件,
+ * 之後的进程以dualtune_load读取,主机,处理器或编译配置不符时失败(须重新调优).
+ * dualtune_init合并以上步骤: 首次使用时调优并写入缓存,以後直接读取.
+ * 累加器组数改变归约的累加次序,因此不同主机上归约的结果可能略有不同.
+ * 编译期的选择(USE_BRANCH_DADD,FP_FMA_INTRINS等)影响每个内联函数,
+ * 不能在运行时切换,以nmake bench比较各配置.
+ */
+
+#define DUALTUNE_VERSION 1
+
+/* 调优参数X(名称,说明),取值均为归约的SIMD累加器组数1,2,4或8 */
+#define DUALTUNE_LIST(X)                                                       \
+  X(sum_acc, "vdf2sum")                                                        \
+  X(dot_acc, "vdf2dot")                                                        \
+  X(sumf_acc, "vdf2sumf")                                                      \
+  X(dotf_acc, "vdf2dotf")
+
+#define DUALTUNE_ONE(name, desc) +1
+#define DUALTUNE_COUNT (0 DUALTUNE_LIST(DUALTUNE_ONE)) // 参数个数
+
+/* 调优结果 */
+typedef struct dualtune {
+#define DUALTUNE_FIELD(name, desc) int name;
+  DUALTUNE_LIST(DUALTUNE_FIELD)
+#undef DUALTUNE_FIELD
+} dualtune;
+
+/* 默认值(与vdf2sum等相同) */
+static inline void dualtune_default(dualtune *t) {
+#define DUALTUNE_FIELD(name, desc) t->name = 2;
+  DUALTUNE_LIST(DUALTUNE_FIELD)
+#undef DUALTUNE_FIELD
+}
+
+/* 以调优结果批量求和 */
+static inline dualdouble dualtune_vdf2sum(const dualtune *t, dualdouble_soa a,
+                                          size_t n) {
+  return vdf2sum_acc(a, n, t->sum_acc);
+}
+
+/* 以调优结果批量求点积 */
+static inline dualdouble dualtune_vdf2dot(const dualtune *t, dualdouble_soa a,
+                                          dualdouble_soa b, size_t n) {
+  return vdf2dot_acc(a, b, n, t->dot_acc);
+}
+
+/* 以调优结果批量求和 */
+static inline dualfloat dualtune_vdf2sumf(const dualtune *t, dualfloat_soa a,
+                                          size_t n) {
+  return vdf2sum_accf(a, n, t->sumf_acc);
+}
+
+/* 以调优结果批量求点积 */
+static inline dualfloat dualtune_vdf2dotf(const dualtune *t, dualfloat_soa a,
+                                          dualfloat_soa b, size_t n) {
+  return vdf2dot_accf(a, b, n, t->dotf_acc);
+}
+
+/* 处理器型号(x86的cpuid品牌字符串),其他平台为"unknown" */
+static inline void dualtune_cpuname(char *buf, size_t size) {
+  unsigned r[13] = {0};
+  char *p = (char *)r;
+  int i;
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+  __cpuid((int *)r, (int)0x80000000u);
+  if (r[0] >= 0x80000004u)
+    for (i = 0; i < 3; i++)
+      __cpuid((int *)r + 4 * i, (int)(0x80000002u + i));
+  else
+    r[0] = 0;
+#elif defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+  if (__get_cpuid_max(0x80000000u, NULL) >= 0x80000004u)
+    for (i = 0; i < 3; i++)
+      __get_cpuid(0x80000002u + i, &r[4 * i], &r[4 * i + 1], &r[4 * i + 2],
+                  &r[4 * i + 3]);
+#endif
+  (void)i;
+  while (*p == ' ')
+    p++;
+  snprintf(buf, size, "%s", *p ? p : "unknown");
+}
+
+/* 缓存文件中识别本机与编译配置的三行: host,cpu与build */
+static inline void dualtune_key(char *host, char *cpu, char *build,
+                                size_t size) {
+  if (dual_hostname(host, size) != 0)
+    snprintf(host, size, "unknown");
+  dualtune_cpuname(cpu, size);
+#if defined(DUAL_BATCH_AVX) && DUAL_BATCH_FMA
+  snprintf(build, size, "avx fma");
+#elif defined(DUAL_BATCH_AVX)
+  snprintf(build, size, "avx");
+#else
+  snprintf(build, size, "scalar");
+#endif
+}
+
+/* 调优用的随机双数(xorshift),高位在±[1,2)中 */
+static inline void dualtune_fill(double *hi, double *lo, size_t n,
+                                 uint64_t *seed) {
+  size_t i;
+  for (i = 0; i < n; i++) {
+    uint64_t x = *seed;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    *seed = x;
+    hi[i] = (x & 1 ? -1.0 : 1.0) * (1.0 + ldexp((double)(x >> 11), -53));
+    lo[i] = hi[i] * ldexp((double)(x >> 40), -78); // |lo|<2^-54|hi|
+  }
+}
+
+/*
+ * 计时一个调优参数的各候选值(1,2,4,8)并返回最快者,
+ * kernel(arg,k)执行一次归约(n个元素),log非NULL时输出各候选值的时间.
+ */
+static inline int dualtune_pick(const char *name, const char *desc,
+                                double (*kernel)(void *, int), void *arg,
+                                size_t n, FILE *log) {
+  double best[4], ns;
+  volatile double sink = 0; // 防止结果被优化掉
+  uint64_t t0;
+  int c, r, trial, win = 0;
+  for (c = 0; c < 4; c++)
+    best[c] = 1e300;
+  for (trial = 0; trial < 15; trial++) // 各候选值交替计时,取最短
+    for (c = 0; c < 4; c++) {
+      t0 = dual_time_ns();
+      for (r = 0; r < 8; r++)
+        sink = sink + kernel(arg, 1 << c);
+      ns = (double)(dual_time_ns() - t0) / (8.0 * (double)n);
+      if (ns < best[c])
+        best[c] = ns;
+    }
+  for (c = 1; c < 4; c++)
+    if (best[c] < best[win] * 0.98) // 差别不足2%时取较少的累加器
+      win = c;
+  if (log) {
+    fprintf(log, "%-9s %-9s", name, desc);
+    for (c = 0; c < 4; c++)
+      fprintf(log, "  k=%d %.3f%s", 1 << c, best[c], c == win ? "*" : " ");
+    fprintf(log, "  ns/elem\n");
+  }
+  return 1 << win;
+}
+
+/* 调优用的数据 */
+typedef struct dualtune_data {
+  dualdouble_soa a, b;
+  dualfloat_soa af, bf;
+  size_t n;
+} dualtune_data;
+
+static inline double dualtune_sum(void *p, int k) {
+  dualtune_data *d = (dualtune_data *)p;
+  return vdf2sum_acc(d->a, d->n, k).hi;
+}
+
+static inline double dualtune_dot(void *p, int k) {
+  dualtune_data *d = (dualtune_data *)p;
+  return vdf2dot_acc(d->a, d->b, d->n, k).hi;
+}
+
+static inline double dualtune_sumf(void *p, int k) {
+  dualtune_data *d = (dualtune_data *)p;
+  return vdf2sum_accf(d->af, d->n, k).hi;
+}
+
+static inline double dualtune_dotf(void *p, int k) {
+  dualtune_data *d = (dualtune_data *)p;
+  return vdf2dot_accf(d->af, d->bf, d->n, k).hi;
+}
+
+/*
+ * 在本机计时各调优参数的候选值,结果写入t(约需0.1秒),
+ * log非NULL时输出各候选值的时间,内存不足返回-1(t为默认值).
+ */
+static inline int dualtune_run(dualtune *t, FILE *log) {
+  const size_t n = 4096; // 数据留在L1/L2缓存中,只比较计算速度
+  dualtune_data d;
+  uint64_t seed = 0x9e3779b97f4a7c15u;
+  size_t i;
+  double *buf = (double *)dual_aligned_alloc(4 * n * sizeof(double), 64);
+  float *fbuf = (float *)dual_aligned_alloc(4 * n * sizeof(float), 64);
+  dualtune_default(t);
+  if (!buf || !fbuf) {
+    dual_aligned_free(buf);
+    dual_aligned_free(fbuf);
+    return -1;
+  }
+  d.n = n;
+  d.a = dsoa(buf, buf + n);
+  d.b = dsoa(buf + 2 * n, buf + 3 * n);
+  dualtune_fill(d.a.hi, d.a.lo, n, &seed);
+  dualtune_fill(d.b.hi, d.b.lo, n, &seed);
+  d.af = dsoaf(fbuf, fbuf + n);
+  d.bf = dsoaf(fbuf + 2 * n, fbuf + 3 * n);
+  for (i = 0; i < n; i++) { // double舍入到float的余数为低位
+    d.af.hi[i] = (float)d.a.hi[i];
+    d.af.lo[i] = (float)(d.a.hi[i] - d.af.hi[i]);
+    d.bf.hi[i] = (float)d.b.hi[i];
+    d.bf.lo[i] = (float)(d.b.hi[i] - d.bf.hi[i]);
+  }
+  t->sum_acc = dualtune_pick("sum_acc", "vdf2sum", dualtune_sum, &d, n, log);
+  t->dot_acc = dualtune_pick("dot_acc", "vdf2dot", dualtune_dot, &d, n, log);
+  t->sumf_acc =
+      dualtune_pick("sumf_acc", "vdf2sumf", dualtune_sumf, &d, n, log);
+  t->dotf_acc =
+      dualtune_pick("dotf_acc", "vdf2dotf", dualtune_dotf, &d, n, log);
+  dual_aligned_free(buf);
+  dual_aligned_free(fbuf);
+  return 0;
+}
+
+/*
+ * 写入缓存文件: 文本格式,每行"名称 值",
+ * 前三行host,cpu与build识别本机与编译配置. 失败返回-1.
+ */
+static inline int dualtune_save(const dualtune *t, const char *path) {
+  char host[128], cpu[128], build[128];
+  FILE *f = fopen(path, "w");
+  int ok;
+  if (!f)
+    return -1;
+  dualtune_key(host, cpu, build, sizeof(host));
+  fprintf(f, "# dualtune %d\nhost %s\ncpu %s\nbuild %s\n", DUALTUNE_VERSION,
+          host, cpu, build);
+#define DUALTUNE_FIELD(name, desc) fprintf(f, #name " %d\n", t->name);
+  DUALTUNE_LIST(DUALTUNE_FIELD)
+#undef DUALTUNE_FIELD
+  ok = !ferror(f);
+  return fclose(f) == 0 && ok ? 0 : -1;
+}
+
+/*
+ * 读取缓存文件,文件不存在,版本,主机,处理器或编译配置不符,
+ * 或缺少参数时返回-1(t为默认值).
+ */
+static inline int dualtune_load(dualtune *t, const char *path) {
+  char host[128], cpu[128], build[128], head[32], line[256], *v;
+  int match = 0, found = 0, bit, val;
+  FILE *f = fopen(path, "r");
+  dualtune_default(t);
+  if (!f)
+    return -1;
+  dualtune_key(host, cpu, build, sizeof(host));
+  snprintf(head, sizeof(head), "# dualtune %d", DUALTUNE_VERSION);
+  if (!fgets(line, sizeof(line), f) || strncmp(line, head, strlen(head))) {
+    fclose(f);
+    return -1;
+  }
+  while (fgets(line, sizeof(line), f)) {
+    line[strcspn(line, "\r\n")] = 0;
+    v = strchr(line, ' ');
+    if (!v)
+      continue;
+    *v++ = 0;
+    if (strcmp(line, "host") == 0)
+      match |= (strcmp(v, host) == 0) << 0;
+    else if (strcmp(line, "cpu") == 0)
+      match |= (strcmp(v, cpu) == 0) << 1;
+    else if (strcmp(line, "build") == 0)
+      match |= (strcmp(v, build) == 0) << 2;
+    val = atoi(v);
+    if (val != 1 && val != 2 && val != 4 && val != DUAL_BATCH_MAXACC)
+      continue;
+    bit = 0;
+#define DUALTUNE_FIELD(name, desc)                                             \
+  if (strcmp(line, #name) == 0) {                                              \
+    t->name = val;                                                             \
+    found |= 1 << bit;                                                         \
+  }                                                                            \
+  bit++;
+    DUALTUNE_LIST(DUALTUNE_FIELD)
+#undef DUALTUNE_FIELD
+  }
+  fclose(f);
+  if (match == 7 && found == (1 << DUALTUNE_COUNT) - 1)
+    return 0;
+  dualtune_default(t);
+  return -1;
+}
+
+/*
+ * 读取缓存文件path,失败时(首次使用或换了机器)调优并写入path.
+ * path为NULL时使用环境变量DUALTUNE_CACHE,也未设置则只调优不缓存.
+ * 返回0为读取了缓存,1为重新调优,-1为调优或写入失败(t仍可使用).
+ */
+static inline int dualtune_init(dualtune *t, const char *path) {
+  if (!path)
+    path = getenv("DUALTUNE_CACHE");
+  if (path && dualtune_load(t, path) == 0)
+    return 0;
+  if (dualtune_run(t, NULL) != 0)
+    return -1;
+  return path && dualtune_save(t, path) != 0 ? -1 : 1;
+}
+
+#endif
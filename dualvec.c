@@ -0,0 +1,233 @@
+﻿/**
+ * 标量核心的自动向量化检查(C与C++均可编译,需要GCC)
+ * 下面以DUALVEC标记的循环逐元素调用标量函数(df2add,df2mul等),
+ * 须以-O3 -fopt-info-vec-optimized=报告文件编译,运行时读取编译器的报告,
+ * 任一标记的循环未被向量化则列出并返回1,
+ * 同时以随机数据核对这些循环与批量函数(vdf2add等)的结果逐位相同.
+ * 标记的循环不能向量化通常是标量函数中出现了分支或按指针重解释类型.
+ *
+ * 用法: dualvec 报告文件
+ */
+
+#include "dualbatch.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define DV_N 1027
+#define DV_MARK "DUALVEC"
+#define DV_MAXLOOP 64
+
+/* SoA数组逐元素双数加法 */
+static void dv_add_soa(dualdouble_soa r, dualdouble_soa a, dualdouble_soa b,
+                       size_t n) {
+  size_t i;
+  for (i = 0; i < n; i++) { /* DUALVEC */
+    dualdouble x = df2add(ddual(a.hi[i], a.lo[i]), ddual(b.hi[i], b.lo[i]));
+    r.hi[i] = x.hi;
+    r.lo[i] = x.lo;
+  }
+}
+
+/* SoA数组逐元素双数减法 */
+static void dv_sub_soa(dualdouble_soa r, dualdouble_soa a, dualdouble_soa b,
+                       size_t n) {
+  size_t i;
+  for (i = 0; i < n; i++) { /* DUALVEC */
+    dualdouble x = df2sub(ddual(a.hi[i], a.lo[i]), ddual(b.hi[i], b.lo[i]));
+    r.hi[i] = x.hi;
+    r.lo[i] = x.lo;
+  }
+}
+
+/* SoA数组逐元素双数乘法 */
+static void dv_mul_soa(dualdouble_soa r, dualdouble_soa a, dualdouble_soa b,
+                       size_t n) {
+  size_t i;
+  for (i = 0; i < n; i++) { /* DUALVEC */
+    dualdouble x = df2mul(ddual(a.hi[i], a.lo[i]), ddual(b.hi[i], b.lo[i]));
+    r.hi[i] = x.hi;
+    r.lo[i] = x.lo;
+  }
+}
+
+/* AoS数组逐元素双数加法 */
+static void dv_add_aos(dualdouble *r, const dualdouble *a, const dualdouble *b,
+                       size_t n) {
+  size_t i;
+  for (i = 0; i < n; i++) /* DUALVEC */
+    r[i] = df2add(a[i], b[i]);
+}
+
+/* AoS数组逐元素双数乘法 */
+static void dv_mul_aos(dualdouble *r, const dualdouble *a, const dualdouble *b,
+                       size_t n) {
+  size_t i;
+  for (i = 0; i < n; i++) /* DUALVEC */
+    r[i] = df2mul(a[i], b[i]);
+}
+
+/* SoA数组逐元素dualfloat加法 */
+static void dv_addf_soa(dualfloat_soa r, dualfloat_soa a, dualfloat_soa b,
+                        size_t n) {
+  size_t i;
+  for (i = 0; i < n; i++) { /* DUALVEC */
+    dualfloat x =
+        df2addf(ddualf(a.hi[i], a.lo[i]), ddualf(b.hi[i], b.lo[i]));
+    r.hi[i] = x.hi;
+    r.lo[i] = x.lo;
+  }
+}
+
+/* SoA数组逐元素dualfloat乘法 */
+static void dv_mulf_soa(dualfloat_soa r, dualfloat_soa a, dualfloat_soa b,
+                        size_t n) {
+  size_t i;
+  for (i = 0; i < n; i++) { /* DUALVEC */
+    dualfloat x =
+        df2mulf(ddualf(a.hi[i], a.lo[i]), ddualf(b.hi[i], b.lo[i]));
+    r.hi[i] = x.hi;
+    r.lo[i] = x.lo;
+  }
+}
+
+/* 取本文件所有标记循环的行号,返回个数 */
+static int dv_marks(int *lines, int max) {
+  char buf[512];
+  int n = 0, line = 0;
+  FILE *f = fopen(__FILE__, "r");
+  if (!f)
+    return -1;
+  while (fgets(buf, sizeof(buf), f)) {
+    line++;
+    if (strstr(buf, "/* " DV_MARK " */") && n < max)
+      lines[n++] = line;
+  }
+  fclose(f);
+  return n;
+}
+
+/* 编译器报告中本文件第line行的循环是否已被向量化 */
+static int dv_vectorized(const char *report, int line) {
+  char buf[1024], key[64];
+  const char *base = strrchr(__FILE__, '/');
+  const char *base2 = strrchr(__FILE__, '\\');
+  int found = 0;
+  FILE *f = fopen(report, "r");
+  if (!f)
+    return 0;
+  if (!base || (base2 && base2 > base))
+    base = base2;
+  base = base ? base + 1 : __FILE__;
+  snprintf(key, sizeof(key), "%s:%d:", base, line);
+  while (!found && fgets(buf, sizeof(buf), f)) {
+    const char *p = strstr(buf, key);
+    found = p && (p == buf || p[-1] == '/' || p[-1] == '\\') &&
+            strstr(p, "loop vectorized") != NULL;
+  }
+  fclose(f);
+  return found;
+}
+
+/* 随机双数,指数在2^-40至2^40之间 */
+static dualdouble dv_rand(void) {
+  double hi = ldexp((double)rand() / RAND_MAX + 0.5, rand() % 81 - 40);
+  double lo = hi * ldexp((double)rand() / RAND_MAX - 0.5, -53);
+  if (rand() & 1)
+    hi = -hi, lo = -lo;
+  if (rand() % 8 == 0)
+    lo = 0;
+  return dfnorm(ddual(hi, lo));
+}
+
+/* 比较两个SoA数组,返回不同的元素个数 */
+static size_t dv_diff(dualdouble_soa x, dualdouble_soa y, size_t n) {
+  size_t i, d = 0;
+  for (i = 0; i < n; i++)
+    d += memcmp(&x.hi[i], &y.hi[i], sizeof(double)) != 0 ||
+         memcmp(&x.lo[i], &y.lo[i], sizeof(double)) != 0;
+  return d;
+}
+
+/* dualfloat版本 */
+static size_t dv_difff(dualfloat_soa x, dualfloat_soa y, size_t n) {
+  size_t i, d = 0;
+  for (i = 0; i < n; i++)
+    d += memcmp(&x.hi[i], &y.hi[i], sizeof(float)) != 0 ||
+         memcmp(&x.lo[i], &y.lo[i], sizeof(float)) != 0;
+  return d;
+}
+
+int main(int argc, char **argv) {
+  static double buf[10][DV_N];
+  static float fbuf[8][DV_N];
+  static dualdouble aa[DV_N], ab[DV_N], ar[DV_N];
+  dualdouble_soa a = {buf[0], buf[1]}, b = {buf[2], buf[3]};
+  dualdouble_soa r = {buf[4], buf[5]}, s = {buf[6], buf[7]};
+  dualdouble_soa t = {buf[8], buf[9]};
+  dualfloat_soa fa = {fbuf[0], fbuf[1]}, fb = {fbuf[2], fbuf[3]};
+  dualfloat_soa fr = {fbuf[4], fbuf[5]}, fs = {fbuf[6], fbuf[7]};
+  int lines[DV_MAXLOOP], nl, i, bad = 0;
+  size_t k, d;
+  if (argc != 2) {
+    fprintf(stderr, "usage: %s report\n", argv[0]);
+    return 2;
+  }
+  /* 结果与批量函数逐位相同 */
+  srand(1);
+  for (k = 0; k < DV_N; k++) {
+    dualdouble x = dv_rand(), y = dv_rand();
+    dsoaset(a, k, x);
+    dsoaset(b, k, y);
+    aa[k] = x;
+    ab[k] = y;
+    dsoasetf(fa, k, ddualf((float)x.hi, (float)(x.hi - (float)x.hi)));
+    dsoasetf(fb, k, ddualf((float)y.hi, (float)(y.hi - (float)y.hi)));
+  }
+#define DV_CHECK(name, d)                                                      \
+  if (d) {                                                                     \
+    printf("%-12s %zu mismatches\n", name, (size_t)(d));                       \
+    bad = 1;                                                                   \
+  }
+  dv_add_soa(r, a, b, DV_N);
+  vdf2add(s, a, b, DV_N);
+  DV_CHECK("add_soa", dv_diff(r, s, DV_N));
+  dv_sub_soa(r, a, b, DV_N);
+  vdf2sub(s, a, b, DV_N);
+  DV_CHECK("sub_soa", dv_diff(r, s, DV_N));
+  dv_mul_soa(r, a, b, DV_N);
+  vdf2mul(s, a, b, DV_N);
+  DV_CHECK("mul_soa", dv_diff(r, s, DV_N));
+  dv_add_aos(ar, aa, ab, DV_N);
+  for (k = 0; k < DV_N; k++)
+    dsoaset(t, k, ar[k]);
+  vdf2add(s, a, b, DV_N);
+  DV_CHECK("add_aos", dv_diff(t, s, DV_N));
+  dv_mul_aos(ar, aa, ab, DV_N);
+  for (k = 0; k < DV_N; k++)
+    dsoaset(t, k, ar[k]);
+  vdf2mul(s, a, b, DV_N);
+  DV_CHECK("mul_aos", dv_diff(t, s, DV_N));
+  dv_addf_soa(fr, fa, fb, DV_N);
+  vdf2addf(fs, fa, fb, DV_N);
+  DV_CHECK("addf_soa", dv_difff(fr, fs, DV_N));
+  dv_mulf_soa(fr, fa, fb, DV_N);
+  vdf2mulf(fs, fa, fb, DV_N);
+  DV_CHECK("mulf_soa", dv_difff(fr, fs, DV_N));
+#undef DV_CHECK
+  /* 编译器的向量化报告 */
+  nl = dv_marks(lines, DV_MAXLOOP);
+  if (nl <= 0) {
+    fprintf(stderr, "%s: cannot read marked loops\n", __FILE__);
+    return 2;
+  }
+  d = 0;
+  for (i = 0; i < nl; i++) {
+    if (dv_vectorized(argv[1], lines[i]))
+      continue;
+    printf("%s:%d: loop not vectorized\n", __FILE__, lines[i]);
+    d++;
+  }
+  printf("%d marked loops, %zu not vectorized\n", nl, d);
+  return bad || d ? 1 : 0;
+}
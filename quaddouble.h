@@ -0,0 +1,524 @@
+﻿#ifndef _QUAD_DOUBLE_H_
+#define _QUAD_DOUBLE_H_
+#include "dualbatch.h"
+#include <math.h>
+
+/**
+ * quaddouble四倍双数,由4个互不重叠的double组成,约有212位精度
+ * 以dualdouble的无误差加法(dadd)与乘法(dmul)为基础,算法参考QD库
+ * (Hida,Li,Bailey: Library for Double-Double and Quad-Double Arithmetic).
+ * qd2add的误差不超过2ulps;fqd2add较快但相减抵消时只有相对于|a|+|b|的精度,
+ * 结果的分量也可能重叠;
+ * qd2mul,qd2div,qdsqrt的结果通常有210位精度.
+ * 规格化不使用分支,因此除qd2add外的运算都有逐位相同的批量版本.
+ */
+
+typedef struct quaddouble {
+  double x[4]; // 按绝对值递减排列
+#if defined(__cplusplus) || defined(c_plusplus)
+  quaddouble &operator=(double a) {
+    x[0] = a;
+    x[1] = x[2] = x[3] = 0;
+    return *this;
+  }
+#endif
+} quaddouble;
+
+/* 构造四倍双数 */
+DF_INLINE quaddouble qdual(double x0, double x1, double x2,
+                           double x3) {
+  quaddouble ret;
+  ret.x[0] = x0;
+  ret.x[1] = x1;
+  ret.x[2] = x2;
+  ret.x[3] = x3;
+  return ret;
+}
+
+/* dualdouble转为quaddouble */
+DF_INLINE quaddouble qdfromdf(dualdouble a) {
+  return qdual(a.hi, a.lo, 0.0, 0.0);
+}
+
+/* quaddouble舍入为dualdouble */
+DF_INLINE dualdouble qdtodf(quaddouble a) {
+  return dfnorm(ddual(a.x[0], a.x[1] + (a.x[2] + a.x[3])));
+}
+
+/* 取反 */
+DF_INLINE quaddouble qdneg(quaddouble a) {
+  return qdual(-a.x[0], -a.x[1], -a.x[2], -a.x[3]);
+}
+
+/* 乘以2的幂(无舍入) */
+DF_INLINE quaddouble qdmulpow2(quaddouble a, double b) {
+  return qdual(a.x[0] * b, a.x[1] * b, a.x[2] * b, a.x[3] * b);
+}
+
+/* 三数无误差相加: a+b+c的和写入a,误差按大小写入b,c */
+DF_INLINE void qd_three_sum(double *a, double *b, double *c) {
+  dualdouble t1 = dadd(*a, *b);
+  dualdouble t2 = dadd(*c, t1.hi);
+  dualdouble t3 = dadd(t1.lo, t2.lo);
+  *a = t2.hi;
+  *b = t3.hi;
+  *c = t3.lo;
+}
+
+/* 三数相加: a+b+c的和写入a,误差之和写入b */
+DF_INLINE void qd_three_sum2(double *a, double *b, double c) {
+  dualdouble t1 = dadd(*a, *b);
+  dualdouble t2 = dadd(c, t1.hi);
+  *a = t2.hi;
+  *b = t1.lo + t2.lo;
+}
+
+/*
+ * 将大致按绝对值递减排列的5个分量规格化为quaddouble
+ * 第一遍自下而上相加,使c0成为近似和;
+ * 第二遍自上而下把每个分量的误差传给下一个分量.
+ * 分量可能为0或不完全有序,因此使用不要求大小顺序的dadd而不是分支,
+ * 除最後一次加法外没有舍入误差.
+ */
+DF_INLINE quaddouble qd_renorm(double c0, double c1, double c2,
+                               double c3, double c4) {
+  quaddouble ret;
+  dualdouble t;
+  t = dadd(c3, c4);
+  c3 = t.hi;
+  c4 = t.lo;
+  t = dadd(c2, c3);
+  c2 = t.hi;
+  c3 = t.lo;
+  t = dadd(c1, c2);
+  c1 = t.hi;
+  c2 = t.lo;
+  t = dadd(c0, c1);
+  ret.x[0] = t.hi;
+  t = dadd(t.lo, c2);
+  ret.x[1] = t.hi;
+  t = dadd(t.lo, c3);
+  ret.x[2] = t.hi;
+  ret.x[3] = t.lo + c4;
+  return ret;
+}
+
+/* 规格化quaddouble */
+DF_INLINE quaddouble qdnorm(quaddouble a) {
+  return qd_renorm(a.x[0], a.x[1], a.x[2], a.x[3], 0.0);
+}
+
+/* 四倍双数加法(精度略低但更快,无分支) */
+DF_INLINE quaddouble fqd2add(quaddouble a, quaddouble b) {
+  dualdouble s0 = dadd(a.x[0], b.x[0]);
+  dualdouble s1 = dadd(a.x[1], b.x[1]);
+  dualdouble s2 = dadd(a.x[2], b.x[2]);
+  dualdouble s3 = dadd(a.x[3], b.x[3]);
+  dualdouble t = dadd(s1.hi, s0.lo);
+  double c2 = s2.hi, c3 = s3.hi, t0 = t.lo, t1 = s1.lo, t2 = s2.lo;
+  qd_three_sum(&c2, &t0, &t1);
+  qd_three_sum2(&c3, &t0, t2);
+  t0 = t0 + t1 + s3.lo;
+  return qd_renorm(s0.hi, t.hi, c2, c3, t0);
+}
+
+/* 四倍双数减法(精度略低但更快,无分支) */
+DF_INLINE quaddouble fqd2sub(quaddouble a, quaddouble b) {
+  return fqd2add(a, qdneg(b));
+}
+
+/* (u,v)累加t,u与v都不为0时返回移出的最高分量,否则返回0 */
+DF_INLINE double qd_three_accum(double *u, double *v, double t) {
+  dualdouble s = dadd(*v, t);
+  dualdouble r = dadd(*u, s.hi);
+  *u = r.lo;
+  *v = s.lo;
+  if (*u != 0 && *v != 0)
+    return r.hi;
+  if (*v == 0)
+    *v = *u;
+  *u = r.hi;
+  return 0.0;
+}
+
+/* 四倍双数加法:按绝对值从大到小归并两数的分量并累加 */
+DF_INLINE quaddouble qd2add(quaddouble a, quaddouble b) {
+  double x[4] = {0.0, 0.0, 0.0, 0.0};
+  double u = 0.0, v = 0.0, t = 0.0, s = 0.0;
+  dualdouble r;
+  int i = 0, j = 0, k = 0;
+  if (erpmark(a.x[i]) > erpmark(b.x[j]))
+    u = a.x[i++];
+  else
+    u = b.x[j++];
+  if (erpmark(a.x[i]) > erpmark(b.x[j]))
+    v = a.x[i++];
+  else
+    v = b.x[j++];
+  r = dfnorm(ddual(u, v));
+  u = r.hi;
+  v = r.lo;
+  while (k < 4) {
+    if (i >= 4 && j >= 4) {
+      x[k] = u;
+      if (k < 3)
+        x[++k] = v;
+      break;
+    }
+    if (i >= 4)
+      t = b.x[j++];
+    else if (j >= 4)
+      t = a.x[i++];
+    else if (erpmark(a.x[i]) > erpmark(b.x[j]))
+      t = a.x[i++];
+    else
+      t = b.x[j++];
+    s = qd_three_accum(&u, &v, t);
+    if (s != 0)
+      x[k++] = s;
+  }
+  for (; i < 4; i++) // 剩余分量已小于最低位
+    x[3] += a.x[i];
+  for (; j < 4; j++)
+    x[3] += b.x[j];
+  return qd_renorm(x[0], x[1], x[2], x[3], 0.0);
+}
+
+/* 四倍双数减法 */
+DF_INLINE quaddouble qd2sub(quaddouble a, quaddouble b) {
+  return qd2add(a, qdneg(b));
+}
+
+/* 四倍双数乘以double */
+DF_INLINE quaddouble qdmul(quaddouble a, double b) {
+  dualdouble p0 = dmul(a.x[0], b);
+  dualdouble p1 = dmul(a.x[1], b);
+  dualdouble p2 = dmul(a.x[2], b);
+  dualdouble s1 = dadd(p0.lo, p1.hi);
+  double c2 = s1.lo, c3 = p1.lo, c4 = p2.hi;
+  qd_three_sum(&c2, &c3, &c4);
+  c3 += fmuladd(a.x[3], b, p2.lo);
+  return qd_renorm(p0.hi, s1.hi, c2, c3, c4);
+}
+
+/* 四倍双数乘法,只计算到O(eps^3)的项 */
+DF_INLINE quaddouble qd2mul(quaddouble a, quaddouble b) {
+  dualdouble p0 = dmul(a.x[0], b.x[0]);
+  dualdouble p1 = dmul(a.x[0], b.x[1]);
+  dualdouble p2 = dmul(a.x[1], b.x[0]);
+  dualdouble p3 = dmul(a.x[0], b.x[2]);
+  dualdouble p4 = dmul(a.x[1], b.x[1]);
+  dualdouble p5 = dmul(a.x[2], b.x[0]);
+  double c1 = p1.hi, c2 = p2.hi, c3 = p0.lo;
+  double d0 = p1.lo, d1 = p2.lo, e0 = p3.hi, e1 = p4.hi, e2 = p5.hi;
+  double r2, r3;
+  dualdouble s0, s1, t;
+  qd_three_sum(&c1, &c2, &c3); // O(eps)的项
+  qd_three_sum(&c2, &d0, &d1); // O(eps^2)的6项
+  qd_three_sum(&e0, &e1, &e2);
+  s0 = dadd(c2, e0);
+  s1 = dadd(d0, e1);
+  t = dadd(s1.hi, s0.lo);
+  r2 = d1 + e2 + (t.lo + s1.lo);
+  r3 = fmuladd(a.x[1], b.x[2], a.x[0] * b.x[3]); // O(eps^3)的项
+  r3 = fmuladd(a.x[3], b.x[0], fmuladd(a.x[2], b.x[1], r3));
+  r3 = t.hi + (r3 + c3 + p3.lo + p4.lo + p5.lo);
+  return qd_renorm(p0.hi, c1, s0.hi, r3, r2);
+}
+
+/* 四倍双数自乘 */
+DF_INLINE quaddouble qdsqr(quaddouble a) { return qd2mul(a, a); }
+
+/* 四倍双数除法:逐个double求商,每次以余数修正 */
+DF_INLINE quaddouble qd2div(quaddouble a, quaddouble b) {
+  double q0, q1, q2, q3, q4;
+  quaddouble r;
+  q0 = a.x[0] / b.x[0];
+  r = fqd2sub(a, qdmul(b, q0));
+  q1 = r.x[0] / b.x[0];
+  r = fqd2sub(r, qdmul(b, q1));
+  q2 = r.x[0] / b.x[0];
+  r = fqd2sub(r, qdmul(b, q2));
+  q3 = r.x[0] / b.x[0];
+  r = fqd2sub(r, qdmul(b, q3));
+  q4 = r.x[0] / b.x[0];
+  return qd_renorm(q0, q1, q2, q3, q4);
+}
+
+/* 四倍双数开平方:以牛顿迭代求1/sqrt(a),再乘以a */
+DF_INLINE quaddouble qdsqrt(quaddouble a) {
+  quaddouble r, h;
+  const quaddouble half = qdual(0.5, 0.0, 0.0, 0.0);
+  int i;
+  if (a.x[0] == 0 || a.x[0] == INFINITY)
+    return qdual(a.x[0], 0.0, 0.0, 0.0);
+  r = qdual(1.0 / df_sqrt(a.x[0]), 0.0, 0.0, 0.0);
+  h = qdmulpow2(a, 0.5);
+  for (i = 0; i < 3; i++) // 每次迭代精度加倍: 53,106,212
+    r = fqd2add(r, qd2mul(fqd2sub(half, qd2mul(h, qdsqr(r))), r));
+  return qd2mul(r, a);
+}
+
+/* SoA布局的quaddouble数组视图 */
+typedef struct quaddouble_soa {
+  double *x[4];
+} quaddouble_soa;
+
+/* 构造SoA视图 */
+static inline quaddouble_soa qdsoa(double *x0, double *x1, double *x2,
+                                   double *x3) {
+  quaddouble_soa ret;
+  ret.x[0] = x0;
+  ret.x[1] = x1;
+  ret.x[2] = x2;
+  ret.x[3] = x3;
+  return ret;
+}
+
+/* 读取SoA数组的一个元素 */
+static inline quaddouble qdsoaget(quaddouble_soa a, size_t i) {
+  return qdual(a.x[0][i], a.x[1][i], a.x[2][i], a.x[3][i]);
+}
+
+/* 写入SoA数组的一个元素 */
+static inline void qdsoaset(quaddouble_soa a, size_t i, quaddouble x) {
+  a.x[0][i] = x.x[0];
+  a.x[1][i] = x.x[1];
+  a.x[2][i] = x.x[2];
+  a.x[3][i] = x.x[3];
+}
+
+#ifdef DUAL_BATCH_AVX
+/* 4个四倍双数,每个分量一个ymm寄存器 */
+typedef struct quaddouble4 {
+  __m256d x[4];
+} quaddouble4;
+
+/* 从SoA数组装载4个元素(不要求对齐) */
+static inline quaddouble4 qdload4(quaddouble_soa a, size_t i) {
+  quaddouble4 ret;
+  int k;
+  for (k = 0; k < 4; k++)
+    ret.x[k] = _mm256_loadu_pd(a.x[k] + i);
+  return ret;
+}
+
+/* 向SoA数组写入4个元素(不要求对齐) */
+static inline void qdstore4(quaddouble_soa a, size_t i, quaddouble4 x) {
+  int k;
+  for (k = 0; k < 4; k++)
+    _mm256_storeu_pd(a.x[k] + i, x.x[k]);
+}
+
+/* 4路qd_three_sum */
+static inline void qd_three_sum4(__m256d *a, __m256d *b, __m256d *c) {
+  dualdouble4 t1 = dadd4(*a, *b);
+  dualdouble4 t2 = dadd4(*c, t1.hi);
+  dualdouble4 t3 = dadd4(t1.lo, t2.lo);
+  *a = t2.hi;
+  *b = t3.hi;
+  *c = t3.lo;
+}
+
+/* 4路qd_three_sum2 */
+static inline void qd_three_sum24(__m256d *a, __m256d *b, __m256d c) {
+  dualdouble4 t1 = dadd4(*a, *b);
+  dualdouble4 t2 = dadd4(c, t1.hi);
+  *a = t2.hi;
+  *b = _mm256_add_pd(t1.lo, t2.lo);
+}
+
+/* 4路qd_renorm */
+static inline quaddouble4 qd_renorm4(__m256d c0, __m256d c1, __m256d c2,
+                                     __m256d c3, __m256d c4) {
+  quaddouble4 ret;
+  dualdouble4 t;
+  t = dadd4(c3, c4);
+  c3 = t.hi;
+  c4 = t.lo;
+  t = dadd4(c2, c3);
+  c2 = t.hi;
+  c3 = t.lo;
+  t = dadd4(c1, c2);
+  c1 = t.hi;
+  c2 = t.lo;
+  t = dadd4(c0, c1);
+  ret.x[0] = t.hi;
+  t = dadd4(t.lo, c2);
+  ret.x[1] = t.hi;
+  t = dadd4(t.lo, c3);
+  ret.x[2] = t.hi;
+  ret.x[3] = _mm256_add_pd(t.lo, c4);
+  return ret;
+}
+
+/* 4路四倍双数取反 */
+static inline quaddouble4 qdneg4(quaddouble4 a) {
+  const __m256d mask = _mm256_set1_pd(-0.0);
+  int k;
+  for (k = 0; k < 4; k++)
+    a.x[k] = _mm256_xor_pd(a.x[k], mask);
+  return a;
+}
+
+/* 4路四倍双数加法,同fqd2add */
+static inline quaddouble4 fqd2add4(quaddouble4 a, quaddouble4 b) {
+  dualdouble4 s0 = dadd4(a.x[0], b.x[0]);
+  dualdouble4 s1 = dadd4(a.x[1], b.x[1]);
+  dualdouble4 s2 = dadd4(a.x[2], b.x[2]);
+  dualdouble4 s3 = dadd4(a.x[3], b.x[3]);
+  dualdouble4 t = dadd4(s1.hi, s0.lo);
+  __m256d c2 = s2.hi, c3 = s3.hi, t0 = t.lo, t1 = s1.lo;
+  qd_three_sum4(&c2, &t0, &t1);
+  qd_three_sum24(&c3, &t0, s2.lo);
+  t0 = _mm256_add_pd(_mm256_add_pd(t0, t1), s3.lo);
+  return qd_renorm4(s0.hi, t.hi, c2, c3, t0);
+}
+
+/* 4路四倍双数减法,同fqd2sub */
+static inline quaddouble4 fqd2sub4(quaddouble4 a, quaddouble4 b) {
+  return fqd2add4(a, qdneg4(b));
+}
+
+/* 4路四倍双数乘以double,同qdmul */
+static inline quaddouble4 qdmul4(quaddouble4 a, __m256d b) {
+  dualdouble4 p0 = dmul4(a.x[0], b);
+  dualdouble4 p1 = dmul4(a.x[1], b);
+  dualdouble4 p2 = dmul4(a.x[2], b);
+  dualdouble4 s1 = dadd4(p0.lo, p1.hi);
+  __m256d c2 = s1.lo, c3 = p1.lo, c4 = p2.hi;
+  qd_three_sum4(&c2, &c3, &c4);
+  c3 = _mm256_add_pd(c3, fmuladd4(a.x[3], b, p2.lo));
+  return qd_renorm4(p0.hi, s1.hi, c2, c3, c4);
+}
+
+/* 4路四倍双数乘法,同qd2mul */
+static inline quaddouble4 qd2mul4(quaddouble4 a, quaddouble4 b) {
+  dualdouble4 p0 = dmul4(a.x[0], b.x[0]);
+  dualdouble4 p1 = dmul4(a.x[0], b.x[1]);
+  dualdouble4 p2 = dmul4(a.x[1], b.x[0]);
+  dualdouble4 p3 = dmul4(a.x[0], b.x[2]);
+  dualdouble4 p4 = dmul4(a.x[1], b.x[1]);
+  dualdouble4 p5 = dmul4(a.x[2], b.x[0]);
+  __m256d c1 = p1.hi, c2 = p2.hi, c3 = p0.lo;
+  __m256d d0 = p1.lo, d1 = p2.lo, e0 = p3.hi, e1 = p4.hi, e2 = p5.hi;
+  __m256d r2, r3;
+  dualdouble4 s0, s1, t;
+  qd_three_sum4(&c1, &c2, &c3);
+  qd_three_sum4(&c2, &d0, &d1);
+  qd_three_sum4(&e0, &e1, &e2);
+  s0 = dadd4(c2, e0);
+  s1 = dadd4(d0, e1);
+  t = dadd4(s1.hi, s0.lo);
+  r2 = _mm256_add_pd(_mm256_add_pd(d1, e2), _mm256_add_pd(t.lo, s1.lo));
+  r3 = fmuladd4(a.x[1], b.x[2], _mm256_mul_pd(a.x[0], b.x[3]));
+  r3 = fmuladd4(a.x[3], b.x[0], fmuladd4(a.x[2], b.x[1], r3));
+  r3 = _mm256_add_pd(_mm256_add_pd(r3, c3), p3.lo);
+  r3 = _mm256_add_pd(_mm256_add_pd(r3, p4.lo), p5.lo);
+  r3 = _mm256_add_pd(t.hi, r3);
+  return qd_renorm4(p0.hi, c1, s0.hi, r3, r2);
+}
+
+/* 4路四倍双数除法,同qd2div */
+static inline quaddouble4 qd2div4(quaddouble4 a, quaddouble4 b) {
+  __m256d q[5];
+  quaddouble4 r = a;
+  int k;
+  for (k = 0; k < 5; k++) {
+    q[k] = _mm256_div_pd(r.x[0], b.x[0]);
+    if (k < 4)
+      r = fqd2sub4(r, qdmul4(b, q[k]));
+  }
+  return qd_renorm4(q[0], q[1], q[2], q[3], q[4]);
+}
+
+/* 4路四倍双数开平方,同qdsqrt */
+static inline quaddouble4 qdsqrt4(quaddouble4 a) {
+  const __m256d zero = _mm256_setzero_pd();
+  quaddouble4 r, h, half;
+  __m256d spec;
+  int k;
+  spec = _mm256_or_pd(_mm256_cmp_pd(a.x[0], zero, _CMP_EQ_OQ),
+                      _mm256_cmp_pd(a.x[0], _mm256_set1_pd(INFINITY),
+                                    _CMP_EQ_OQ));
+  half.x[0] = _mm256_set1_pd(0.5);
+  r.x[0] = _mm256_div_pd(_mm256_set1_pd(1.0), _mm256_sqrt_pd(a.x[0]));
+  for (k = 1; k < 4; k++)
+    half.x[k] = r.x[k] = zero;
+  for (k = 0; k < 4; k++)
+    h.x[k] = _mm256_mul_pd(a.x[k], half.x[0]);
+  for (k = 0; k < 3; k++)
+    r = fqd2add4(r, qd2mul4(fqd2sub4(half, qd2mul4(h, qd2mul4(r, r))), r));
+  r = qd2mul4(r, a);
+  /* 标量版本的0与无穷大分支以混合代替 */
+  r.x[0] = _mm256_blendv_pd(r.x[0], a.x[0], spec);
+  for (k = 1; k < 4; k++)
+    r.x[k] = _mm256_blendv_pd(r.x[k], zero, spec);
+  return r;
+}
+#endif
+
+/* 批量四倍双数加法: r[i]=a[i]+b[i],同fqd2add */
+static inline void vfqd2add(quaddouble_soa r, quaddouble_soa a,
+                            quaddouble_soa b, size_t n) {
+  size_t i = 0;
+#ifdef DUAL_BATCH_AVX
+  for (; i + 4 <= n; i += 4)
+    qdstore4(r, i, fqd2add4(qdload4(a, i), qdload4(b, i)));
+#endif
+  for (; i < n; i++)
+    qdsoaset(r, i, fqd2add(qdsoaget(a, i), qdsoaget(b, i)));
+}
+
+/* 批量四倍双数减法: r[i]=a[i]-b[i],同fqd2sub */
+static inline void vfqd2sub(quaddouble_soa r, quaddouble_soa a,
+                            quaddouble_soa b, size_t n) {
+  size_t i = 0;
+#ifdef DUAL_BATCH_AVX
+  for (; i + 4 <= n; i += 4)
+    qdstore4(r, i, fqd2sub4(qdload4(a, i), qdload4(b, i)));
+#endif
+  for (; i < n; i++)
+    qdsoaset(r, i, fqd2sub(qdsoaget(a, i), qdsoaget(b, i)));
+}
+
+/* 批量四倍双数乘法: r[i]=a[i]*b[i] */
+static inline void vqd2mul(quaddouble_soa r, quaddouble_soa a,
+                           quaddouble_soa b, size_t n) {
+  size_t i = 0;
+#ifdef DUAL_BATCH_AVX
+  for (; i + 4 <= n; i += 4)
+    qdstore4(r, i, qd2mul4(qdload4(a, i), qdload4(b, i)));
+#endif
+  for (; i < n; i++)
+    qdsoaset(r, i, qd2mul(qdsoaget(a, i), qdsoaget(b, i)));
+}
+
+/* 批量四倍双数除法: r[i]=a[i]/b[i] */
+static inline void vqd2div(quaddouble_soa r, quaddouble_soa a,
+                           quaddouble_soa b, size_t n) {
+  size_t i = 0;
+#ifdef DUAL_BATCH_AVX
+  for (; i + 4 <= n; i += 4)
+    qdstore4(r, i, qd2div4(qdload4(a, i), qdload4(b, i)));
+#endif
+  for (; i < n; i++)
+    qdsoaset(r, i, qd2div(qdsoaget(a, i), qdsoaget(b, i)));
+}
+
+/* 批量四倍双数开平方: r[i]=sqrt(a[i]) */
+static inline void vqdsqrt(quaddouble_soa r, quaddouble_soa a, size_t n) {
+  size_t i = 0;
+#ifdef DUAL_BATCH_AVX
+  for (; i + 4 <= n; i += 4)
+    qdstore4(r, i, qdsqrt4(qdload4(a, i)));
+#endif
+  for (; i < n; i++)
+    qdsoaset(r, i, qdsqrt(qdsoaget(a, i)));
+}
+
+#if defined(__cplusplus) || defined(c_plusplus)
+#include "quaddouble_cxx.h"
+#endif
+
+#endif
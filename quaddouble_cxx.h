@@ -0,0 +1,131 @@
+﻿#ifndef _QUAD_DOUBLE_H_
+#error "it must include by <quaddouble.h>"
+#else
+#ifndef _QUAD_DOUBLE_CXX_
+#define _QUAD_DOUBLE_CXX_
+
+/**
+ * quaddouble的运算符
+ * 定义FAST_DF_OPERATOR时加减法为fqd2add/fqd2sub,否则为qd2add/qd2sub.
+ */
+
+#ifdef FAST_DF_OPERATOR
+#define QD_ADD fqd2add
+#define QD_SUB fqd2sub
+#else
+#define QD_ADD qd2add
+#define QD_SUB qd2sub
+#endif
+
+/* add */
+inline quaddouble operator+(quaddouble a, double b) {
+  return QD_ADD(a, qdual(b, 0.0, 0.0, 0.0));
+}
+
+inline quaddouble operator+(double a, quaddouble b) {
+  return QD_ADD(qdual(a, 0.0, 0.0, 0.0), b);
+}
+
+inline quaddouble operator+(quaddouble a, quaddouble b) {
+  return QD_ADD(a, b);
+}
+
+inline quaddouble &operator+=(quaddouble &a, double b) { return a = a + b; }
+
+inline quaddouble &operator+=(quaddouble &a, quaddouble b) {
+  return a = QD_ADD(a, b);
+}
+
+/* sub */
+inline quaddouble operator-(quaddouble a, double b) {
+  return QD_SUB(a, qdual(b, 0.0, 0.0, 0.0));
+}
+
+inline quaddouble operator-(double a, quaddouble b) {
+  return QD_SUB(qdual(a, 0.0, 0.0, 0.0), b);
+}
+
+inline quaddouble operator-(quaddouble a, quaddouble b) {
+  return QD_SUB(a, b);
+}
+
+inline quaddouble operator-(quaddouble a) { return qdneg(a); }
+
+inline quaddouble &operator-=(quaddouble &a, double b) { return a = a - b; }
+
+inline quaddouble &operator-=(quaddouble &a, quaddouble b) {
+  return a = QD_SUB(a, b);
+}
+
+/* mul */
+inline quaddouble operator*(quaddouble a, double b) { return qdmul(a, b); }
+
+inline quaddouble operator*(double a, quaddouble b) { return qdmul(b, a); }
+
+inline quaddouble operator*(quaddouble a, quaddouble b) {
+  return qd2mul(a, b);
+}
+
+inline quaddouble &operator*=(quaddouble &a, double b) {
+  return a = qdmul(a, b);
+}
+
+inline quaddouble &operator*=(quaddouble &a, quaddouble b) {
+  return a = qd2mul(a, b);
+}
+
+/* div */
+inline quaddouble operator/(quaddouble a, double b) {
+  return qd2div(a, qdual(b, 0.0, 0.0, 0.0));
+}
+
+inline quaddouble operator/(double a, quaddouble b) {
+  return qd2div(qdual(a, 0.0, 0.0, 0.0), b);
+}
+
+inline quaddouble operator/(quaddouble a, quaddouble b) {
+  return qd2div(a, b);
+}
+
+inline quaddouble &operator/=(quaddouble &a, double b) { return a = a / b; }
+
+inline quaddouble &operator/=(quaddouble &a, quaddouble b) {
+  return a = qd2div(a, b);
+}
+
+#undef QD_ADD
+#undef QD_SUB
+
+/* 比较运算,两数都应已规格化,依次比较各分量(有NaN时为0) */
+inline int qd_cmp(quaddouble a, quaddouble b) {
+  int k;
+  for (k = 0; k < 4; k++) {
+    if (a.x[k] < b.x[k])
+      return -1;
+    if (a.x[k] > b.x[k])
+      return 1;
+  }
+  return 0;
+}
+
+inline bool operator==(quaddouble a, quaddouble b) {
+  return (a.x[0] == b.x[0] && a.x[1] == b.x[1] && a.x[2] == b.x[2] &&
+          a.x[3] == b.x[3]);
+}
+
+inline bool operator!=(quaddouble a, quaddouble b) { return !(a == b); }
+
+inline bool operator<(quaddouble a, quaddouble b) { return qd_cmp(a, b) < 0; }
+
+inline bool operator>(quaddouble a, quaddouble b) { return qd_cmp(a, b) > 0; }
+
+inline bool operator<=(quaddouble a, quaddouble b) {
+  return qd_cmp(a, b) <= 0;
+}
+
+inline bool operator>=(quaddouble a, quaddouble b) {
+  return qd_cmp(a, b) >= 0;
+}
+
+#endif
+#endif // !_QUAD_DOUBLE_H_